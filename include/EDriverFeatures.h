@@ -145,6 +145,12 @@ namespace video
 		//! Support for clamping vertices beyond far-plane to depth instead of capping them.
 		EVDF_DEPTH_CLAMP,
 
+		//! Supports a depth only prepass of the solid render pass.
+		/** The driver writes depth only with SMaterial::ColorMask ECP_NONE and
+		honors ECFN_EQUAL without depth writes for the shading pass.
+		See scene::DEPTH_PREPASS_SOLID */
+		EVDF_DEPTH_PREPASS,
+
 		//! Only used for counting the elements of this enum
 		EVDF_COUNT
 	};
@@ -9,6 +9,7 @@
 #include "IBoneSceneNode.h"
 #include "IAnimatedMeshMD2.h"
 #include "IAnimatedMeshMD3.h"
+#include "SAnimationLayer.h"
 
 namespace irr
 {
@@ -218,6 +219,42 @@ namespace scene
 		/** Culling is unaffected. */
 		virtual void setRenderFromIdentity( bool On )=0;
 
+		//! Adds a clip which is blended over the animation of a skinned mesh
+		/** The node samples all layers into the local positions,
+		rotations and scales of the joints, blends them and skins the
+		mesh once with the result. No joint scene nodes are needed for
+		it. The frame of each layer is advanced with its own speed while
+		the node animates. Layers are ignored for meshes which are not
+		skinned and while the joint mode is EJUOR_CONTROL.
+		\param layer The clip, its weights and mask.
+		\return Index of the new layer. */
+		virtual u32 addAnimationLayer(const SAnimationLayer& layer) = 0;
+
+		//! Returns a layer to change its weight, frames or mask
+		/** The node only blends the layers again when the frame of the
+		node or of a layer moved or a layer was fetched with this function,
+		so get the layer again for each change instead of keeping the
+		reference.
+		\param index Index of the layer, as returned by addAnimationLayer(). */
+		virtual SAnimationLayer& getAnimationLayer(u32 index) = 0;
+
+		//! Returns the amount of animation layers
+		virtual u32 getAnimationLayerCount() const = 0;
+
+		//! Removes an animation layer
+		/** The layers after it move down by one index. */
+		virtual void removeAnimationLayer(u32 index) = 0;
+
+		//! Sets the mask factor of a joint and all joints below it in a layer
+		/** For masking a body part, like the upper body from the spine
+		on. If the mask of the layer is empty, all other joints get a
+		factor of 0 first.
+		\param index Index of the layer.
+		\param jointName Name of the first joint.
+		\param factor Factor from 0 to 1 for the weight of the layer.
+		\return False if there is no such joint. */
+		virtual bool setAnimationLayerMask(u32 index, const c8* jointName, f32 factor=1.f) = 0;
+
 		//! Creates a clone of this scene node and its children.
 		/** \param newParent An optional new parent.
 		\param newManager An optional new scene manager.
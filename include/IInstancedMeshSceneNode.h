@@ -0,0 +1,84 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_I_INSTANCED_MESH_SCENE_NODE_H_INCLUDED
+#define IRR_I_INSTANCED_MESH_SCENE_NODE_H_INCLUDED
+
+#include "ISceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+
+class IMesh;
+
+
+//! A scene node drawing many copies of the same static mesh
+/** Each instance has its own transformation relative to the node and an
+optional color, which is multiplied with the vertex colors of the mesh.
+Instances outside of the view frustum are culled together each frame and
+the visible ones are drawn with IVideoDriver::drawMeshBufferInstanced(),
+so every material is set only once. All instances share the materials of
+the node.
+*/
+class IInstancedMeshSceneNode : public ISceneNode
+{
+public:
+
+	//! Constructor
+	/** Use setMesh() to set the mesh to display.
+	*/
+	IInstancedMeshSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1,1,1))
+		: ISceneNode(parent, mgr, id, position, rotation, scale) {}
+
+	//! Sets a new mesh to display
+	/** \param mesh Mesh drawn for every instance. */
+	virtual void setMesh(IMesh* mesh) = 0;
+
+	//! Get the currently defined mesh for display.
+	/** \return Pointer to mesh which is displayed by this node. */
+	virtual IMesh* getMesh(void) = 0;
+
+	//! Adds an instance
+	/** \param transform Transformation of the instance relative to the node.
+	\param color Multiplied with the vertex colors of the instance.
+	\return Index of the new instance. */
+	virtual u32 addInstance(const core::matrix4& transform,
+		video::SColor color=video::SColor(0xffffffff)) = 0;
+
+	//! Removes an instance
+	/** The indices of all following instances decrease by one.
+	\param index Index of the instance. */
+	virtual void removeInstance(u32 index) = 0;
+
+	//! Removes all instances
+	virtual void clearInstances() = 0;
+
+	//! Get the amount of instances
+	virtual u32 getInstanceCount() const = 0;
+
+	//! Sets the transformation of an instance relative to the node
+	virtual void setInstanceTransform(u32 index, const core::matrix4& transform) = 0;
+
+	//! Get the transformation of an instance relative to the node
+	virtual const core::matrix4& getInstanceTransform(u32 index) const = 0;
+
+	//! Sets the color of an instance
+	virtual void setInstanceColor(u32 index, video::SColor color) = 0;
+
+	//! Get the color of an instance
+	virtual video::SColor getInstanceColor(u32 index) const = 0;
+
+	//! Get the amount of instances which passed culling in the last frame
+	virtual u32 getVisibleInstanceCount() const = 0;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -7,6 +7,7 @@
 
 #include "IAnimatedMesh.h"
 #include "IQ3Shader.h"
+#include "irrArray.h"
 
 namespace irr
 {
@@ -37,6 +38,35 @@ namespace scene
 
 		//! returns the requested brush entity
 		virtual IMesh* getBrushEntityMesh(quake3::IEntity &ent) const = 0;
+
+		//! Returns the amount of visibility clusters of the level
+		/** \return 0 if the level has no visibility data. */
+		virtual s32 getClusterCount() const = 0;
+
+		//! Returns the visibility cluster which contains a position
+		/** Walks the bsp tree of the level.
+		\param pos Position in the coordinate system of the level mesh.
+		\return Index of the cluster or -1 if the position is outside
+		of the level or the level has no bsp tree. */
+		virtual s32 getClusterFromPosition(const core::vector3df& pos) const = 0;
+
+		//! Returns if a cluster is potentially visible from another one
+		/** \return True if there is no visibility data or the viewer is
+		in no cluster, false if the target is in no cluster. */
+		virtual bool isClusterVisible(s32 from, s32 to) const = 0;
+
+		//! Collects the indices of the potentially visible level geometry
+		/** The faces of all leafs whose cluster is visible from the given
+		cluster are written to the index list of their mesh buffer in
+		getMesh(quake3::E_Q3_MESH_GEOMETRY).
+		\param cluster Cluster of the viewer, see getClusterFromPosition().
+		With -1 or without visibility data all faces are collected.
+		\param indices Array of index lists, one for each mesh buffer of
+		the geometry mesh. The lists are cleared first.
+		\param count Amount of index lists.
+		\return Amount of faces collected. */
+		virtual u32 getPotentiallyVisibleIndices(s32 cluster,
+			core::array<u16>* indices, u32 count) const = 0;
 	};
 
 } // end namespace scene
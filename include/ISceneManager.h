@@ -107,6 +107,8 @@ namespace scene
 	class IBillboardTextSceneNode;
 	class ICameraSceneNode;
 	class IDummyTransformationSceneNode;
+	class IInstancedMeshSceneNode;
+	class IStaticBatchSceneNode;
 	class ILightManager;
 	class ILightSceneNode;
 	class IMesh;
@@ -119,6 +121,7 @@ namespace scene
 	class IMetaTriangleSelector;
 	class IOctreeSceneNode;
 	class IParticleSystemSceneNode;
+	class IQ3LevelMesh;
 	class ISceneCollisionManager;
 	class ISceneLoader;
 	class ISceneNode;
@@ -519,6 +522,43 @@ namespace scene
 			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
 			bool alsoAddIfMeshPointerZero=false) = 0;
 
+		//! Adds a scene node for rendering many instances of a static mesh.
+		/** Instances are added with IInstancedMeshSceneNode::addInstance().
+		\param mesh: Pointer to the loaded static mesh drawn for every instance.
+		\param parent: Parent of the scene node. Can be NULL if no parent.
+		\param id: Id of the node. This id can be used to identify the scene node.
+		\param position: Position of the space relative to its parent where the
+		scene node will be placed.
+		\param rotation: Initial rotation of the scene node.
+		\param scale: Initial scale of the scene node.
+		\param alsoAddIfMeshPointerZero: Add the scene node even if a 0 pointer is passed.
+		\return Pointer to the created scene node.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IInstancedMeshSceneNode* addInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			bool alsoAddIfMeshPointerZero=false) = 0;
+
+		//! Adds a scene node drawing static mesh scene nodes merged into few meshbuffers
+		/** Collects the visible mesh scene nodes without children and
+		animators below a root whose meshes only contain solid triangle
+		lists. Their geometry is merged per material into meshbuffers with
+		32 bit indices, split into chunks on a grid which are culled on
+		their own. The collected nodes are hidden and the batch follows
+		their changes, see IStaticBatchSceneNode. Use it for many small
+		static nodes sharing few materials to draw them with few calls.
+		\param root Root of the nodes to merge. If 0, the whole scene is used.
+		\param chunkSize Edge length of the cubes of the grid in world units.
+		Nodes are put into the chunk containing the center of their box.
+		\param parent Parent of the scene node. Can be NULL if no parent. The
+		node should stay at the origin of the world.
+		\param id Id of the node. This id can be used to identify the scene node.
+		\return Pointer to the created scene node.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual IStaticBatchSceneNode* addStaticBatchSceneNode(ISceneNode* root=0, f32 chunkSize=256.f,
+			ISceneNode* parent=0, s32 id=-1) = 0;
+
 		//! Adds a scene node for rendering a animated water surface mesh.
 		/** Looks really good when the Material type EMT_TRANSPARENT_REFLECTION
 		is used.
@@ -905,6 +945,21 @@ namespace scene
 												ISceneNode* parent=0, s32 id=-1
 												) = 0;
 
+		//! Adds a scene node for the geometry of a quake3 level to the scene graph.
+		/** Each frame the node looks up the cluster of the active camera in the
+		bsp tree of the level and only draws the faces of the clusters which
+		are potentially visible from there. Rooms hidden behind walls are
+		skipped this way, unlike with addOctreeSceneNode(). Outside of the
+		level or for levels without vis data all faces are drawn.
+		\param mesh Level mesh as loaded from a .bsp file. The faces of
+		getMesh(quake3::E_Q3_MESH_GEOMETRY) are rendered.
+		\param parent Parent of the scene node. Can be NULL if no parent.
+		\param id Id of the node. This id can be used to identify the scene node.
+		\return Pointer to the created scene node or 0 if the mesh is invalid.
+		This pointer should not be dropped. See IReferenceCounted::drop() for more information. */
+		virtual ISceneNode* addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+			ISceneNode* parent=0, s32 id=-1) = 0;
+
 
 		//! Adds an empty scene node to the scene graph.
 		/** Can be used for doing advanced transformations
@@ -1465,6 +1520,28 @@ namespace scene
 		/** All scene nodes are removed. */
 		virtual void clear() = 0;
 
+		//! Adds a mesh which hides the scene nodes behind it.
+		/** Before the scene nodes register, the meshes of all visible
+		occluders are drawn into a small depth buffer on the cpu. Nodes
+		with EAC_OCC_SOFTWARE in their automatic culling are culled if
+		their bounding box is completely behind them. Unlike EAC_OCC_QUERY
+		this needs no support of the driver and works with the null driver,
+		too. Occluders should be simple, closed meshes inside of large
+		solid objects like walls or terrain.
+		\param node The mesh is drawn with the absolute transformation of
+		this node. Replaces an occluder added for the node before. The
+		occluder is removed when the node is no longer part of the scene,
+		e.g. after ISceneNode::remove() or removeAll().
+		\param mesh The occluder. If 0, the mesh of a mesh scene node or
+		the first frame of an animated mesh scene node is used. */
+		virtual void addOccluder(ISceneNode* node, const IMesh* mesh=0) = 0;
+
+		//! Removes the occluder of a scene node.
+		virtual void removeOccluder(ISceneNode* node) = 0;
+
+		//! Removes all occluders.
+		virtual void removeAllOccluders() = 0;
+
 		//! Get interface to the parameters set in this scene.
 		/** String parameters can be used by plugins and mesh loaders.
 		See	COLLADA_CREATE_SCENE_INSTANCES and DMF_USE_MATERIALS_DIRS */
@@ -10,6 +10,7 @@
 #include "ECullingTypes.h"
 #include "EDebugSceneTypes.h"
 #include "ISceneNodeAnimator.h"
+#include "ISceneNodeSpatialIndex.h"
 #include "ITriangleSelector.h"
 #include "SMaterial.h"
 #include "irrString.h"
@@ -49,7 +50,10 @@ namespace scene
 			: RelativeTranslation(position), RelativeRotation(rotation), RelativeScale(scale),
 				Parent(0), SceneManager(mgr), TriangleSelector(0), ID(id),
 				AutomaticCullingState(EAC_BOX), DebugDataVisible(EDS_OFF),
-				IsVisible(true), IsDebugObject(false)
+				IsVisible(true), IsDebugObject(false), SpatialIndex(0), SpatialIndexSlot(-1),
+				AppliedParent(0), AppliedParentVersion(0),
+				AbsoluteTransformationCached(false), CompareRelativeTransformation(false),
+				TransformationVersion(0), HierarchyVersion(0)
 		{
 			if (parent)
 				parent->addChild(this);
@@ -235,6 +239,28 @@ namespace scene
 		}
 
 
+		//! Get the version of the absolute transformation
+		/** Incremented each time updateAbsolutePosition() changes the
+		absolute transformation of the node. Caches which depend on
+		the transformation can compare it to the version they were
+		built with instead of comparing the matrices.
+		\return Version of the absolute transformation. */
+		u32 getTransformationVersion() const
+		{
+			return TransformationVersion;
+		}
+
+
+		//! Get the version of the subtree below this node
+		/** Incremented each time a node is added to or removed from
+		the children of this node or of any node below it.
+		\return Version of the subtree. */
+		u32 getHierarchyVersion() const
+		{
+			return HierarchyVersion;
+		}
+
+
 		//! Returns whether the node should be visible (if all of its parents are visible).
 		/** This is only an option set by the user, but has nothing to
 		do with geometry culling
@@ -304,6 +330,9 @@ namespace scene
 				child->remove(); // remove from old parent
 				Children.push_back(child);
 				child->Parent = this;
+				child->AbsoluteTransformationCached = false;
+				child->setSpatialIndex(SpatialIndex);
+				hierarchyChanged();
 			}
 		}
 
@@ -321,8 +350,10 @@ namespace scene
 				if ((*it) == child)
 				{
 					(*it)->Parent = 0;
+					(*it)->setSpatialIndex(0);
 					(*it)->drop();
 					Children.erase(it);
+					hierarchyChanged();
 					return true;
 				}
 
@@ -340,10 +371,12 @@ namespace scene
 			for (; it != Children.end(); ++it)
 			{
 				(*it)->Parent = 0;
+				(*it)->setSpatialIndex(0);
 				(*it)->drop();
 			}
 
 			Children.clear();
+			hierarchyChanged();
 		}
 
 
@@ -481,6 +514,8 @@ namespace scene
 		/** \param scale New scale of the node, relative to its parent. */
 		virtual void setScale(const core::vector3df& scale)
 		{
+			if (differs(RelativeScale, scale))
+				AbsoluteTransformationCached = false;
 			RelativeScale = scale;
 		}
 
@@ -501,6 +536,8 @@ namespace scene
 		\param rotation New rotation of the node in degrees. */
 		virtual void setRotation(const core::vector3df& rotation)
 		{
+			if (differs(RelativeRotation, rotation))
+				AbsoluteTransformationCached = false;
 			RelativeRotation = rotation;
 		}
 
@@ -520,6 +557,8 @@ namespace scene
 		\param newpos New relative position of the scene node. */
 		virtual void setPosition(const core::vector3df& newpos)
 		{
+			if (differs(RelativeTranslation, newpos))
+				AbsoluteTransformationCached = false;
 			RelativeTranslation = newpos;
 		}
 
@@ -612,6 +651,7 @@ namespace scene
 			remove();
 
 			Parent = newParent;
+			AbsoluteTransformationCached = false;
 
 			if (Parent)
 				Parent->addChild(this);
@@ -661,16 +701,76 @@ namespace scene
 
 		//! Updates the absolute position based on the relative and the parents position
 		/** Note: This does not recursively update the parents absolute positions, so if you have a deeper
-			hierarchy you might want to update the parents first.*/
+			hierarchy you might want to update the parents first.
+			The relative transformation is only built and multiplied again when setPosition(),
+			setRotation() or setScale() changed it, the node got a new parent or the parent
+			moved since the last update. See setCompareRelativeTransformation() for nodes
+			which change it in other ways. */
 		virtual void updateAbsolutePosition()
 		{
-			if (Parent)
-			{
-				AbsoluteTransformation =
-					Parent->getAbsoluteTransformation() * getRelativeTransformation();
-			}
-			else
-				AbsoluteTransformation = getRelativeTransformation();
+			if (calculateAbsolutePosition() && SpatialIndex)
+				SpatialIndex->nodeMoved(this);
+		}
+
+
+		//! Tells the node that AbsoluteTransformation was written directly
+		/** updateAbsolutePosition() skips the update as long as the relative
+		transformation and the parent did not change. Derived nodes which
+		set AbsoluteTransformation themselves have to call this afterwards,
+		so the next update recalculates it and caches depending on
+		getTransformationVersion() and the spatial index see the change. */
+		void transformationChanged()
+		{
+			AbsoluteTransformationCached = false;
+			++TransformationVersion;
+			if (SpatialIndex)
+				SpatialIndex->nodeMoved(this);
+		}
+
+
+		//! Sets the spatial index of this node and all its children
+		/** Called by addChild() and removeChild(), the scene manager sets
+		it for the root scene node.
+		\param index The new index, 0 removes the nodes from their index. */
+		void setSpatialIndex(ISceneNodeSpatialIndex* index)
+		{
+			// children always have the index of their parent
+			if (SpatialIndex == index)
+				return;
+
+			if (SpatialIndex)
+				SpatialIndex->nodeRemoved(this);
+			SpatialIndex = index;
+			if (SpatialIndex)
+				SpatialIndex->nodeMoved(this);
+
+			ISceneNodeList::Iterator it = Children.begin();
+			for (; it != Children.end(); ++it)
+				(*it)->setSpatialIndex(index);
+		}
+
+
+		//! Get the spatial index this node is in
+		/** \return The index or 0 if the scene is not indexed. */
+		ISceneNodeSpatialIndex* getSpatialIndex() const
+		{
+			return SpatialIndex;
+		}
+
+
+		//! Get the slot of the node in its spatial index
+		/** Only used by the index, -1 if the node has none. */
+		s32 getSpatialIndexSlot() const
+		{
+			return SpatialIndexSlot;
+		}
+
+
+		//! Sets the slot of the node in its spatial index
+		/** Only used by the index. */
+		void setSpatialIndexSlot(s32 slot)
+		{
+			SpatialIndexSlot = slot;
 		}
 
 
@@ -774,6 +874,8 @@ namespace scene
 		{
 			Name = toCopyFrom->Name;
 			AbsoluteTransformation = toCopyFrom->AbsoluteTransformation;
+			AbsoluteTransformationCached = false;
+			++TransformationVersion;
 			RelativeTranslation = toCopyFrom->RelativeTranslation;
 			RelativeRotation = toCopyFrom->RelativeRotation;
 			RelativeScale = toCopyFrom->RelativeScale;
@@ -809,6 +911,19 @@ namespace scene
 			}
 		}
 
+		//! Makes updateAbsolutePosition() build and compare the relative transformation each time
+		/** Needed by nodes which override getRelativeTransformation() with a matrix
+		not only depending on the setters, or which write RelativeTranslation,
+		RelativeRotation or RelativeScale directly. Without it the relative
+		transformation is only built again after setPosition(), setRotation(),
+		setScale(), a new parent or a moved parent.
+		\param compare True to compare the relative transformation on each update. */
+		void setCompareRelativeTransformation(bool compare)
+		{
+			CompareRelativeTransformation = compare;
+			AbsoluteTransformationCached = false;
+		}
+
 		//! Sets the new scene manager for this node and all children.
 		//! Called by addChild when moving nodes between scene managers
 		void setSceneManager(ISceneManager* newManager)
@@ -824,6 +939,9 @@ namespace scene
 		core::stringc Name;
 
 		//! Absolute transformation of the node.
+		/** Only recalculated by updateAbsolutePosition() when the relative
+		transformation or the parent changed. Call transformationChanged()
+		after setting it directly. */
 		core::matrix4 AbsoluteTransformation;
 
 		//! Relative translation of the scene node.
@@ -864,6 +982,78 @@ namespace scene
 
 		//! Is debug object?
 		bool IsDebugObject;
+
+	private:
+
+		//! absolute transformation from the relative one and the parent
+		/** \return True if the absolute transformation changed. */
+		bool calculateAbsolutePosition()
+		{
+			const u32 parentVersion = Parent ? Parent->TransformationVersion : 0;
+			const bool unchanged = AbsoluteTransformationCached &&
+				Parent == AppliedParent && parentVersion == AppliedParentVersion;
+
+			// nothing moved since the last update, the setters did not mark the node
+			if (unchanged && !CompareRelativeTransformation)
+				return false;
+
+			const core::matrix4 relative(getRelativeTransformation());
+			if (CompareRelativeTransformation)
+			{
+				if (unchanged && relative == AppliedRelativeTransformation)
+					return false;
+				AppliedRelativeTransformation = relative;
+			}
+
+			if (Parent)
+				AbsoluteTransformation = Parent->getAbsoluteTransformation() * relative;
+			else
+				AbsoluteTransformation = relative;
+
+			AppliedParent = Parent;
+			AppliedParentVersion = parentVersion;
+			AbsoluteTransformationCached = true;
+
+			++TransformationVersion;
+			return true;
+		}
+
+		//! exact compare, the setters only mark the node when a value changed
+		static bool differs(const core::vector3df& a, const core::vector3df& b)
+		{
+			return a.X != b.X || a.Y != b.Y || a.Z != b.Z;
+		}
+
+		//! increments the hierarchy version of this node and all parents
+		void hierarchyChanged()
+		{
+			for (ISceneNode* node = this; node; node = node->Parent)
+				++node->HierarchyVersion;
+		}
+
+		//! Spatial index the node is in
+		ISceneNodeSpatialIndex* SpatialIndex;
+
+		//! Slot of the node in the spatial index
+		s32 SpatialIndexSlot;
+
+		//! Parent the absolute transformation was calculated from, the relative
+		//! transformation only with CompareRelativeTransformation
+		core::matrix4 AppliedRelativeTransformation;
+		const ISceneNode* AppliedParent;
+		u32 AppliedParentVersion;
+
+		//! Cleared by the setters, addChild() and setParent() to recalculate the node
+		bool AbsoluteTransformationCached;
+
+		//! Set by setCompareRelativeTransformation()
+		bool CompareRelativeTransformation;
+
+		//! Incremented on each change of the absolute transformation
+		u32 TransformationVersion;
+
+		//! Incremented on each change of the subtree
+		u32 HierarchyVersion;
 	};
 
 
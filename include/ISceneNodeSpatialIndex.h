@@ -0,0 +1,39 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_I_SCENE_NODE_SPATIAL_INDEX_H_INCLUDED
+#define IRR_I_SCENE_NODE_SPATIAL_INDEX_H_INCLUDED
+
+namespace irr
+{
+namespace scene
+{
+	class ISceneNode;
+
+	//! Spatial index of the scene nodes of a scene, kept up to date by the nodes
+	/** The scene manager uses one for culling and picking if the
+	scene::SPATIAL_SCENE_INDEX parameter is set. Nodes added to the scene
+	get the index of their new parent. They call nodeMoved() when their
+	absolute transformation changes and nodeRemoved() when they leave the
+	scene. */
+	class ISceneNodeSpatialIndex
+	{
+	public:
+
+		//! Destructor
+		virtual ~ISceneNodeSpatialIndex() {}
+
+		//! Called when a node was added to the indexed scene or its absolute transformation changed
+		/** Can be called from the constructor of the node, so the index
+		must not call virtual methods of the node in here. */
+		virtual void nodeMoved(ISceneNode* node) = 0;
+
+		//! Called when a node is removed from the indexed scene
+		virtual void nodeRemoved(ISceneNode* node) = 0;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
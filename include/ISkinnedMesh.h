@@ -65,6 +65,31 @@ namespace scene
 		//! Sets Interpolation Mode
 		virtual void setInterpolationMode(E_INTERPOLATION_MODE mode) = 0;
 
+		//! Stores the animation keys of all joints in a compressed format
+		/** Keys which linear interpolation between their neighbours
+		rebuilds within the tolerance are removed first. Positions and
+		scales are then quantized to 16 bit per component within the
+		range of their track, rotations to 48 bit by storing the three
+		smallest quaternion components. The key arrays of the joints are
+		empty afterwards and the keys are decompressed while animating,
+		use getJointKeys() to read them. Resampled keys are built again.
+		Call it once the mesh is finalized, see also
+		SKINNED_MESH_KEY_COMPRESSION for meshes loaded by the scene manager.
+		\param tolerance Largest difference of a position or scale
+		component, or of a rotation quaternion component, for which a key
+		is removed. Quantization adds a small error on top of it. */
+		virtual void compressKeys(f32 tolerance) = 0;
+
+		//! Resamples the animation keys of all joints at a constant rate
+		/** With linear interpolation the keys of a frame are then found
+		by index instead of being searched, which helps long animations.
+		The resampled keys are an approximation unless all original keys
+		lie on the samples. They are not used with EIM_CONSTANT.
+		\param framesPerKey Frames between two resampled keys, the
+		animation length is divided evenly. The keys are built right away
+		and again by finalize(). 0 removes them. */
+		virtual void setKeyResampling(f32 framesPerKey) = 0;
+
 		//! Animates this mesh's joints based on frame input
 		virtual void animateMesh(f32 frame, f32 blend)=0;
 
@@ -121,11 +146,28 @@ namespace scene
 			core::quaternion rotation;
 		};
 
+		//! Animation keys stored by compressKeys()
+		struct SCompressedKeys
+		{
+			//! Frame of each key
+			core::array<f32> Frames;
+
+			//! Three quantized components per key
+			core::array<u16> Values;
+
+			//! Smallest position or scale of the keys
+			core::vector3df Offset;
+
+			//! Position or scale difference of one quantization step
+			core::vector3df Step;
+		};
+
 		//! Joints
 		struct SJoint
 		{
 			SJoint() : UseAnimationFrom(0), GlobalSkinningSpace(false),
-				positionHint(-1),scaleHint(-1),rotationHint(-1)
+				positionHint(-1),scaleHint(-1),rotationHint(-1),
+				SamplesPerFrame(0.f)
 			{
 			}
 
@@ -173,6 +215,17 @@ namespace scene
 			s32 positionHint;
 			s32 scaleHint;
 			s32 rotationHint;
+
+			//! keys resampled at a constant rate, see setKeyResampling
+			core::array<core::vector3df> SampledPositions;
+			core::array<core::vector3df> SampledScales;
+			core::array<core::quaternion> SampledRotations;
+			f32 SamplesPerFrame;
+
+			//! keys stored by compressKeys
+			SCompressedKeys CompressedPositions;
+			SCompressedKeys CompressedScales;
+			SCompressedKeys CompressedRotations;
 		};
 
 
@@ -189,6 +242,16 @@ namespace scene
 		//! exposed for loaders: joints list
 		virtual const core::array<SJoint*>& getAllJoints() const = 0;
 
+		//! Copies the animation keys of a joint
+		/** Unlike the key arrays of the joint this also returns the keys
+		stored by compressKeys(), decompressed. Mesh writers use it.
+		\param joint Joint of this mesh.
+		\param positionKeys Receives the position keys.
+		\param scaleKeys Receives the scale keys.
+		\param rotationKeys Receives the rotation keys. */
+		virtual void getJointKeys(const SJoint* joint, core::array<SPositionKey>& positionKeys,
+			core::array<SScaleKey>& scaleKeys, core::array<SRotationKey>& rotationKeys) const = 0;
+
 		//! loaders should call this after populating the mesh
 		virtual void finalize() = 0;
 
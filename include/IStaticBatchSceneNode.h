@@ -0,0 +1,65 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_I_STATIC_BATCH_SCENE_NODE_H_INCLUDED
+#define IRR_I_STATIC_BATCH_SCENE_NODE_H_INCLUDED
+
+#include "ISceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+
+//! A scene node drawing many static mesh scene nodes merged into few meshbuffers
+/** The geometry of the member nodes is transformed into world space and
+merged per material into meshbuffers with 32 bit indices. The merged
+buffers are split into chunks on a grid, which are culled on their own.
+Member nodes are hidden while they are in the batch. The batch checks them
+every frame in OnAnimate() and only rebuilds the chunks of members which
+moved, got another mesh or whose parents were hidden or shown. Setting a
+member visible again or removing it from the scene takes it out of the
+batch. The node itself should stay at the origin, as its transformation
+is applied on top of the world space geometry.
+*/
+class IStaticBatchSceneNode : public ISceneNode
+{
+public:
+
+	//! Constructor
+	IStaticBatchSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id)
+		: ISceneNode(parent, mgr, id) {}
+
+	//! Adds all suitable mesh scene nodes of a subtree
+	/** Suitable are visible mesh scene nodes without children and
+	animators, whose mesh only has triangle lists with solid materials.
+	\param root Root of the subtree, is added itself if suitable.
+	\return Amount of nodes added. */
+	virtual u32 addNodes(ISceneNode* root) = 0;
+
+	//! Takes a node out of the batch and makes it visible again
+	/** \return False if the node is not in the batch. */
+	virtual bool removeNode(ISceneNode* node) = 0;
+
+	//! Rebuilds the chunk of a member after changing its materials or the content of its mesh
+	virtual void nodeChanged(ISceneNode* node) = 0;
+
+	//! Get the amount of member nodes
+	virtual u32 getNodeCount() const = 0;
+
+	//! Get the amount of chunks
+	virtual u32 getChunkCount() const = 0;
+
+	//! Get the amount of merged meshbuffers of all chunks
+	virtual u32 getMeshBufferCount() const = 0;
+
+	//! Get the amount of chunks which passed culling in the last frame
+	virtual u32 getVisibleChunkCount() const = 0;
+};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -1004,6 +1004,19 @@ namespace video
 		/** \param mb Buffer to draw */
 		virtual void drawMeshBuffer(const scene::IMeshBuffer* mb) =0;
 
+		//! Draws a mesh buffer once for every transformation
+		/** The current material is used for all instances. It is not set
+		again between instances, so set it with setMaterial() before.
+		The world transformation is restored after drawing.
+		\param mb Buffer to draw
+		\param transforms World transformation of each instance
+		\param colors Optional color of each instance, needs at least as
+		many entries as transforms. The vertex colors of the buffer are
+		multiplied by it. */
+		virtual void drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+			const core::array<core::matrix4>& transforms,
+			const core::array<SColor>* colors=0) =0;
+
 		//! Draws normals of a mesh buffer
 		/** \param mb Buffer to draw the normals of
 		\param length length scale factor of the normals
@@ -1068,6 +1081,14 @@ namespace video
 		\return Amount of primitives drawn in the last frame. */
 		virtual u32 getPrimitiveCountDrawn( u32 mode =0 ) const =0;
 
+		//! Returns amount of setMaterial calls which changed render states in the last frame.
+		/** Drivers may skip setMaterial calls which would set the same
+		render states as the call before. So far only Burning's Video
+		does this, other drivers return 0.
+		\param skipped Return the amount of skipped calls instead.
+		\return Amount of applied or skipped setMaterial calls in the last frame. */
+		virtual u32 getMaterialChangeCount( bool skipped =false ) const =0;
+
 		//! Deletes all dynamic lights which were previously added with addDynamicLight().
 		virtual void deleteAllDynamicLights() =0;
 
@@ -0,0 +1,64 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef S_ANIMATION_LAYER_H_INCLUDED
+#define S_ANIMATION_LAYER_H_INCLUDED
+
+#include "irrTypes.h"
+#include "irrArray.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	//! A clip of a skinned mesh which is blended over the pose of an animated mesh scene node
+	/** Layers are blended in the order they were added with
+	IAnimatedMeshSceneNode::addAnimationLayer(), each one over the pose
+	of the frame loop of the node and the layers before it. Positions and
+	scales are interpolated linearly and rotations spherically from that
+	pose to the clip, with the weight of the layer times the factor of
+	the joint in the mask. The weights are not normalized: a layer with
+	weight 1 replaces everything below it, and a layer with weight w
+	leaves 1-w of the layers below it. So to mix clips with the shares
+	s1, s2, .. sn (adding up to 1), give layer i the weight
+	si / (s1 + .. + si), e.g. 1 and 0.3 for a 70/30 mix of two clips.
+	An upper body clip can follow with a mask which only contains the
+	joints of the upper body. */
+	struct SAnimationLayer
+	{
+		SAnimationLayer() : StartFrame(0), EndFrame(0), FramesPerSecond(25.f),
+			CurrentFrame(0.f), Weight(1.f), Loop(true)
+		{
+		}
+
+		//! First frame of the clip
+		s32 StartFrame;
+
+		//! Last frame of the clip
+		s32 EndFrame;
+
+		//! Speed of the clip, negative values play it backwards
+		f32 FramesPerSecond;
+
+		//! Frame of the clip which is sampled, advanced by the node
+		f32 CurrentFrame;
+
+		//! Strength of the layer from 0 to 1
+		f32 Weight;
+
+		//! If false the clip stops at its last frame
+		bool Loop;
+
+		//! Factor from 0 to 1 for the weight of each joint, by joint index
+		/** Joints past the end get a factor of 1, so an empty mask
+		blends all joints with the full weight. */
+		core::array<f32> JointMask;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
@@ -47,6 +47,9 @@ namespace irr
 #endif
 			DisplayAdapter(0),
 			DriverMultithreaded(false),
+			FastTextureMapping(false),
+			TiledRasterizer(false),
+			SIMDVertexTransform(true),
 			UsePerformanceTimer(true),
 			SDK_version_do_not_use(IRRLICHT_SDK_VERSION)
 		{
@@ -80,6 +83,9 @@ namespace irr
 			LoggingLevel = other.LoggingLevel;
 			DisplayAdapter = other.DisplayAdapter;
 			DriverMultithreaded = other.DriverMultithreaded;
+			FastTextureMapping = other.FastTextureMapping;
+			TiledRasterizer = other.TiledRasterizer;
+			SIMDVertexTransform = other.SIMDVertexTransform;
 			UsePerformanceTimer = other.UsePerformanceTimer;
 			return *this;
 		}
@@ -286,9 +292,39 @@ namespace irr
 		//! Create the driver multithreaded.
 		/** Default is false. Enabling this can slow down your application.
 			Note that this does _not_ make Irrlicht threadsafe, but only the underlying driver-API for the graphiccard.
-			So far only supported on D3D. */
+			Supported on D3D. Burning's Video uses it to rasterize the triangles of a draw call
+			in parallel (one horizontal band of the screen per processor). The result is the same
+			as rendered with a single thread. With only one processor no threads are created;
+			the driver attribute "RasterThreads" reports the number of raster threads in use. */
 		bool DriverMultithreaded;
 
+		//! Selects the fast texture mapping profile of Burning's Video.
+		/** Only affects the textured gouraud shader CTRTextureGouraud2, which draws
+		EMT_SOLID and the materials falling back to it. When true, its textures are
+		sampled nearest and texture coordinates and colors are only perspective correct
+		at both ends of a scanline and interpolated linearly in between. When false
+		(default), the output is the same as with the compile time configuration of
+		the driver. Both profiles are compiled into the same library. Ignored by the
+		other drivers. */
+		bool FastTextureMapping;
+
+		//! Burning's Video draws batched triangles tile row by tile row.
+		/** Only takes effect together with DriverMultithreaded and more than one raster thread.
+		The triangles of a batch are then drawn into one horizontal tile row of the render
+		target after the other, so the color, depth and stencil rows of a tile row stay in
+		the cache, and each tile row is a job for the next free thread. Triangles crossing
+		a tile row border are set up once per tile row they touch. The result is the same
+		as without tiles. Default is false. Ignored by the other drivers. */
+		bool TiledRasterizer;
+
+		//! Burning's Video transforms the fixed function vertices with SSE2 or AVX.
+		/** Only when the library was compiled with SSE2 support (not with BURNINGVIDEO_NO_SIMD)
+		and the processor has it. The result is the same as with the scalar code, which is
+		used when this is false, e.g. to compare both. The driver attribute "VertexSIMD"
+		reports the instruction set in use, 0 for the scalar code. Default is true.
+		Ignored by the other drivers. */
+		bool SIMDVertexTransform;
+
 		//! Enables use of high performance timers on Windows platform.
 		/** When performance timers are not used, standard GetTickCount()
 		is used instead which usually has worse resolution, but also less
@@ -31,6 +31,106 @@ namespace scene
 	**/
 	const c8* const ALLOW_ZWRITE_ON_TRANSPARENT = "Allow_ZWrite_On_Transparent";
 
+	//! Name of the parameter for drawing the solid render pass with a depth only prepass.
+	/** ESNRP_SOLID nodes are first drawn without color writes and with
+	simple materials, then drawn again with ECFN_EQUAL depth testing, so
+	expensive materials are shaded only once per visible pixel. Only nodes
+	whose materials are opaque (no alpha test), not wireframe and use the
+	default ECFN_LESSEQUAL depth test with depth writes take part, all
+	others are drawn once with their own depth states. Nodes are
+	rendered twice, so this helps scenes with much overdraw and expensive
+	materials like normal or parallax maps. It only has an effect if the
+	driver supports video::EVDF_DEPTH_PREPASS. Default is false.
+	Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::DEPTH_PREPASS_SOLID, true);
+	\endcode
+	**/
+	const c8* const DEPTH_PREPASS_SOLID = "Depth_Prepass_Solid";
+
+	//! Name of the parameter for registering the scene nodes on several threads.
+	/** ISceneManager::drawAll() then calls OnRegisterSceneNode() of the
+	children of the root scene node from a pool of worker threads, so the
+	culling of different subtrees runs at the same time. The render lists
+	are filled afterwards in the same order as without this parameter.
+	Animation stays on the calling thread. OnRegisterSceneNode() of all
+	nodes in the scene must be thread safe apart from calling
+	ISceneManager::registerNodeForRendering(): it may change members of
+	its own node, but no data shared with other nodes like meshes. The
+	built-in nodes do so, except particle systems, whose emitters share
+	one random number generator. Don't use the parameter for scenes with
+	particle systems. Helps scenes with many top level nodes.
+	Default is false. Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::PARALLEL_SCENE_TRAVERSAL, true);
+	\endcode
+	**/
+	const c8* const PARALLEL_SCENE_TRAVERSAL = "Parallel_Scene_Traversal";
+
+	//! Name of the parameter for keeping the scene nodes in a spatial index.
+	/** The scene manager then keeps the world space bounding boxes of all
+	nodes in a dynamic AABB tree, updated when nodes move. ISceneManager::drawAll()
+	tests the tree against the view frustum once, so nodes with
+	EAC_BOX, EAC_FRUSTUM_BOX or EAC_FRUSTUM_SPHERE culling in fully
+	visible regions and nodes with EAC_FRUSTUM_BOX culling in invisible
+	regions don't need their own test. The picking of
+	ISceneCollisionManager::getSceneNodeFromRayBB() and
+	getSceneNodeFromCameraBB() only visits the nodes on the ray. The
+	bounding boxes of all nodes are compared on each update, so nodes
+	whose box changes without the node moving, like animated meshes, are
+	updated as well. Helps scenes with many nodes. Default is false. Use
+	it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::SPATIAL_SCENE_INDEX, true);
+	\endcode
+	**/
+	const c8* const SPATIAL_SCENE_INDEX = "Spatial_Scene_Index";
+
+	//! Name of the parameter for culling the scene nodes in batches.
+	/** ISceneManager::drawAll() then collects the world space bounding
+	boxes of all visible nodes with EAC_BOX or EAC_FRUSTUM_BOX culling
+	before they register and tests 4 of them at a time against the view
+	frustum with SSE2. isCulled() uses these results and only tests the
+	nodes on its own which are too close to a frustum plane to be sure.
+	The culled nodes are the same as without this parameter. Helps scenes
+	with many nodes using EAC_FRUSTUM_BOX. Default is false. Use it like
+	this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::BATCHED_SCENE_CULLING, true);
+	\endcode
+	**/
+	const c8* const BATCHED_SCENE_CULLING = "Batched_Scene_Culling";
+
+	//! Name of the parameter for keeping a flat copy of the scene graph.
+	/** ISceneManager::drawAll() then keeps the scene nodes in depth first
+	order in contiguous arrays together with their parent indices,
+	visibility, absolute transformations and world space bounding boxes.
+	The order is only rebuilt when nodes are added or removed and the
+	boxes are only transformed again for nodes which moved or changed
+	their bounding box, see ISceneNode::getTransformationVersion(). The
+	scene nodes stay the owners of their data. BATCHED_SCENE_CULLING then
+	sweeps over these arrays instead of walking through the child lists
+	and transforming all boxes each frame. It's the only user of the
+	copy, so without BATCHED_SCENE_CULLING the copy is not updated.
+	Helps scenes with many mostly static nodes. Default is false. Use it
+	like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::FLAT_SCENE_STORE, true);
+	\endcode
+	**/
+	const c8* const FLAT_SCENE_STORE = "Flat_Scene_Store";
+
+	//! Compress the animation keys of skinned meshes once they are loaded
+	/** If set to a tolerance above 0, ISkinnedMesh::compressKeys() is
+	called with it for each skinned mesh which a loader created in
+	ISceneManager::getMesh(). Helps keeping large motion libraries in
+	memory. Default is 0, which keeps the keys as they are. Use it like this:
+	\code
+	SceneManager->getParameters()->setAttribute(scene::SKINNED_MESH_KEY_COMPRESSION, 0.001f);
+	\endcode
+	**/
+	const c8* const SKINNED_MESH_KEY_COMPRESSION = "Skinned_Mesh_Key_Compression";
+
 	//! Deprecated, use IMeshLoader::getMeshTextureLoader()->setTexturePath instead.
 	/** Was used for changing the texture path of the built-in csm loader like this:
 	\code
@@ -103,6 +103,7 @@
 #include "IImage.h"
 #include "IImageLoader.h"
 #include "IImageWriter.h"
+#include "IInstancedMeshSceneNode.h"
 #include "IIndexBuffer.h"
 #include "ILightSceneNode.h"
 #include "ILogger.h"
@@ -149,6 +150,7 @@
 #include "IShaderConstantSetCallBack.h"
 #include "IShadowVolumeSceneNode.h"
 #include "ISkinnedMesh.h"
+#include "IStaticBatchSceneNode.h"
 #include "ITerrainSceneNode.h"
 #include "ITextSceneNode.h"
 #include "ITexture.h"
@@ -172,6 +174,7 @@
 #include "rect.h"
 #include "S3DVertex.h"
 #include "SAnimatedMesh.h"
+#include "SAnimationLayer.h"
 #include "SceneParameters.h"
 #include "SColor.h"
 #include "SExposedVideoData.h"
@@ -14,6 +14,7 @@
 #endif // _IRR_COMPILE_WITH_SHADOW_VOLUME_SCENENODE_
 #include "IAnimatedMeshMD3.h"
 #include "CSkinnedMesh.h"
+#include "CSkinnedMeshInstance.h"
 #include "IDummyTransformationSceneNode.h"
 #include "IBoneSceneNode.h"
 #include "IMaterialRenderer.h"
@@ -36,12 +37,12 @@ CAnimatedMeshSceneNode::CAnimatedMeshSceneNode(IAnimatedMesh* mesh,
 		const core::vector3df& rotation,
 		const core::vector3df& scale)
 : IAnimatedMeshSceneNode(parent, mgr, id, position, rotation, scale), Mesh(0),
-	StartFrame(0), EndFrame(0), FramesPerSecond(0.025f),
+	SkinnedInstance(0), StartFrame(0), EndFrame(0), FramesPerSecond(0.025f),
 	CurrentFrameNr(0.f), LastTimeMs(0),
 	TransitionTime(0), Transiting(0.f), TransitingBlend(0.f),
 	JointMode(EJUOR_NONE), JointsUsed(false),
 	Looping(true), ReadOnlyMaterials(false), RenderFromIdentity(false),
-	LoopCallBack(0), PassCount(0), Shadow(0), MD3Special(0)
+	LoopCallBack(0), PassCount(0), Shadow(0), LayersChanged(true), LayersFrame(0.f), MD3Special(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CAnimatedMeshSceneNode");
@@ -57,6 +58,9 @@ CAnimatedMeshSceneNode::~CAnimatedMeshSceneNode()
 	if (MD3Special)
 		MD3Special->drop();
 
+	if (SkinnedInstance)
+		SkinnedInstance->drop();
+
 	if (Mesh)
 		Mesh->drop();
 
@@ -73,6 +77,7 @@ void CAnimatedMeshSceneNode::setCurrentFrame(f32 frame)
 {
 	// if you pass an out of range value, we just clamp it
 	CurrentFrameNr = core::clamp ( frame, (f32)StartFrame, (f32)EndFrame );
+	LayersChanged = true;
 
 	beginTransition(); //transit to this frame if enabled
 }
@@ -203,22 +208,22 @@ IMesh * CAnimatedMeshSceneNode::getMeshForCurrentFrame()
 		return 0;
 #else
 
-		// As multiple scene nodes may be sharing the same skinned mesh, we have to
-		// re-animate it every frame to ensure that this node gets the mesh that it needs.
+		// As multiple scene nodes may be sharing the same skinned mesh, each node
+		// animates and skins its own instance of it. The mesh itself is not changed.
 
 		CSkinnedMesh* skinnedMesh = static_cast<CSkinnedMesh*>(Mesh);
 
 		if (JointMode == EJUOR_CONTROL)//write to mesh
-			skinnedMesh->transferJointsToMesh(JointChildSceneNodes);
+			skinnedMesh->transferJointsToMesh(*SkinnedInstance, JointChildSceneNodes);
 		else
-			skinnedMesh->animateMesh(getFrameNr(), 1.0f);
+			animateSkinnedInstance();
 
 		// Update the skinned mesh for the current joint transforms.
-		skinnedMesh->skinMesh();
+		skinnedMesh->skinMesh(*SkinnedInstance);
 
 		if (JointMode == EJUOR_READ)//read from mesh
 		{
-			skinnedMesh->recoverJointsFromMesh(JointChildSceneNodes);
+			skinnedMesh->recoverJointsFromMesh(*SkinnedInstance, JointChildSceneNodes);
 
 			//---slow---
 			for (u32 n=0;n<JointChildSceneNodes.size();++n)
@@ -228,13 +233,10 @@ IMesh * CAnimatedMeshSceneNode::getMeshForCurrentFrame()
 				}
 		}
 
-		if(JointMode == EJUOR_CONTROL)
-		{
-			// For meshes other than EJUOR_CONTROL, this is done by calling animateMesh()
-			skinnedMesh->updateBoundingBox();
-		}
+		if (ReadOnlyMaterials)
+			SkinnedInstance->updateMaterials();
 
-		return skinnedMesh;
+		return SkinnedInstance;
 #endif
 	}
 }
@@ -250,6 +252,7 @@ void CAnimatedMeshSceneNode::OnAnimate(u32 timeMs)
 
 	// set CurrentFrameNr
 	buildFrameNr(timeMs-LastTimeMs);
+	buildLayerFrames(timeMs-LastTimeMs);
 
 	// update bbox
 	if (Mesh)
@@ -400,22 +403,29 @@ void CAnimatedMeshSceneNode::render()
 		// show skeleton
 		if (DebugDataVisible & scene::EDS_SKELETON)
 		{
-			if (Mesh->getMeshType() == EAMT_SKINNED)
+#ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+			if (SkinnedInstance)
 			{
 				// draw skeleton
+				const core::array<ISkinnedMesh::SJoint*>& joints = ((ISkinnedMesh*)Mesh)->getAllJoints();
 
-				for (u32 g=0; g < ((ISkinnedMesh*)Mesh)->getAllJoints().size(); ++g)
+				for (u32 g=0; g < joints.size(); ++g)
 				{
-					ISkinnedMesh::SJoint *joint=((ISkinnedMesh*)Mesh)->getAllJoints()[g];
+					const ISkinnedMesh::SJoint *joint=joints[g];
 
 					for (u32 n=0;n<joint->Children.size();++n)
 					{
-						driver->draw3DLine(joint->GlobalAnimatedMatrix.getTranslation(),
-								joint->Children[n]->GlobalAnimatedMatrix.getTranslation(),
+						const s32 child = joints.linear_search(joint->Children[n]);
+						if (child < 0)
+							continue;
+
+						driver->draw3DLine(SkinnedInstance->getGlobalAnimatedMatrix(g).getTranslation(),
+								SkinnedInstance->getGlobalAnimatedMatrix(child).getTranslation(),
 								video::SColor(255,51,66,255));
 					}
 				}
 			}
+#endif
 
 			// show tag for quake3 models
 			if (Mesh->getMeshType() == EAMT_MD3)
@@ -559,8 +569,8 @@ IShadowVolumeSceneNode* CAnimatedMeshSceneNode::addShadowVolumeSceneNode(
 	if (!SceneManager->getVideoDriver()->queryFeature(video::EVDF_STENCIL_BUFFER))
 		return 0;
 
-	if (!shadowMesh)
-		shadowMesh = Mesh; // if null is given, use the mesh of node
+	if (!shadowMesh) // if null is given, use the mesh of node
+		shadowMesh = SkinnedInstance ? (const IMesh*)SkinnedInstance : (const IMesh*)Mesh;
 
 	if (Shadow)
 		Shadow->drop();
@@ -831,10 +841,12 @@ void CAnimatedMeshSceneNode::setMesh(IAnimatedMesh* mesh)
 		Mesh->grab();
 	}
 
+	setSkinnedInstance();
+
 	// get materials and bounding box
 	Box = Mesh->getBoundingBox();
 
-	IMesh* m = Mesh->getMesh(0,0);
+	IMesh* m = SkinnedInstance ? SkinnedInstance : Mesh->getMesh(0,0);
 	if (m)
 	{
 		Materials.clear();
@@ -914,6 +926,7 @@ void CAnimatedMeshSceneNode::setJointMode(E_JOINT_UPDATE_ON_RENDER mode)
 {
 	checkJoints();
 	JointMode=mode;
+	LayersChanged = true;
 }
 
 //! Sets the transition time in seconds (note: This needs to enable joints, and setJointmode maybe set to 2)
@@ -947,13 +960,12 @@ void CAnimatedMeshSceneNode::animateJoints(bool CalculateAbsolutePositions)
 	if (Mesh && Mesh->getMeshType() == EAMT_SKINNED )
 	{
 		checkJoints();
-		const f32 frame = getFrameNr(); //old?
 
 		CSkinnedMesh* skinnedMesh=static_cast<CSkinnedMesh*>(Mesh);
 
-		skinnedMesh->transferOnlyJointsHintsToMesh( JointChildSceneNodes );
-		skinnedMesh->animateMesh(frame, 1.0f);
-		skinnedMesh->recoverJointsFromMesh( JointChildSceneNodes);
+		skinnedMesh->transferOnlyJointsHintsToMesh(*SkinnedInstance, JointChildSceneNodes);
+		animateSkinnedInstance();
+		skinnedMesh->recoverJointsFromMesh(*SkinnedInstance, JointChildSceneNodes);
 
 		//-----------------------------------------
 		//		Transition
@@ -1037,7 +1049,7 @@ void CAnimatedMeshSceneNode::checkJoints()
 
 		//Create joints for SkinnedMesh
 		((CSkinnedMesh*)Mesh)->addJoints(JointChildSceneNodes, this, SceneManager);
-		((CSkinnedMesh*)Mesh)->recoverJointsFromMesh(JointChildSceneNodes);
+		((CSkinnedMesh*)Mesh)->recoverJointsFromMesh(*SkinnedInstance, JointChildSceneNodes);
 
 		JointsUsed=true;
 		JointMode=EJUOR_READ;
@@ -1045,6 +1057,158 @@ void CAnimatedMeshSceneNode::checkJoints()
 #endif
 }
 
+//! creates the own instance of a skinned mesh, dropping the old one
+void CAnimatedMeshSceneNode::setSkinnedInstance()
+{
+	if (SkinnedInstance)
+	{
+		SkinnedInstance->drop();
+		SkinnedInstance = 0;
+	}
+
+#ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+	if (Mesh && Mesh->getMeshType() == EAMT_SKINNED)
+		SkinnedInstance = static_cast<CSkinnedMesh*>(Mesh)->createInstance();
+#endif
+	LayersChanged = true;
+}
+
+//! animates the own instance of a skinned mesh, blending the layers over the current frame
+void CAnimatedMeshSceneNode::animateSkinnedInstance()
+{
+#ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+	const CSkinnedMesh* skinnedMesh = static_cast<CSkinnedMesh*>(Mesh);
+
+	if (Layers.empty())
+	{
+		skinnedMesh->animateMesh(*SkinnedInstance, getFrameNr());
+	}
+	else if (LayersChanged || LayersFrame != getFrameNr())
+	{
+		skinnedMesh->animateMesh(*SkinnedInstance, getFrameNr(), Layers.const_pointer(), Layers.size());
+		LayersChanged = false;
+		LayersFrame = getFrameNr();
+	}
+#endif
+}
+
+//! advances the frames of the animation layers
+void CAnimatedMeshSceneNode::buildLayerFrames(u32 timeMs)
+{
+	for (u32 i=0; i<Layers.size(); ++i)
+	{
+		SAnimationLayer& layer = Layers[i];
+		const f32 previousFrame = layer.CurrentFrame;
+
+		if (layer.StartFrame >= layer.EndFrame)
+		{
+			layer.CurrentFrame = (f32)layer.StartFrame;
+		}
+		else
+		{
+			layer.CurrentFrame += timeMs * layer.FramesPerSecond * 0.001f;
+			if (layer.Loop)
+			{
+				const f32 length = (f32)(layer.EndFrame-layer.StartFrame);
+				if (layer.CurrentFrame > layer.EndFrame)
+					layer.CurrentFrame = layer.StartFrame + fmodf(layer.CurrentFrame - layer.StartFrame, length);
+				else if (layer.CurrentFrame < layer.StartFrame)
+					layer.CurrentFrame = layer.EndFrame - fmodf(layer.EndFrame - layer.CurrentFrame, length);
+			}
+			else
+			{
+				layer.CurrentFrame = core::clamp(layer.CurrentFrame, (f32)layer.StartFrame, (f32)layer.EndFrame);
+			}
+		}
+
+		if (layer.CurrentFrame != previousFrame)
+			LayersChanged = true;
+	}
+}
+
+//! Adds a clip which is blended over the animation of a skinned mesh
+u32 CAnimatedMeshSceneNode::addAnimationLayer(const SAnimationLayer& layer)
+{
+	Layers.push_back(layer);
+	LayersChanged = true;
+	return Layers.size()-1;
+}
+
+//! Returns a layer to change its weight, frames or mask
+SAnimationLayer& CAnimatedMeshSceneNode::getAnimationLayer(u32 index)
+{
+	LayersChanged = true;
+	return Layers[index];
+}
+
+//! Returns the amount of animation layers
+u32 CAnimatedMeshSceneNode::getAnimationLayerCount() const
+{
+	return Layers.size();
+}
+
+//! Removes an animation layer
+void CAnimatedMeshSceneNode::removeAnimationLayer(u32 index)
+{
+	if (index < Layers.size())
+	{
+		Layers.erase(index);
+		LayersChanged = true;
+	}
+}
+
+//! Sets the mask factor of a joint and all joints below it in a layer
+bool CAnimatedMeshSceneNode::setAnimationLayerMask(u32 index, const c8* jointName, f32 factor)
+{
+#ifndef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+	os::Printer::log("Compiled without _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_", ELL_WARNING);
+	return false;
+#else
+	if (index >= Layers.size() || !Mesh || Mesh->getMeshType() != EAMT_SKINNED)
+		return false;
+
+	ISkinnedMesh* skinnedMesh = static_cast<ISkinnedMesh*>(Mesh);
+	const s32 number = skinnedMesh->getJointNumber(jointName);
+	if (number == -1)
+	{
+		os::Printer::log("Joint with specified name not found in skinned mesh", jointName, ELL_DEBUG);
+		return false;
+	}
+
+	const core::array<ISkinnedMesh::SJoint*>& joints = skinnedMesh->getAllJoints();
+	core::array<f32>& mask = Layers[index].JointMask;
+	if (mask.empty())
+	{
+		mask.set_used(joints.size());
+		for (u32 i=0; i<mask.size(); ++i)
+			mask[i] = 0.f;
+	}
+	else
+	{
+		while (mask.size() < joints.size())
+			mask.push_back(1.f);
+	}
+
+	// the joint and its children
+	core::array<ISkinnedMesh::SJoint*> stack;
+	stack.push_back(joints[number]);
+	while (!stack.empty())
+	{
+		ISkinnedMesh::SJoint* joint = stack.getLast();
+		stack.erase(stack.size()-1);
+
+		const s32 i = joints.linear_search(joint);
+		if (i != -1)
+			mask[i] = factor;
+		for (u32 c=0; c<joint->Children.size(); ++c)
+			stack.push_back(joint->Children[c]);
+	}
+
+	LayersChanged = true;
+	return true;
+#endif
+}
+
 /*!
 */
 void CAnimatedMeshSceneNode::beginTransition()
@@ -1115,6 +1279,7 @@ ISceneNode* CAnimatedMeshSceneNode::clone(ISceneNode* newParent, ISceneManager*
 		newNode->Shadow->grab();
 	newNode->JointChildSceneNodes = JointChildSceneNodes;
 	newNode->PretransitingSave = PretransitingSave;
+	newNode->Layers = Layers;
 	newNode->RenderFromIdentity = RenderFromIdentity;
 	newNode->MD3Special = MD3Special;
 
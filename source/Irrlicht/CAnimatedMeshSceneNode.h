@@ -16,6 +16,7 @@ namespace irr
 namespace scene
 {
 	class IDummyTransformationSceneNode;
+	class CSkinnedMeshInstance;
 
 	class CAnimatedMeshSceneNode : public IAnimatedMeshSceneNode
 	{
@@ -155,6 +156,21 @@ namespace scene
 		//! render mesh ignoring its transformation. Used with ragdolls. (culling is unaffected)
 		virtual void setRenderFromIdentity( bool On ) IRR_OVERRIDE;
 
+		//! Adds a clip which is blended over the animation of a skinned mesh
+		virtual u32 addAnimationLayer(const SAnimationLayer& layer) IRR_OVERRIDE;
+
+		//! Returns a layer to change its weight, frames or mask
+		virtual SAnimationLayer& getAnimationLayer(u32 index) IRR_OVERRIDE;
+
+		//! Returns the amount of animation layers
+		virtual u32 getAnimationLayerCount() const IRR_OVERRIDE;
+
+		//! Removes an animation layer
+		virtual void removeAnimationLayer(u32 index) IRR_OVERRIDE;
+
+		//! Sets the mask factor of a joint and all joints below it in a layer
+		virtual bool setAnimationLayerMask(u32 index, const c8* jointName, f32 factor=1.f) IRR_OVERRIDE;
+
 		//! Creates a clone of this scene node and its children.
 		/** \param newParent An optional new parent.
 		\param newManager An optional new scene manager.
@@ -167,13 +183,19 @@ namespace scene
 		IMesh* getMeshForCurrentFrame();
 
 		void buildFrameNr(u32 timeMs);
+		void buildLayerFrames(u32 timeMs);
 		void checkJoints();
 		void beginTransition();
+		void setSkinnedInstance();
+		void animateSkinnedInstance();
 
 		core::array<video::SMaterial> Materials;
 		core::aabbox3d<f32> Box;
 		IAnimatedMesh* Mesh;
 
+		// own joint pose and skinned meshbuffers if Mesh is a skinned mesh
+		CSkinnedMeshInstance* SkinnedInstance;
+
 		s32 StartFrame;
 		s32 EndFrame;
 		f32 FramesPerSecond;
@@ -200,6 +222,12 @@ namespace scene
 		core::array<IBoneSceneNode* > JointChildSceneNodes;
 		core::array<core::matrix4> PretransitingSave;
 
+		// blended over the frame loop, the pose is only built again when LayersChanged
+		// or the frame of the node is no longer LayersFrame
+		core::array<SAnimationLayer> Layers;
+		bool LayersChanged;
+		f32 LayersFrame;
+
 		// Quake3 Model
 		struct SMD3Special : public virtual IReferenceCounted
 		{
@@ -390,41 +390,46 @@ void CB3DMeshWriter::writeJointChunk(io::IWriteFile* file, ISkinnedMesh* mesh, I
     // ---------------------------
 
     f32 floatBuffer[5];
-    // Animation keys
-    if (joint->PositionKeys.size())
+    // Animation keys, the mesh decompresses them if needed
+    core::array<ISkinnedMesh::SPositionKey> positionKeys;
+    core::array<ISkinnedMesh::SScaleKey> scaleKeys;
+    core::array<ISkinnedMesh::SRotationKey> rotationKeys;
+    mesh->getJointKeys(joint, positionKeys, scaleKeys, rotationKeys);
+
+    if (positionKeys.size())
     {
         file->write("KEYS", 4);
-        u32 keysSize = 4 * joint->PositionKeys.size() * 4; // X, Y and Z pos + frame
+        u32 keysSize = 4 * positionKeys.size() * 4; // X, Y and Z pos + frame
         keysSize += 4;  // Flag to define the type of the key
         file->write(&keysSize, 4);
 
         u32 flag = 1; // 1 = flag for position keys
         file->write(&flag, 4);
 
-        for (u32 i = 0; i < joint->PositionKeys.size(); i++)
+        for (u32 i = 0; i < positionKeys.size(); i++)
         {
-            const s32 frame = static_cast<s32>(joint->PositionKeys[i].frame * animationSpeedMultiplier);
+            const s32 frame = static_cast<s32>(positionKeys[i].frame * animationSpeedMultiplier);
             file->write(&frame, 4);
 
-            const core::vector3df pos = joint->PositionKeys[i].position;
+            const core::vector3df pos = positionKeys[i].position;
             pos.getAs3Values(floatBuffer);
             file->write(floatBuffer, 12);
         }
     }
-    if (joint->RotationKeys.size())
+    if (rotationKeys.size())
     {
         file->write("KEYS", 4);
-        u32 keysSize = 4 * joint->RotationKeys.size() * 5; // W, X, Y and Z rot + frame
+        u32 keysSize = 4 * rotationKeys.size() * 5; // W, X, Y and Z rot + frame
         keysSize += 4; // Flag
         file->write(&keysSize, 4);
 
         u32 flag = 4;
         file->write(&flag, 4);
 
-        for (u32 i = 0; i < joint->RotationKeys.size(); i++)
+        for (u32 i = 0; i < rotationKeys.size(); i++)
         {
-            const s32 frame = static_cast<s32>(joint->RotationKeys[i].frame * animationSpeedMultiplier);
-            const core::quaternion rot = joint->RotationKeys[i].rotation;
+            const s32 frame = static_cast<s32>(rotationKeys[i].frame * animationSpeedMultiplier);
+            const core::quaternion rot = rotationKeys[i].rotation;
 
             memcpy(floatBuffer, &frame, 4);
             floatBuffer[1] = rot.W;
@@ -434,22 +439,22 @@ void CB3DMeshWriter::writeJointChunk(io::IWriteFile* file, ISkinnedMesh* mesh, I
             file->write(floatBuffer, 20);
         }
     }
-    if (joint->ScaleKeys.size())
+    if (scaleKeys.size())
     {
         file->write("KEYS", 4);
-        u32 keysSize = 4 * joint->ScaleKeys.size() * 4; // X, Y and Z scale + frame
+        u32 keysSize = 4 * scaleKeys.size() * 4; // X, Y and Z scale + frame
         keysSize += 4; // Flag
         file->write(&keysSize, 4);
 
         u32 flag = 2;
         file->write(&flag, 4);
 
-        for (u32 i = 0; i < joint->ScaleKeys.size(); i++)
+        for (u32 i = 0; i < scaleKeys.size(); i++)
         {
-            const s32 frame = static_cast<s32>(joint->ScaleKeys[i].frame * animationSpeedMultiplier);
+            const s32 frame = static_cast<s32>(scaleKeys[i].frame * animationSpeedMultiplier);
             file->write(&frame, 4);
 
-            const core::vector3df scale = joint->ScaleKeys[i].scale;
+            const core::vector3df scale = scaleKeys[i].scale;
             scale.getAs3Values(floatBuffer);
             file->write(floatBuffer, 12);
         }
@@ -17,6 +17,9 @@ namespace video
 //! constructor
 CDepthBuffer::CDepthBuffer(const core::dimension2d<u32>& size)
 : Buffer(0), Size(0,0)
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+	, TileCountX(0), TileCountY(0), Generation(1)
+#endif
 {
 	#ifdef _DEBUG
 	setDebugName("CDepthBuffer");
@@ -51,9 +54,121 @@ void CDepthBuffer::clear(f32 value, const interlaced_control interlaced)
 #endif
 
 	memset32_interlaced(Buffer, zMaxValue.u, Pitch, Size.Height, interlaced);
+
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+	// interlaced clear keeps the other scanlines
+	for (u32 i = 0; i != TileMin.size(); ++i)
+	{
+		if (interlaced.bypass)
+		{
+			TileMin[i] = zMaxValue.f;
+			TileMark[i] = 0;
+		}
+		else if (zMaxValue.f < TileMin[i])
+			TileMin[i] = zMaxValue.f;
+	}
+#endif
+}
+
+
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+
+bool CDepthBuffer::hiz_clip(AbsRectangle& tile, const AbsRectangle& r) const
+{
+	const s32 x0 = core::s32_max(r.x0, 0);
+	const s32 y0 = core::s32_max(r.y0, 0);
+	const s32 x1 = core::s32_min(r.x1, (s32)Size.Width - 1);
+	const s32 y1 = core::s32_min(r.y1, (s32)Size.Height - 1);
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	tile.x0 = x0 >> SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	tile.y0 = y0 >> SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	tile.x1 = x1 >> SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	tile.y1 = y1 >> SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	return true;
 }
 
 
+//! recalculate farthest depth of a tile
+void CDepthBuffer::hiz_update(const u32 index)
+{
+	const u32 tx = (index % TileCountX) << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	const u32 ty = (index / TileCountX) << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	const u32 w = core::min_(Size.Width - tx, 1u << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT);
+	const u32 h = core::min_(Size.Height - ty, 1u << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT);
+
+	const fp24* z = (fp24*)(Buffer + ty * Pitch) + tx;
+	fp24 m = z[0];
+	for (u32 y = 0; y != h; ++y)
+	{
+		for (u32 x = 0; x != w; ++x)
+		{
+			if (z[x] < m)
+				m = z[x];
+		}
+		z = (fp24*)((u8*)z + Pitch);
+	}
+
+	TileMin[index] = m;
+	TileMark[index] = 0;
+}
+
+
+void CDepthBuffer::hiz_mark(const AbsRectangle& r, const bool lower)
+{
+	AbsRectangle tile;
+	if (!hiz_clip(tile, r))
+		return;
+
+	for (s32 ty = tile.y0; ty <= tile.y1; ++ty)
+	{
+		const u32 row = ty * TileCountX;
+		for (s32 tx = tile.x0; tx <= tile.x1; ++tx)
+		{
+			// keep an older mark. tile can still be recalculated in this draw call
+			if (TileMark[row + tx] == 0)
+				TileMark[row + tx] = Generation;
+			if (lower)
+				TileMin[row + tx] = -FLT_MAX;
+		}
+	}
+}
+
+
+bool CDepthBuffer::hiz_reject(const AbsRectangle& r, const f32 w)
+{
+	AbsRectangle tile;
+	if (!hiz_clip(tile, r))
+		return false;
+
+	// incremental interpolation in the scanline shaders may slightly overshoot the vertex depth
+	const f32 w_max = w + core::abs_(w) * (1.f / 1024.f);
+
+	for (s32 ty = tile.y0; ty <= tile.y1; ++ty)
+	{
+		const u32 row = ty * TileCountX;
+		for (s32 tx = tile.x0; tx <= tile.x1; ++tx)
+		{
+			if (w_max < TileMin[row + tx])
+				continue;
+
+			// tiles written by the current draw call are not recalculated (mesh would test against itself)
+			const u32 mark = TileMark[row + tx];
+			if (mark == 0 || mark == Generation)
+				return false;
+
+			hiz_update(row + tx);
+			if (!(w_max < TileMin[row + tx]))
+				return false;
+		}
+	}
+	return true;
+}
+
+#endif
+
+
 
 //! sets the new size of the buffer
 void CDepthBuffer::setSize(const core::dimension2d<u32>& size)
@@ -69,6 +184,14 @@ void CDepthBuffer::setSize(const core::dimension2d<u32>& size)
 	size_t TotalSize = Pitch * size.Height;
 	Buffer = new u8[align_next(TotalSize,16)];
 
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+	const u32 tileSize = 1 << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	TileCountX = (size.Width + tileSize - 1) >> SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	TileCountY = (size.Height + tileSize - 1) >> SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT;
+	TileMin.set_used(TileCountX * TileCountY);
+	TileMark.set_used(TileCountX * TileCountY);
+#endif
+
 	clear( 1.f, interlaced_disabled());
 }
 
@@ -6,6 +6,7 @@
 #define IRR_C_Z_BUFFER_H_INCLUDED
 
 #include "IDepthBuffer.h"
+#include "irrArray.h"
 
 namespace irr
 {
@@ -40,12 +41,45 @@ namespace video
 		//! returns pitch of depthbuffer (in bytes)
 		virtual u32 getPitch() const IRR_OVERRIDE { return Pitch; }
 
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+		//! depth values inside the pixel rectangle (inclusive) have changed
+		/** \param lower false if values were only written where w >= z. Tiles stay a valid
+		lower bound and are recalculated when a later draw call tests them.
+		true if any value was written, tiles can't reject until recalculated. */
+		void hiz_mark(const AbsRectangle& r, const bool lower);
+
+		//! returns true if w is nearer to the far plane than all depth values inside the rectangle
+		/** depth test of the shaders passes for w >= z, so nothing with depth <= w would be drawn */
+		bool hiz_reject(const AbsRectangle& r, const f32 w);
+
+		//! start of a draw call. tiles marked before are recalculated on demand
+		void hiz_next()
+		{
+			Generation += 1;
+			if (Generation == 0)
+				Generation = 1;
+		}
+#endif
 
 	private:
 
 		u8* Buffer;
 		core::dimension2d<u32> Size;
 		u32 Pitch;
+
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+		//! tile r lies in. returns false if outside
+		bool hiz_clip(AbsRectangle& tile, const AbsRectangle& r) const;
+		void hiz_update(const u32 index);
+
+		// lower bound of the depth values of each tile (farthest w)
+		core::array<f32> TileMin;
+		// draw call generation the tile was written in. 0 tile is exact
+		core::array<u32> TileMark;
+		u32 TileCountX;
+		u32 TileCountY;
+		u32 Generation;
+#endif
 	};
 
 
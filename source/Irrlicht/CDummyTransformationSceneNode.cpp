@@ -20,6 +20,9 @@ CDummyTransformationSceneNode::CDummyTransformationSceneNode(
 	#endif
 
 	setAutomaticCulling(scene::EAC_OFF);
+
+	// the matrix is changed through getRelativeTransformationMatrix()
+	setCompareRelativeTransformation(true);
 }
 
 
@@ -0,0 +1,303 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CInstancedMeshSceneNode.h"
+#include "IVideoDriver.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+//! constructor
+CInstancedMeshSceneNode::CInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position, const core::vector3df& rotation,
+			const core::vector3df& scale)
+: IInstancedMeshSceneNode(parent, mgr, id, position, rotation, scale), Mesh(0),
+	BoxDirty(true), VisibleColored(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CInstancedMeshSceneNode");
+	#endif
+
+	setMesh(mesh);
+}
+
+
+//! destructor
+CInstancedMeshSceneNode::~CInstancedMeshSceneNode()
+{
+	if (Mesh)
+		Mesh->drop();
+}
+
+
+//! culls the instances and registers the node if any is visible
+void CInstancedMeshSceneNode::OnRegisterSceneNode()
+{
+	if (IsVisible && Mesh)
+	{
+		cullInstances();
+
+		if (VisibleTransforms.size())
+		{
+			video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+			int transparentCount = 0;
+			int solidCount = 0;
+
+			for (u32 i=0; i<Materials.size(); ++i)
+			{
+				if ( driver->needsTransparentRenderPass(Materials[i]) )
+					++transparentCount;
+				else
+					++solidCount;
+
+				if (solidCount && transparentCount)
+					break;
+			}
+
+			if (solidCount)
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+			if (transparentCount)
+				SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+		}
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+}
+
+
+//! fills the visible instance lists
+/** The frustum is transformed into node space once. Each instance box is
+then tested against the planes with its corner closest to the inside. */
+void CInstancedMeshSceneNode::cullInstances()
+{
+	updateBoxes();
+
+	VisibleTransforms.set_used(0);
+	VisibleColors.set_used(0);
+	VisibleColored = false;
+
+	const ICameraSceneNode* cam = SceneManager->getActiveCamera();
+	const bool cull = cam && getAutomaticCulling() != EAC_OFF;
+
+	SViewFrustum frust;
+	if (cull)
+	{
+		frust = *cam->getViewFrustum();
+		frust.transform(core::matrix4(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE));
+	}
+
+	for (u32 i=0; i<Transforms.size(); ++i)
+	{
+		if (cull)
+		{
+			const core::aabbox3d<f32>& box = InstanceBoxes[i];
+			bool outside = false;
+			for (u32 p=0; p<SViewFrustum::VF_PLANE_COUNT && !outside; ++p)
+			{
+				const core::plane3d<f32>& plane = frust.planes[p];
+				const core::vector3df corner(
+					plane.Normal.X > 0.f ? box.MinEdge.X : box.MaxEdge.X,
+					plane.Normal.Y > 0.f ? box.MinEdge.Y : box.MaxEdge.Y,
+					plane.Normal.Z > 0.f ? box.MinEdge.Z : box.MaxEdge.Z);
+				outside = plane.Normal.dotProduct(corner) + plane.D > core::ROUNDING_ERROR_f32;
+			}
+			if (outside)
+				continue;
+		}
+
+		VisibleTransforms.push_back(AbsoluteTransformation * Transforms[i]);
+		VisibleColors.push_back(Colors[i]);
+		VisibleColored |= Colors[i].color != 0xffffffff;
+	}
+}
+
+
+//! renders the visible instances
+void CInstancedMeshSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	if (!Mesh || !driver || VisibleTransforms.empty())
+		return;
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+
+	for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+	{
+		scene::IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+		if (mb && i < Materials.size())
+		{
+			const video::SMaterial& material = Materials[i];
+
+			// only render transparent buffer if this is the transparent render pass
+			// and solid only in solid pass
+			if (driver->needsTransparentRenderPass(material) == isTransparentPass)
+			{
+				driver->setMaterial(material);
+				driver->drawMeshBufferInstanced(mb, VisibleTransforms, VisibleColored ? &VisibleColors : 0);
+			}
+		}
+	}
+
+	// for debug purposes only:
+	if (DebugDataVisible & scene::EDS_BBOX && !isTransparentPass)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		m.AntiAliasing=0;
+		driver->setMaterial(m);
+		driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+		driver->draw3DBox(getBoundingBox(), video::SColor(255,255,255,255));
+	}
+}
+
+
+//! recalculates the instance boxes and the node box if instances or the mesh changed
+void CInstancedMeshSceneNode::updateBoxes() const
+{
+	if (Mesh && !(MeshBox == Mesh->getBoundingBox()))
+	{
+		MeshBox = Mesh->getBoundingBox();
+		BoxDirty = true;
+	}
+
+	if (!BoxDirty)
+		return;
+
+	InstanceBoxes.set_used(Transforms.size());
+	for (u32 i=0; i<Transforms.size(); ++i)
+	{
+		InstanceBoxes[i] = MeshBox;
+		Transforms[i].transformBoxEx(InstanceBoxes[i]);
+
+		if (i)
+			Box.addInternalBox(InstanceBoxes[i]);
+		else
+			Box = InstanceBoxes[i];
+	}
+
+	if (Transforms.empty())
+		Box.reset(0.f, 0.f, 0.f);
+
+	BoxDirty = false;
+}
+
+
+//! returns the axis aligned bounding box of all instances
+const core::aabbox3d<f32>& CInstancedMeshSceneNode::getBoundingBox() const
+{
+	updateBoxes();
+	return Box;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CInstancedMeshSceneNode::getMaterial(u32 i)
+{
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CInstancedMeshSceneNode::getMaterialCount() const
+{
+	return Materials.size();
+}
+
+
+//! Sets a new mesh
+void CInstancedMeshSceneNode::setMesh(IMesh* mesh)
+{
+	if (mesh)
+	{
+		mesh->grab();
+		if (Mesh)
+			Mesh->drop();
+
+		Mesh = mesh;
+		copyMaterials();
+		BoxDirty = true;
+	}
+}
+
+
+//! Adds an instance
+u32 CInstancedMeshSceneNode::addInstance(const core::matrix4& transform, video::SColor color)
+{
+	Transforms.push_back(transform);
+	Colors.push_back(color);
+	BoxDirty = true;
+
+	return Transforms.size() - 1;
+}
+
+
+//! Removes an instance
+void CInstancedMeshSceneNode::removeInstance(u32 index)
+{
+	if (index >= Transforms.size())
+		return;
+
+	Transforms.erase(index);
+	Colors.erase(index);
+	BoxDirty = true;
+}
+
+
+//! Removes all instances
+void CInstancedMeshSceneNode::clearInstances()
+{
+	Transforms.clear();
+	Colors.clear();
+	VisibleTransforms.clear();
+	VisibleColors.clear();
+	BoxDirty = true;
+}
+
+
+//! Sets the transformation of an instance relative to the node
+void CInstancedMeshSceneNode::setInstanceTransform(u32 index, const core::matrix4& transform)
+{
+	if (index >= Transforms.size())
+		return;
+
+	Transforms[index] = transform;
+	BoxDirty = true;
+}
+
+
+void CInstancedMeshSceneNode::copyMaterials()
+{
+	Materials.clear();
+
+	if (Mesh)
+	{
+		video::SMaterial mat;
+
+		for (u32 i=0; i<Mesh->getMeshBufferCount(); ++i)
+		{
+			IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+			if (mb)
+				mat = mb->getMaterial();
+
+			Materials.push_back(mat);
+		}
+	}
+}
+
+
+} // end namespace scene
+} // end namespace irr
@@ -0,0 +1,112 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_INSTANCED_MESH_SCENE_NODE_H_INCLUDED
+#define IRR_C_INSTANCED_MESH_SCENE_NODE_H_INCLUDED
+
+#include "IInstancedMeshSceneNode.h"
+#include "IMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	class CInstancedMeshSceneNode : public IInstancedMeshSceneNode
+	{
+	public:
+
+		//! constructor
+		CInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f));
+
+		//! destructor
+		virtual ~CInstancedMeshSceneNode();
+
+		//! culls the instances and registers the node if any is visible
+		virtual void OnRegisterSceneNode() IRR_OVERRIDE;
+
+		//! renders the visible instances
+		virtual void render() IRR_OVERRIDE;
+
+		//! returns the axis aligned bounding box of all instances
+		virtual const core::aabbox3d<f32>& getBoundingBox() const IRR_OVERRIDE;
+
+		//! returns the material based on the zero based index i.
+		virtual video::SMaterial& getMaterial(u32 i) IRR_OVERRIDE;
+
+		//! returns amount of materials used by this scene node.
+		virtual u32 getMaterialCount() const IRR_OVERRIDE;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const IRR_OVERRIDE { return ESNT_INSTANCED_MESH; }
+
+		//! Sets a new mesh
+		virtual void setMesh(IMesh* mesh) IRR_OVERRIDE;
+
+		//! Returns the current mesh
+		virtual IMesh* getMesh(void) IRR_OVERRIDE { return Mesh; }
+
+		//! Adds an instance
+		virtual u32 addInstance(const core::matrix4& transform, video::SColor color=video::SColor(0xffffffff)) IRR_OVERRIDE;
+
+		//! Removes an instance
+		virtual void removeInstance(u32 index) IRR_OVERRIDE;
+
+		//! Removes all instances
+		virtual void clearInstances() IRR_OVERRIDE;
+
+		//! Get the amount of instances
+		virtual u32 getInstanceCount() const IRR_OVERRIDE { return Transforms.size(); }
+
+		//! Sets the transformation of an instance relative to the node
+		virtual void setInstanceTransform(u32 index, const core::matrix4& transform) IRR_OVERRIDE;
+
+		//! Get the transformation of an instance relative to the node
+		virtual const core::matrix4& getInstanceTransform(u32 index) const IRR_OVERRIDE { return Transforms[index]; }
+
+		//! Sets the color of an instance
+		virtual void setInstanceColor(u32 index, video::SColor color) IRR_OVERRIDE { if (index < Colors.size()) Colors[index] = color; }
+
+		//! Get the color of an instance
+		virtual video::SColor getInstanceColor(u32 index) const IRR_OVERRIDE { return Colors[index]; }
+
+		//! Get the amount of instances which passed culling in the last frame
+		virtual u32 getVisibleInstanceCount() const IRR_OVERRIDE { return VisibleTransforms.size(); }
+
+	protected:
+
+		void copyMaterials();
+
+		//! recalculates the instance boxes and the node box if instances or the mesh changed
+		void updateBoxes() const;
+
+		//! fills the visible instance lists
+		void cullInstances();
+
+		core::array<video::SMaterial> Materials;
+		IMesh* Mesh;
+
+		// instances, relative to the node
+		core::array<core::matrix4> Transforms;
+		core::array<video::SColor> Colors;
+
+		// bounding boxes of the instances in node space and their union
+		mutable core::array<core::aabbox3d<f32> > InstanceBoxes;
+		mutable core::aabbox3d<f32> Box;
+		mutable core::aabbox3d<f32> MeshBox;
+		mutable bool BoxDirty;
+
+		// result of the last culling, in world space
+		core::array<core::matrix4> VisibleTransforms;
+		core::array<video::SColor> VisibleColors;
+		bool VisibleColored;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
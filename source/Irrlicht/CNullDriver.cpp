@@ -94,6 +94,9 @@ CNullDriver::CNullDriver(io::IFileSystem* io, const core::dimension2d<u32>& scre
 	setDebugName("CNullDriver");
 	#endif
 
+	MaterialChanges[0] = MaterialChanges[1] = 0;
+	MaterialChangesLastFrame[0] = MaterialChangesLastFrame[1] = 0;
+
 	DriverAttributes = new io::CAttributes();
 	DriverAttributes->addInt("MaxTextures", _IRR_MATERIAL_MAX_TEXTURES_);
 	DriverAttributes->addInt("MaxSupportedTextures", _IRR_MATERIAL_MAX_TEXTURES_);
@@ -320,12 +323,15 @@ void CNullDriver::deleteAllTextures()
 bool CNullDriver::beginScene(u16 clearFlag, SColor clearColor, f32 clearDepth, u8 clearStencil, const SExposedVideoData& videoData, core::rect<s32>* sourceRect)
 {
 	PrimitivesDrawn = 0;
+	MaterialChanges[0] = MaterialChanges[1] = 0;
 	return true;
 }
 
 bool CNullDriver::endScene()
 {
 	FPSCounter.registerFrame(os::Timer::getRealTime(), PrimitivesDrawn);
+	MaterialChangesLastFrame[0] = MaterialChanges[0];
+	MaterialChangesLastFrame[1] = MaterialChanges[1];
 	updateAllHardwareBuffers();
 	updateAllOcclusionQueries();
 	return true;
@@ -1043,6 +1049,13 @@ u32 CNullDriver::getPrimitiveCountDrawn( u32 param ) const
 }
 
 
+//! returns amount of setMaterial calls which changed render states in the last frame.
+u32 CNullDriver::getMaterialChangeCount( bool skipped ) const
+{
+	return MaterialChangesLastFrame[skipped ? 1 : 0];
+}
+
+
 
 //! Sets the dynamic ambient light color. The default color is
 //! (0,0,0,0) which means it is dark.
@@ -1772,6 +1785,46 @@ void CNullDriver::drawMeshBuffer(const scene::IMeshBuffer* mb)
 }
 
 
+//! Draws a mesh buffer once for every transformation
+void CNullDriver::drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+	const core::array<core::matrix4>& transforms, const core::array<SColor>* colors)
+{
+	if (!mb || transforms.empty())
+		return;
+
+	const core::matrix4 world = getTransform(ETS_WORLD);
+	const u32 vertexCount = mb->getVertexCount();
+	const u32 pitch = getVertexPitchFromType(mb->getVertexType());
+
+	for (u32 i=0; i<transforms.size(); ++i)
+	{
+		setTransform(ETS_WORLD, transforms[i]);
+
+		if (!colors || (*colors)[i].color == 0xffffffff)
+		{
+			drawMeshBuffer(mb);
+			continue;
+		}
+
+		// all vertex types start with the members of S3DVertex
+		InstanceVertices.set_used(vertexCount*pitch);
+		memcpy(InstanceVertices.pointer(), mb->getVertices(), vertexCount*pitch);
+
+		const SColor c = (*colors)[i];
+		for (u32 v=0; v<vertexCount; ++v)
+		{
+			SColor& vc = ((S3DVertex*)(InstanceVertices.pointer() + v*pitch))->Color;
+			vc.set(vc.getAlpha()*c.getAlpha()/255, vc.getRed()*c.getRed()/255,
+				vc.getGreen()*c.getGreen()/255, vc.getBlue()*c.getBlue()/255);
+		}
+
+		drawVertexPrimitiveList(InstanceVertices.const_pointer(), vertexCount, mb->getIndices(), mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	}
+
+	setTransform(ETS_WORLD, world);
+}
+
+
 //! Draws the normals of a mesh buffer
 void CNullDriver::drawMeshBufferNormals(const scene::IMeshBuffer* mb, f32 length, SColor color)
 {
@@ -253,6 +253,9 @@ namespace video
 		//! very useful method for statistics.
 		virtual u32 getPrimitiveCountDrawn( u32 param = 0 ) const IRR_OVERRIDE;
 
+		//! returns amount of setMaterial calls which changed render states in the last frame.
+		virtual u32 getMaterialChangeCount( bool skipped = false ) const IRR_OVERRIDE;
+
 		//! deletes all dynamic lights there are
 		virtual void deleteAllDynamicLights() IRR_OVERRIDE;
 
@@ -378,6 +381,11 @@ namespace video
 		//! Draws a mesh buffer
 		virtual void drawMeshBuffer(const scene::IMeshBuffer* mb) IRR_OVERRIDE;
 
+		//! Draws a mesh buffer once for every transformation
+		virtual void drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+			const core::array<core::matrix4>& transforms,
+			const core::array<SColor>* colors=0) IRR_OVERRIDE;
+
 		//! Draws the normals of a mesh buffer
 		virtual void drawMeshBufferNormals(const scene::IMeshBuffer* mb, f32 length=10.f,
 			SColor color=0xffffffff) IRR_OVERRIDE;
@@ -880,6 +888,13 @@ namespace video
 		u32 PrimitivesDrawn;
 		u32 MinVertexCountForVBO;
 
+		//! setMaterial calls of the current and the last frame. [0] applied, [1] skipped
+		u32 MaterialChanges[2];
+		u32 MaterialChangesLastFrame[2];
+
+		//! copy of the vertices of an instance with color in drawMeshBufferInstanced
+		core::array<u8> InstanceVertices;
+
 		u32 TextureCreationFlags;
 
 		f32 FogStart;
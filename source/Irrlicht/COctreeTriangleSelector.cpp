@@ -155,7 +155,7 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 	if (SceneNode && useNodeTransform)
 	{
-		if ( SceneNode->getAbsoluteTransformation().getInverse(mat) )
+		if ( getInverseNodeTransformation(mat) )
 			mat.transformBoxEx(invbox);
 		else
 			// TODO: case not handled well, we can only return all triangles
@@ -248,8 +248,8 @@ void COctreeTriangleSelector::getTriangles(core::triangle3df* triangles, s32 arr
 	core::vector3df vectStartInv ( line.start ), vectEndInv ( line.end );
 	if (SceneNode && useNodeTransform)
 	{
-		mat = SceneNode->getAbsoluteTransformation();
-		mat.makeInverse();
+		if ( !getInverseNodeTransformation(mat) )
+			mat = SceneNode->getAbsoluteTransformation();
 		mat.transformVect(vectStartInv, line.start);
 		mat.transformVect(vectEndInv, line.end);
 	}
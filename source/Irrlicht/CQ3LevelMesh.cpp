@@ -38,6 +38,10 @@ CQ3LevelMesh::CQ3LevelMesh(io::IFileSystem* fs, scene::ISceneManager* smgr,
 	IReferenceCounted::setDebugName("CQ3LevelMesh");
 	#endif
 
+	VisData.numOfClusters = 0;
+	VisData.bytesPerCluster = 0;
+	VisData.pBitsets = 0;
+
 	for ( s32 i = 0; i!= E_Q3_MESH_SIZE; ++i )
 	{
 		Mesh[i] = 0;
@@ -59,6 +63,7 @@ CQ3LevelMesh::CQ3LevelMesh(io::IFileSystem* fs, scene::ISceneManager* smgr,
 CQ3LevelMesh::~CQ3LevelMesh()
 {
 	cleanLoader ();
+	cleanVisData();
 
 	if (Driver)
 		Driver->drop();
@@ -176,10 +181,6 @@ void CQ3LevelMesh::cleanLoader ()
 	delete [] Vertices; Vertices = 0;
 	delete [] Faces; Faces = 0;
 	delete [] Models; Models = 0;
-	delete [] Planes; Planes = 0;
-	delete [] Nodes; Nodes = 0;
-	delete [] Leafs; Leafs = 0;
-	delete [] LeafFaces; LeafFaces = 0;
 	delete [] MeshVerts; MeshVerts = 0;
 	delete [] Brushes; Brushes = 0;
 
@@ -187,6 +188,22 @@ void CQ3LevelMesh::cleanLoader ()
 	Tex.clear();
 }
 
+/*!
+	the bsp tree and the vis data are kept after loading
+*/
+void CQ3LevelMesh::cleanVisData()
+{
+	delete [] Planes; Planes = 0; NumPlanes = 0;
+	delete [] Nodes; Nodes = 0; NumNodes = 0;
+	delete [] Leafs; Leafs = 0; NumLeafs = 0;
+	delete [] LeafFaces; LeafFaces = 0; NumLeafFaces = 0;
+	delete [] VisData.pBitsets; VisData.pBitsets = 0;
+	VisData.numOfClusters = 0;
+	VisData.bytesPerCluster = 0;
+
+	FaceIndices.clear();
+}
+
 //! returns the amount of frames in milliseconds. If the amount is 1, it is a static (=non animated) mesh.
 u32 CQ3LevelMesh::getFrameCount() const
 {
@@ -314,7 +331,22 @@ void CQ3LevelMesh::loadFaces(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadPlanes(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumPlanes = l->length / sizeof(tBSPPlane);
+	if ( !NumPlanes )
+		return;
+	Planes = new tBSPPlane[NumPlanes];
+
+	file->seek(l->offset);
+	file->read(Planes, NumPlanes * sizeof(tBSPPlane));
+
+	if ( LoadParam.swapHeader )
+	for (s32 i=0;i<NumPlanes;i++)
+	{
+		Planes[i].vNormal[0] = os::Byteswap::byteswap(Planes[i].vNormal[0]);
+		Planes[i].vNormal[1] = os::Byteswap::byteswap(Planes[i].vNormal[1]);
+		Planes[i].vNormal[2] = os::Byteswap::byteswap(Planes[i].vNormal[2]);
+		Planes[i].d = os::Byteswap::byteswap(Planes[i].d);
+	}
 }
 
 
@@ -322,7 +354,26 @@ void CQ3LevelMesh::loadPlanes(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadNodes(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumNodes = l->length / sizeof(tBSPNode);
+	if ( !NumNodes )
+		return;
+	Nodes = new tBSPNode[NumNodes];
+
+	file->seek(l->offset);
+	file->read(Nodes, NumNodes * sizeof(tBSPNode));
+
+	if ( LoadParam.swapHeader )
+	for (s32 i=0;i<NumNodes;i++)
+	{
+		Nodes[i].plane = os::Byteswap::byteswap(Nodes[i].plane);
+		Nodes[i].front = os::Byteswap::byteswap(Nodes[i].front);
+		Nodes[i].back = os::Byteswap::byteswap(Nodes[i].back);
+		for (u32 k=0; k<3; ++k)
+		{
+			Nodes[i].mins[k] = os::Byteswap::byteswap(Nodes[i].mins[k]);
+			Nodes[i].maxs[k] = os::Byteswap::byteswap(Nodes[i].maxs[k]);
+		}
+	}
 }
 
 
@@ -330,7 +381,29 @@ void CQ3LevelMesh::loadNodes(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadLeafs(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumLeafs = l->length / sizeof(tBSPLeaf);
+	if ( !NumLeafs )
+		return;
+	Leafs = new tBSPLeaf[NumLeafs];
+
+	file->seek(l->offset);
+	file->read(Leafs, NumLeafs * sizeof(tBSPLeaf));
+
+	if ( LoadParam.swapHeader )
+	for (s32 i=0;i<NumLeafs;i++)
+	{
+		Leafs[i].cluster = os::Byteswap::byteswap(Leafs[i].cluster);
+		Leafs[i].area = os::Byteswap::byteswap(Leafs[i].area);
+		for (u32 k=0; k<3; ++k)
+		{
+			Leafs[i].mins[k] = os::Byteswap::byteswap(Leafs[i].mins[k]);
+			Leafs[i].maxs[k] = os::Byteswap::byteswap(Leafs[i].maxs[k]);
+		}
+		Leafs[i].leafface = os::Byteswap::byteswap(Leafs[i].leafface);
+		Leafs[i].numOfLeafFaces = os::Byteswap::byteswap(Leafs[i].numOfLeafFaces);
+		Leafs[i].leafBrush = os::Byteswap::byteswap(Leafs[i].leafBrush);
+		Leafs[i].numOfLeafBrushes = os::Byteswap::byteswap(Leafs[i].numOfLeafBrushes);
+	}
 }
 
 
@@ -338,15 +411,54 @@ void CQ3LevelMesh::loadLeafs(tBSPLump* l, io::IReadFile* file)
 */
 void CQ3LevelMesh::loadLeafFaces(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	NumLeafFaces = l->length / sizeof(s32);
+	if ( !NumLeafFaces )
+		return;
+	LeafFaces = new s32[NumLeafFaces];
+
+	file->seek(l->offset);
+	file->read(LeafFaces, NumLeafFaces * sizeof(s32));
+
+	if ( LoadParam.swapHeader )
+	{
+		for (s32 i=0;i<NumLeafFaces;i++)
+			LeafFaces[i] = os::Byteswap::byteswap(LeafFaces[i]);
+	}
 }
 
 
 /*!
+	the vis data is a bitset for each cluster with the clusters visible from it
 */
 void CQ3LevelMesh::loadVisData(tBSPLump* l, io::IReadFile* file)
 {
-	// ignore
+	if ( l->length < 8 )
+		return;
+
+	file->seek(l->offset);
+	file->read(&VisData.numOfClusters, sizeof(s32));
+	file->read(&VisData.bytesPerCluster, sizeof(s32));
+
+	if ( LoadParam.swapHeader )
+	{
+		VisData.numOfClusters = os::Byteswap::byteswap(VisData.numOfClusters);
+		VisData.bytesPerCluster = os::Byteswap::byteswap(VisData.bytesPerCluster);
+	}
+
+	// both counts come from the file, check them before multiplying
+	if ( VisData.numOfClusters <= 0 || VisData.bytesPerCluster <= 0 ||
+		VisData.bytesPerCluster < VisData.numOfClusters / 8 + ( VisData.numOfClusters % 8 ? 1 : 0 ) ||
+		VisData.bytesPerCluster > ( l->length - 8 ) / VisData.numOfClusters )
+	{
+		os::Printer::log("quake3::loadVisData ignoring invalid vis data", LevelName, ELL_WARNING);
+		VisData.numOfClusters = 0;
+		VisData.bytesPerCluster = 0;
+		return;
+	}
+
+	const s32 size = VisData.numOfClusters * VisData.bytesPerCluster;
+	VisData.pBitsets = new c8[size];
+	file->read(VisData.pBitsets, size);
 }
 
 
@@ -964,6 +1076,7 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 				}
 			}
 
+			const u32 firstIndex = buffer->getIndexCount();
 
 			switch(Faces[i].type)
 			{
@@ -1018,6 +1131,19 @@ scene::SMesh** CQ3LevelMesh::buildMesh(s32 num)
 					break;
 
 			} // end switch
+
+			// remember the indices of the main level geometry for the vis data
+			if ( 0 == num && item[g].index == E_Q3_MESH_GEOMETRY && i < (s32) FaceIndices.size() )
+			{
+				const core::array<IMeshBuffer*>& buffers = newmesh[E_Q3_MESH_GEOMETRY]->MeshBuffers;
+				s32 b = (s32) buffers.size() - 1;
+				while ( b >= 0 && buffers[b] != buffer )
+					--b;
+
+				FaceIndices[i].buffer = b;
+				FaceIndices[i].first = firstIndex;
+				FaceIndices[i].count = buffer->getIndexCount() - firstIndex;
+			}
 		}
 	}
 
@@ -1054,6 +1180,14 @@ void CQ3LevelMesh::constructMesh()
 
 	s32 i, j;
 
+	FaceIndices.set_used(NumFaces);
+	for (i = 0; i < NumFaces; i++)
+	{
+		FaceIndices[i].buffer = -1;
+		FaceIndices[i].first = 0;
+		FaceIndices[i].count = 0;
+	}
+
 	// First the main level
 	SMesh **tmp = buildMesh(0);
 
@@ -1491,6 +1625,141 @@ IMesh* CQ3LevelMesh::getBrushEntityMesh(quake3::IEntity &ent) const
 }
 
 
+//! returns the amount of visibility clusters
+s32 CQ3LevelMesh::getClusterCount() const
+{
+	return VisData.pBitsets ? VisData.numOfClusters : 0;
+}
+
+
+//! returns the cluster containing a position
+s32 CQ3LevelMesh::getClusterFromPosition(const core::vector3df& pos) const
+{
+	if ( !Nodes || !Planes || !Leafs )
+		return -1;
+
+	// back to the quake3 coordinate system
+	const f32 p[3] = { pos.X, pos.Z, pos.Y };
+
+	s32 index = 0;
+	s32 depth = 0;
+	while ( index >= 0 )
+	{
+		if ( index >= NumNodes || ++depth > NumNodes )
+			return -1;
+
+		const tBSPNode& node = Nodes[index];
+		if ( node.plane < 0 || node.plane >= NumPlanes )
+			return -1;
+
+		const tBSPPlane& plane = Planes[node.plane];
+		const f32 dist = plane.vNormal[0] * p[0] + plane.vNormal[1] * p[1] +
+			plane.vNormal[2] * p[2] - plane.d;
+
+		index = dist >= 0.f ? node.front : node.back;
+	}
+
+	const s32 leaf = -(index + 1);
+	if ( leaf >= NumLeafs )
+		return -1;
+
+	return Leafs[leaf].cluster;
+}
+
+
+//! returns if cluster to is potentially visible from cluster from
+bool CQ3LevelMesh::isClusterVisible(s32 from, s32 to) const
+{
+	if ( !VisData.pBitsets || from < 0 || from >= VisData.numOfClusters )
+		return true;
+
+	if ( to < 0 || to >= VisData.numOfClusters )
+		return false;
+
+	const u8 bits = (u8) VisData.pBitsets[from * VisData.bytesPerCluster + (to >> 3)];
+	return ( bits & ( 1 << ( to & 7 ) ) ) != 0;
+}
+
+
+//! appends the indices of a face to the list of its mesh buffer
+static inline bool appendFaceIndices(const IMesh* mesh, s32 buffer, u32 first, u32 count,
+	core::array<u16>* indices, u32 listCount)
+{
+	if ( buffer < 0 || (u32) buffer >= listCount || 0 == count )
+		return false;
+
+	const u16* source = mesh->getMeshBuffer(buffer)->getIndices() + first;
+	core::array<u16>& list = indices[buffer];
+	for ( u32 i = 0; i != count; ++i )
+		list.push_back(source[i]);
+
+	return true;
+}
+
+
+//! collects the indices of the potentially visible level geometry
+u32 CQ3LevelMesh::getPotentiallyVisibleIndices(s32 cluster, core::array<u16>* indices, u32 count) const
+{
+	u32 i;
+	for ( i = 0; i != count; ++i )
+		indices[i].set_used(0);
+
+	const IMesh* mesh = Mesh[E_Q3_MESH_GEOMETRY];
+	if ( !mesh )
+		return 0;
+
+	if ( count > mesh->getMeshBufferCount() )
+		count = mesh->getMeshBufferCount();
+
+	u32 faces = 0;
+
+	// without a cluster everything is visible, in the order of the mesh buffers
+	if ( cluster < 0 || !VisData.pBitsets || !Leafs || !LeafFaces )
+	{
+		for ( i = 0; i != FaceIndices.size(); ++i )
+		{
+			const SFaceIndices& f = FaceIndices[i];
+			if ( appendFaceIndices(mesh, f.buffer, f.first, f.count, indices, count) )
+				faces += 1;
+		}
+		return faces;
+	}
+
+	// faces shared by leafs are only added once. Kept local, the level
+	// scene nodes sharing this mesh may call this from several threads
+	core::array<u8> added;
+	added.set_used(FaceIndices.size());
+	if ( added.size() )
+		memset(added.pointer(), 0, added.size());
+
+	for ( s32 l = 0; l < NumLeafs; ++l )
+	{
+		const tBSPLeaf& leaf = Leafs[l];
+		if ( leaf.cluster < 0 || !isClusterVisible(cluster, leaf.cluster) )
+			continue;
+
+		if ( leaf.leafface < 0 || leaf.numOfLeafFaces <= 0 ||
+			leaf.leafface + leaf.numOfLeafFaces > NumLeafFaces )
+			continue;
+
+		for ( s32 k = 0; k != leaf.numOfLeafFaces; ++k )
+		{
+			const s32 face = LeafFaces[leaf.leafface + k];
+			if ( face < 0 || face >= (s32) FaceIndices.size() || added[face] )
+				continue;
+
+			added[face] = 1;
+
+			const SFaceIndices& f = FaceIndices[face];
+			if ( appendFaceIndices(mesh, f.buffer, f.first, f.count, indices, count) )
+				faces += 1;
+		}
+	}
+
+	return faces;
+}
+
+
 /*!
 */
 const IShader * CQ3LevelMesh::getShader(u32 index) const
@@ -1777,7 +2046,19 @@ void CQ3LevelMesh::cleanMeshes()
 	{
 		bool texture0important = ( i == 0 );
 
-		cleanMesh(Mesh[i], texture0important);
+		if ( i == E_Q3_MESH_GEOMETRY )
+		{
+			core::array<s32> remap;
+			cleanMesh(Mesh[i], texture0important, &remap);
+
+			for (u32 f = 0; f < FaceIndices.size(); ++f)
+			{
+				if ( FaceIndices[f].buffer >= 0 )
+					FaceIndices[f].buffer = remap[FaceIndices[f].buffer];
+			}
+		}
+		else
+			cleanMesh(Mesh[i], texture0important);
 	}
 
 	// Then the brush entities
@@ -1787,7 +2068,7 @@ void CQ3LevelMesh::cleanMeshes()
 	}
 }
 
-void CQ3LevelMesh::cleanMesh(SMesh *m, const bool texture0important)
+void CQ3LevelMesh::cleanMesh(SMesh *m, const bool texture0important, core::array<s32>* remap)
 {
 	// delete all buffers without geometry in it.
 	u32 run = 0;
@@ -1815,6 +2096,10 @@ void CQ3LevelMesh::cleanMesh(SMesh *m, const bool texture0important)
 	s32 blockstart = -1;
 	s32 blockcount = 0;
 
+	// new index of each buffer, -1 for removed ones
+	if ( remap )
+		remap->set_used(0);
+
 	while( i < m->MeshBuffers.size())
 	{
 		run += 1;
@@ -1836,6 +2121,8 @@ void CQ3LevelMesh::cleanMesh(SMesh *m, const bool texture0important)
 			// delete Meshbuffer
 			i -= 1;
 			remove += 1;
+			if ( remap )
+				remap->push_back(-1);
 			b->drop();
 			m->MeshBuffers.erase(i);
 		}
@@ -1855,6 +2142,8 @@ void CQ3LevelMesh::cleanMesh(SMesh *m, const bool texture0important)
 				}
 				blockstart = -1;
 			}
+			if ( remap )
+				remap->push_back(i);
 			i += 1;
 		}
 	}
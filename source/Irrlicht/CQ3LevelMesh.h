@@ -89,6 +89,19 @@ namespace scene
 		//! returns the requested brush entity
 		virtual IMesh* getBrushEntityMesh(quake3::IEntity &ent) const IRR_OVERRIDE;
 
+		//! returns the amount of visibility clusters
+		virtual s32 getClusterCount() const IRR_OVERRIDE;
+
+		//! returns the cluster containing a position
+		virtual s32 getClusterFromPosition(const core::vector3df& pos) const IRR_OVERRIDE;
+
+		//! returns if cluster to is potentially visible from cluster from
+		virtual bool isClusterVisible(s32 from, s32 to) const IRR_OVERRIDE;
+
+		//! collects the indices of the potentially visible level geometry
+		virtual u32 getPotentiallyVisibleIndices(s32 cluster,
+			core::array<u16>* indices, u32 count) const IRR_OVERRIDE;
+
 		//Link to held meshes? ...
 
 
@@ -404,6 +417,17 @@ namespace scene
 		s32 *LeafFaces;
 		s32 NumLeafFaces;
 
+		tBSPVisData VisData;
+
+		// where the faces of the main level ended up in the geometry mesh
+		struct SFaceIndices
+		{
+			s32 buffer;	// -1 if not part of the geometry
+			u32 first;
+			u32 count;
+		};
+		core::array<SFaceIndices> FaceIndices;
+
 		s32 *MeshVerts;           // The vertex offsets for a mesh
 		s32 NumMeshVerts;
 
@@ -474,8 +498,10 @@ namespace scene
 		};
 
 		void cleanMeshes();
-		void cleanMesh(SMesh *m, const bool texture0important = false);
+		void cleanMesh(SMesh *m, const bool texture0important = false,
+			core::array<s32>* remap = 0);
 		void cleanLoader ();
+		void cleanVisData();
 		void calcBoundingBoxes();
 		c8 buf[128];
 		f32 FramesPerSecond;
@@ -0,0 +1,196 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+
+#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
+
+#include "CQ3LevelSceneNode.h"
+#include "ISceneManager.h"
+#include "IVideoDriver.h"
+#include "ICameraSceneNode.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+//! constructor
+CQ3LevelSceneNode::CQ3LevelSceneNode(IQ3LevelMesh* mesh, ISceneNode* parent,
+		ISceneManager* mgr, s32 id)
+	: ISceneNode(parent, mgr, id), LevelMesh(mesh), Mesh(0),
+	Cluster(-1), PassCount(0), Valid(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CQ3LevelSceneNode");
+	#endif
+
+	if (!LevelMesh)
+		return;
+
+	LevelMesh->grab();
+
+	Mesh = LevelMesh->getMesh(quake3::E_Q3_MESH_GEOMETRY);
+	if (!Mesh)
+		return;
+
+	Mesh->grab();
+	Box = Mesh->getBoundingBox();
+
+	const u32 count = Mesh->getMeshBufferCount();
+	Materials.reallocate(count);
+	Indices.reallocate(count);
+	for (u32 i=0; i<count; ++i)
+	{
+		Materials.push_back(Mesh->getMeshBuffer(i)->getMaterial());
+		Indices.push_back(core::array<u16>());
+	}
+}
+
+
+//! destructor
+CQ3LevelSceneNode::~CQ3LevelSceneNode()
+{
+	if (Mesh)
+		Mesh->drop();
+	if (LevelMesh)
+		LevelMesh->drop();
+}
+
+
+void CQ3LevelSceneNode::OnRegisterSceneNode()
+{
+	if (!IsVisible || !Mesh)
+		return;
+
+	// cluster of the camera, in the coordinate system of the level
+	s32 cluster = -1;
+	const ICameraSceneNode* camera = SceneManager->getActiveCamera();
+	if (camera)
+	{
+		core::vector3df pos = camera->getAbsolutePosition();
+		if (!AbsoluteTransformation.isIdentity())
+		{
+			core::matrix4 invTrans(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE);
+			invTrans.transformVect(pos);
+		}
+		cluster = LevelMesh->getClusterFromPosition(pos);
+	}
+
+	// the potentially visible set only changes with the cluster
+	if (!Valid || cluster != Cluster)
+	{
+		LevelMesh->getPotentiallyVisibleIndices(cluster,
+			Indices.pointer(), Indices.size());
+		Cluster = cluster;
+		Valid = true;
+	}
+
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	PassCount = 0;
+	u32 transparentCount = 0;
+	u32 solidCount = 0;
+
+	// count transparent and solid materials with visible faces
+	for (u32 i=0; i<Materials.size(); ++i)
+	{
+		if (Indices[i].empty())
+			continue;
+
+		if (driver->needsTransparentRenderPass(Materials[i]))
+			++transparentCount;
+		else
+			++solidCount;
+
+		if (solidCount && transparentCount)
+			break;
+	}
+
+	if (solidCount)
+		SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+
+	if (transparentCount)
+		SceneManager->registerNodeForRendering(this, scene::ESNRP_TRANSPARENT);
+
+	ISceneNode::OnRegisterSceneNode();
+}
+
+
+//! renders the node.
+void CQ3LevelSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	if (!Mesh || !driver)
+		return;
+
+	const bool isTransparentPass =
+		SceneManager->getSceneNodeRenderPass() == scene::ESNRP_TRANSPARENT;
+	++PassCount;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	for (u32 i=0; i<Materials.size(); ++i)
+	{
+		const core::array<u16>& indices = Indices[i];
+		if (indices.empty())
+			continue;
+
+		const bool transparent = driver->needsTransparentRenderPass(Materials[i]);
+
+		// only render transparent buffer if this is the transparent render pass
+		// and solid only in solid pass
+		if (transparent == isTransparentPass)
+		{
+			const IMeshBuffer* mb = Mesh->getMeshBuffer(i);
+			driver->setMaterial(Materials[i]);
+			driver->drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(),
+				indices.const_pointer(), indices.size() / 3,
+				mb->getVertexType(), scene::EPT_TRIANGLES, video::EIT_16BIT);
+		}
+	}
+
+	// for debug purposes only
+	if (DebugDataVisible && PassCount==1)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		driver->setMaterial(m);
+
+		if (DebugDataVisible & scene::EDS_BBOX)
+			driver->draw3DBox(Box, video::SColor(255,255,255,255));
+	}
+}
+
+
+//! returns the axis aligned bounding box of this node
+const core::aabbox3d<f32>& CQ3LevelSceneNode::getBoundingBox() const
+{
+	return Box;
+}
+
+
+//! returns the material based on the zero based index i.
+video::SMaterial& CQ3LevelSceneNode::getMaterial(u32 i)
+{
+	if (i >= Materials.size())
+		return ISceneNode::getMaterial(i);
+
+	return Materials[i];
+}
+
+
+//! returns amount of materials used by this scene node.
+u32 CQ3LevelSceneNode::getMaterialCount() const
+{
+	return Materials.size();
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_BSP_LOADER_
@@ -0,0 +1,66 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_Q3_LEVEL_SCENE_NODE_H_INCLUDED
+#define IRR_C_Q3_LEVEL_SCENE_NODE_H_INCLUDED
+
+#include "ISceneNode.h"
+#include "IQ3LevelMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+	//! Scene node rendering the geometry of a quake3 level with its vis data
+	/** Finds the cluster of the active camera each frame and only draws
+	the faces of the leafs in potentially visible clusters. Outside of the
+	level or without vis data everything is drawn. */
+	class CQ3LevelSceneNode : public ISceneNode
+	{
+	public:
+
+		//! constructor
+		CQ3LevelSceneNode(IQ3LevelMesh* mesh, ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! destructor
+		virtual ~CQ3LevelSceneNode();
+
+		//! finds the cluster of the camera and registers the node
+		virtual void OnRegisterSceneNode() IRR_OVERRIDE;
+
+		//! renders the potentially visible faces
+		virtual void render() IRR_OVERRIDE;
+
+		//! returns the axis aligned bounding box of the level geometry
+		virtual const core::aabbox3d<f32>& getBoundingBox() const IRR_OVERRIDE;
+
+		//! returns the material based on the zero based index i
+		virtual video::SMaterial& getMaterial(u32 i) IRR_OVERRIDE;
+
+		//! returns amount of materials used by this scene node
+		virtual u32 getMaterialCount() const IRR_OVERRIDE;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const IRR_OVERRIDE { return ESNT_Q3LEVEL_SCENE_NODE; }
+
+	private:
+
+		IQ3LevelMesh* LevelMesh;
+		IMesh* Mesh;
+
+		core::array<video::SMaterial> Materials;
+
+		// potentially visible indices for each mesh buffer
+		core::array< core::array<u16> > Indices;
+
+		core::aabbox3d<f32> Box;
+		s32 Cluster;
+		s32 PassCount;
+		bool Valid;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
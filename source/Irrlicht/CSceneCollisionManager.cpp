@@ -7,6 +7,7 @@
 #include "ICameraSceneNode.h"
 #include "ITriangleSelector.h"
 #include "SViewFrustum.h"
+#include "CSceneSpatialIndex.h"
 
 #include "os.h"
 #include "irrMath.h"
@@ -16,9 +17,17 @@ namespace irr
 namespace scene
 {
 
+//! true if the node passes the debug and id filters of picking
+static inline bool isPickCandidate(const ISceneNode* node, s32 bits, bool noDebugObjects)
+{
+	return (noDebugObjects ? !node->isDebugObject() : true) &&
+		(bits==0 || (bits != 0 && (node->getID() & bits)));
+}
+
+
 //! constructor
 CSceneCollisionManager::CSceneCollisionManager(ISceneManager* smanager, video::IVideoDriver* driver)
-: SceneManager(smanager), Driver(driver)
+: SceneManager(smanager), Driver(driver), SpatialIndex(0)
 {
 	#ifdef _DEBUG
 	setDebugName("CSceneCollisionManager");
@@ -37,6 +46,13 @@ CSceneCollisionManager::~CSceneCollisionManager()
 }
 
 
+//! sets the spatial index used for picking, 0 if the scene isn't indexed
+void CSceneCollisionManager::setSpatialIndex(CSceneSpatialIndex* index)
+{
+	SpatialIndex = index;
+}
+
+
 //! Returns the scene node, which is currently visible at the given
 //! screen coordinates, viewed from the currently active camera.
 ISceneNode* CSceneCollisionManager::getSceneNodeFromScreenCoordinatesBB(
@@ -62,6 +78,24 @@ ISceneNode* CSceneCollisionManager::getSceneNodeFromRayBB(
 
 	core::line3d<f32> truncatableRay(ray);
 
+	// only test the nodes in the regions of the scene crossed by the ray
+	if (SpatialIndex && (root == 0 || root == SceneManager->getRootSceneNode()))
+	{
+		SpatialIndex->update();
+		PickedNodes.set_used(0);
+		SpatialIndex->getNodesOnLine(ray, PickedNodes);
+
+		const core::vector3df rayVector = ray.getVector().normalize();
+		for (u32 i = 0; i < PickedNodes.size(); ++i)
+		{
+			ISceneNode* current = PickedNodes[i];
+			if (isPickCandidate(current, idBitMask, noDebugObjects) &&
+				isPickedFromRoot(current, idBitMask, noDebugObjects))
+				pickNodeBB(current, truncatableRay, rayVector, dist, best);
+		}
+		return best;
+	}
+
 	getPickedNodeBB((root==0)?SceneManager->getRootSceneNode():root, truncatableRay,
 		idBitMask, noDebugObjects, dist, best);
 
@@ -84,112 +118,125 @@ void CSceneCollisionManager::getPickedNodeBB(ISceneNode* root,
 
 		if (current->isVisible())
 		{
-			if((noDebugObjects ? !current->isDebugObject() : true) &&
-				(bits==0 || (bits != 0 && (current->getID() & bits))))
-			{
-				// Assume that single-point bounding-boxes are not meant for collision
-				const core::aabbox3df & objectBox = current->getBoundingBox();
-				if ( objectBox.isEmpty() )
-					continue;
-
-				// get world to object space transform
-				core::matrix4 worldToObject;
-				if (!current->getAbsoluteTransformation().getInverse(worldToObject))
-					continue;
-
-				// transform vector from world space to object space
-				core::line3df objectRay(ray);
-				worldToObject.transformVect(objectRay.start);
-				worldToObject.transformVect(objectRay.end);
-
-				// Do the initial intersection test in object space, since the
-				// object space box test is more accurate.
-				if(objectBox.isPointInside(objectRay.start))
-				{
-					// use fast bbox intersection to find distance to hitpoint
-					// algorithm from Kay et al., code from gamedev.net
-					const core::vector3df dir = (objectRay.end-objectRay.start).normalize();
-					const core::vector3df minDist = (objectBox.MinEdge - objectRay.start)/dir;
-					const core::vector3df maxDist = (objectBox.MaxEdge - objectRay.start)/dir;
-					const core::vector3df realMin(core::min_(minDist.X, maxDist.X),core::min_(minDist.Y, maxDist.Y),core::min_(minDist.Z, maxDist.Z));
-					const core::vector3df realMax(core::max_(minDist.X, maxDist.X),core::max_(minDist.Y, maxDist.Y),core::max_(minDist.Z, maxDist.Z));
-
-					const f32 minmax = core::min_(realMax.X, realMax.Y, realMax.Z);
-					// nearest distance to intersection
-					const f32 maxmin = core::max_(realMin.X, realMin.Y, realMin.Z);
-
-					const f32 toIntersectionSq = (maxmin>0?maxmin*maxmin:minmax*minmax);
-					if (toIntersectionSq < outbestdistance)
-					{
-						outbestdistance = toIntersectionSq;
-						outbestnode = current;
-
-						// And we can truncate the ray to stop us hitting further nodes.
-						ray.end = ray.start + (rayVector * sqrtf(toIntersectionSq));
-					}
-				}
-				else
-				if (objectBox.intersectsWithLine(objectRay))
-				{
-					// Now transform into world space, since we need to use world space
-					// scales and distances.
-					core::aabbox3df worldBox(objectBox);
-					current->getAbsoluteTransformation().transformBoxEx(worldBox);
-
-					core::vector3df edges[8];
-					worldBox.getEdges(edges);
-
-					/* We need to check against each of 6 faces, composed of these corners:
-						  /3--------/7
-						 /  |      / |
-						/   |     /  |
-						1---------5  |
-						|   2- - -| -6
-						|  /      |  /
-						|/        | /
-						0---------4/
-
-						Note that we define them as opposite pairs of faces.
-					*/
-					static const s32 faceEdges[6][3] =
-					{
-						{ 0, 1, 5 }, // Front
-						{ 6, 7, 3 }, // Back
-						{ 2, 3, 1 }, // Left
-						{ 4, 5, 7 }, // Right
-						{ 1, 3, 7 }, // Top
-						{ 2, 0, 4 }  // Bottom
-					};
-
-					core::vector3df intersection;
-					core::plane3df facePlane;
-					f32 bestDistToBoxBorder = FLT_MAX;
-					f32 bestToIntersectionSq = FLT_MAX;
+			if (isPickCandidate(current, bits, noDebugObjects) &&
+				!pickNodeBB(current, ray, rayVector, outbestdistance, outbestnode))
+				continue;
+
+			// Only check the children if this node is visible.
+			getPickedNodeBB(current, ray, bits, noDebugObjects, outbestdistance, outbestnode);
+		}
+	}
+}
+
+
+//! tests the bounding box of a single node. Returns false if its children are not picked
+bool CSceneCollisionManager::pickNodeBB(ISceneNode* current,
+		core::line3df& ray, const core::vector3df& rayVector,
+		f32& outbestdistance, ISceneNode*& outbestnode)
+{
+	// Assume that single-point bounding-boxes are not meant for collision
+	const core::aabbox3df & objectBox = current->getBoundingBox();
+	if ( objectBox.isEmpty() )
+		return false;
+
+	// get world to object space transform
+	core::matrix4 worldToObject;
+	if (!current->getAbsoluteTransformation().getInverse(worldToObject))
+		return false;
+
+	// transform vector from world space to object space
+	core::line3df objectRay(ray);
+	worldToObject.transformVect(objectRay.start);
+	worldToObject.transformVect(objectRay.end);
+
+	// Do the initial intersection test in object space, since the
+	// object space box test is more accurate.
+	if(objectBox.isPointInside(objectRay.start))
+	{
+		// use fast bbox intersection to find distance to hitpoint
+		// algorithm from Kay et al., code from gamedev.net
+		const core::vector3df dir = (objectRay.end-objectRay.start).normalize();
+		const core::vector3df minDist = (objectBox.MinEdge - objectRay.start)/dir;
+		const core::vector3df maxDist = (objectBox.MaxEdge - objectRay.start)/dir;
+		const core::vector3df realMin(core::min_(minDist.X, maxDist.X),core::min_(minDist.Y, maxDist.Y),core::min_(minDist.Z, maxDist.Z));
+		const core::vector3df realMax(core::max_(minDist.X, maxDist.X),core::max_(minDist.Y, maxDist.Y),core::max_(minDist.Z, maxDist.Z));
+
+		const f32 minmax = core::min_(realMax.X, realMax.Y, realMax.Z);
+		// nearest distance to intersection
+		const f32 maxmin = core::max_(realMin.X, realMin.Y, realMin.Z);
+
+		const f32 toIntersectionSq = (maxmin>0?maxmin*maxmin:minmax*minmax);
+		if (toIntersectionSq < outbestdistance)
+		{
+			outbestdistance = toIntersectionSq;
+			outbestnode = current;
+
+			// And we can truncate the ray to stop us hitting further nodes.
+			ray.end = ray.start + (rayVector * sqrtf(toIntersectionSq));
+		}
+	}
+	else
+	if (objectBox.intersectsWithLine(objectRay))
+	{
+		// Now transform into world space, since we need to use world space
+		// scales and distances.
+		core::aabbox3df worldBox(objectBox);
+		current->getAbsoluteTransformation().transformBoxEx(worldBox);
+
+		core::vector3df edges[8];
+		worldBox.getEdges(edges);
+
+		/* We need to check against each of 6 faces, composed of these corners:
+			  /3--------/7
+			 /  |      / |
+			/   |     /  |
+			1---------5  |
+			|   2- - -| -6
+			|  /      |  /
+			|/        | /
+			0---------4/
+
+			Note that we define them as opposite pairs of faces.
+		*/
+		static const s32 faceEdges[6][3] =
+		{
+			{ 0, 1, 5 }, // Front
+			{ 6, 7, 3 }, // Back
+			{ 2, 3, 1 }, // Left
+			{ 4, 5, 7 }, // Right
+			{ 1, 3, 7 }, // Top
+			{ 2, 0, 4 }  // Bottom
+		};
+
+		core::vector3df intersection;
+		core::plane3df facePlane;
+		f32 bestDistToBoxBorder = FLT_MAX;
+		f32 bestToIntersectionSq = FLT_MAX;
 
                     for(s32 face = 0; face < 6; ++face)
-					{
-						facePlane.setPlane(edges[faceEdges[face][0]],
-											edges[faceEdges[face][1]],
-											edges[faceEdges[face][2]]);
-
-						// Only consider lines that might be entering through this face, since we
-						// already know that the start point is outside the box.
-						if(facePlane.classifyPointRelation(ray.start) != core::ISREL3D_FRONT)
-							continue;
-
-						// Don't bother using a limited ray, since we already know that it should be long
-						// enough to intersect with the box.
-						if(facePlane.getIntersectionWithLine(ray.start, rayVector, intersection))
-						{
-							const f32 toIntersectionSq = ray.start.getDistanceFromSQ(intersection);
-							if(toIntersectionSq < outbestdistance)
-							{
-								// We have to check that the intersection with this plane is actually
-								// on the box, so need to go back to object space again.
-								worldToObject.transformVect(intersection);
+		{
+			facePlane.setPlane(edges[faceEdges[face][0]],
+								edges[faceEdges[face][1]],
+								edges[faceEdges[face][2]]);
+
+			// Only consider lines that might be entering through this face, since we
+			// already know that the start point is outside the box.
+			if(facePlane.classifyPointRelation(ray.start) != core::ISREL3D_FRONT)
+				continue;
+
+			// Don't bother using a limited ray, since we already know that it should be long
+			// enough to intersect with the box.
+			if(facePlane.getIntersectionWithLine(ray.start, rayVector, intersection))
+			{
+				const f32 toIntersectionSq = ray.start.getDistanceFromSQ(intersection);
+				if(toIntersectionSq < outbestdistance)
+				{
+					// We have to check that the intersection with this plane is actually
+					// on the box, so need to go back to object space again.
+					worldToObject.transformVect(intersection);
 
                                 // find the closest point on the box borders. Have to do this as exact checks will fail due to floating point problems.
-								f32 distToBorder = core::max_ ( core::min_ (core::abs_(objectBox.MinEdge.X-intersection.X), core::abs_(objectBox.MaxEdge.X-intersection.X)),
+					f32 distToBorder = core::max_ ( core::min_ (core::abs_(objectBox.MinEdge.X-intersection.X), core::abs_(objectBox.MaxEdge.X-intersection.X)),
                                                                 core::min_ (core::abs_(objectBox.MinEdge.Y-intersection.Y), core::abs_(objectBox.MaxEdge.Y-intersection.Y)),
                                                                 core::min_ (core::abs_(objectBox.MinEdge.Z-intersection.Z), core::abs_(objectBox.MaxEdge.Z-intersection.Z)) );
                                 if ( distToBorder < bestDistToBoxBorder )
@@ -197,30 +244,48 @@ void CSceneCollisionManager::getPickedNodeBB(ISceneNode* root,
                                     bestDistToBoxBorder = distToBorder;
                                     bestToIntersectionSq = toIntersectionSq;
                                 }
-							}
-						}
+				}
+			}
 
-						// If the ray could be entering through the first face of a pair, then it can't
-						// also be entering through the opposite face, and so we can skip that face.
-						if (!(face & 0x01))
-							++face;
-					}
+			// If the ray could be entering through the first face of a pair, then it can't
+			// also be entering through the opposite face, and so we can skip that face.
+			if (!(face & 0x01))
+				++face;
+		}
 
-					if ( bestDistToBoxBorder < FLT_MAX )
-					{
+		if ( bestDistToBoxBorder < FLT_MAX )
+		{
                         outbestdistance = bestToIntersectionSq;
-						outbestnode = current;
+			outbestnode = current;
 
                         // If we got a hit, we can now truncate the ray to stop us hitting further nodes.
                         ray.end = ray.start + (rayVector * sqrtf(outbestdistance));
-					}
-				}
-			}
-
-			// Only check the children if this node is visible.
-			getPickedNodeBB(current, ray, bits, noDebugObjects, outbestdistance, outbestnode);
 		}
 	}
+
+	return true;
+}
+
+
+//! true if getPickedNodeBB() reaches the node when starting at the root scene node
+bool CSceneCollisionManager::isPickedFromRoot(const ISceneNode* node, s32 bits, bool noDebugObjects) const
+{
+	if (!node->isVisible())
+		return false;
+
+	const ISceneNode* root = SceneManager->getRootSceneNode();
+	for (const ISceneNode* parent = node->getParent(); parent && parent != root; parent = parent->getParent())
+	{
+		if (!parent->isVisible())
+			return false;
+
+		// the children of tested nodes with empty boxes or singular transformations are skipped
+		core::matrix4 worldToObject;
+		if (isPickCandidate(parent, bits, noDebugObjects) &&
+			(parent->getBoundingBox().isEmpty() || !parent->getAbsoluteTransformation().getInverse(worldToObject)))
+			return false;
+	}
+	return true;
 }
 
 
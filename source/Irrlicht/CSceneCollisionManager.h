@@ -13,6 +13,7 @@ namespace irr
 {
 namespace scene
 {
+	class CSceneSpatialIndex;
 
 	//! The Scene Collision Manager provides methods for performing collision tests and picking on scene nodes.
 	class CSceneCollisionManager : public ISceneCollisionManager
@@ -25,6 +26,9 @@ namespace scene
 		//! destructor
 		virtual ~CSceneCollisionManager();
 
+		//! sets the spatial index used for picking, 0 if the scene isn't indexed
+		void setSpatialIndex(CSceneSpatialIndex* index);
+
 		//! Returns the scene node, which is currently visible at the given
 		//! screen coordinates, viewed from the currently active camera.
 		virtual ISceneNode* getSceneNodeFromScreenCoordinatesBB(const core::position2d<s32>& pos,
@@ -83,6 +87,13 @@ namespace scene
 					bool bNoDebugObjects,
 					f32& outbestdistance, ISceneNode*& outbestnode);
 
+		//! tests the bounding box of a single node. Returns false if its children are not picked
+		bool pickNodeBB(ISceneNode* current, core::line3df& ray, const core::vector3df& rayVector,
+					f32& outbestdistance, ISceneNode*& outbestnode);
+
+		//! true if getPickedNodeBB() reaches the node when starting at the root scene node
+		bool isPickedFromRoot(const ISceneNode* node, s32 bits, bool noDebugObjects) const;
+
 		//! recursive method for going through all scene nodes
 		void getPickedNodeFromBBAndSelector(
 						SCollisionHit& hitResult,
@@ -143,6 +154,9 @@ namespace scene
 		ISceneManager* SceneManager;
 		video::IVideoDriver* Driver;
 		core::array<core::triangle3df> Triangles; // triangle buffer
+
+		CSceneSpatialIndex* SpatialIndex;
+		core::array<ISceneNode*> PickedNodes;
 	};
 
 
@@ -0,0 +1,106 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CSceneFlatStore.h"
+#include "ISceneNode.h"
+
+#include <string.h>
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! aabbox3d::operator== allows rounding errors
+	inline bool sameBox(const core::aabbox3df& a, const core::aabbox3df& b)
+	{
+		return a.MinEdge.X == b.MinEdge.X && a.MinEdge.Y == b.MinEdge.Y && a.MinEdge.Z == b.MinEdge.Z &&
+			a.MaxEdge.X == b.MaxEdge.X && a.MaxEdge.Y == b.MaxEdge.Y && a.MaxEdge.Z == b.MaxEdge.Z;
+	}
+}
+
+
+CSceneFlatStore::CSceneFlatStore()
+	: Root(0), HierarchyVersion(0)
+{
+}
+
+
+//! brings the arrays up to date with the nodes below the root
+void CSceneFlatStore::update(ISceneNode* root)
+{
+	if (root != Root || root->getHierarchyVersion() != HierarchyVersion)
+	{
+		Nodes.set_used(0);
+		Parents.set_used(0);
+		SubtreeEnd.set_used(0);
+		rebuild(root, -1);
+
+		const u32 count = Nodes.size();
+		Visible.set_used(count);
+		Valid.set_used(count);
+		Culling.set_used(count);
+		Versions.set_used(count);
+		Transforms.set_used(count);
+		Boxes.set_used(count);
+		WorldBoxes.set_used(count);
+		if (count)
+			memset(Valid.pointer(), 0, count);
+
+		Root = root;
+		HierarchyVersion = root->getHierarchyVersion();
+	}
+
+	const u32 count = Nodes.size();
+	for (u32 i = 0; i < count; )
+	{
+		const ISceneNode* node = Nodes[i];
+		if (!node->isVisible())
+		{
+			// invisible nodes don't register their subtree
+			Visible[i] = 0;
+			i = SubtreeEnd[i];
+			continue;
+		}
+		Visible[i] = 1;
+		Culling[i] = node->getAutomaticCulling();
+
+		const core::aabbox3df& box = node->getBoundingBox();
+		const u32 version = node->getTransformationVersion();
+		if (!Valid[i] || Versions[i] != version || !sameBox(Boxes[i], box))
+		{
+			Transforms[i] = node->getAbsoluteTransformation();
+			Versions[i] = version;
+			Boxes[i] = box;
+			WorldBoxes[i] = box;
+			Transforms[i].transformBoxEx(WorldBoxes[i]);
+			Valid[i] = 1;
+		}
+		++i;
+	}
+}
+
+
+//! appends the subtree below a node in depth first order
+void CSceneFlatStore::rebuild(ISceneNode* node, s32 parent)
+{
+	const ISceneNodeList& children = node->getChildren();
+	ISceneNodeList::ConstIterator it = children.begin();
+	for (; it != children.end(); ++it)
+	{
+		const u32 index = Nodes.size();
+		Nodes.push_back(*it);
+		Parents.push_back(parent);
+		SubtreeEnd.push_back(0);
+
+		rebuild(*it, (s32)index);
+		SubtreeEnd[index] = Nodes.size();
+	}
+}
+
+} // end namespace scene
+} // end namespace irr
+
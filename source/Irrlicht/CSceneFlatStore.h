@@ -0,0 +1,90 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_SCENE_FLAT_STORE_H_INCLUDED
+#define IRR_C_SCENE_FLAT_STORE_H_INCLUDED
+
+#include "irrArray.h"
+#include "aabbox3d.h"
+#include "matrix4.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ISceneNode;
+
+	//! Copy of the scene graph in contiguous arrays
+	/** Keeps the nodes below a root in depth first order together with
+	their parent indices, absolute transformations and bounding boxes, so
+	passes over the whole scene are linear sweeps instead of walks through
+	the child lists. The nodes stay the owners of their data. The order is
+	only rebuilt when the hierarchy version of the root changes, the
+	transformations and world space boxes only for nodes whose
+	transformation version or bounding box changed. */
+	class CSceneFlatStore
+	{
+	public:
+
+		CSceneFlatStore();
+
+		//! brings the arrays up to date with the nodes below the root
+		/** Nodes below invisible nodes are not updated. */
+		void update(ISceneNode* root);
+
+		//! amount of nodes, without the root
+		u32 size() const { return Nodes.size(); }
+
+		//! node at a position in depth first order
+		ISceneNode* getNode(u32 i) const { return Nodes[i]; }
+
+		//! index of the parent, -1 for children of the root
+		s32 getParent(u32 i) const { return Parents[i]; }
+
+		//! index after the last node of the subtree of a node
+		u32 getSubtreeEnd(u32 i) const { return SubtreeEnd[i]; }
+
+		//! if the node was visible in the last update()
+		bool isVisible(u32 i) const { return Visible[i] != 0; }
+
+		//! culling state of the node in the last update()
+		u32 getAutomaticCulling(u32 i) const { return Culling[i]; }
+
+		//! absolute transformation of the node
+		const core::matrix4& getTransform(u32 i) const { return Transforms[i]; }
+
+		//! transformation version of the node when its transformation was copied
+		u32 getTransformVersion(u32 i) const { return Versions[i]; }
+
+		//! bounding box of the node in node space
+		const core::aabbox3df& getBoundingBox(u32 i) const { return Boxes[i]; }
+
+		//! bounding box of the node in world space
+		const core::aabbox3df& getWorldBox(u32 i) const { return WorldBoxes[i]; }
+
+	private:
+
+		//! appends the subtree below a node in depth first order
+		void rebuild(ISceneNode* node, s32 parent);
+
+		core::array<ISceneNode*> Nodes;
+		core::array<s32> Parents;
+		core::array<u32> SubtreeEnd;
+		core::array<u8> Visible;
+		core::array<u8> Valid;		// transformation and boxes copied
+		core::array<u32> Culling;
+		core::array<u32> Versions;
+		core::array<core::matrix4> Transforms;
+		core::array<core::aabbox3df> Boxes;
+		core::array<core::aabbox3df> WorldBoxes;
+
+		const ISceneNode* Root;
+		u32 HierarchyVersion;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
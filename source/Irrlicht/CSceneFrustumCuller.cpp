@@ -0,0 +1,358 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CSceneFrustumCuller.h"
+#include "CSceneFlatStore.h"
+#include "ISceneNode.h"
+#include "SViewFrustum.h"
+
+#include <string.h>
+
+//SSE2 box tests. the scalar code decides the same nodes
+#if !defined(IRR_SCENE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define IRR_SCENE_CULLER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	inline u32 hashNode(const ISceneNode* node)
+	{
+		return (u32)(((size_t)node >> 4) * 2654435761u);
+	}
+
+	/*
+		The frustum box test of isCulled() transforms the frustum into
+		node space and tests the corners of the node box. Here the world
+		space box around the node box is tested instead. A node is only
+		outside or inside if the distance to a plane is larger than
+		the rounding errors of both ways. The relative part covers the
+		float math, the absolute part per node the ROUNDING_ERROR_f32
+		of the node space test scaled to world space.
+	*/
+	const f32 RelativeTolerance = 1e-4f;
+	const f32 ScaleTolerance = 1e-5f;
+
+	//! tolerance of the frustum box test for a transformation. FLT_MAX if the node space test is not reproducible
+	f32 frustumBoxTolerance(const core::matrix4& m)
+	{
+		if (m[3] != 0.f || m[7] != 0.f || m[11] != 0.f || m[15] != 1.f)
+			return FLT_MAX;
+
+		const f32 sx = m[0] * m[0] + m[1] * m[1] + m[2] * m[2];
+		const f32 sy = m[4] * m[4] + m[5] * m[5] + m[6] * m[6];
+		const f32 sz = m[8] * m[8] + m[9] * m[9] + m[10] * m[10];
+		const f32 s = sqrtf(core::max_(sx, sy, sz));
+
+		// badly conditioned or singular matrices make the node space test unstable
+		const f32 det = m[0] * (m[5] * m[10] - m[6] * m[9]) -
+			m[1] * (m[4] * m[10] - m[6] * m[8]) +
+			m[2] * (m[4] * m[9] - m[5] * m[8]);
+		if (!(s < 1e12f) || !(fabsf(det) > 1e-6f * s * s * s))
+			return FLT_MAX;
+
+		return ScaleTolerance * s;
+	}
+}
+
+
+//! tests all visible nodes below the root
+void CSceneFrustumCuller::cull(ISceneNode* root, const SViewFrustum& frustum, const CSceneFlatStore* store)
+{
+	Nodes.set_used(0);
+	MinX.set_used(0);
+	MinY.set_used(0);
+	MinZ.set_used(0);
+	MaxX.set_used(0);
+	MaxY.set_used(0);
+	MaxZ.set_used(0);
+	Tolerance.set_used(0);
+
+	if (store)
+		gather(*store);
+	else
+		gather(root);
+	testBoxes(frustum);
+
+	// power of two at least twice the node count
+	u32 size = 16;
+	while (size < Nodes.size() * 2)
+		size <<= 1;
+	Hash.set_used(size);
+	memset(Hash.pointer(), 0, size * sizeof(u32));
+
+	const u32 mask = size - 1;
+	for (u32 i = 0; i < Nodes.size(); ++i)
+	{
+		u32 h = hashNode(Nodes[i].Node) & mask;
+		while (Hash[h])
+			h = (h + 1) & mask;
+		Hash[h] = i + 1;
+	}
+}
+
+
+//! result for a node in the last cull()
+CSceneFrustumCuller::E_CULL_RESULT CSceneFrustumCuller::getResult(const ISceneNode* node) const
+{
+	if (Nodes.empty())
+		return ECR_UNKNOWN;
+
+	const u32 mask = Hash.size() - 1;
+	for (u32 h = hashNode(node) & mask; Hash[h]; h = (h + 1) & mask)
+	{
+		const u32 i = Hash[h] - 1;
+		const SNode& entry = Nodes[i];
+		if (entry.Node != node)
+			continue;
+
+		if (entry.Culling != node->getAutomaticCulling() ||
+			entry.Box != node->getBoundingBox() ||
+			entry.TransformVersion != node->getTransformationVersion())
+			return ECR_UNKNOWN;
+
+		const u32 bit = 1u << (i & 31);
+		if (Culled[i >> 5] & bit)
+			return ECR_CULLED;
+		if (Visible[i >> 5] & bit)
+			return ECR_VISIBLE;
+		return ECR_UNKNOWN;
+	}
+	return ECR_UNKNOWN;
+}
+
+
+//! adds the visible nodes of the subtree
+void CSceneFrustumCuller::gather(ISceneNode* node)
+{
+	const ISceneNodeList& children = node->getChildren();
+	ISceneNodeList::ConstIterator it = children.begin();
+	for (; it != children.end(); ++it)
+	{
+		ISceneNode* child = *it;
+
+		// invisible nodes don't register their subtree
+		if (!child->isVisible())
+			continue;
+
+		const u32 culling = child->getAutomaticCulling();
+		if ((culling & (EAC_BOX | EAC_FRUSTUM_BOX)) && !(culling & EAC_OCC_QUERY))
+		{
+			// same box as the EAC_BOX test
+			const core::aabbox3df& box = child->getBoundingBox();
+			const core::matrix4& transform = child->getAbsoluteTransformation();
+			core::aabbox3df worldBox(box);
+			transform.transformBoxEx(worldBox);
+			addNode(child, box, culling, worldBox, transform, child->getTransformationVersion());
+		}
+
+		gather(child);
+	}
+}
+
+
+//! adds the visible nodes of the flat store
+void CSceneFrustumCuller::gather(const CSceneFlatStore& store)
+{
+	const u32 count = store.size();
+	for (u32 i = 0; i < count; )
+	{
+		if (!store.isVisible(i))
+		{
+			i = store.getSubtreeEnd(i);
+			continue;
+		}
+
+		const u32 culling = store.getAutomaticCulling(i);
+		if ((culling & (EAC_BOX | EAC_FRUSTUM_BOX)) && !(culling & EAC_OCC_QUERY))
+		{
+			addNode(store.getNode(i), store.getBoundingBox(i), culling,
+				store.getWorldBox(i), store.getTransform(i), store.getTransformVersion(i));
+		}
+		++i;
+	}
+}
+
+
+//! adds a node with its world space box
+void CSceneFrustumCuller::addNode(const ISceneNode* node, const core::aabbox3df& box, u32 culling,
+	const core::aabbox3df& worldBox, const core::matrix4& transform, u32 version)
+{
+	SNode entry;
+	entry.Node = node;
+	entry.Box = box;
+	entry.TransformVersion = version;
+	entry.Culling = culling;
+	Nodes.push_back(entry);
+
+	MinX.push_back(worldBox.MinEdge.X);
+	MinY.push_back(worldBox.MinEdge.Y);
+	MinZ.push_back(worldBox.MinEdge.Z);
+	MaxX.push_back(worldBox.MaxEdge.X);
+	MaxY.push_back(worldBox.MaxEdge.Y);
+	MaxZ.push_back(worldBox.MaxEdge.Z);
+	Tolerance.push_back((culling & EAC_FRUSTUM_BOX) ? frustumBoxTolerance(transform) : FLT_MAX);
+}
+
+
+//! classifies the gathered boxes and fills the bitmasks
+void CSceneFrustumCuller::testBoxes(const SViewFrustum& frustum)
+{
+	const u32 count = Nodes.size();
+	const u32 words = (count + 31) >> 5;
+
+	BoxCulling.set_used(words);
+	FrustumBoxCulling.set_used(words);
+	OtherCulling.set_used(words);
+	Culled.set_used(words);
+	Visible.set_used(words);
+	if (!words)
+		return;
+
+	memset(BoxCulling.pointer(), 0, words * sizeof(u32));
+	memset(FrustumBoxCulling.pointer(), 0, words * sizeof(u32));
+	memset(OtherCulling.pointer(), 0, words * sizeof(u32));
+	memset(Culled.pointer(), 0, words * sizeof(u32));
+	memset(Visible.pointer(), 0, words * sizeof(u32));
+
+	u32 i;
+	for (i = 0; i < count; ++i)
+	{
+		const u32 bit = 1u << (i & 31);
+		const u32 culling = Nodes[i].Culling;
+		if (culling & EAC_BOX)
+			BoxCulling[i >> 5] |= bit;
+		if (culling & EAC_FRUSTUM_BOX)
+			FrustumBoxCulling[i >> 5] |= bit;
+		if (culling & EAC_FRUSTUM_SPHERE)
+			OtherCulling[i >> 5] |= bit;
+	}
+
+	// pad to full batches
+	for (; i & 3; ++i)
+	{
+		MinX.push_back(0.f);
+		MinY.push_back(0.f);
+		MinZ.push_back(0.f);
+		MaxX.push_back(0.f);
+		MaxY.push_back(0.f);
+		MaxZ.push_back(0.f);
+		Tolerance.push_back(FLT_MAX);
+	}
+
+	const core::aabbox3df& frustumBox = frustum.getBoundingBox();
+
+	for (u32 batch = 0; batch < count; batch += 4)
+	{
+		// 4 bits each, one per lane
+		u32 boxOutside = 0;
+		u32 outside = 0;
+		u32 inside = 0;
+
+#if defined(IRR_SCENE_CULLER_SSE2)
+		const __m128 minX = _mm_loadu_ps(MinX.const_pointer() + batch);
+		const __m128 minY = _mm_loadu_ps(MinY.const_pointer() + batch);
+		const __m128 minZ = _mm_loadu_ps(MinZ.const_pointer() + batch);
+		const __m128 maxX = _mm_loadu_ps(MaxX.const_pointer() + batch);
+		const __m128 maxY = _mm_loadu_ps(MaxY.const_pointer() + batch);
+		const __m128 maxZ = _mm_loadu_ps(MaxZ.const_pointer() + batch);
+
+		// aabbox3d::intersectsWithBox
+		__m128 hit = _mm_and_ps(_mm_cmple_ps(minX, _mm_set1_ps(frustumBox.MaxEdge.X)), _mm_cmple_ps(minY, _mm_set1_ps(frustumBox.MaxEdge.Y)));
+		hit = _mm_and_ps(hit, _mm_cmple_ps(minZ, _mm_set1_ps(frustumBox.MaxEdge.Z)));
+		hit = _mm_and_ps(hit, _mm_cmpge_ps(maxX, _mm_set1_ps(frustumBox.MinEdge.X)));
+		hit = _mm_and_ps(hit, _mm_cmpge_ps(maxY, _mm_set1_ps(frustumBox.MinEdge.Y)));
+		hit = _mm_and_ps(hit, _mm_cmpge_ps(maxZ, _mm_set1_ps(frustumBox.MinEdge.Z)));
+		boxOutside = ~_mm_movemask_ps(hit) & 15;
+
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		const __m128 relative = _mm_set1_ps(RelativeTolerance);
+		const __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+		const __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+		const __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+		const __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+		const __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+		const __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+		const __m128 acx = _mm_and_ps(cx, absMask);
+		const __m128 acy = _mm_and_ps(cy, absMask);
+		const __m128 acz = _mm_and_ps(cz, absMask);
+		const __m128 tolerance = _mm_loadu_ps(Tolerance.const_pointer() + batch);
+
+		__m128 out = _mm_setzero_ps();
+		__m128 in = _mm_cmpeq_ps(out, out);
+		for (u32 p = 0; p < SViewFrustum::VF_PLANE_COUNT; ++p)
+		{
+			const core::plane3df& plane = frustum.planes[p];
+			const __m128 nx = _mm_set1_ps(plane.Normal.X);
+			const __m128 ny = _mm_set1_ps(plane.Normal.Y);
+			const __m128 nz = _mm_set1_ps(plane.Normal.Z);
+			const __m128 anx = _mm_and_ps(nx, absMask);
+			const __m128 any = _mm_and_ps(ny, absMask);
+			const __m128 anz = _mm_and_ps(nz, absMask);
+
+			// distance of the center and radius of the box along the normal
+			const __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_mul_ps(nz, cz)), _mm_set1_ps(plane.D));
+			const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(anx, ex), _mm_mul_ps(any, ey)), _mm_mul_ps(anz, ez));
+			const __m128 size = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(anx, acx), _mm_mul_ps(any, acy)), _mm_mul_ps(anz, acz)), r), _mm_set1_ps(fabsf(plane.D)));
+			const __m128 margin = _mm_add_ps(_mm_mul_ps(relative, size), tolerance);
+
+			out = _mm_or_ps(out, _mm_cmpgt_ps(_mm_sub_ps(d, r), margin));
+			in = _mm_and_ps(in, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_sub_ps(_mm_setzero_ps(), margin)));
+		}
+		outside = _mm_movemask_ps(out);
+		inside = _mm_movemask_ps(in);
+#else
+		for (u32 lane = 0; lane < 4; ++lane)
+		{
+			const u32 k = batch + lane;
+			const core::aabbox3df box(MinX[k], MinY[k], MinZ[k], MaxX[k], MaxY[k], MaxZ[k]);
+			if (!box.intersectsWithBox(frustumBox))
+				boxOutside |= 1 << lane;
+
+			const core::vector3df c((MinX[k] + MaxX[k]) * 0.5f, (MinY[k] + MaxY[k]) * 0.5f, (MinZ[k] + MaxZ[k]) * 0.5f);
+			const core::vector3df e((MaxX[k] - MinX[k]) * 0.5f, (MaxY[k] - MinY[k]) * 0.5f, (MaxZ[k] - MinZ[k]) * 0.5f);
+
+			bool laneOut = false;
+			bool laneIn = true;
+			for (u32 p = 0; p < SViewFrustum::VF_PLANE_COUNT; ++p)
+			{
+				const core::plane3df& plane = frustum.planes[p];
+				const core::vector3df an(fabsf(plane.Normal.X), fabsf(plane.Normal.Y), fabsf(plane.Normal.Z));
+				const f32 d = plane.Normal.X * c.X + plane.Normal.Y * c.Y + plane.Normal.Z * c.Z + plane.D;
+				const f32 r = an.X * e.X + an.Y * e.Y + an.Z * e.Z;
+				const f32 size = an.X * fabsf(c.X) + an.Y * fabsf(c.Y) + an.Z * fabsf(c.Z) + r + fabsf(plane.D);
+				const f32 margin = RelativeTolerance * size + Tolerance[k];
+
+				laneOut |= d - r > margin;
+				laneIn &= d + r < -margin;
+			}
+			outside |= (laneOut ? 1 : 0) << lane;
+			inside |= (laneIn ? 1 : 0) << lane;
+		}
+#endif
+
+		// same results as the tests in CSceneManager::isCulled, which stop at the first culling one
+		const u32 word = batch >> 5;
+		const u32 shift = batch & 31;
+		const u32 box = (BoxCulling[word] >> shift) & 15;
+		const u32 frustumBoxTest = (FrustumBoxCulling[word] >> shift) & 15;
+		const u32 other = (OtherCulling[word] >> shift) & 15;
+
+		const u32 culled = (boxOutside & box) | (outside & frustumBoxTest);
+		const u32 visible = ~culled & ~other & (~frustumBoxTest | inside) & 15;
+
+		Culled[word] |= culled << shift;
+		Visible[word] |= visible << shift;
+	}
+}
+
+} // end namespace scene
+} // end namespace irr
+
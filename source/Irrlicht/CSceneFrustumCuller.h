@@ -0,0 +1,99 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_SCENE_FRUSTUM_CULLER_H_INCLUDED
+#define IRR_C_SCENE_FRUSTUM_CULLER_H_INCLUDED
+
+#include "irrArray.h"
+#include "aabbox3d.h"
+#include "matrix4.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ISceneNode;
+	class CSceneFlatStore;
+	struct SViewFrustum;
+
+	//! Tests the nodes of a scene in batches against the view frustum before they register
+	/** Gathers the world space boxes of all visible nodes with EAC_BOX or
+	EAC_FRUSTUM_BOX culling into SoA arrays and tests 4 of them at a time.
+	Results go into bitmasks. A node is only decided where the result is
+	sure to be the one of CSceneManager::isCulled(), all others are left
+	to the test of the scene manager. */
+	class CSceneFrustumCuller
+	{
+	public:
+
+		//! result of the last cull() for a node
+		enum E_CULL_RESULT
+		{
+			//! not decided, node has to be tested
+			ECR_UNKNOWN = 0,
+
+			//! node is not culled
+			ECR_VISIBLE,
+
+			//! node is culled
+			ECR_CULLED
+		};
+
+		//! tests all visible nodes below the root
+		/** \param store If not 0, the nodes and their world space boxes
+		are taken from it instead of walking through the scene. It has to
+		be up to date with the nodes below the root. */
+		void cull(ISceneNode* root, const SViewFrustum& frustum, const CSceneFlatStore* store=0);
+
+		//! result for a node in the last cull()
+		/** Only valid if the culling mode, bounding box and absolute
+		transformation of the node did not change since. */
+		E_CULL_RESULT getResult(const ISceneNode* node) const;
+
+	private:
+
+		struct SNode
+		{
+			const ISceneNode* Node;
+			core::aabbox3df Box;
+			u32 TransformVersion;
+			u32 Culling;
+		};
+
+		//! adds the visible nodes of the subtree
+		void gather(ISceneNode* node);
+
+		//! adds the visible nodes of the flat store
+		void gather(const CSceneFlatStore& store);
+
+		//! adds a node with its world space box
+		void addNode(const ISceneNode* node, const core::aabbox3df& box, u32 culling,
+			const core::aabbox3df& worldBox, const core::matrix4& transform, u32 version);
+
+		//! classifies the gathered boxes and fills the bitmasks
+		void testBoxes(const SViewFrustum& frustum);
+
+		core::array<SNode> Nodes;
+
+		// world space boxes in SoA form, padded to a multiple of 4
+		core::array<f32> MinX, MinY, MinZ;
+		core::array<f32> MaxX, MaxY, MaxZ;
+		core::array<f32> Tolerance;	// of the frustum box test, from the scale of the node
+
+		// bit per node
+		core::array<u32> BoxCulling;
+		core::array<u32> FrustumBoxCulling;
+		core::array<u32> OtherCulling;	// tests not done here
+		core::array<u32> Culled;
+		core::array<u32> Visible;
+
+		// open addressing from node to index + 1
+		core::array<u32> Hash;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
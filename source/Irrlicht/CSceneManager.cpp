@@ -19,6 +19,7 @@
 #include "IProfiler.h"
 
 #include "os.h"
+#include "CThreadPool.h"
 
 // We need this include for the case of skinned mesh support without
 // any such loader
@@ -154,6 +155,8 @@
 #include "CBillboardSceneNode.h"
 #endif // _IRR_COMPILE_WITH_BILLBOARD_SCENENODE_
 #include "CMeshSceneNode.h"
+#include "CInstancedMeshSceneNode.h"
+#include "CStaticBatchSceneNode.h"
 #include "CSkyBoxSceneNode.h"
 #ifdef _IRR_COMPILE_WITH_SKYDOME_SCENENODE_
 #include "CSkyDomeSceneNode.h"
@@ -179,11 +182,16 @@
 #include "CEmptySceneNode.h"
 #include "CTextSceneNode.h"
 #include "CQuake3ShaderSceneNode.h"
+#include "CQ3LevelSceneNode.h"
 #include "CVolumeLightSceneNode.h"
 
 #include "CDefaultSceneNodeFactory.h"
 
 #include "CSceneCollisionManager.h"
+#include "CSceneSpatialIndex.h"
+#include "CSceneFrustumCuller.h"
+#include "CSceneFlatStore.h"
+#include "CSceneOcclusionCuller.h"
 #include "CTriangleSelector.h"
 #include "COctreeTriangleSelector.h"
 #include "CTriangleBBSelector.h"
@@ -220,7 +228,10 @@ CSceneManager::CSceneManager(video::IVideoDriver* driver, io::IFileSystem* fs,
 	CursorControl(cursorControl), CollisionManager(0),
 	ActiveCamera(0), ShadowColor(150,0,0,0), AmbientLight(0,0,0,0), Parameters(0),
 	MeshCache(cache), CurrentRenderPass(ESNRP_NONE), LightManager(0),
-	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type")
+	IRR_XML_FORMAT_SCENE(L"irr_scene"), IRR_XML_FORMAT_NODE(L"node"), IRR_XML_FORMAT_NODE_ATTR_TYPE(L"type"),
+	TraversalPool(0), TraversalActive(false), SpatialIndex(0), SpatialIndexCulling(false),
+	FrustumCuller(0), BatchedCulling(false), OcclusionCuller(0), OcclusionCulling(false),
+	FlatStore(0)
 {
 	#ifdef _DEBUG
 	ISceneManager::setDebugName("CSceneManager ISceneManager");
@@ -382,11 +393,22 @@ CSceneManager::~CSceneManager()
 		CursorControl->drop();
 
 	if (CollisionManager)
+	{
+		static_cast<CSceneCollisionManager*>(CollisionManager)->setSpatialIndex(0);
 		CollisionManager->drop();
+	}
 
 	if (GeometryCreator)
 		GeometryCreator->drop();
 
+	if (TraversalPool)
+		TraversalPool->drop();
+
+	delete FrustumCuller;
+	delete OcclusionCuller;
+	OcclusionCuller = 0;
+	delete FlatStore;
+
 	if (GUIEnvironment)
 		GUIEnvironment->drop();
 
@@ -422,6 +444,12 @@ CSceneManager::~CSceneManager()
 	removeAll();
 	removeAnimators();
 
+	if (SpatialIndex)
+	{
+		setSpatialIndex(0);
+		delete SpatialIndex;
+	}
+
 	if (Driver)
 		Driver->drop();
 }
@@ -482,6 +510,10 @@ IAnimatedMesh* CSceneManager::getUncachedMesh(io::IReadFile* file, const io::pat
 			msh = MeshLoaderList[i]->createMesh(file);
 			if (msh)
 			{
+				const f32 keyTolerance = Parameters->getAttributeAsFloat(SKINNED_MESH_KEY_COMPRESSION);
+				if (keyTolerance > 0.f && msh->getMeshType() == EAMT_SKINNED)
+					static_cast<ISkinnedMesh*>(msh)->compressKeys(keyTolerance);
+
 				MeshCache->addMesh(cachename, msh);
 				msh->drop();
 				break;
@@ -587,6 +619,27 @@ IMeshSceneNode* CSceneManager::addQuake3SceneNode(const IMeshBuffer* meshBuffer,
 }
 
 
+//! Adds a scene node for the geometry of a quake3 level, culled with its vis data
+ISceneNode* CSceneManager::addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+					ISceneNode* parent, s32 id)
+{
+#ifdef _IRR_COMPILE_WITH_BSP_LOADER_
+	if (!mesh || !mesh->getMesh(quake3::E_Q3_MESH_GEOMETRY))
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	CQ3LevelSceneNode* node = new CQ3LevelSceneNode(mesh, parent, this, id);
+	node->drop();
+
+	return node;
+#else
+	return 0;
+#endif
+}
+
+
 //! adds Volume Lighting Scene Node.
 //! the returned pointer must not be dropped.
 IVolumeLightSceneNode* CSceneManager::addVolumeLightSceneNode(
@@ -664,6 +717,42 @@ IMeshSceneNode* CSceneManager::addMeshSceneNode(IMesh* mesh, ISceneNode* parent,
 }
 
 
+//! Adds a scene node for rendering many instances of a static mesh.
+IInstancedMeshSceneNode* CSceneManager::addInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent, s32 id,
+	const core::vector3df& position, const core::vector3df& rotation,
+	const core::vector3df& scale, bool alsoAddIfMeshPointerZero)
+{
+	if (!alsoAddIfMeshPointerZero && !mesh)
+		return 0;
+
+	if (!parent)
+		parent = this;
+
+	IInstancedMeshSceneNode* node = new CInstancedMeshSceneNode(mesh, parent, this, id, position, rotation, scale);
+	node->drop();
+
+	return node;
+}
+
+
+//! Adds a scene node drawing static mesh scene nodes merged into few meshbuffers
+IStaticBatchSceneNode* CSceneManager::addStaticBatchSceneNode(ISceneNode* root, f32 chunkSize,
+	ISceneNode* parent, s32 id)
+{
+	if (!root)
+		root = this;
+
+	if (!parent)
+		parent = this;
+
+	IStaticBatchSceneNode* node = new CStaticBatchSceneNode(chunkSize, parent, this, id);
+	node->addNodes(root);
+	node->drop();
+
+	return node;
+}
+
+
 //! Adds a scene node for rendering a animated water surface mesh.
 ISceneNode* CSceneManager::addWaterSurfaceSceneNode(IMesh* mesh, f32 waveHeight, f32 waveSpeed, f32 waveLength,
 	ISceneNode* parent, s32 id, const core::vector3df& position,
@@ -1250,6 +1339,44 @@ bool CSceneManager::isCulled(const ISceneNode* node) const
 		result = (Driver->getOcclusionQueryResult(node)==0);
 	}
 
+	// hidden behind the occluders drawn before the registration
+	if (!result && OcclusionCulling && (node->getAutomaticCulling() & scene::EAC_OCC_SOFTWARE))
+	{
+		result = OcclusionCuller->isOccluded(node);
+	}
+
+	// the spatial index already tested the region of the node against the view frustum.
+	// Nodes inside pass all tests, outside is only as exact as the frustum box test
+	if (!result && SpatialIndexCulling &&
+		(node->getAutomaticCulling() & (scene::EAC_BOX | scene::EAC_FRUSTUM_BOX | scene::EAC_FRUSTUM_SPHERE)))
+	{
+		switch (SpatialIndex->getFrustumState(node))
+		{
+		case CSceneSpatialIndex::EFS_OUTSIDE:
+			if (node->getAutomaticCulling() & scene::EAC_FRUSTUM_BOX)
+				return true;
+			break;
+		case CSceneSpatialIndex::EFS_INSIDE:
+			return false;
+		default:
+			break;
+		}
+	}
+
+	// decided by the batch test before the registration
+	if (!result && BatchedCulling)
+	{
+		switch (FrustumCuller->getResult(node))
+		{
+		case CSceneFrustumCuller::ECR_CULLED:
+			return true;
+		case CSceneFrustumCuller::ECR_VISIBLE:
+			return false;
+		default:
+			break;
+		}
+	}
+
 	// can be seen by a bounding box ?
 	if (!result && (node->getAutomaticCulling() & scene::EAC_BOX))
 	{
@@ -1311,10 +1438,53 @@ bool CSceneManager::isCulled(const ISceneNode* node) const
 }
 
 
-//! registers a node for rendering it at a specific time.
-u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
+//! returns the pass a node is drawn in or ESNRP_NONE if it is culled
+E_SCENE_NODE_RENDER_PASS CSceneManager::getRenderPass(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass) const
+{
+	switch(pass)
+	{
+	case ESNRP_CAMERA:
+	case ESNRP_SKY_BOX:
+		return pass;
+
+	case ESNRP_LIGHT:
+		// TODO: Point Light culling..
+		// Lighting model in irrlicht has to be redone..
+		return pass;
+
+	case ESNRP_SOLID:
+	case ESNRP_TRANSPARENT:
+	case ESNRP_TRANSPARENT_EFFECT:
+	case ESNRP_SHADOW:
+	case ESNRP_GUI:
+		return isCulled(node) ? ESNRP_NONE : pass;
+
+	case ESNRP_AUTOMATIC:
+		if (!isCulled(node))
+		{
+			const u32 count = node->getMaterialCount();
+			for (u32 i=0; i<count; ++i)
+			{
+				if (Driver->needsTransparentRenderPass(node->getMaterial(i)))
+					return ESNRP_TRANSPARENT;
+			}
+
+			// not transparent, register as solid
+			return ESNRP_SOLID;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	return ESNRP_NONE;
+}
+
+
+//! adds a node which is not culled to the list of its render pass
+u32 CSceneManager::addToRenderList(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
 {
-	IRR_PROFILE(CProfileScope p1(EPID_SM_REGISTER);)
 	u32 taken = 0;
 
 	switch(pass)
@@ -1339,13 +1509,8 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 		break;
 
 	case ESNRP_LIGHT:
-		// TODO: Point Light culling..
-		// Lighting model in irrlicht has to be redone..
-		//if (!isCulled(node))
-		{
-			LightList.push_back(node);
-			taken = 1;
-		}
+		LightList.push_back(node);
+		taken = 1;
 		break;
 
 	case ESNRP_SKY_BOX:
@@ -1353,71 +1518,60 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 		taken = 1;
 		break;
 	case ESNRP_SOLID:
-		if (!isCulled(node))
-		{
-			SolidNodeList.push_back(node);
-			taken = 1;
-		}
+		SolidNodeList.push_back(DefaultNodeEntry(node, camWorldPos));
+		taken = 1;
 		break;
 	case ESNRP_TRANSPARENT:
-		if (!isCulled(node))
-		{
-			TransparentNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
-			taken = 1;
-		}
+		TransparentNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
+		taken = 1;
 		break;
 	case ESNRP_TRANSPARENT_EFFECT:
-		if (!isCulled(node))
-		{
-			TransparentEffectNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
-			taken = 1;
-		}
-		break;
-	case ESNRP_AUTOMATIC:
-		if (!isCulled(node))
-		{
-			const u32 count = node->getMaterialCount();
-
-			taken = 0;
-			for (u32 i=0; i<count; ++i)
-			{
-				if (Driver->needsTransparentRenderPass(node->getMaterial(i)))
-				{
-					// register as transparent node
-					TransparentNodeEntry e(node, camWorldPos);
-					TransparentNodeList.push_back(e);
-					taken = 1;
-					break;
-				}
-			}
-
-			// not transparent, register as solid
-			if (!taken)
-			{
-				SolidNodeList.push_back(node);
-				taken = 1;
-			}
-		}
+		TransparentEffectNodeList.push_back(TransparentNodeEntry(node, camWorldPos));
+		taken = 1;
 		break;
 	case ESNRP_SHADOW:
-		if (!isCulled(node))
-		{
-			ShadowNodeList.push_back(node);
-			taken = 1;
-		}
+		ShadowNodeList.push_back(node);
+		taken = 1;
 		break;
-
 	case ESNRP_GUI:
-		if (!isCulled(node))
+		GuiNodeList.push_back(node);
+		taken = 1;
+		break;
+
+	default: // ignore this one
+		break;
+	}
+
+	return taken;
+}
+
+
+//! registers a node for rendering it at a specific time.
+u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass)
+{
+	// called from a job of registerSceneNodesParallel. only culls, the lists are filled later
+	if (TraversalActive)
+	{
+		STraversalJob& job = *TraversalJobOfThread[TraversalPool->getThreadIndex()];
+		job.Calls += 1;
+
+		STraversalJob::SEntry entry;
+		entry.Node = node;
+		entry.Pass = getRenderPass(node, pass);
+		if (entry.Pass == ESNRP_NONE)
 		{
-			GuiNodeList.push_back(node);
-			taken = 1;
+			job.Culled += 1;
+			return 0;
 		}
 
-	case ESNRP_NONE: // ignore this one
-		break;
+		job.Entries.push_back(entry);
+		return 1;
 	}
 
+	IRR_PROFILE(CProfileScope p1(EPID_SM_REGISTER);)
+	const E_SCENE_NODE_RENDER_PASS renderPass = getRenderPass(node, pass);
+	const u32 taken = renderPass != ESNRP_NONE ? addToRenderList(node, renderPass) : 0;
+
 #ifdef _IRR_SCENEMANAGER_DEBUG
 	s32 index = Parameters->findAttribute("calls");
 	Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+1);
@@ -1432,6 +1586,99 @@ u32 CSceneManager::registerNodeForRendering(ISceneNode* node, E_SCENE_NODE_RENDE
 	return taken;
 }
 
+//! lets the top level subtrees register themselves in jobs of the traversal pool
+void CSceneManager::registerSceneNodesParallel()
+{
+	if (!IsVisible)
+		return;
+
+	if (!TraversalPool)
+		TraversalPool = new CThreadPool();
+
+	TraversalRoots.set_used(0);
+	ISceneNodeList::Iterator it = Children.begin();
+	for (; it != Children.end(); ++it)
+		TraversalRoots.push_back(*it);
+
+	// a few jobs per thread to balance subtrees of different size
+	const u32 threadCount = TraversalPool->getThreadCount();
+	const u32 jobCount = core::min_(TraversalRoots.size(), threadCount * 4);
+	while (TraversalJobs.size() < jobCount)
+		TraversalJobs.push_back(STraversalJob());
+
+	u32 i;
+	for (i=0; i<jobCount; ++i)
+	{
+		TraversalJobs[i].Entries.set_used(0);
+		TraversalJobs[i].Calls = 0;
+		TraversalJobs[i].Culled = 0;
+	}
+	TraversalJobOfThread.set_used(threadCount);
+
+	TraversalActive = true;
+	TraversalPool->run(traversalJob, this, jobCount);
+	TraversalActive = false;
+
+	// jobs own consecutive subtrees, so merging in job order keeps the order of a serial traversal
+	for (i=0; i<jobCount; ++i)
+	{
+		STraversalJob& job = TraversalJobs[i];
+		for (u32 e=0; e<job.Entries.size(); ++e)
+		{
+			if (!addToRenderList(job.Entries[e].Node, job.Entries[e].Pass))
+				job.Culled += 1; // camera registered twice
+		}
+
+#ifdef _IRR_SCENEMANAGER_DEBUG
+		s32 index = Parameters->findAttribute("calls");
+		Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+(s32)job.Calls);
+		index = Parameters->findAttribute("culled");
+		Parameters->setAttribute(index, Parameters->getAttributeAsInt(index)+(s32)job.Culled);
+#endif
+	}
+}
+
+
+//! ThreadPoolJob of registerSceneNodesParallel
+void CSceneManager::traversalJob(void* userData, u32 job)
+{
+	CSceneManager* smgr = (CSceneManager*)userData;
+	smgr->TraversalJobOfThread[smgr->TraversalPool->getThreadIndex()] = &smgr->TraversalJobs[job];
+
+	const u32 rootCount = smgr->TraversalRoots.size();
+	const u32 jobCount = core::min_(rootCount, smgr->TraversalPool->getThreadCount() * 4);
+	const u32 end = rootCount * (job + 1) / jobCount;
+	for (u32 i = rootCount * job / jobCount; i < end; ++i)
+		smgr->TraversalRoots[i]->OnRegisterSceneNode();
+}
+
+
+//! creates or removes the spatial index as set by SPATIAL_SCENE_INDEX
+bool CSceneManager::updateSpatialIndex()
+{
+	const bool enabled = Parameters->getAttributeAsBool(SPATIAL_SCENE_INDEX);
+	if (enabled && !SpatialIndex)
+	{
+		SpatialIndex = new CSceneSpatialIndex(this);
+		setSpatialIndex(SpatialIndex);
+		static_cast<CSceneCollisionManager*>(CollisionManager)->setSpatialIndex(SpatialIndex);
+	}
+	else if (!enabled && SpatialIndex)
+	{
+		static_cast<CSceneCollisionManager*>(CollisionManager)->setSpatialIndex(0);
+		setSpatialIndex(0);
+		delete SpatialIndex;
+		SpatialIndex = 0;
+	}
+
+	if (!SpatialIndex)
+		return false;
+
+	SpatialIndex->update();
+	return true;
+}
+
+
 void CSceneManager::clearAllRegisteredNodesForRendering()
 {
 	CameraList.clear();
@@ -1444,6 +1691,64 @@ void CSceneManager::clearAllRegisteredNodesForRendering()
 	GuiNodeList.clear();
 }
 
+//! materials without alpha test write the same depth as EMT_SOLID
+static const video::E_MATERIAL_TYPE DepthPrepassOpaque[] =
+{
+	video::EMT_SOLID_2_LAYER, video::EMT_LIGHTMAP, video::EMT_LIGHTMAP_ADD,
+	video::EMT_LIGHTMAP_M2, video::EMT_LIGHTMAP_M4, video::EMT_LIGHTMAP_LIGHTING,
+	video::EMT_LIGHTMAP_LIGHTING_M2, video::EMT_LIGHTMAP_LIGHTING_M4, video::EMT_DETAIL_MAP,
+	video::EMT_SPHERE_MAP, video::EMT_REFLECTION_2_LAYER, video::EMT_NORMAL_MAP_SOLID,
+	video::EMT_PARALLAX_MAP_SOLID
+};
+
+//! a node takes part in the depth prepass if all its materials fill with the default depth test and depth writes
+static bool isDepthPrepassNode(ISceneNode* node, video::SOverrideMaterial& userOverride)
+{
+	const u32 count = node->getMaterialCount();
+	for (u32 i=0; i<count; ++i)
+	{
+		video::SMaterial overridden;
+		const video::SMaterial* material = &node->getMaterial(i);
+		if (userOverride.Enabled)
+		{
+			overridden = *material;
+			userOverride.apply(overridden);
+			material = &overridden;
+		}
+
+		if (material->ZBuffer != video::ECFN_LESSEQUAL || material->ZWriteEnable == video::EZW_OFF ||
+			material->Wireframe || material->PointCloud)
+			return false;
+
+		bool opaque = material->MaterialType == video::EMT_SOLID;
+		for (u32 k=0; k<sizeof(DepthPrepassOpaque)/sizeof(DepthPrepassOpaque[0]) && !opaque; ++k)
+			opaque = material->MaterialType == DepthPrepassOpaque[k];
+		if (!opaque)
+			return false;
+	}
+	return count > 0;
+}
+
+//! shading after the depth prepass. only nodes of the prepass get the equal depth test without depth writes
+static void setDepthPrepassShading(video::SOverrideMaterial& overrideMaterial, const video::SOverrideMaterial& userOverride, bool prepassNode)
+{
+	const u32 userFlags = userOverride.Enabled ? userOverride.EnableFlags : 0;
+	if (prepassNode)
+	{
+		overrideMaterial.Enabled = true;
+		overrideMaterial.EnableFlags = userFlags | video::EMF_ZBUFFER | video::EMF_ZWRITE_ENABLE;
+		overrideMaterial.Material.ZBuffer = video::ECFN_EQUAL;
+		overrideMaterial.Material.ZWriteEnable = video::EZW_OFF;
+	}
+	else
+	{
+		overrideMaterial.Enabled = userOverride.Enabled;
+		overrideMaterial.EnableFlags = userFlags;
+		overrideMaterial.Material.ZBuffer = userOverride.Material.ZBuffer;
+		overrideMaterial.Material.ZWriteEnable = userOverride.Material.ZWriteEnable;
+	}
+}
+
 //! This method is called just before the rendering process of the whole scene.
 //! draws all scene nodes
 void CSceneManager::drawAll()
@@ -1492,8 +1797,54 @@ void CSceneManager::drawAll()
 	}
 	IRR_PROFILE(getProfiler().stop(EPID_SM_RENDER_CAMERAS));
 
+	// classify the indexed nodes against the view frustum in one go
+	if (updateSpatialIndex() && ActiveCamera)
+	{
+		SpatialIndex->cullFrustum(*ActiveCamera->getViewFrustum());
+		SpatialIndexCulling = true;
+	}
+
+	// copy the nodes into arrays for the batched culling, its only user
+	const bool batchedCulling = ActiveCamera && Parameters->getAttributeAsBool(BATCHED_SCENE_CULLING);
+	if (!Parameters->getAttributeAsBool(FLAT_SCENE_STORE))
+	{
+		delete FlatStore;
+		FlatStore = 0;
+	}
+	else if (batchedCulling)
+	{
+		if (!FlatStore)
+			FlatStore = new CSceneFlatStore();
+		FlatStore->update(this);
+	}
+
+	// test the boxes of the visible nodes in batches
+	if (batchedCulling)
+	{
+		if (!FrustumCuller)
+			FrustumCuller = new CSceneFrustumCuller();
+		FrustumCuller->cull(this, *ActiveCamera->getViewFrustum(), FlatStore);
+		BatchedCulling = true;
+	}
+
+	// draw the occluders for EAC_OCC_SOFTWARE
+	if (ActiveCamera && OcclusionCuller && !OcclusionCuller->empty())
+	{
+		// nodes removed from the scene are kept alive by the occluder, they must not hide anything
+		OcclusionCuller->removeDetached(this);
+		OcclusionCuller->render(ActiveCamera);
+		OcclusionCulling = true;
+	}
+
 	// let all nodes register themselves
-	OnRegisterSceneNode();
+	if (Parameters->getAttributeAsBool(PARALLEL_SCENE_TRAVERSAL))
+		registerSceneNodesParallel();
+	else
+		OnRegisterSceneNode();
+
+	SpatialIndexCulling = false;
+	BatchedCulling = false;
+	OcclusionCulling = false;
 
 	if (LightManager)
 		LightManager->OnPreRender(LightList);
@@ -1597,7 +1948,42 @@ void CSceneManager::drawAll()
 		CurrentRenderPass = ESNRP_SOLID;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRenderPass) != 0);
 
-		SolidNodeList.sort(); // sort by textures
+		radixSort(SolidNodeList, SolidNodeSortBuffer); // sort by material and textures, then front to back
+
+		// depth only prepass, then shading with an equal depth test for the nodes of the prepass
+		const bool depthPrepass = SolidNodeList.size() > 0 &&
+			Parameters->getAttributeAsBool(DEPTH_PREPASS_SOLID) &&
+			Driver->queryFeature(video::EVDF_DEPTH_PREPASS);
+
+		video::SOverrideMaterial& overrideMaterial = Driver->getOverrideMaterial();
+		video::SOverrideMaterial overrideSaved;
+		if (depthPrepass)
+		{
+			overrideSaved = overrideMaterial;
+			if (!overrideSaved.Enabled)
+				overrideMaterial.reset();
+
+			for (i=0; i<sizeof(DepthPrepassOpaque)/sizeof(DepthPrepassOpaque[0]); ++i)
+				overrideMaterial.MaterialTypes.push_back(video::SOverrideMaterial::SMaterialTypeReplacement(DepthPrepassOpaque[i], video::EMT_SOLID));
+
+			overrideMaterial.Enabled = true;
+			overrideMaterial.EnableFlags |= video::EMF_COLOR_MASK | video::EMF_LIGHTING | video::EMF_FOG_ENABLE;
+			overrideMaterial.Material.ColorMask = video::ECP_NONE;
+			overrideMaterial.Material.Lighting = false;
+			overrideMaterial.Material.FogEnable = false;
+
+			// nodes with other depth states or alpha tested materials keep their own depth test
+			for (i=0; i<SolidNodeList.size(); ++i)
+			{
+				SolidNodeList[i].DepthPrepass = isDepthPrepassNode(SolidNodeList[i].Node, overrideSaved);
+				if (SolidNodeList[i].DepthPrepass)
+					SolidNodeList[i].Node->render();
+			}
+
+			// shading pass. keeps the materials of the user override
+			overrideMaterial.MaterialTypes.set_used(overrideMaterial.MaterialTypes.size() - sizeof(DepthPrepassOpaque)/sizeof(DepthPrepassOpaque[0]));
+			overrideMaterial.Material = overrideSaved.Material;
+		}
 
 		if (LightManager)
 		{
@@ -1605,6 +1991,8 @@ void CSceneManager::drawAll()
 			for (i=0; i<SolidNodeList.size(); ++i)
 			{
 				ISceneNode* node = SolidNodeList[i].Node;
+				if (depthPrepass)
+					setDepthPrepassShading(overrideMaterial, overrideSaved, SolidNodeList[i].DepthPrepass);
 				LightManager->OnNodePreRender(node);
 				node->render();
 				LightManager->OnNodePostRender(node);
@@ -1613,9 +2001,16 @@ void CSceneManager::drawAll()
 		else
 		{
 			for (i=0; i<SolidNodeList.size(); ++i)
+			{
+				if (depthPrepass)
+					setDepthPrepassShading(overrideMaterial, overrideSaved, SolidNodeList[i].DepthPrepass);
 				SolidNodeList[i].Node->render();
+			}
 		}
 
+		if (depthPrepass)
+			overrideMaterial = overrideSaved;
+
 #ifdef _IRR_SCENEMANAGER_DEBUG
 		Parameters->setAttribute("drawn_solid", (s32) SolidNodeList.size() );
 #endif
@@ -1664,7 +2059,7 @@ void CSceneManager::drawAll()
 		CurrentRenderPass = ESNRP_TRANSPARENT;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRenderPass) != 0);
 
-		TransparentNodeList.sort(); // sort by distance from camera
+		radixSort(TransparentNodeList, TransparentNodeSortBuffer); // sort by distance from camera
 		if (LightManager)
 		{
 			LightManager->OnRenderPassPreRender(CurrentRenderPass);
@@ -1698,7 +2093,7 @@ void CSceneManager::drawAll()
 		CurrentRenderPass = ESNRP_TRANSPARENT_EFFECT;
 		Driver->getOverrideMaterial().Enabled = ((Driver->getOverrideMaterial().EnablePasses & CurrentRenderPass) != 0);
 
-		TransparentEffectNodeList.sort(); // sort by distance from camera
+		radixSort(TransparentEffectNodeList, TransparentNodeSortBuffer); // sort by distance from camera
 
 		if (LightManager)
 		{
@@ -2165,6 +2560,7 @@ void CSceneManager::removeAll()
 {
 	ISceneNode::removeAll();
 	setActiveCamera(0);
+	removeAllOccluders();
 	// Make sure the driver is reset, might need a more complex method at some point
 	if (Driver)
 		Driver->setMaterial(video::SMaterial());
@@ -2178,6 +2574,43 @@ void CSceneManager::clear()
 }
 
 
+//! Adds a mesh which hides the scene nodes behind it
+void CSceneManager::addOccluder(ISceneNode* node, const IMesh* mesh)
+{
+	if (!node)
+		return;
+	if (!mesh)
+	{
+		if (node->getType() == ESNT_MESH)
+			mesh = static_cast<IMeshSceneNode*>(node)->getMesh();
+		else if (node->getType() == ESNT_ANIMATED_MESH && static_cast<IAnimatedMeshSceneNode*>(node)->getMesh())
+			mesh = static_cast<IAnimatedMeshSceneNode*>(node)->getMesh()->getMesh(0);
+		if (!mesh)
+			return;
+	}
+
+	if (!OcclusionCuller)
+		OcclusionCuller = new CSceneOcclusionCuller();
+	OcclusionCuller->addOccluder(node, mesh);
+}
+
+
+//! Removes the occluder of a scene node
+void CSceneManager::removeOccluder(ISceneNode* node)
+{
+	if (OcclusionCuller && node)
+		OcclusionCuller->removeOccluder(node);
+}
+
+
+//! Removes all occluders
+void CSceneManager::removeAllOccluders()
+{
+	if (OcclusionCuller)
+		OcclusionCuller->removeOccluder(0);
+}
+
+
 //! Returns interface to the parameters set in this scene.
 io::IAttributes* CSceneManager::getParameters()
 {
@@ -2609,9 +3042,9 @@ void CSceneManager::deserializeAttributes(io::IAttributes* in, io::SAttributeRea
 		Driver->setFog(color, fogType, start, end, density, pixelFog, rangeFog);
 	}
 
-	RelativeTranslation.set(0,0,0);
-	RelativeRotation.set(0,0,0);
-	RelativeScale.set(1,1,1);
+	setPosition(core::vector3df(0,0,0));
+	setRotation(core::vector3df(0,0,0));
+	setScale(core::vector3df(1,1,1));
 	IsVisible = true;
 	AutomaticCullingState = scene::EAC_BOX;
 	DebugDataVisible = scene::EDS_OFF;
@@ -16,6 +16,8 @@
 
 namespace irr
 {
+	class CThreadPool;
+
 namespace io
 {
 	class IFileSystem;
@@ -24,6 +26,10 @@ namespace scene
 {
 	class IMeshCache;
 	class IGeometryCreator;
+	class CSceneSpatialIndex;
+	class CSceneFrustumCuller;
+	class CSceneOcclusionCuller;
+	class CSceneFlatStore;
 
 	/*!
 		The Scene Manager manages scene nodes, mesh resources, cameras and all the other stuff.
@@ -97,6 +103,17 @@ namespace scene
 			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
 			bool alsoAddIfMeshPointerZero=false) IRR_OVERRIDE;
 
+		//! Adds a scene node for rendering many instances of a static mesh.
+		virtual IInstancedMeshSceneNode* addInstancedMeshSceneNode(IMesh* mesh, ISceneNode* parent=0, s32 id=-1,
+			const core::vector3df& position = core::vector3df(0,0,0),
+			const core::vector3df& rotation = core::vector3df(0,0,0),
+			const core::vector3df& scale = core::vector3df(1.0f, 1.0f, 1.0f),
+			bool alsoAddIfMeshPointerZero=false) IRR_OVERRIDE;
+
+		//! Adds a scene node drawing static mesh scene nodes merged into few meshbuffers
+		virtual IStaticBatchSceneNode* addStaticBatchSceneNode(ISceneNode* root=0, f32 chunkSize=256.f,
+			ISceneNode* parent=0, s32 id=-1) IRR_OVERRIDE;
+
 		//! Adds a scene node for rendering a animated water surface mesh.
 		virtual ISceneNode* addWaterSurfaceSceneNode(IMesh* mesh, f32 waveHeight, f32 waveSpeed, f32 wlength, ISceneNode* parent=0, s32 id=-1,
 			const core::vector3df& position = core::vector3df(0,0,0),
@@ -206,6 +223,10 @@ namespace scene
 		virtual IMeshSceneNode* addQuake3SceneNode(const IMeshBuffer* meshBuffer, const quake3::IShader * shader,
 			ISceneNode* parent=0, s32 id=-1) IRR_OVERRIDE;
 
+		//! Adds a scene node for the geometry of a quake3 level, culled with its vis data
+		virtual ISceneNode* addQuake3LevelSceneNode(IQ3LevelMesh* mesh,
+			ISceneNode* parent=0, s32 id=-1) IRR_OVERRIDE;
+
 
 		//! Adds a Hill Plane mesh to the mesh pool. The mesh is
 		//! generated on the fly and looks like a plane with some hills
@@ -436,6 +457,15 @@ namespace scene
 		//! Clears the whole scene. All scene nodes are removed.
 		virtual void clear() IRR_OVERRIDE;
 
+		//! Adds a mesh which hides the scene nodes behind it
+		virtual void addOccluder(ISceneNode* node, const IMesh* mesh=0) IRR_OVERRIDE;
+
+		//! Removes the occluder of a scene node
+		virtual void removeOccluder(ISceneNode* node) IRR_OVERRIDE;
+
+		//! Removes all occluders
+		virtual void removeAllOccluders() IRR_OVERRIDE;
+
 		//! Removes all children of this scene node
 		virtual void removeAll() IRR_OVERRIDE;
 
@@ -545,27 +575,24 @@ namespace scene
 		//! clears the deletion list
 		void clearDeletionList();
 
-		//! writes a scene node
-		void writeSceneNode(io::IXMLWriter* writer, ISceneNode* node, ISceneUserDataSerializer* userDataSerializer, const fschar_t* currentPath=0, bool init=false);
+		//! returns the pass a node is drawn in or ESNRP_NONE if it is culled
+		E_SCENE_NODE_RENDER_PASS getRenderPass(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass) const;
 
-		struct DefaultNodeEntry
-		{
-			DefaultNodeEntry(ISceneNode* n) :
-				Node(n), TextureValue(0)
-			{
-				if (n->getMaterialCount())
-					TextureValue = (n->getMaterial(0).getTexture(0));
-			}
+		//! adds a node which is not culled to the list of its render pass
+		u32 addToRenderList(ISceneNode* node, E_SCENE_NODE_RENDER_PASS pass);
 
-			bool operator < (const DefaultNodeEntry& other) const
-			{
-				return (TextureValue < other.TextureValue);
-			}
+		//! lets the top level subtrees register themselves in jobs of the traversal pool
+		void registerSceneNodesParallel();
 
-			ISceneNode* Node;
-			private:
-			void* TextureValue;
-		};
+		//! ThreadPoolJob of registerSceneNodesParallel
+		static void traversalJob(void* userData, u32 job);
+
+		//! creates or removes the spatial index as set by SPATIAL_SCENE_INDEX
+		/** \return true if the scene is indexed */
+		bool updateSpatialIndex();
+
+		//! writes a scene node
+		void writeSceneNode(io::IXMLWriter* writer, ISceneNode* node, ISceneUserDataSerializer* userDataSerializer, const fschar_t* currentPath=0, bool init=false);
 
 		/*
 			const core::aabbox3d<f32> box = Node->getTransformedBoundingBox();
@@ -589,25 +616,102 @@ namespace scene
 			return core::min_(l0, l1);
 		}
 
-		//! sort on distance (center) to camera
+		//! 12 bit material renderer and 28 bit hash of the textures of the first material
+		static inline u64 materialSortKey(ISceneNode* node)
+		{
+			if (!node->getMaterialCount())
+				return 0;
+
+			const video::SMaterial& material = node->getMaterial(0);
+			u32 textures = 0;
+			for (u32 i=0; i<video::MATERIAL_MAX_TEXTURES_USED; ++i)
+				textures = (textures ^ (u32)((size_t)material.getTexture(i) >> 4)) * 0x9E3779B1;
+
+			const u64 type = core::min_((u32)material.MaterialType, 0xFFFu);
+			return (type << 28) | (textures >> 4);
+		}
+
+		//! sort on material renderer, textures and front to back distance (sphere) to camera
+		struct DefaultNodeEntry
+		{
+			DefaultNodeEntry(ISceneNode* n, const core::vector3df& camera)
+				: Node(n), DepthPrepass(false)
+			{
+				// squared distance is positive, so its bits sort like the float. 24 bits are enough here
+				const f32 distance = estimatedSphereDistance(n, camera);
+				SortKey = (materialSortKey(n) << 24) | (core::IR(distance) >> 7);
+			}
+
+			ISceneNode* Node;
+			u64 SortKey;
+			//! drawn in the depth prepass and shaded with an equal depth test
+			bool DepthPrepass;
+		};
+
+		//! sort on distance (sphere) to camera back to front, then on material renderer and textures
 		struct TransparentNodeEntry
 		{
 			TransparentNodeEntry(ISceneNode* n, const core::vector3df& camera)
 				: Node(n)
 			{
 				//Distance = Node->getAbsoluteTransformation().getTranslation().getDistanceFromSQ(camera);
-				Distance = estimatedSphereDistance(n, camera);
+				const f32 distance = estimatedSphereDistance(n, camera);
+				SortKey = ((u64)~core::IR(distance) << 32) | (materialSortKey(n) >> 8);
 			}
 
-			bool operator < (const TransparentNodeEntry& other) const
+			ISceneNode* Node;
+			u64 SortKey;
+		};
+
+		//! stable sort on SortKey of DefaultNodeEntry or TransparentNodeEntry
+		/** Radix sort with 8 bits per pass. Passes in which all keys have the
+		same byte are skipped, which are most of them for small scenes. */
+		template <class T>
+		static void radixSort(core::array<T>& list, core::array<T>& scratch)
+		{
+			const u32 size = list.size();
+			if (size < 2)
+				return;
+
+			u32 histogram[8][256];
+			memset(histogram, 0, sizeof(histogram));
+			u32 i, b;
+			for (i=0; i<size; ++i)
 			{
-				return Distance > other.Distance;
+				const u64 key = list[i].SortKey;
+				for (b=0; b<8; ++b)
+					histogram[b][(key >> (b * 8)) & 0xFF] += 1;
 			}
 
-			ISceneNode* Node;
-			private:
-				f64 Distance;
-		};
+			scratch.set_used(size);
+			T* src = list.pointer();
+			T* dst = scratch.pointer();
+			for (b=0; b<8; ++b)
+			{
+				u32* count = histogram[b];
+				const u32 shift = b * 8;
+				if (count[(src[0].SortKey >> shift) & 0xFF] == size)
+					continue;
+
+				u32 offset = 0;
+				for (i=0; i<256; ++i)
+				{
+					const u32 c = count[i];
+					count[i] = offset;
+					offset += c;
+				}
+
+				for (i=0; i<size; ++i)
+					dst[count[(src[i].SortKey >> shift) & 0xFF]++] = src[i];
+
+				T* swap = src;
+				src = dst;
+				dst = swap;
+			}
+
+			if (src != list.pointer())
+				memcpy(list.pointer(), src, size * sizeof(T));
+		}
 
 		//! sort on distance (sphere) to camera
 		struct DistanceNodeEntry
@@ -635,6 +739,23 @@ namespace scene
 			f64 Distance;
 		};
 
+		//! nodes registered by one job of the parallel scene traversal
+		struct STraversalJob
+		{
+			STraversalJob() : Calls(0), Culled(0) {}
+
+			struct SEntry
+			{
+				ISceneNode* Node;
+				E_SCENE_NODE_RENDER_PASS Pass;
+			};
+
+			//! registered nodes which are not culled in registration order
+			core::array<SEntry> Entries;
+			u32 Calls;
+			u32 Culled;
+		};
+
 		//! video driver
 		video::IVideoDriver* Driver;
 
@@ -660,6 +781,10 @@ namespace scene
 		core::array<TransparentNodeEntry> TransparentEffectNodeList;
 		core::array<ISceneNode*> GuiNodeList;
 
+		//! scratch buffers of radixSort
+		core::array<DefaultNodeEntry> SolidNodeSortBuffer;
+		core::array<TransparentNodeEntry> TransparentNodeSortBuffer;
+
 		core::array<IMeshLoader*> MeshLoaderList;
 		core::array<ISceneLoader*> SceneLoaderList;
 		core::array<ISceneNode*> DeletionList;
@@ -693,6 +818,28 @@ namespace scene
 		const core::stringw IRR_XML_FORMAT_NODE_ATTR_TYPE;
 
 		IGeometryCreator* GeometryCreator;
+
+		//! parallel scene traversal. created when first used
+		CThreadPool* TraversalPool;
+		core::array<ISceneNode*> TraversalRoots;
+		core::array<STraversalJob> TraversalJobs;
+		core::array<STraversalJob*> TraversalJobOfThread;
+		bool TraversalActive;
+
+		//! spatial index of the scene. created when first used
+		CSceneSpatialIndex* SpatialIndex;
+		bool SpatialIndexCulling;
+
+		//! batched frustum culling. created when first used
+		CSceneFrustumCuller* FrustumCuller;
+		bool BatchedCulling;
+
+		//! software occlusion culling. created with the first occluder
+		CSceneOcclusionCuller* OcclusionCuller;
+		bool OcclusionCulling;
+
+		//! flat copy of the scene graph. created when first used
+		CSceneFlatStore* FlatStore;
 	};
 
 } // end namespace video
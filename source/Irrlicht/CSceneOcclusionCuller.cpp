@@ -0,0 +1,531 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CSceneOcclusionCuller.h"
+#include "ISceneNode.h"
+#include "ICameraSceneNode.h"
+#include "IMesh.h"
+#include "IMeshBuffer.h"
+#include "SViewFrustum.h"
+
+// SSE2 spans, the scalar code computes the same values
+#if !defined(IRR_SCENE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define IRR_SCENE_OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	// the depth buffer is small, it only has to find large occluded regions
+	const s32 Width = 256;
+	const s32 Height = 128;
+	const s32 TileSize = 8;
+	const s32 TilesX = Width / TileSize;
+	const s32 TilesY = Height / TileSize;
+
+	// widens the inner coverage test and the depth compare for float rounding
+	const f32 EdgeTolerance = 0.501f;
+	const f32 DepthTolerance = 1e-5f;
+
+	//! projects a point, returns false if it is in front of the near plane
+	inline bool projectPoint(const core::matrix4& mvp, const core::matrix4& world,
+		const core::plane3df& nearPlane, const core::vector3df& pos, f32* out)
+	{
+		core::vector3df wpos;
+		world.transformVect(wpos, pos);
+		if (nearPlane.getDistanceTo(wpos) > 0.f)
+			return false;
+
+		f32 clip[4];
+		mvp.transformVect(clip, pos);
+		if (!(clip[3] > 0.f))
+			return false;
+
+		const f32 iw = 1.f / clip[3];
+		out[0] = (clip[0] * iw + 1.f) * (0.5f * Width);
+		out[1] = (1.f - clip[1] * iw) * (0.5f * Height);
+		out[2] = clip[2] * iw;
+		return true;
+	}
+}
+
+
+//! constructor
+CSceneOcclusionCuller::CSceneOcclusionCuller()
+	: Valid(false)
+{
+	Depth.set_used(Width * Height + 4);
+	TileMax.set_used(TilesX * TilesY);
+}
+
+
+//! destructor
+CSceneOcclusionCuller::~CSceneOcclusionCuller()
+{
+	removeOccluder(0);
+}
+
+
+//! sets the mesh hiding the nodes behind it
+void CSceneOcclusionCuller::addOccluder(ISceneNode* node, const IMesh* mesh)
+{
+	if (!node || !mesh)
+		return;
+
+	mesh->grab();
+	for (u32 i = 0; i < Occluders.size(); ++i)
+	{
+		if (Occluders[i].Node == node)
+		{
+			Occluders[i].Mesh->drop();
+			Occluders[i].Mesh = mesh;
+			return;
+		}
+	}
+
+	node->grab();
+
+	SOccluder occluder;
+	occluder.Node = node;
+	occluder.Mesh = mesh;
+	Occluders.push_back(occluder);
+}
+
+
+//! removes the occluder of a node, all if node is 0
+void CSceneOcclusionCuller::removeOccluder(ISceneNode* node)
+{
+	u32 i = 0;
+	while (i < Occluders.size())
+	{
+		if (node && Occluders[i].Node != node)
+		{
+			++i;
+			continue;
+		}
+
+		Occluders[i].Node->drop();
+		Occluders[i].Mesh->drop();
+		Occluders.erase(i);
+	}
+	Valid = false;
+}
+
+
+//! removes the occluders of nodes which are no longer below root
+void CSceneOcclusionCuller::removeDetached(const ISceneNode* root)
+{
+	u32 i = 0;
+	while (i < Occluders.size())
+	{
+		const ISceneNode* top = Occluders[i].Node;
+		while (top->getParent())
+			top = top->getParent();
+
+		if (top == root)
+		{
+			++i;
+			continue;
+		}
+
+		Occluders[i].Node->drop();
+		Occluders[i].Mesh->drop();
+		Occluders.erase(i);
+		Valid = false;
+	}
+}
+
+
+//! draws the visible occluders as seen from the camera
+void CSceneOcclusionCuller::render(const ICameraSceneNode* camera)
+{
+	Valid = false;
+	if (!camera || Occluders.empty())
+		return;
+
+	ViewProjection.setbyproduct_nocheck(camera->getProjectionMatrix(), camera->getViewMatrix());
+	NearPlane = camera->getViewFrustum()->planes[SViewFrustum::VF_NEAR_PLANE];
+
+	for (u32 i = 0; i < Depth.size(); ++i)
+		Depth[i] = FLT_MAX;
+
+	core::matrix4 mvp(core::matrix4::EM4CONST_NOTHING);
+	for (u32 o = 0; o < Occluders.size(); ++o)
+	{
+		const SOccluder& occluder = Occluders[o];
+		if (!occluder.Node->isTrulyVisible())
+			continue;
+
+		const core::matrix4& world = occluder.Node->getAbsoluteTransformation();
+		mvp.setbyproduct_nocheck(ViewProjection, world);
+
+		for (u32 b = 0; b < occluder.Mesh->getMeshBufferCount(); ++b)
+		{
+			const IMeshBuffer* mb = occluder.Mesh->getMeshBuffer(b);
+			if (mb->getPrimitiveType() != EPT_TRIANGLES)
+				continue;
+
+			const u32 vertexCount = mb->getVertexCount();
+			Screen.set_used(vertexCount * 3);
+			for (u32 v = 0; v < vertexCount; ++v)
+			{
+				if (!projectPoint(mvp, world, NearPlane, mb->getPosition(v), &Screen[v * 3]))
+					Screen[v * 3] = FLT_MAX;
+			}
+
+			// triangles reaching in front of the near plane are clipped when
+			// rendered, so they can't be used as occluders
+			const u32 indexCount = mb->getIndexCount() - mb->getIndexCount() % 3;
+			const u16* indices16 = mb->getIndices();
+			const u32* indices32 = (const u32*)mb->getIndices();
+			const bool bit32 = mb->getIndexType() == video::EIT_32BIT;
+			u32 idx[6];
+			bool next = false;
+			for (u32 t = 0; t < indexCount; t += 3)
+			{
+				// the next triangle was read already
+				u32 k;
+				if (next)
+				{
+					for (k = 0; k < 3; ++k)
+						idx[k] = idx[k + 3];
+				}
+				else
+				{
+					for (k = 0; k < 3; ++k)
+						idx[k] = bit32 ? indices32[t + k] : indices16[t + k];
+				}
+				next = false;
+
+				if (!isDrawable(idx, vertexCount))
+					continue;
+
+				/*
+					Only pixels completely inside are covered, so the pixels along the
+					diagonal of a quad would stay open if both triangles were drawn on
+					their own. A quad as the next triangle shares an edge is drawn in one.
+				*/
+				if (t + 3 < indexCount)
+				{
+					for (k = 0; k < 3; ++k)
+						idx[k + 3] = bit32 ? indices32[t + 3 + k] : indices16[t + 3 + k];
+					next = true;
+
+					const f32* quad[4];
+					if (isDrawable(idx + 3, vertexCount) && getQuad(idx, quad))
+					{
+						SDepthPlane planes[2];
+						const bool p0 = getDepthPlane(&Screen[idx[0] * 3], &Screen[idx[1] * 3], &Screen[idx[2] * 3], planes[0]);
+						const bool p1 = getDepthPlane(&Screen[idx[3] * 3], &Screen[idx[4] * 3], &Screen[idx[5] * 3], planes[1]);
+						if (p0 && p1)
+						{
+							drawPolygon(quad, 4, planes, 2);
+							next = false;
+							t += 3;
+							continue;
+						}
+					}
+				}
+
+				const f32* triangle[3] = { &Screen[idx[0] * 3], &Screen[idx[1] * 3], &Screen[idx[2] * 3] };
+				SDepthPlane plane;
+				if (getDepthPlane(triangle[0], triangle[1], triangle[2], plane))
+					drawPolygon(triangle, 3, &plane, 1);
+			}
+		}
+	}
+
+	updateTiles();
+	Valid = true;
+}
+
+
+//! returns if all vertices of the triangle are valid and behind the near plane
+bool CSceneOcclusionCuller::isDrawable(const u32* idx, u32 vertexCount) const
+{
+	for (u32 k = 0; k < 3; ++k)
+	{
+		if (idx[k] >= vertexCount || Screen[idx[k] * 3] == FLT_MAX)
+			return false;
+	}
+	return true;
+}
+
+
+//! outline of two triangles sharing an edge, if they lie on both sides of it on the screen
+bool CSceneOcclusionCuller::getQuad(const u32* idx, const f32** quad) const
+{
+	// a is the corner of the first triangle not on the shared edge
+	for (u32 a = 0; a < 3; ++a)
+	{
+		const u32 s0 = idx[(a + 1) % 3];
+		const u32 s1 = idx[(a + 2) % 3];
+
+		u32 shared = 0;
+		u32 d = 0;
+		for (u32 k = 3; k < 6; ++k)
+		{
+			if (idx[k] == s0 || idx[k] == s1)
+				++shared;
+			else
+				d = idx[k];
+		}
+		if (shared != 2 || d == idx[a])
+			continue;
+
+		const f32* va = &Screen[idx[a] * 3];
+		const f32* vs0 = &Screen[s0 * 3];
+		const f32* vs1 = &Screen[s1 * 3];
+		const f32* vd = &Screen[d * 3];
+
+		// a folded quad could cover pixels neither triangle covers
+		const f32 ex = vs1[0] - vs0[0];
+		const f32 ey = vs1[1] - vs0[1];
+		const f32 sa = ex * (va[1] - vs0[1]) - ey * (va[0] - vs0[0]);
+		const f32 sd = ex * (vd[1] - vs0[1]) - ey * (vd[0] - vs0[0]);
+		if (!(sa * sd < 0.f))
+			return false;
+
+		quad[0] = va;
+		quad[1] = vs0;
+		quad[2] = vd;
+		quad[3] = vs1;
+		return true;
+	}
+	return false;
+}
+
+
+//! depth of a triangle over the screen, false if it is degenerated
+bool CSceneOcclusionCuller::getDepthPlane(const f32* v0, const f32* v1, const f32* v2, SDepthPlane& plane)
+{
+	const f32 area = (v1[0] - v0[0]) * (v2[1] - v0[1]) - (v2[0] - v0[0]) * (v1[1] - v0[1]);
+	if (!(fabsf(area) > 1e-6f))
+		return false;
+
+	plane.X = v0[0];
+	plane.Y = v0[1];
+	plane.Z = v0[2];
+	plane.DzDx = ((v1[2] - v0[2]) * (v2[1] - v0[1]) - (v2[2] - v0[2]) * (v1[1] - v0[1])) / area;
+	plane.DzDy = ((v2[2] - v0[2]) * (v1[0] - v0[0]) - (v1[2] - v0[2]) * (v2[0] - v0[0])) / area;
+
+	// from the center to the farthest corner of a pixel
+	plane.Offset = 0.5f * (fabsf(plane.DzDx) + fabsf(plane.DzDy));
+	return true;
+}
+
+
+//! draws a convex or star shaped polygon of screen space x, y and depth
+void CSceneOcclusionCuller::drawPolygon(const f32* const* v, u32 count, const SDepthPlane* planes, u32 planeCount)
+{
+	f32 area = 0.f;
+	f32 minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX;
+	u32 i;
+	for (i = 0; i < count; ++i)
+	{
+		const f32* a = v[i];
+		const f32* b = v[(i + 1) % count];
+		area += a[0] * b[1] - b[0] * a[1];
+		minX = core::min_(minX, a[0]);
+		maxX = core::max_(maxX, a[0]);
+		minY = core::min_(minY, a[1]);
+		maxY = core::max_(maxY, a[1]);
+	}
+
+	// only pixels completely inside the polygon are covered
+	const s32 x0 = core::s32_max(core::ceil32(minX), 0);
+	const s32 x1 = core::s32_min(core::floor32(maxX), Width);
+	const s32 y0 = core::s32_max(core::ceil32(minY), 0);
+	const s32 y1 = core::s32_min(core::floor32(maxY), Height);
+	if (x0 >= x1 || y0 >= y1)
+		return;
+
+	// both sides occlude, edge i from vertex i to the next one is E = A * (x - xi) + B * (y - yi), positive inside
+	const f32 side = area < 0.f ? -1.f : 1.f;
+	f32 A[4], B[4], T[4];
+	for (i = 0; i < count; ++i)
+	{
+		const f32* a = v[i];
+		const f32* b = v[(i + 1) % count];
+		A[i] = side * (a[1] - b[1]);
+		B[i] = side * (b[0] - a[0]);
+		// the edge function is smallest in this corner of the pixel
+		T[i] = EdgeTolerance * (fabsf(A[i]) + fabsf(B[i]));
+	}
+
+	for (s32 y = y0; y < y1; ++y)
+	{
+		const f32 cy = (f32)y + 0.5f;
+		f32* row = &Depth[y * Width];
+
+		s32 x = x0;
+#ifdef IRR_SCENE_OCCLUSION_SSE2
+		const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 end = _mm_set1_ps((f32)x1);
+		for (; x < x1; x += 4)
+		{
+			const __m128 cx = _mm_add_ps(_mm_set1_ps((f32)x), offsets);
+			__m128 inside = _mm_cmplt_ps(cx, end);
+			for (i = 0; i < count; ++i)
+			{
+				const __m128 e = _mm_add_ps(
+					_mm_mul_ps(_mm_set1_ps(A[i]), _mm_sub_ps(cx, _mm_set1_ps(v[i][0]))),
+					_mm_set1_ps(B[i] * (cy - v[i][1])));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(e, _mm_set1_ps(T[i])));
+			}
+			if (!_mm_movemask_ps(inside))
+				continue;
+
+			__m128 z = _mm_set1_ps(-FLT_MAX);
+			for (i = 0; i < planeCount; ++i)
+			{
+				const SDepthPlane& p = planes[i];
+				const __m128 pz = _mm_add_ps(_mm_add_ps(_mm_set1_ps(p.Z),
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.DzDx), _mm_sub_ps(cx, _mm_set1_ps(p.X))),
+						_mm_set1_ps(p.DzDy * (cy - p.Y)))), _mm_set1_ps(p.Offset));
+				z = _mm_max_ps(z, pz);
+			}
+
+			const __m128 old = _mm_loadu_ps(row + x);
+			const __m128 nearer = _mm_min_ps(old, z);
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer), _mm_andnot_ps(inside, old)));
+		}
+#else
+		for (; x < x1; ++x)
+		{
+			const f32 cx = (f32)x + 0.5f;
+			bool inside = true;
+			for (i = 0; i < count; ++i)
+				inside &= A[i] * (cx - v[i][0]) + B[i] * (cy - v[i][1]) >= T[i];
+			if (!inside)
+				continue;
+
+			f32 z = -FLT_MAX;
+			for (i = 0; i < planeCount; ++i)
+			{
+				const SDepthPlane& p = planes[i];
+				z = core::max_(z, (p.Z + (p.DzDx * (cx - p.X) + p.DzDy * (cy - p.Y))) + p.Offset);
+			}
+			if (z < row[x])
+				row[x] = z;
+		}
+#endif
+	}
+}
+
+
+//! updates the farthest depth of each tile
+void CSceneOcclusionCuller::updateTiles()
+{
+	for (s32 ty = 0; ty < TilesY; ++ty)
+	{
+		for (s32 tx = 0; tx < TilesX; ++tx)
+		{
+			const f32* tile = &Depth[ty * TileSize * Width + tx * TileSize];
+#ifdef IRR_SCENE_OCCLUSION_SSE2
+			__m128 m = _mm_loadu_ps(tile);
+			for (s32 y = 0; y < TileSize; ++y)
+			{
+				const f32* row = tile + y * Width;
+				m = _mm_max_ps(m, _mm_max_ps(_mm_loadu_ps(row), _mm_loadu_ps(row + 4)));
+			}
+			m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+			m = _mm_max_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+			TileMax[ty * TilesX + tx] = _mm_cvtss_f32(m);
+#else
+			f32 m = tile[0];
+			for (s32 y = 0; y < TileSize; ++y)
+				for (s32 x = 0; x < TileSize; ++x)
+					m = core::max_(m, tile[y * Width + x]);
+			TileMax[ty * TilesX + tx] = m;
+#endif
+		}
+	}
+}
+
+
+//! returns if the box of the node is hidden behind the occluders
+bool CSceneOcclusionCuller::isOccluded(const ISceneNode* node) const
+{
+	if (!Valid)
+		return false;
+
+	core::vector3df edges[8];
+	node->getBoundingBox().getEdges(edges);
+
+	const core::matrix4& world = node->getAbsoluteTransformation();
+	core::matrix4 mvp(core::matrix4::EM4CONST_NOTHING);
+	mvp.setbyproduct_nocheck(ViewProjection, world);
+
+	// screen rectangle and nearest depth of the box
+	f32 minX = FLT_MAX, minY = FLT_MAX, maxX = -FLT_MAX, maxY = -FLT_MAX, minZ = FLT_MAX;
+	for (u32 i = 0; i < 8; ++i)
+	{
+		f32 p[3];
+		if (!projectPoint(mvp, world, NearPlane, edges[i], p))
+			return false;
+
+		minX = core::min_(minX, p[0]);
+		maxX = core::max_(maxX, p[0]);
+		minY = core::min_(minY, p[1]);
+		maxY = core::max_(maxY, p[1]);
+		minZ = core::min_(minZ, p[2]);
+	}
+
+	// all pixels the box touches
+	const s32 x0 = core::s32_max(core::floor32(minX), 0);
+	const s32 x1 = core::s32_min(core::ceil32(maxX), Width);
+	const s32 y0 = core::s32_max(core::floor32(minY), 0);
+	const s32 y1 = core::s32_min(core::ceil32(maxY), Height);
+
+	// off screen or degenerated, left to the frustum tests
+	if (x0 >= x1 || y0 >= y1)
+		return false;
+
+	const f32 limit = minZ - DepthTolerance * (fabsf(minZ) + 1.f);
+
+	for (s32 ty = y0 / TileSize; ty <= (y1 - 1) / TileSize; ++ty)
+	{
+		for (s32 tx = x0 / TileSize; tx <= (x1 - 1) / TileSize; ++tx)
+		{
+			// the whole tile is in front of the box
+			if (TileMax[ty * TilesX + tx] < limit)
+				continue;
+
+			const s32 sx = core::s32_max(x0, tx * TileSize);
+			const s32 ex = core::s32_min(x1, (tx + 1) * TileSize);
+			const s32 sy = core::s32_max(y0, ty * TileSize);
+			const s32 ey = core::s32_min(y1, (ty + 1) * TileSize);
+
+			for (s32 y = sy; y < ey; ++y)
+			{
+				const f32* row = &Depth[y * Width];
+				s32 x = sx;
+#ifdef IRR_SCENE_OCCLUSION_SSE2
+				const __m128 l = _mm_set1_ps(limit);
+				for (; x + 4 <= ex; x += 4)
+				{
+					if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), l)))
+						return false;
+				}
+#endif
+				for (; x < ex; ++x)
+				{
+					if (row[x] >= limit)
+						return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+} // end namespace scene
+} // end namespace irr
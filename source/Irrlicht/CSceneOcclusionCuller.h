@@ -0,0 +1,98 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_SCENE_OCCLUSION_CULLER_H_INCLUDED
+#define IRR_C_SCENE_OCCLUSION_CULLER_H_INCLUDED
+
+#include "irrArray.h"
+#include "matrix4.h"
+#include "plane3d.h"
+
+namespace irr
+{
+namespace scene
+{
+	class ISceneNode;
+	class ICameraSceneNode;
+	class IMesh;
+
+	//! Software occlusion culling for nodes with EAC_OCC_SOFTWARE
+	/** Rasterizes the occluder meshes into a small depth buffer on the
+	cpu and tests the screen rectangles of node boxes against it. Both
+	sides are conservative: occluders only cover pixels they cover
+	completely and write the farthest depth inside the pixel, boxes
+	touch all pixels they overlap with their nearest depth. So a node
+	is never culled while a part of its box could be seen. */
+	class CSceneOcclusionCuller
+	{
+	public:
+
+		//! constructor
+		CSceneOcclusionCuller();
+
+		//! destructor
+		~CSceneOcclusionCuller();
+
+		//! sets the mesh hiding the nodes behind it, drawn with the transformation of the node
+		void addOccluder(ISceneNode* node, const IMesh* mesh);
+
+		//! removes the occluder of a node, all if node is 0
+		void removeOccluder(ISceneNode* node);
+
+		//! removes the occluders of nodes which are no longer below root
+		void removeDetached(const ISceneNode* root);
+
+		//! returns true if there are no occluders
+		bool empty() const { return Occluders.empty(); }
+
+		//! draws the visible occluders as seen from the camera
+		void render(const ICameraSceneNode* camera);
+
+		//! returns if the box of the node is hidden behind the occluders of the last render()
+		bool isOccluded(const ISceneNode* node) const;
+
+	private:
+
+		struct SOccluder
+		{
+			ISceneNode* Node;
+			const IMesh* Mesh;
+		};
+
+		//! depth of a triangle as a plane in screen space
+		struct SDepthPlane
+		{
+			f32 X, Y, Z;
+			f32 DzDx, DzDy;
+			f32 Offset;	// to the farthest corner of a pixel
+		};
+
+		bool isDrawable(const u32* idx, u32 vertexCount) const;
+		bool getQuad(const u32* idx, const f32** quad) const;
+		static bool getDepthPlane(const f32* v0, const f32* v1, const f32* v2, SDepthPlane& plane);
+
+		//! draws a polygon of up to 4 screen space vertices with x, y and depth
+		void drawPolygon(const f32* const* v, u32 count, const SDepthPlane* planes, u32 planeCount);
+
+		//! updates the farthest depth of each tile
+		void updateTiles();
+
+		core::array<SOccluder> Occluders;
+
+		// depth (z/w) per pixel with padding for 4 wide access, FLT_MAX where nothing is drawn
+		core::array<f32> Depth;
+		core::array<f32> TileMax;
+
+		// projected vertices of a mesh buffer, x, y and depth. x is FLT_MAX in front of the near plane
+		core::array<f32> Screen;
+
+		core::matrix4 ViewProjection;
+		core::plane3df NearPlane;
+		bool Valid;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
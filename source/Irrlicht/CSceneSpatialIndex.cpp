@@ -0,0 +1,528 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CSceneSpatialIndex.h"
+#include "ISceneNode.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! half the surface area, cost of a tree node
+	inline f32 surfaceArea(const core::aabbox3df& box)
+	{
+		const core::vector3df e = box.getExtent();
+		return e.X * e.Y + e.Y * e.Z + e.Z * e.X;
+	}
+
+	inline core::aabbox3df merge(const core::aabbox3df& a, const core::aabbox3df& b)
+	{
+		core::aabbox3df box(a);
+		box.addInternalBox(b);
+		return box;
+	}
+
+	//! -1 if the box is outside of the frustum, 1 if completely inside, 0 otherwise
+	s32 classifyBox(const SViewFrustum& frustum, const core::aabbox3df& box)
+	{
+		s32 result = 1;
+		for (u32 i = 0; i < SViewFrustum::VF_PLANE_COUNT; ++i)
+		{
+			const core::plane3df& plane = frustum.planes[i];
+
+			// corner farthest behind the plane. Normals point out of the frustum
+			const core::vector3df n(plane.Normal.X > 0.f ? box.MinEdge.X : box.MaxEdge.X,
+				plane.Normal.Y > 0.f ? box.MinEdge.Y : box.MaxEdge.Y,
+				plane.Normal.Z > 0.f ? box.MinEdge.Z : box.MaxEdge.Z);
+			if (plane.Normal.dotProduct(n) + plane.D > core::ROUNDING_ERROR_f32)
+				return -1;
+
+			const core::vector3df p(plane.Normal.X > 0.f ? box.MaxEdge.X : box.MinEdge.X,
+				plane.Normal.Y > 0.f ? box.MaxEdge.Y : box.MinEdge.Y,
+				plane.Normal.Z > 0.f ? box.MaxEdge.Z : box.MinEdge.Z);
+			if (plane.Normal.dotProduct(p) + plane.D > 0.f)
+				result = 0;
+		}
+		return result;
+	}
+
+	//! slab test of the segment start + t*dir, t in [0,1]
+	bool segmentHitsBox(const core::vector3df& start, const core::vector3df& dir, const core::aabbox3df& box)
+	{
+		f32 tmin = 0.f;
+		f32 tmax = 1.f;
+		const f32* s = &start.X;
+		const f32* d = &dir.X;
+		const f32* minEdge = &box.MinEdge.X;
+		const f32* maxEdge = &box.MaxEdge.X;
+		for (u32 i = 0; i < 3; ++i)
+		{
+			if (core::iszero(d[i]))
+			{
+				if (s[i] < minEdge[i] || s[i] > maxEdge[i])
+					return false;
+				continue;
+			}
+
+			const f32 inv = 1.f / d[i];
+			f32 t0 = (minEdge[i] - s[i]) * inv;
+			f32 t1 = (maxEdge[i] - s[i]) * inv;
+			if (t0 > t1)
+				core::swap(t0, t1);
+			tmin = core::max_(tmin, t0);
+			tmax = core::min_(tmax, t1);
+			if (tmin > tmax)
+				return false;
+		}
+		return true;
+	}
+}
+
+
+//! constructor
+CSceneSpatialIndex::CSceneSpatialIndex(ISceneNode* root)
+	: Root(root), FreeEntry(-1), EntryCount(0), TreeRoot(-1), FreeTreeNode(-1), Stamp(0)
+{
+}
+
+
+//! destructor
+CSceneSpatialIndex::~CSceneSpatialIndex()
+{
+	for (u32 i = 0; i < Entries.size(); ++i)
+	{
+		if (Entries[i].Node)
+			Entries[i].Node->setSpatialIndexSlot(-1);
+	}
+}
+
+
+//! marks the node for update()
+void CSceneSpatialIndex::nodeMoved(ISceneNode* node)
+{
+	if (node == Root)
+		return;
+
+	s32 slot = node->getSpatialIndexSlot();
+	if (slot < 0)
+	{
+		if (FreeEntry >= 0)
+		{
+			slot = FreeEntry;
+			FreeEntry = Entries[slot].NextFree;
+		}
+		else
+		{
+			slot = (s32)Entries.size();
+			Entries.push_back(SEntry());
+		}
+
+		SEntry& entry = Entries[slot];
+		entry.Node = node;
+		entry.Leaf = -1;
+		entry.NextFree = -1;
+		entry.TransformVersion = 0;
+		entry.Stamp = 0;
+		entry.Inside = false;
+		entry.Dirty = false;
+
+		node->setSpatialIndexSlot(slot);
+		++EntryCount;
+	}
+
+	SEntry& entry = Entries[slot];
+	if (!entry.Dirty)
+	{
+		entry.Dirty = true;
+		Moved.push_back(slot);
+	}
+}
+
+
+//! removes the node from the index
+void CSceneSpatialIndex::nodeRemoved(ISceneNode* node)
+{
+	const s32 slot = node->getSpatialIndexSlot();
+	if (node == Root || slot < 0)
+		return;
+
+	SEntry& entry = Entries[slot];
+	if (entry.Leaf >= 0)
+	{
+		removeLeaf(entry.Leaf);
+		freeTreeNode(entry.Leaf);
+	}
+
+	// the slot might still be in Moved, update() skips free entries
+	entry.Node = 0;
+	entry.Leaf = -1;
+	entry.Dirty = false;
+	entry.NextFree = FreeEntry;
+	FreeEntry = slot;
+	--EntryCount;
+
+	node->setSpatialIndexSlot(-1);
+}
+
+
+//! reinserts the moved nodes which left their leaf box
+void CSceneSpatialIndex::update()
+{
+	// bounding boxes of animated nodes change without a move
+	for (u32 i = 0; i < Entries.size(); ++i)
+	{
+		SEntry& entry = Entries[i];
+		if (entry.Node && !entry.Dirty && entry.LocalBox != entry.Node->getBoundingBox())
+		{
+			entry.Dirty = true;
+			Moved.push_back(i);
+		}
+	}
+
+	for (u32 i = 0; i < Moved.size(); ++i)
+	{
+		const s32 slot = Moved[i];
+		SEntry& entry = Entries[slot];
+		if (!entry.Node || !entry.Dirty)
+			continue;
+		entry.Dirty = false;
+
+		entry.LocalBox = entry.Node->getBoundingBox();
+		entry.TransformVersion = entry.Node->getTransformationVersion();
+		core::aabbox3df box(entry.LocalBox);
+		entry.Node->getAbsoluteTransformation().transformBoxEx(box);
+
+		if (entry.Leaf >= 0)
+		{
+			if (box.isFullInside(Tree[entry.Leaf].Box))
+				continue;
+			removeLeaf(entry.Leaf);
+		}
+		else
+			entry.Leaf = allocateTreeNode();
+
+		// margin, so small movements don't change the tree
+		const core::vector3df margin = box.getExtent() * 0.125f;
+		box.MinEdge -= margin;
+		box.MaxEdge += margin;
+
+		STreeNode& leaf = Tree[entry.Leaf];
+		leaf.Box = box;
+		leaf.Entry = slot;
+		insertLeaf(entry.Leaf);
+	}
+
+	Moved.set_used(0);
+}
+
+
+//! classifies the leaves against the frustum
+void CSceneSpatialIndex::cullFrustum(const SViewFrustum& frustum)
+{
+	++Stamp;
+	if (TreeRoot < 0)
+		return;
+
+	Stack.set_used(0);
+	Stack.push_back(TreeRoot);
+	while (Stack.size())
+	{
+		const s32 index = Stack.getLast();
+		Stack.set_used(Stack.size() - 1);
+
+		const STreeNode& node = Tree[index];
+		const s32 state = classifyBox(frustum, node.Box);
+
+		// leaves not reached keep their old stamp and count as outside
+		if (state < 0)
+			continue;
+
+		if (state > 0)
+			markInside(index);
+		else if (node.Child[0] < 0)
+		{
+			SEntry& entry = Entries[node.Entry];
+			entry.Stamp = Stamp;
+			entry.Inside = false;
+		}
+		else
+		{
+			Stack.push_back(node.Child[0]);
+			Stack.push_back(node.Child[1]);
+		}
+	}
+}
+
+
+//! state of the node in the last cullFrustum()
+CSceneSpatialIndex::E_FRUSTUM_STATE CSceneSpatialIndex::getFrustumState(const ISceneNode* node) const
+{
+	const s32 slot = node->getSpatialIndexSlot();
+	if (slot < 0 || node->getSpatialIndex() != this)
+		return EFS_UNKNOWN;
+
+	const SEntry& entry = Entries[slot];
+	if (entry.Dirty || entry.Leaf < 0)
+		return EFS_UNKNOWN;
+
+	// animated nodes change their box, moved nodes may not be updated yet
+	if (entry.LocalBox != node->getBoundingBox() || entry.TransformVersion != node->getTransformationVersion())
+		return EFS_UNKNOWN;
+
+	if (entry.Stamp != Stamp)
+		return EFS_OUTSIDE;
+
+	return entry.Inside ? EFS_INSIDE : EFS_UNKNOWN;
+}
+
+
+//! appends all nodes with leaf boxes crossed by the line
+void CSceneSpatialIndex::getNodesOnLine(const core::line3df& line, core::array<ISceneNode*>& outNodes) const
+{
+	if (TreeRoot < 0)
+		return;
+
+	const core::vector3df dir = line.end - line.start;
+
+	Stack.set_used(0);
+	Stack.push_back(TreeRoot);
+	while (Stack.size())
+	{
+		const STreeNode& node = Tree[Stack.getLast()];
+		Stack.set_used(Stack.size() - 1);
+
+		if (!segmentHitsBox(line.start, dir, node.Box))
+			continue;
+
+		if (node.Child[0] < 0)
+			outNodes.push_back(Entries[node.Entry].Node);
+		else
+		{
+			Stack.push_back(node.Child[0]);
+			Stack.push_back(node.Child[1]);
+		}
+	}
+}
+
+
+s32 CSceneSpatialIndex::allocateTreeNode()
+{
+	s32 index;
+	if (FreeTreeNode >= 0)
+	{
+		index = FreeTreeNode;
+		FreeTreeNode = Tree[index].Parent;
+	}
+	else
+	{
+		index = (s32)Tree.size();
+		Tree.push_back(STreeNode());
+	}
+
+	STreeNode& node = Tree[index];
+	node.Parent = -1;
+	node.Child[0] = -1;
+	node.Child[1] = -1;
+	node.Height = 0;
+	node.Entry = -1;
+	return index;
+}
+
+
+void CSceneSpatialIndex::freeTreeNode(s32 index)
+{
+	Tree[index].Parent = FreeTreeNode;
+	Tree[index].Height = -1;
+	FreeTreeNode = index;
+}
+
+
+//! inserts the leaf next to the sibling which grows the tree the least
+void CSceneSpatialIndex::insertLeaf(s32 leaf)
+{
+	if (TreeRoot < 0)
+	{
+		TreeRoot = leaf;
+		Tree[leaf].Parent = -1;
+		return;
+	}
+
+	const core::aabbox3df leafBox = Tree[leaf].Box;
+	s32 index = TreeRoot;
+	while (Tree[index].Child[0] >= 0)
+	{
+		const STreeNode& node = Tree[index];
+		const f32 area = surfaceArea(node.Box);
+		const f32 combinedArea = surfaceArea(merge(node.Box, leafBox));
+
+		// cost of a new parent for this node and the leaf
+		const f32 cost = 2.f * combinedArea;
+
+		// the box of this node grows when the leaf moves further down
+		const f32 inheritanceCost = 2.f * (combinedArea - area);
+
+		f32 childCost[2];
+		for (u32 i = 0; i < 2; ++i)
+		{
+			const STreeNode& child = Tree[node.Child[i]];
+			childCost[i] = surfaceArea(merge(child.Box, leafBox)) + inheritanceCost;
+			if (child.Child[0] >= 0)
+				childCost[i] -= surfaceArea(child.Box);
+		}
+
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = childCost[0] < childCost[1] ? node.Child[0] : node.Child[1];
+	}
+
+	const s32 sibling = index;
+	const s32 oldParent = Tree[sibling].Parent;
+	const s32 newParent = allocateTreeNode();
+
+	STreeNode& parent = Tree[newParent];
+	parent.Parent = oldParent;
+	parent.Box = merge(leafBox, Tree[sibling].Box);
+	parent.Height = Tree[sibling].Height + 1;
+	parent.Child[0] = sibling;
+	parent.Child[1] = leaf;
+	Tree[sibling].Parent = newParent;
+	Tree[leaf].Parent = newParent;
+
+	if (oldParent >= 0)
+	{
+		STreeNode& p = Tree[oldParent];
+		p.Child[p.Child[0] == sibling ? 0 : 1] = newParent;
+	}
+	else
+		TreeRoot = newParent;
+
+	refit(newParent);
+}
+
+
+//! removes the leaf from the tree, the tree node of the leaf stays allocated
+void CSceneSpatialIndex::removeLeaf(s32 leaf)
+{
+	if (leaf == TreeRoot)
+	{
+		TreeRoot = -1;
+		return;
+	}
+
+	const s32 parent = Tree[leaf].Parent;
+	const s32 grandParent = Tree[parent].Parent;
+	const s32 sibling = Tree[parent].Child[Tree[parent].Child[0] == leaf ? 1 : 0];
+
+	Tree[sibling].Parent = grandParent;
+	freeTreeNode(parent);
+
+	if (grandParent >= 0)
+	{
+		STreeNode& g = Tree[grandParent];
+		g.Child[g.Child[0] == parent ? 0 : 1] = sibling;
+		refit(grandParent);
+	}
+	else
+		TreeRoot = sibling;
+
+	Tree[leaf].Parent = -1;
+}
+
+
+//! rotates the higher child of an unbalanced node up. Returns the new root of the subtree
+s32 CSceneSpatialIndex::balance(s32 index)
+{
+	const STreeNode& node = Tree[index];
+	if (node.Height < 2)
+		return index;
+
+	const s32 diff = Tree[node.Child[1]].Height - Tree[node.Child[0]].Height;
+	if (diff > 1)
+		return rotateUp(index, 1);
+	if (diff < -1)
+		return rotateUp(index, 0);
+	return index;
+}
+
+
+//! replaces node a by its child c, a takes the place of the lower child of c
+s32 CSceneSpatialIndex::rotateUp(s32 index, u32 child)
+{
+	STreeNode& a = Tree[index];
+	const s32 ib = a.Child[1 - child];
+	const s32 ic = a.Child[child];
+	STreeNode& c = Tree[ic];
+	const s32 i0 = c.Child[0];
+	const s32 i1 = c.Child[1];
+
+	c.Child[0] = index;
+	c.Parent = a.Parent;
+	a.Parent = ic;
+
+	if (c.Parent >= 0)
+	{
+		STreeNode& p = Tree[c.Parent];
+		p.Child[p.Child[0] == index ? 0 : 1] = ic;
+	}
+	else
+		TreeRoot = ic;
+
+	const s32 keep = Tree[i0].Height > Tree[i1].Height ? i0 : i1;
+	const s32 move = keep == i0 ? i1 : i0;
+
+	c.Child[1] = keep;
+	a.Child[child] = move;
+	Tree[move].Parent = index;
+
+	a.Box = merge(Tree[ib].Box, Tree[move].Box);
+	a.Height = 1 + core::max_(Tree[ib].Height, Tree[move].Height);
+	c.Box = merge(a.Box, Tree[keep].Box);
+	c.Height = 1 + core::max_(a.Height, Tree[keep].Height);
+
+	return ic;
+}
+
+
+//! fixes boxes and heights from the tree node up to the root
+void CSceneSpatialIndex::refit(s32 index)
+{
+	while (index >= 0)
+	{
+		index = balance(index);
+
+		STreeNode& node = Tree[index];
+		const STreeNode& c0 = Tree[node.Child[0]];
+		const STreeNode& c1 = Tree[node.Child[1]];
+		node.Height = 1 + core::max_(c0.Height, c1.Height);
+		node.Box = merge(c0.Box, c1.Box);
+
+		index = node.Parent;
+	}
+}
+
+
+//! marks all leaves below the tree node as inside of the frustum
+void CSceneSpatialIndex::markInside(s32 index)
+{
+	const STreeNode& node = Tree[index];
+	if (node.Child[0] < 0)
+	{
+		SEntry& entry = Entries[node.Entry];
+		entry.Stamp = Stamp;
+		entry.Inside = true;
+	}
+	else
+	{
+		markInside(node.Child[0]);
+		markInside(node.Child[1]);
+	}
+}
+
+} // end namespace scene
+} // end namespace irr
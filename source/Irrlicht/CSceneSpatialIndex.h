@@ -0,0 +1,119 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_SCENE_SPATIAL_INDEX_H_INCLUDED
+#define IRR_C_SCENE_SPATIAL_INDEX_H_INCLUDED
+
+#include "ISceneNodeSpatialIndex.h"
+#include "irrArray.h"
+#include "aabbox3d.h"
+#include "line3d.h"
+#include "matrix4.h"
+
+namespace irr
+{
+namespace scene
+{
+	struct SViewFrustum;
+
+	//! Dynamic AABB tree over the world space bounding boxes of the nodes of a scene
+	/** Leaves hold boxes enlarged by a margin, so a node moving a bit stays
+	in its leaf. Moved nodes are only marked and reinserted by update(). */
+	class CSceneSpatialIndex : public ISceneNodeSpatialIndex
+	{
+	public:
+
+		//! result of the last frustum query for a node
+		enum E_FRUSTUM_STATE
+		{
+			//! index can't tell, node has to be tested
+			EFS_UNKNOWN = 0,
+
+			//! node is outside of the frustum
+			EFS_OUTSIDE,
+
+			//! node is completely inside of the frustum
+			EFS_INSIDE
+		};
+
+		//! constructor. The root node itself is not indexed.
+		CSceneSpatialIndex(ISceneNode* root);
+
+		//! destructor
+		virtual ~CSceneSpatialIndex();
+
+		//! marks the node for update()
+		virtual void nodeMoved(ISceneNode* node) IRR_OVERRIDE;
+
+		//! removes the node from the index
+		virtual void nodeRemoved(ISceneNode* node) IRR_OVERRIDE;
+
+		//! reinserts the moved nodes and nodes with a changed bounding box which left their leaf box
+		void update();
+
+		//! classifies the leaves against the frustum. Call update() before.
+		void cullFrustum(const SViewFrustum& frustum);
+
+		//! state of the node in the last cullFrustum()
+		/** Only valid if the node, its bounding box and its absolute
+		transformation did not change since the last update(). */
+		E_FRUSTUM_STATE getFrustumState(const ISceneNode* node) const;
+
+		//! appends all nodes with leaf boxes crossed by the line. Call update() before.
+		void getNodesOnLine(const core::line3df& line, core::array<ISceneNode*>& outNodes) const;
+
+		//! amount of indexed nodes
+		u32 getNodeCount() const { return EntryCount; }
+
+	private:
+
+		struct SEntry
+		{
+			ISceneNode* Node;			// 0 if free
+			core::aabbox3df LocalBox;	// bounding box of the node when the leaf was set
+			u32 TransformVersion;		// transformation version of the node then
+			s32 Leaf;					// tree node, -1 if not inserted yet
+			s32 NextFree;
+			u32 Stamp;					// cullFrustum() which classified the leaf
+			bool Inside;
+			bool Dirty;					// in Moved, leaf box is outdated
+		};
+
+		struct STreeNode
+		{
+			core::aabbox3df Box;
+			s32 Parent;					// next free node if unused
+			s32 Child[2];				// -1 for leaves
+			s32 Height;					// 0 for leaves
+			s32 Entry;					// of leaves
+		};
+
+		s32 allocateTreeNode();
+		void freeTreeNode(s32 index);
+		void insertLeaf(s32 leaf);
+		void removeLeaf(s32 leaf);
+		s32 balance(s32 index);
+		s32 rotateUp(s32 index, u32 child);
+		void refit(s32 index);
+		void markInside(s32 index);
+
+		ISceneNode* Root;
+
+		core::array<SEntry> Entries;
+		s32 FreeEntry;
+		u32 EntryCount;
+		core::array<s32> Moved;
+
+		core::array<STreeNode> Tree;
+		s32 TreeRoot;
+		s32 FreeTreeNode;
+
+		u32 Stamp;
+		mutable core::array<s32> Stack;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -6,10 +6,17 @@
 #ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
 
 #include "CSkinnedMesh.h"
+#include "CSkinnedMeshInstance.h"
 #include "CBoneSceneNode.h"
 #include "IAnimatedMeshSceneNode.h"
 #include "os.h"
 
+//SSE2 skinning of the influence table. gives the same results as skinJoint
+#if !defined(IRR_SCENE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define IRR_SKINNED_MESH_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace
 {
 	// Frames must always be increasing, so we remove objects where this isn't the case
@@ -82,6 +89,305 @@ namespace
 	{
 		return a.rotation == b.rotation;
 	}
+
+	template <class T> // T = objects containing a "frame" variable
+	irr::f32 keyFrame(const T& key)
+	{
+		return key.frame;
+	}
+
+	// frames of compressed keys
+	irr::f32 keyFrame(irr::f32 frame)
+	{
+		return frame;
+	}
+
+	// index of the first key at or after the frame, -1 if there is none
+	// hint is the result of the last search, frames usually advance slowly
+	template <class T> // T = keys or their frames
+	irr::s32 findKey(const irr::core::array<T>& keys, irr::f32 frame, irr::s32& hint)
+	{
+		//Test the Hints...
+		if (hint>=0 && (irr::u32)hint < keys.size())
+		{
+			//check this hint
+			if (hint>0 && keyFrame(keys[hint])>=frame && keyFrame(keys[hint-1])<frame)
+				return hint;
+
+			//check the next index
+			if (hint+1 < (irr::s32)keys.size() && keyFrame(keys[hint+1])>=frame && keyFrame(keys[hint])<frame)
+				return ++hint;
+		}
+
+		//The hint test failed, do a binary search, keys are sorted by frame
+		if (keys.empty() || keyFrame(keys.getLast()) < frame)
+			return -1;
+
+		irr::u32 first = 0;
+		irr::u32 last = keys.size()-1;
+		while (first < last)
+		{
+			const irr::u32 mid = (first+last)/2;
+			if (keyFrame(keys[mid]) < frame)
+				first = mid+1;
+			else
+				last = mid;
+		}
+		hint = (irr::s32)first;
+		return hint;
+	}
+
+	// linear interpolation between a key and the one before it
+	void interpolateKeys(const irr::scene::ISkinnedMesh::SPositionKey& a, const irr::scene::ISkinnedMesh::SPositionKey& b,
+		irr::f32 frame, irr::core::vector3df& position)
+	{
+		const irr::f32 fd1 = frame - a.frame;
+		const irr::f32 fd2 = b.frame - frame;
+		position = ((b.position-a.position)/(fd1+fd2))*fd1 + a.position;
+	}
+
+	void interpolateKeys(const irr::scene::ISkinnedMesh::SScaleKey& a, const irr::scene::ISkinnedMesh::SScaleKey& b,
+		irr::f32 frame, irr::core::vector3df& scale)
+	{
+		const irr::f32 fd1 = frame - a.frame;
+		const irr::f32 fd2 = b.frame - frame;
+		scale = ((b.scale-a.scale)/(fd1+fd2))*fd1 + a.scale;
+	}
+
+	void interpolateKeys(const irr::scene::ISkinnedMesh::SRotationKey& a, const irr::scene::ISkinnedMesh::SRotationKey& b,
+		irr::f32 frame, irr::core::quaternion& rotation)
+	{
+		const irr::f32 fd1 = frame - a.frame;
+		const irr::f32 fd2 = b.frame - frame;
+		rotation.slerp(a.rotation, b.rotation, fd1/(fd1+fd2));
+	}
+
+	// value of the keys at a frame with linear interpolation, for resampling
+	template <class T, class V> // T = key type, V = its value
+	V interpolateAt(const irr::core::array<T>& keys, irr::f32 frame, irr::s32& hint, const V& first, const V& last)
+	{
+		const irr::s32 found = findKey(keys, frame, hint);
+		if (found == -1)
+			return last;
+		if (found == 0)
+			return first;
+		V value;
+		interpolateKeys(keys[found], keys[found-1], frame, value);
+		return value;
+	}
+
+	irr::core::vector3df sampleKeys(const irr::core::array<irr::scene::ISkinnedMesh::SPositionKey>& keys, irr::f32 frame, irr::s32& hint)
+	{
+		return interpolateAt(keys, frame, hint, keys[0].position, keys.getLast().position);
+	}
+
+	irr::core::vector3df sampleKeys(const irr::core::array<irr::scene::ISkinnedMesh::SScaleKey>& keys, irr::f32 frame, irr::s32& hint)
+	{
+		return interpolateAt(keys, frame, hint, keys[0].scale, keys.getLast().scale);
+	}
+
+	irr::core::quaternion sampleKeys(const irr::core::array<irr::scene::ISkinnedMesh::SRotationKey>& keys, irr::f32 frame, irr::s32& hint)
+	{
+		return interpolateAt(keys, frame, hint, keys[0].rotation, keys.getLast().rotation);
+	}
+
+	irr::core::vector3df& keyValue(irr::scene::ISkinnedMesh::SPositionKey& key)
+	{
+		return key.position;
+	}
+
+	irr::core::vector3df& keyValue(irr::scene::ISkinnedMesh::SScaleKey& key)
+	{
+		return key.scale;
+	}
+
+	irr::core::quaternion& keyValue(irr::scene::ISkinnedMesh::SRotationKey& key)
+	{
+		return key.rotation;
+	}
+
+	// largest difference of the components
+	irr::f32 keyDistance(const irr::core::vector3df& a, const irr::core::vector3df& b)
+	{
+		const irr::core::vector3df d = a - b;
+		return irr::core::max_(fabsf(d.X), fabsf(d.Y), fabsf(d.Z));
+	}
+
+	// q and -q are the same rotation
+	irr::f32 keyDistance(const irr::core::quaternion& a, const irr::core::quaternion& b)
+	{
+		const irr::f32 s = a.dotProduct(b) < 0.f ? -1.f : 1.f;
+		return irr::core::max_(irr::core::max_(fabsf(a.X-s*b.X), fabsf(a.Y-s*b.Y)),
+			irr::core::max_(fabsf(a.Z-s*b.Z), fabsf(a.W-s*b.W)));
+	}
+
+	// Drop keys which linear interpolation between the kept keys rebuilds within the tolerance
+	// return number of kicked keys
+	template <class T> // T = key type
+	irr::u32 dropInterpolatedKeys(irr::core::array<T>& keys, irr::f32 tolerance)
+	{
+		if (keys.size() < 3)
+			return 0;
+
+		irr::core::array<T> kept(keys.size());
+		kept.push_back(keys[0]);
+		irr::u32 last = 0;	// index of the last kept key
+		for (irr::u32 j=1; j+1<keys.size(); ++j)
+		{
+			// keep j if interpolating from the last kept key to the next one misses a key up to j
+			for (irr::u32 k=last+1; k<=j; ++k)
+			{
+				T key = keys[k];
+				interpolateKeys(keys[j+1], keys[last], key.frame, keyValue(key));
+				if (keyDistance(keyValue(key), keyValue(keys[k])) > tolerance)
+				{
+					kept.push_back(keys[j]);
+					last = j;
+					break;
+				}
+			}
+		}
+		kept.push_back(keys.getLast());
+
+		const irr::u32 d = keys.size() - kept.size();
+		keys.swap(kept);
+		return d;
+	}
+
+	irr::u16 quantize(irr::f32 value, irr::f32 offset, irr::f32 step)
+	{
+		if (step <= 0.f)
+			return 0;
+		return (irr::u16)irr::core::s32_clamp(irr::core::round32((value-offset)/step), 0, 65535);
+	}
+
+	// 16 bit per component within the range of the keys
+	template <class T> // T = position or scale keys
+	void compressTrack(irr::core::array<T>& keys, irr::scene::ISkinnedMesh::SCompressedKeys& out)
+	{
+		irr::core::aabbox3df range(keyValue(keys[0]));
+		for (irr::u32 i=1; i<keys.size(); ++i)
+			range.addInternalPoint(keyValue(keys[i]));
+
+		out.Offset = range.MinEdge;
+		out.Step = range.getExtent() / 65535.f;
+		out.Frames.set_used(keys.size());
+		out.Values.set_used(keys.size()*3);
+		for (irr::u32 i=0; i<keys.size(); ++i)
+		{
+			out.Frames[i] = keys[i].frame;
+			const irr::core::vector3df& v = keyValue(keys[i]);
+			out.Values[i*3+0] = quantize(v.X, out.Offset.X, out.Step.X);
+			out.Values[i*3+1] = quantize(v.Y, out.Offset.Y, out.Step.Y);
+			out.Values[i*3+2] = quantize(v.Z, out.Offset.Z, out.Step.Z);
+		}
+	}
+
+	// 48 bit per rotation: the three smallest components with 15 bit each,
+	// the index of the largest one in the top bits of the first two values
+	const irr::f32 SMALLEST_THREE_RANGE = 0.70710678f;	// 1/sqrt(2)
+
+	void compressTrack(irr::core::array<irr::scene::ISkinnedMesh::SRotationKey>& keys, irr::scene::ISkinnedMesh::SCompressedKeys& out)
+	{
+		out.Offset.set(0.f, 0.f, 0.f);
+		out.Step.set(0.f, 0.f, 0.f);
+		out.Frames.set_used(keys.size());
+		out.Values.set_used(keys.size()*3);
+		for (irr::u32 i=0; i<keys.size(); ++i)
+		{
+			out.Frames[i] = keys[i].frame;
+			const irr::core::quaternion& q = keys[i].rotation;
+			const irr::f32 c[4] = { q.X, q.Y, q.Z, q.W };
+
+			irr::u32 largest = 0;
+			for (irr::u32 j=1; j<4; ++j)
+			{
+				if (fabsf(c[j]) > fabsf(c[largest]))
+					largest = j;
+			}
+
+			// the largest component is restored as positive
+			const irr::f32 sign = c[largest] < 0.f ? -1.f : 1.f;
+			irr::u16* values = &out.Values[i*3];
+			for (irr::u32 j=0, n=0; j<4; ++j)
+			{
+				if (j == largest)
+					continue;
+				const irr::f32 v = irr::core::clamp(c[j]*sign, -SMALLEST_THREE_RANGE, SMALLEST_THREE_RANGE);
+				values[n++] = (irr::u16)irr::core::round32((v+SMALLEST_THREE_RANGE)*(32767.f*0.5f/SMALLEST_THREE_RANGE));
+			}
+			values[0] |= (irr::u16)((largest & 1) << 15);
+			values[1] |= (irr::u16)((largest >> 1) << 15);
+		}
+	}
+
+	void decompressKey(const irr::scene::ISkinnedMesh::SCompressedKeys& keys, irr::u32 i, irr::core::vector3df& value)
+	{
+		const irr::u16* values = &keys.Values[i*3];
+		value.set(keys.Offset.X + values[0]*keys.Step.X,
+			keys.Offset.Y + values[1]*keys.Step.Y,
+			keys.Offset.Z + values[2]*keys.Step.Z);
+	}
+
+	void decompressKey(const irr::scene::ISkinnedMesh::SCompressedKeys& keys, irr::u32 i, irr::core::quaternion& value)
+	{
+		const irr::u16* values = &keys.Values[i*3];
+		const irr::u32 largest = (values[0] >> 15) | ((values[1] >> 15) << 1);
+
+		irr::f32 c[4];
+		irr::f32 sum = 0.f;
+		for (irr::u32 j=0, n=0; j<4; ++j)
+		{
+			if (j == largest)
+				continue;
+			c[j] = (values[n++] & 0x7fff)*(2.f*SMALLEST_THREE_RANGE/32767.f) - SMALLEST_THREE_RANGE;
+			sum += c[j]*c[j];
+		}
+		c[largest] = sqrtf(irr::core::max_(0.f, 1.f-sum));
+		value.set(c[0], c[1], c[2], c[3]);
+	}
+
+	template <class T> // T = key type
+	void decompressKey(const irr::scene::ISkinnedMesh::SCompressedKeys& keys, irr::u32 i, T& key)
+	{
+		key.frame = keys.Frames[i];
+		decompressKey(keys, i, keyValue(key));
+	}
+
+	template <class T> // T = key type
+	void decompressKeys(const irr::scene::ISkinnedMesh::SCompressedKeys& keys, irr::core::array<T>& out)
+	{
+		out.set_used(keys.Frames.size());
+		for (irr::u32 i=0; i<out.size(); ++i)
+			decompressKey(keys, i, out[i]);
+	}
+
+	// pair of samples around a position in samples at a constant rate
+	// false if there are no samples
+	template <class T>
+	bool findSample(const irr::core::array<T>& samples, irr::f32 sample, irr::u32& i, irr::f32& t)
+	{
+		if (samples.empty())
+			return false;
+
+		const irr::u32 last = samples.size()-2;
+		if (sample <= 0.f)
+		{
+			i = 0;
+			t = 0.f;
+		}
+		else if (sample >= (irr::f32)(last+1))
+		{
+			i = last;
+			t = 1.f;
+		}
+		else
+		{
+			i = irr::core::min_((irr::u32)sample, last);
+			t = sample - (irr::f32)i;
+		}
+		return true;
+	}
 };
 
 namespace irr
@@ -92,7 +398,7 @@ namespace scene
 
 //! constructor
 CSkinnedMesh::CSkinnedMesh()
-: SkinningBuffers(0), EndFrame(0.f), FramesPerSecond(25.f),
+: SkinningBuffers(0), EndFrame(0.f), FramesPerSecond(25.f), FramesPerKey(0.f),
 	LastAnimatedFrame(-1), SkinnedLastFrame(false),
 	InterpolationMode(EIM_LINEAR),
 	HasAnimation(false), PreparedForSkinning(false),
@@ -234,58 +540,12 @@ void CSkinnedMesh::buildAllLocalAnimatedMatrices()
 
 		//Could be faster:
 
-		if (joint->UseAnimationFrom &&
-			(joint->UseAnimationFrom->PositionKeys.size() ||
-			 joint->UseAnimationFrom->ScaleKeys.size() ||
-			 joint->UseAnimationFrom->RotationKeys.size() ))
+		if (joint->UseAnimationFrom && hasKeys(joint->UseAnimationFrom))
 		{
 			joint->GlobalSkinningSpace=false;
 
-			// IRR_TEST_BROKEN_QUATERNION_USE: TODO - switched to getMatrix_transposed instead of getMatrix for downward compatibility.
-			//								   Not tested so far if this was correct or wrong before quaternion fix!
-			joint->Animatedrotation.getMatrix_transposed(joint->LocalAnimatedMatrix);
-
-			// --- joint->LocalAnimatedMatrix *= joint->Animatedrotation.getMatrix() ---
-			f32 *m1 = joint->LocalAnimatedMatrix.pointer();
-			core::vector3df &Pos = joint->Animatedposition;
-			m1[0] += Pos.X*m1[3];
-			m1[1] += Pos.Y*m1[3];
-			m1[2] += Pos.Z*m1[3];
-			m1[4] += Pos.X*m1[7];
-			m1[5] += Pos.Y*m1[7];
-			m1[6] += Pos.Z*m1[7];
-			m1[8] += Pos.X*m1[11];
-			m1[9] += Pos.Y*m1[11];
-			m1[10] += Pos.Z*m1[11];
-			m1[12] += Pos.X*m1[15];
-			m1[13] += Pos.Y*m1[15];
-			m1[14] += Pos.Z*m1[15];
-			// -----------------------------------
-
-			if (joint->ScaleKeys.size())
-			{
-				/*
-				core::matrix4 scaleMatrix;
-				scaleMatrix.setScale(joint->Animatedscale);
-				joint->LocalAnimatedMatrix *= scaleMatrix;
-				*/
-
-				// -------- joint->LocalAnimatedMatrix *= scaleMatrix -----------------
-				core::matrix4& mat = joint->LocalAnimatedMatrix;
-				mat[0] *= joint->Animatedscale.X;
-				mat[1] *= joint->Animatedscale.X;
-				mat[2] *= joint->Animatedscale.X;
-				mat[3] *= joint->Animatedscale.X;
-				mat[4] *= joint->Animatedscale.Y;
-				mat[5] *= joint->Animatedscale.Y;
-				mat[6] *= joint->Animatedscale.Y;
-				mat[7] *= joint->Animatedscale.Y;
-				mat[8] *= joint->Animatedscale.Z;
-				mat[9] *= joint->Animatedscale.Z;
-				mat[10] *= joint->Animatedscale.Z;
-				mat[11] *= joint->Animatedscale.Z;
-				// -----------------------------------
-			}
+			buildLocalAnimatedMatrix(joint, joint->Animatedposition, joint->Animatedscale,
+					joint->Animatedrotation, joint->LocalAnimatedMatrix);
 		}
 		else
 		{
@@ -296,6 +556,58 @@ void CSkinnedMesh::buildAllLocalAnimatedMatrices()
 }
 
 
+void CSkinnedMesh::buildLocalAnimatedMatrix(const SJoint *joint, const core::vector3df &position,
+				const core::vector3df &scale, const core::quaternion &rotation,
+				core::matrix4 &matrix) const
+{
+	// IRR_TEST_BROKEN_QUATERNION_USE: TODO - switched to getMatrix_transposed instead of getMatrix for downward compatibility.
+	//								   Not tested so far if this was correct or wrong before quaternion fix!
+	rotation.getMatrix_transposed(matrix);
+
+	// --- matrix *= rotation.getMatrix() ---
+	f32 *m1 = matrix.pointer();
+	const core::vector3df &Pos = position;
+	m1[0] += Pos.X*m1[3];
+	m1[1] += Pos.Y*m1[3];
+	m1[2] += Pos.Z*m1[3];
+	m1[4] += Pos.X*m1[7];
+	m1[5] += Pos.Y*m1[7];
+	m1[6] += Pos.Z*m1[7];
+	m1[8] += Pos.X*m1[11];
+	m1[9] += Pos.Y*m1[11];
+	m1[10] += Pos.Z*m1[11];
+	m1[12] += Pos.X*m1[15];
+	m1[13] += Pos.Y*m1[15];
+	m1[14] += Pos.Z*m1[15];
+	// -----------------------------------
+
+	if (joint->ScaleKeys.size() || joint->CompressedScales.Frames.size())
+	{
+		/*
+		core::matrix4 scaleMatrix;
+		scaleMatrix.setScale(scale);
+		matrix *= scaleMatrix;
+		*/
+
+		// -------- matrix *= scaleMatrix -----------------
+		core::matrix4& mat = matrix;
+		mat[0] *= scale.X;
+		mat[1] *= scale.X;
+		mat[2] *= scale.X;
+		mat[3] *= scale.X;
+		mat[4] *= scale.Y;
+		mat[5] *= scale.Y;
+		mat[6] *= scale.Y;
+		mat[7] *= scale.Y;
+		mat[8] *= scale.Z;
+		mat[9] *= scale.Z;
+		mat[10] *= scale.Z;
+		mat[11] *= scale.Z;
+		// -----------------------------------
+	}
+}
+
+
 void CSkinnedMesh::buildAllGlobalAnimatedMatrices(SJoint *joint, SJoint *parentJoint)
 {
 	if (!joint)
@@ -318,198 +630,249 @@ void CSkinnedMesh::buildAllGlobalAnimatedMatrices(SJoint *joint, SJoint *parentJ
 }
 
 
-void CSkinnedMesh::getFrameData(f32 frame, SJoint *joint,
+void CSkinnedMesh::getFrameData(f32 frame, const SJoint *joint,
 				core::vector3df &position, s32 &positionHint,
 				core::vector3df &scale, s32 &scaleHint,
-				core::quaternion &rotation, s32 &rotationHint)
+				core::quaternion &rotation, s32 &rotationHint) const
 {
-	s32 foundPositionIndex = -1;
-	s32 foundScaleIndex = -1;
-	s32 foundRotationIndex = -1;
+	const SJoint* source = joint->UseAnimationFrom;
+	if (!source)
+		return;
+
+	const bool linear = (InterpolationMode==EIM_LINEAR);
+	const f32 sample = frame*source->SamplesPerFrame;
+	u32 i;
+	f32 t;
 
-	if (joint->UseAnimationFrom)
+	if (linear && findSample(source->SampledPositions, sample, i, t))
 	{
-		const core::array<SPositionKey> &PositionKeys=joint->UseAnimationFrom->PositionKeys;
-		const core::array<SScaleKey> &ScaleKeys=joint->UseAnimationFrom->ScaleKeys;
-		const core::array<SRotationKey> &RotationKeys=joint->UseAnimationFrom->RotationKeys;
+		position = core::lerp(source->SampledPositions[i], source->SampledPositions[i+1], t);
+	}
+	else if (source->PositionKeys.size())
+	{
+		const core::array<SPositionKey> &PositionKeys=source->PositionKeys;
+		const s32 found = findKey(PositionKeys, frame, positionHint);
 
-		if (PositionKeys.size())
+		//Do interpolation...
+		if (found!=-1)
 		{
-			foundPositionIndex = -1;
-
-			//Test the Hints...
-			if (positionHint>=0 && (u32)positionHint < PositionKeys.size())
+			if (!linear || found==0)
+				position = PositionKeys[found].position;
+			else
+				interpolateKeys(PositionKeys[found], PositionKeys[found-1], frame, position);
+		}
+	}
+	else if (source->CompressedPositions.Frames.size())
+	{
+		const s32 found = findKey(source->CompressedPositions.Frames, frame, positionHint);
+		if (found!=-1)
+		{
+			SPositionKey keyA;
+			decompressKey(source->CompressedPositions, found, keyA);
+			if (!linear || found==0)
+				position = keyA.position;
+			else
 			{
-				//check this hint
-				if (positionHint>0 && PositionKeys[positionHint].frame>=frame && PositionKeys[positionHint-1].frame<frame )
-					foundPositionIndex=positionHint;
-				else if (positionHint+1 < (s32)PositionKeys.size())
-				{
-					//check the next index
-					if ( PositionKeys[positionHint+1].frame>=frame &&
-							PositionKeys[positionHint+0].frame<frame)
-					{
-						positionHint++;
-						foundPositionIndex=positionHint;
-					}
-				}
+				SPositionKey keyB;
+				decompressKey(source->CompressedPositions, found-1, keyB);
+				interpolateKeys(keyA, keyB, frame, position);
 			}
+		}
+	}
 
-			//The hint test failed, do a full scan...
-			if (foundPositionIndex==-1)
-			{
-				for (u32 i=0; i<PositionKeys.size(); ++i)
-				{
-					if (PositionKeys[i].frame >= frame) //Keys should to be sorted by frame
-					{
-						foundPositionIndex=i;
-						positionHint=i;
-						break;
-					}
-				}
-			}
+	//------------------------------------------------------------
 
-			//Do interpolation...
-			if (foundPositionIndex!=-1)
-			{
-				if (InterpolationMode==EIM_CONSTANT || foundPositionIndex==0)
-				{
-					position = PositionKeys[foundPositionIndex].position;
-				}
-				else if (InterpolationMode==EIM_LINEAR)
-				{
-					const SPositionKey& KeyA = PositionKeys[foundPositionIndex];
-					const SPositionKey& KeyB = PositionKeys[foundPositionIndex-1];
+	if (linear && findSample(source->SampledScales, sample, i, t))
+	{
+		scale = core::lerp(source->SampledScales[i], source->SampledScales[i+1], t);
+	}
+	else if (source->ScaleKeys.size())
+	{
+		const core::array<SScaleKey> &ScaleKeys=source->ScaleKeys;
+		const s32 found = findKey(ScaleKeys, frame, scaleHint);
 
-					const f32 fd1 = frame - KeyA.frame;
-					const f32 fd2 = KeyB.frame - frame;
-					position = ((KeyB.position-KeyA.position)/(fd1+fd2))*fd1 + KeyA.position;
-				}
+		//Do interpolation...
+		if (found!=-1)
+		{
+			if (!linear || found==0)
+				scale = ScaleKeys[found].scale;
+			else
+				interpolateKeys(ScaleKeys[found], ScaleKeys[found-1], frame, scale);
+		}
+	}
+	else if (source->CompressedScales.Frames.size())
+	{
+		const s32 found = findKey(source->CompressedScales.Frames, frame, scaleHint);
+		if (found!=-1)
+		{
+			SScaleKey keyA;
+			decompressKey(source->CompressedScales, found, keyA);
+			if (!linear || found==0)
+				scale = keyA.scale;
+			else
+			{
+				SScaleKey keyB;
+				decompressKey(source->CompressedScales, found-1, keyB);
+				interpolateKeys(keyA, keyB, frame, scale);
 			}
 		}
+	}
 
-		//------------------------------------------------------------
+	//-------------------------------------------------------------
 
-		if (ScaleKeys.size())
-		{
-			foundScaleIndex = -1;
+	if (linear && findSample(source->SampledRotations, sample, i, t))
+	{
+		rotation.slerp(source->SampledRotations[i], source->SampledRotations[i+1], t);
+	}
+	else if (source->RotationKeys.size())
+	{
+		const core::array<SRotationKey> &RotationKeys=source->RotationKeys;
+		const s32 found = findKey(RotationKeys, frame, rotationHint);
 
-			//Test the Hints...
-			if (scaleHint>=0 && (u32)scaleHint < ScaleKeys.size())
+		//Do interpolation...
+		if (found!=-1)
+		{
+			if (!linear || found==0)
+				rotation = RotationKeys[found].rotation;
+			else
+				interpolateKeys(RotationKeys[found], RotationKeys[found-1], frame, rotation);
+		}
+	}
+	else if (source->CompressedRotations.Frames.size())
+	{
+		const s32 found = findKey(source->CompressedRotations.Frames, frame, rotationHint);
+		if (found!=-1)
+		{
+			SRotationKey keyA;
+			decompressKey(source->CompressedRotations, found, keyA);
+			if (!linear || found==0)
+				rotation = keyA.rotation;
+			else
 			{
-				//check this hint
-				if (scaleHint>0 && ScaleKeys[scaleHint].frame>=frame && ScaleKeys[scaleHint-1].frame<frame )
-					foundScaleIndex=scaleHint;
-				else if (scaleHint+1 < (s32)ScaleKeys.size())
-				{
-					//check the next index
-					if ( ScaleKeys[scaleHint+1].frame>=frame &&
-							ScaleKeys[scaleHint+0].frame<frame)
-					{
-						scaleHint++;
-						foundScaleIndex=scaleHint;
-					}
-				}
+				SRotationKey keyB;
+				decompressKey(source->CompressedRotations, found-1, keyB);
+				interpolateKeys(keyA, keyB, frame, rotation);
 			}
+		}
+	}
+}
 
 
-			//The hint test failed, do a full scan...
-			if (foundScaleIndex==-1)
-			{
-				for (u32 i=0; i<ScaleKeys.size(); ++i)
-				{
-					if (ScaleKeys[i].frame >= frame) //Keys should to be sorted by frame
-					{
-						foundScaleIndex=i;
-						scaleHint=i;
-						break;
-					}
-				}
-			}
+//! true if the joint has animation keys, compressed or not
+bool CSkinnedMesh::hasKeys(const SJoint* joint) const
+{
+	return joint->PositionKeys.size() || joint->ScaleKeys.size() || joint->RotationKeys.size() ||
+		joint->CompressedPositions.Frames.size() || joint->CompressedScales.Frames.size() ||
+		joint->CompressedRotations.Frames.size();
+}
 
-			//Do interpolation...
-			if (foundScaleIndex!=-1)
-			{
-				if (InterpolationMode==EIM_CONSTANT || foundScaleIndex==0)
-				{
-					scale = ScaleKeys[foundScaleIndex].scale;
-				}
-				else if (InterpolationMode==EIM_LINEAR)
-				{
-					const SScaleKey& KeyA = ScaleKeys[foundScaleIndex];
-					const SScaleKey& KeyB = ScaleKeys[foundScaleIndex-1];
 
-					const f32 fd1 = frame - KeyA.frame;
-					const f32 fd2 = KeyB.frame - frame;
-					scale = ((KeyB.scale-KeyA.scale)/(fd1+fd2))*fd1 + KeyA.scale;
-				}
-			}
+//! Stores the animation keys of all joints in a compressed format
+void CSkinnedMesh::compressKeys(f32 tolerance)
+{
+	u32 droppedKeys = 0;
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		SJoint* joint = AllJoints[i];
+
+		if (joint->PositionKeys.size())
+		{
+			droppedKeys += dropInterpolatedKeys(joint->PositionKeys, tolerance);
+			compressTrack(joint->PositionKeys, joint->CompressedPositions);
+			joint->PositionKeys.clear();
 		}
 
-		//-------------------------------------------------------------
+		if (joint->ScaleKeys.size())
+		{
+			droppedKeys += dropInterpolatedKeys(joint->ScaleKeys, tolerance);
+			compressTrack(joint->ScaleKeys, joint->CompressedScales);
+			joint->ScaleKeys.clear();
+		}
 
-		if (RotationKeys.size())
+		if (joint->RotationKeys.size())
 		{
-			foundRotationIndex = -1;
+			droppedKeys += dropInterpolatedKeys(joint->RotationKeys, tolerance);
+			compressTrack(joint->RotationKeys, joint->CompressedRotations);
+			joint->RotationKeys.clear();
+		}
+	}
 
-			//Test the Hints...
-			if (rotationHint>=0 && (u32)rotationHint < RotationKeys.size())
-			{
-				//check this hint
-				if (rotationHint>0 && RotationKeys[rotationHint].frame>=frame && RotationKeys[rotationHint-1].frame<frame )
-					foundRotationIndex=rotationHint;
-				else if (rotationHint+1 < (s32)RotationKeys.size())
-				{
-					//check the next index
-					if ( RotationKeys[rotationHint+1].frame>=frame &&
-							RotationKeys[rotationHint+0].frame<frame)
-					{
-						rotationHint++;
-						foundRotationIndex=rotationHint;
-					}
-				}
-			}
+	if (droppedKeys > 0)
+	{
+		os::Printer::log("Skinned Mesh - interpolated frames kicked", core::stringc(droppedKeys).c_str(), ELL_DEBUG);
+	}
 
+	// samples of the keys as they are played now
+	resampleKeys();
+}
 
-			//The hint test failed, do a full scan...
-			if (foundRotationIndex==-1)
-			{
-				for (u32 i=0; i<RotationKeys.size(); ++i)
-				{
-					if (RotationKeys[i].frame >= frame) //Keys should be sorted by frame
-					{
-						foundRotationIndex=i;
-						rotationHint=i;
-						break;
-					}
-				}
-			}
 
-			//Do interpolation...
-			if (foundRotationIndex!=-1)
-			{
-				if (InterpolationMode==EIM_CONSTANT || foundRotationIndex==0)
-				{
-					rotation = RotationKeys[foundRotationIndex].rotation;
-				}
-				else if (InterpolationMode==EIM_LINEAR)
-				{
-					const SRotationKey& KeyA = RotationKeys[foundRotationIndex];
-					const SRotationKey& KeyB = RotationKeys[foundRotationIndex-1];
+//! Resamples the animation keys of all joints at a constant rate
+void CSkinnedMesh::setKeyResampling(f32 framesPerKey)
+{
+	FramesPerKey = framesPerKey;
+	resampleKeys();
+}
+
 
-					const f32 fd1 = frame - KeyA.frame;
-					const f32 fd2 = KeyB.frame - frame;
-					const f32 t = fd1/(fd1+fd2);
+//! samples the keys of all joints every FramesPerKey frames
+void CSkinnedMesh::resampleKeys()
+{
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		SJoint* joint = AllJoints[i];
+		joint->SampledPositions.clear();
+		joint->SampledScales.clear();
+		joint->SampledRotations.clear();
+		joint->SamplesPerFrame = 0.f;
+	}
 
-					/*
-					f32 t = 0;
-					if (KeyA.frame!=KeyB.frame)
-						t = (frame-KeyA.frame) / (KeyB.frame - KeyA.frame);
-					*/
+	if (FramesPerKey <= 0.f || EndFrame <= 0.f)
+		return;
 
-					rotation.slerp(KeyA.rotation, KeyB.rotation, t);
-				}
-			}
+	// divide the animation evenly, so the last sample is at the last frame
+	const u32 count = core::ceil32(EndFrame/FramesPerKey) + 1;
+	const f32 step = EndFrame/(count-1);
+
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		SJoint* joint = AllJoints[i];
+		joint->SamplesPerFrame = 1.f/step;
+
+		// compressed keys are sampled from a decompressed copy
+		core::array<SPositionKey> positionKeys;
+		core::array<SScaleKey> scaleKeys;
+		core::array<SRotationKey> rotationKeys;
+		decompressKeys(joint->CompressedPositions, positionKeys);
+		decompressKeys(joint->CompressedScales, scaleKeys);
+		decompressKeys(joint->CompressedRotations, rotationKeys);
+		const core::array<SPositionKey>& PositionKeys = joint->PositionKeys.size() ? joint->PositionKeys : positionKeys;
+		const core::array<SScaleKey>& ScaleKeys = joint->ScaleKeys.size() ? joint->ScaleKeys : scaleKeys;
+		const core::array<SRotationKey>& RotationKeys = joint->RotationKeys.size() ? joint->RotationKeys : rotationKeys;
+
+		// a single key is constant, nothing to gain
+		s32 positionHint = -1;
+		if (PositionKeys.size() > 1)
+		{
+			joint->SampledPositions.set_used(count);
+			for (u32 s=0; s<count; ++s)
+				joint->SampledPositions[s] = sampleKeys(PositionKeys, s<count-1 ? s*step : EndFrame, positionHint);
+		}
+
+		s32 scaleHint = -1;
+		if (ScaleKeys.size() > 1)
+		{
+			joint->SampledScales.set_used(count);
+			for (u32 s=0; s<count; ++s)
+				joint->SampledScales[s] = sampleKeys(ScaleKeys, s<count-1 ? s*step : EndFrame, scaleHint);
+		}
+
+		s32 rotationHint = -1;
+		if (RotationKeys.size() > 1)
+		{
+			joint->SampledRotations.set_used(count);
+			for (u32 s=0; s<count; ++s)
+				joint->SampledRotations[s] = sampleKeys(RotationKeys, s<count-1 ? s*step : EndFrame, rotationHint);
 		}
 	}
 }
@@ -545,14 +908,26 @@ void CSkinnedMesh::skinMesh()
 			}
 		}
 
-		//clear skinning helper array
-		for (i=0; i<Vertices_Moved.size(); ++i)
-			for (u32 j=0; j<Vertices_Moved[i].size(); ++j)
-				Vertices_Moved[i][j]=false;
+		if (!Influences.empty())
+		{
+			//skin vertex by vertex
+			SkinMatrices.set_used(AllJoints.size());
+			for (i=0; i<AllJoints.size(); ++i)
+				SkinMatrices[i].setbyproduct(AllJoints[i]->GlobalAnimatedMatrix, AllJoints[i]->GlobalInversedMatrix);
 
-		//skin starting with the root joints
-		for (i=0; i<RootJoints.size(); ++i)
-			skinJoint(RootJoints[i], 0);
+			skinInfluences(SkinMatrices, *SkinningBuffers);
+		}
+		else
+		{
+			//clear skinning helper array
+			for (i=0; i<Vertices_Moved.size(); ++i)
+				for (u32 j=0; j<Vertices_Moved[i].size(); ++j)
+					Vertices_Moved[i][j]=false;
+
+			//skin starting with the root joints
+			for (i=0; i<RootJoints.size(); ++i)
+				skinJoint(RootJoints[i], 0);
+		}
 
 		for (i=0; i<SkinningBuffers->size(); ++i)
 			(*SkinningBuffers)[i]->setDirty(EBT_VERTEX);
@@ -562,21 +937,31 @@ void CSkinnedMesh::skinMesh()
 
 
 void CSkinnedMesh::skinJoint(SJoint *joint, SJoint *parentJoint)
+{
+	skinWeights(joint, joint->GlobalAnimatedMatrix, *SkinningBuffers, Vertices_Moved);
+
+	//Skin all children
+	for (u32 j=0; j<joint->Children.size(); ++j)
+		skinJoint(joint->Children[j], joint);
+}
+
+
+void CSkinnedMesh::skinWeights(const SJoint *joint, const core::matrix4 &globalAnimatedMatrix,
+				core::array<SSkinMeshBuffer*> &buffersUsed,
+				core::array< core::array<bool> > &verticesMoved) const
 {
 	if (joint->Weights.size())
 	{
 		//Find this joints pull on vertices...
 		core::matrix4 jointVertexPull(core::matrix4::EM4CONST_NOTHING);
-		jointVertexPull.setbyproduct(joint->GlobalAnimatedMatrix, joint->GlobalInversedMatrix);
+		jointVertexPull.setbyproduct(globalAnimatedMatrix, joint->GlobalInversedMatrix);
 
 		core::vector3df thisVertexMove, thisNormalMove;
 
-		core::array<scene::SSkinMeshBuffer*> &buffersUsed=*SkinningBuffers;
-
 		//Skin Vertices Positions and Normals...
 		for (u32 i=0; i<joint->Weights.size(); ++i)
 		{
-			SWeight& weight = joint->Weights[i];
+			const SWeight& weight = joint->Weights[i];
 
 			// Pull this vertex...
 			jointVertexPull.transformVect(thisVertexMove, weight.StaticPos);
@@ -584,9 +969,10 @@ void CSkinnedMesh::skinJoint(SJoint *joint, SJoint *parentJoint)
 			if (AnimateNormals)
 				jointVertexPull.rotateVect(thisNormalMove, weight.StaticNormal);
 
-			if (! (*(weight.Moved)) )
+			bool& moved = verticesMoved[weight.buffer_id][weight.vertex_id];
+			if (!moved)
 			{
-				*(weight.Moved) = true;
+				moved = true;
 
 				buffersUsed[weight.buffer_id]->getVertex(weight.vertex_id)->Pos = thisVertexMove * weight.strength;
 
@@ -608,10 +994,159 @@ void CSkinnedMesh::skinJoint(SJoint *joint, SJoint *parentJoint)
 			buffersUsed[weight.buffer_id]->boundingBoxNeedsRecalculated();
 		}
 	}
+}
 
-	//Skin all children
-	for (u32 j=0; j<joint->Children.size(); ++j)
-		skinJoint(joint->Children[j], joint);
+
+//! Builds the table of up to 4 weighted joints per skinned vertex
+/** The weights of a vertex keep the order of skinJoint, so skinning the
+table adds them up in the same order. */
+void CSkinnedMesh::buildInfluences()
+{
+	u32 i, j;
+
+	Influences.clear();
+	Influences.reallocate(LocalBuffers.size());
+
+	// index into the table for each vertex
+	core::array< core::array<s32> > entries;
+	entries.reallocate(LocalBuffers.size());
+
+	for (i=0; i<LocalBuffers.size(); ++i)
+	{
+		Influences.push_back(core::array<SInfluence>());
+		entries.push_back(core::array<s32>());
+		entries[i].set_used(LocalBuffers[i]->getVertexCount());
+		for (j=0; j<entries[i].size(); ++j)
+			entries[i][j] = -1;
+	}
+
+	for (i=0; i<JointOrder.size(); ++i)
+	{
+		const SJoint *joint = AllJoints[JointOrder[i]];
+		for (j=0; j<joint->Weights.size(); ++j)
+		{
+			const SWeight& weight = joint->Weights[j];
+			core::array<SInfluence>& influences = Influences[weight.buffer_id];
+			s32& entry = entries[weight.buffer_id][weight.vertex_id];
+
+			if (entry < 0)
+			{
+				entry = influences.size();
+
+				SInfluence influence;
+				influence.StaticPos = weight.StaticPos;
+				influence.StaticNormal = weight.StaticNormal;
+				influence.Vertex = weight.vertex_id;
+				influence.Count = 0;
+				influences.push_back(influence);
+			}
+
+			SInfluence& influence = influences[entry];
+			if (influence.Count == 4)
+			{
+				os::Printer::log("Skinned Mesh: More than 4 weights for a vertex, skinning by joints", ELL_DEBUG);
+				Influences.clear();
+				return;
+			}
+
+			influence.Joint[influence.Count] = (u16)JointOrder[i];
+			influence.Weight[influence.Count] = weight.strength;
+			++influence.Count;
+		}
+	}
+
+	// write the vertices in the order of the buffer
+	for (i=0; i<Influences.size(); ++i)
+		Influences[i].sort();
+}
+
+
+//! Skins all vertices of the influence table in one pass
+/** \param skinMatrices For each joint the global animated matrix multiplied
+by the global inversed matrix. */
+void CSkinnedMesh::skinInfluences(const core::array<core::matrix4> &skinMatrices,
+				core::array<SSkinMeshBuffer*> &buffers) const
+{
+	for (u32 b=0; b<Influences.size(); ++b)
+	{
+		const core::array<SInfluence>& influences = Influences[b];
+		if (influences.empty())
+			continue;
+
+		SSkinMeshBuffer* buffer = buffers[b];
+		u8* vertices = (u8*)buffer->getVertices();
+		const u32 pitch = video::getVertexPitchFromType(buffer->getVertexType());
+
+		for (u32 i=0; i<influences.size(); ++i)
+		{
+			const SInfluence& influence = influences[i];
+			video::S3DVertex* vertex = (video::S3DVertex*)(vertices + influence.Vertex*pitch);
+
+#if defined(IRR_SKINNED_MESH_SSE2)
+			// one lane per coordinate, summed in the order of matrix4::transformVect
+			const __m128 px = _mm_set1_ps(influence.StaticPos.X);
+			const __m128 py = _mm_set1_ps(influence.StaticPos.Y);
+			const __m128 pz = _mm_set1_ps(influence.StaticPos.Z);
+			const __m128 nx = _mm_set1_ps(influence.StaticNormal.X);
+			const __m128 ny = _mm_set1_ps(influence.StaticNormal.Y);
+			const __m128 nz = _mm_set1_ps(influence.StaticNormal.Z);
+
+			__m128 pos = _mm_setzero_ps();
+			__m128 normal = _mm_setzero_ps();
+			for (u32 k=0; k<influence.Count; ++k)
+			{
+				const f32* m = skinMatrices[influence.Joint[k]].pointer();
+				const __m128 c0 = _mm_loadu_ps(m);
+				const __m128 c1 = _mm_loadu_ps(m + 4);
+				const __m128 c2 = _mm_loadu_ps(m + 8);
+				const __m128 c3 = _mm_loadu_ps(m + 12);
+				const __m128 weight = _mm_set1_ps(influence.Weight[k]);
+
+				const __m128 move = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(px, c0), _mm_mul_ps(py, c1)), _mm_mul_ps(pz, c2)), c3), weight);
+				pos = k ? _mm_add_ps(pos, move) : move;
+
+				if (AnimateNormals)
+				{
+					const __m128 turn = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+							_mm_mul_ps(nx, c0), _mm_mul_ps(ny, c1)), _mm_mul_ps(nz, c2)), weight);
+					normal = k ? _mm_add_ps(normal, turn) : turn;
+				}
+			}
+
+			_mm_storel_pi((__m64*)&vertex->Pos.X, pos);
+			_mm_store_ss(&vertex->Pos.Z, _mm_movehl_ps(pos, pos));
+			if (AnimateNormals)
+			{
+				_mm_storel_pi((__m64*)&vertex->Normal.X, normal);
+				_mm_store_ss(&vertex->Normal.Z, _mm_movehl_ps(normal, normal));
+			}
+#else
+			core::vector3df thisVertexMove, thisNormalMove;
+			for (u32 k=0; k<influence.Count; ++k)
+			{
+				const core::matrix4& jointVertexPull = skinMatrices[influence.Joint[k]];
+
+				jointVertexPull.transformVect(thisVertexMove, influence.StaticPos);
+				if (k)
+					vertex->Pos += thisVertexMove * influence.Weight[k];
+				else
+					vertex->Pos = thisVertexMove * influence.Weight[k];
+
+				if (AnimateNormals)
+				{
+					jointVertexPull.rotateVect(thisNormalMove, influence.StaticNormal);
+					if (k)
+						vertex->Normal += thisNormalMove * influence.Weight[k];
+					else
+						vertex->Normal = thisNormalMove * influence.Weight[k];
+				}
+			}
+#endif
+		}
+
+		buffer->boundingBoxNeedsRecalculated();
+	}
 }
 
 
@@ -785,6 +1320,27 @@ const core::array<CSkinnedMesh::SJoint*> &CSkinnedMesh::getAllJoints() const
 }
 
 
+//! Copies the animation keys of a joint, also compressed ones
+void CSkinnedMesh::getJointKeys(const SJoint* joint, core::array<SPositionKey>& positionKeys,
+	core::array<SScaleKey>& scaleKeys, core::array<SRotationKey>& rotationKeys) const
+{
+	if (joint->CompressedPositions.Frames.size())
+		decompressKeys(joint->CompressedPositions, positionKeys);
+	else
+		positionKeys = joint->PositionKeys;
+
+	if (joint->CompressedScales.Frames.size())
+		decompressKeys(joint->CompressedScales, scaleKeys);
+	else
+		scaleKeys = joint->ScaleKeys;
+
+	if (joint->CompressedRotations.Frames.size())
+		decompressKeys(joint->CompressedRotations, rotationKeys);
+	else
+		rotationKeys = joint->RotationKeys;
+}
+
+
 //! (This feature is not implemented in irrlicht yet)
 bool CSkinnedMesh::setHardwareSkinning(bool on)
 {
@@ -856,9 +1412,7 @@ void CSkinnedMesh::checkForAnimation()
 	{
 		if (AllJoints[i]->UseAnimationFrom)
 		{
-			if (AllJoints[i]->UseAnimationFrom->PositionKeys.size() ||
-				AllJoints[i]->UseAnimationFrom->ScaleKeys.size() ||
-				AllJoints[i]->UseAnimationFrom->RotationKeys.size() )
+			if (hasKeys(AllJoints[i]->UseAnimationFrom))
 			{
 				HasAnimation = true;
 			}
@@ -894,6 +1448,14 @@ void CSkinnedMesh::checkForAnimation()
 				if (AllJoints[i]->UseAnimationFrom->RotationKeys.size())
 					if (AllJoints[i]->UseAnimationFrom->RotationKeys.getLast().frame > EndFrame)
 						EndFrame=AllJoints[i]->UseAnimationFrom->RotationKeys.getLast().frame;
+
+				const SJoint* source = AllJoints[i]->UseAnimationFrom;
+				if (source->CompressedPositions.Frames.size())
+					EndFrame = core::max_(EndFrame, source->CompressedPositions.Frames.getLast());
+				if (source->CompressedScales.Frames.size())
+					EndFrame = core::max_(EndFrame, source->CompressedScales.Frames.getLast());
+				if (source->CompressedRotations.Frames.size())
+					EndFrame = core::max_(EndFrame, source->CompressedRotations.Frames.getLast());
 			}
 		}
 	}
@@ -951,6 +1513,8 @@ void CSkinnedMesh::checkForAnimation()
 
 		// normalize weights
 		normalizeWeights();
+
+		buildInfluences();
 	}
 	SkinnedLastFrame=false;
 }
@@ -1005,6 +1569,14 @@ void CSkinnedMesh::finalize()
 		AllJoints[i]->UseAnimationFrom=AllJoints[i];
 	}
 
+	// joints with parents first, as instances keep their pose by index
+	JointOrder.clear();
+	JointParents.set_used(AllJoints.size());
+	for (i=0; i<JointParents.size(); ++i)
+		JointParents[i] = -1;
+	for (i=0; i<RootJoints.size(); ++i)
+		buildJointOrder(RootJoints[i], -1);
+
 	//Set array sizes...
 
 	for (i=0; i<LocalBuffers.size(); ++i)
@@ -1128,6 +1700,8 @@ void CSkinnedMesh::finalize()
 		}
 	}
 
+	resampleKeys();
+
 	//Needed for animation and skinning...
 
 	calculateGlobalMatrices(0,0);
@@ -1171,8 +1745,14 @@ void CSkinnedMesh::updateBoundingBox(void)
 	if(!SkinningBuffers)
 		return;
 
-	core::array<SSkinMeshBuffer*> & buffer = *SkinningBuffers;
-	BoundingBox.reset(0,0,0);
+	updateBoundingBox(*SkinningBuffers, BoundingBox);
+}
+
+
+void CSkinnedMesh::updateBoundingBox(const core::array<SSkinMeshBuffer*> &buffer,
+				core::aabbox3d<f32> &box) const
+{
+	box.reset(0,0,0);
 
 	if (!buffer.empty())
 	{
@@ -1182,7 +1762,7 @@ void CSkinnedMesh::updateBoundingBox(void)
 			core::aabbox3df bb = buffer[j]->BoundingBox;
 			buffer[j]->Transformation.transformBoxEx(bb);
 
-			BoundingBox.addInternalBox(bb);
+			box.addInternalBox(bb);
 		}
 	}
 }
@@ -1412,6 +1992,318 @@ void CSkinnedMesh::addJoints(core::array<IBoneSceneNode*> &jointChildSceneNodes,
 }
 
 
+//! Creates an instance with its own joint pose and skinned meshbuffers
+CSkinnedMeshInstance* CSkinnedMesh::createInstance() const
+{
+	CSkinnedMeshInstance* instance = new CSkinnedMeshInstance(this);
+
+	instance->Joints.set_used(AllJoints.size());
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		const SJoint* joint = AllJoints[i];
+		CSkinnedMeshInstance::SJointPose& pose = instance->Joints[i];
+
+		pose.LocalAnimatedMatrix = joint->LocalMatrix;
+		pose.GlobalAnimatedMatrix = joint->GlobalMatrix;
+		pose.Animatedposition = joint->Animatedposition;
+		pose.Animatedscale = joint->Animatedscale;
+		pose.Animatedrotation = joint->Animatedrotation;
+		pose.positionHint = -1;
+		pose.scaleHint = -1;
+		pose.rotationHint = -1;
+		pose.GlobalSkinningSpace = false;
+	}
+
+	return instance;
+}
+
+
+//! Animates the joints of an instance based on frame input
+void CSkinnedMesh::animateMesh(CSkinnedMeshInstance& instance, f32 frame) const
+{
+	if (!HasAnimation || instance.LastAnimatedFrame==frame)
+		return;
+
+	instance.LastAnimatedFrame=frame;
+	instance.SkinnedLastFrame=false;
+
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		const SJoint *joint = AllJoints[i];
+		CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+
+		getFrameData(frame, joint,
+				pose.Animatedposition, pose.positionHint,
+				pose.Animatedscale, pose.scaleHint,
+				pose.Animatedrotation, pose.rotationHint);
+	}
+
+	buildLocalAnimatedMatrices(instance);
+}
+
+
+//! Animates the joints of an instance and blends layers over them
+void CSkinnedMesh::animateMesh(CSkinnedMeshInstance& instance, f32 frame,
+		const SAnimationLayer* layers, u32 layerCount) const
+{
+	if (!HasAnimation)
+		return;
+
+	// the blended pose depends on all layers, so it isn't cached by frame
+	instance.LastAnimatedFrame=-1.f;
+	instance.SkinnedLastFrame=false;
+
+	const u32 jointCount = AllJoints.size();
+	if (instance.LayerHints.size() < layerCount*jointCount*3)
+	{
+		const u32 first = instance.LayerHints.size();
+		instance.LayerHints.set_used(layerCount*jointCount*3);
+		for (u32 i=first; i<instance.LayerHints.size(); ++i)
+			instance.LayerHints[i] = -1;
+	}
+
+	for (u32 i=0; i<jointCount; ++i)
+	{
+		CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+
+		getFrameData(frame, AllJoints[i],
+				pose.Animatedposition, pose.positionHint,
+				pose.Animatedscale, pose.scaleHint,
+				pose.Animatedrotation, pose.rotationHint);
+	}
+
+	for (u32 l=0; l<layerCount; ++l)
+	{
+		const SAnimationLayer& layer = layers[l];
+		if (layer.Weight <= 0.f)
+			continue;
+
+		s32* hints = &instance.LayerHints[l*jointCount*3];
+		for (u32 i=0; i<jointCount; ++i, hints+=3)
+		{
+			f32 weight = layer.Weight;
+			if (i < layer.JointMask.size())
+				weight *= layer.JointMask[i];
+			if (weight <= 0.f)
+				continue;
+
+			CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+
+			// joints without keys of their own keep the pose below
+			core::vector3df position = pose.Animatedposition;
+			core::vector3df scale = pose.Animatedscale;
+			core::quaternion rotation = pose.Animatedrotation;
+			getFrameData(layer.CurrentFrame, AllJoints[i],
+					position, hints[0],
+					scale, hints[1],
+					rotation, hints[2]);
+
+			if (weight >= 1.f)
+			{
+				pose.Animatedposition = position;
+				pose.Animatedscale = scale;
+				pose.Animatedrotation = rotation;
+			}
+			else
+			{
+				pose.Animatedposition = core::lerp(pose.Animatedposition, position, weight);
+				pose.Animatedscale = core::lerp(pose.Animatedscale, scale, weight);
+				pose.Animatedrotation.slerp(pose.Animatedrotation, rotation, weight);
+			}
+		}
+	}
+
+	buildLocalAnimatedMatrices(instance);
+}
+
+
+//! builds the local matrices of an instance from the animated positions, scales and rotations
+void CSkinnedMesh::buildLocalAnimatedMatrices(CSkinnedMeshInstance& instance) const
+{
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		const SJoint *joint = AllJoints[i];
+		CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+
+		if (joint->UseAnimationFrom && hasKeys(joint->UseAnimationFrom))
+		{
+			pose.GlobalSkinningSpace=false;
+
+			buildLocalAnimatedMatrix(joint, pose.Animatedposition, pose.Animatedscale,
+					pose.Animatedrotation, pose.LocalAnimatedMatrix);
+		}
+		else
+		{
+			pose.LocalAnimatedMatrix=joint->LocalMatrix;
+		}
+	}
+}
+
+
+//! Preforms a software skin on the meshbuffers of an instance based on its joint positions
+/** The instance gets its own copy of the meshbuffers on the first skinning. */
+void CSkinnedMesh::skinMesh(CSkinnedMeshInstance& instance) const
+{
+	if (!HasAnimation || instance.SkinnedLastFrame)
+		return;
+
+	u32 i;
+
+	for (i=0; i<JointOrder.size(); ++i)
+	{
+		CSkinnedMeshInstance::SJointPose& pose = instance.Joints[JointOrder[i]];
+		const s32 parent = JointParents[JointOrder[i]];
+
+		if (parent < 0 || pose.GlobalSkinningSpace)
+			pose.GlobalAnimatedMatrix = pose.LocalAnimatedMatrix;
+		else
+			pose.GlobalAnimatedMatrix = instance.Joints[parent].GlobalAnimatedMatrix * pose.LocalAnimatedMatrix;
+	}
+
+	instance.SkinnedLastFrame=true;
+	if (!HardwareSkinning)
+	{
+		if (instance.Buffers.empty())
+		{
+			instance.Buffers.reallocate(LocalBuffers.size());
+			for (i=0; i<LocalBuffers.size(); ++i)
+			{
+				const SSkinMeshBuffer* source = LocalBuffers[i];
+				SSkinMeshBuffer* buffer = new SSkinMeshBuffer(source->VertexType);
+				buffer->Vertices_Tangents = source->Vertices_Tangents;
+				buffer->Vertices_2TCoords = source->Vertices_2TCoords;
+				buffer->Vertices_Standard = source->Vertices_Standard;
+				buffer->Indices = source->Indices;
+				buffer->Transformation = source->Transformation;
+				buffer->Material = source->Material;
+				buffer->BoundingBox = source->BoundingBox;
+				buffer->setPrimitiveType(source->getPrimitiveType());
+				buffer->setHardwareMappingHint(source->getHardwareMappingHint_Vertex(), EBT_VERTEX);
+				buffer->setHardwareMappingHint(source->getHardwareMappingHint_Index(), EBT_INDEX);
+				instance.Buffers.push_back(buffer);
+
+				instance.Vertices_Moved.push_back(core::array<bool>());
+				instance.Vertices_Moved[i].set_used(buffer->getVertexCount());
+			}
+		}
+
+		//rigid animation
+		for (i=0; i<AllJoints.size(); ++i)
+		{
+			for (u32 j=0; j<AllJoints[i]->AttachedMeshes.size(); ++j)
+			{
+				SSkinMeshBuffer* Buffer=instance.Buffers[ AllJoints[i]->AttachedMeshes[j] ];
+				Buffer->Transformation=instance.Joints[i].GlobalAnimatedMatrix;
+			}
+		}
+
+		if (!Influences.empty())
+		{
+			//skin vertex by vertex
+			instance.SkinMatrices.set_used(AllJoints.size());
+			for (i=0; i<AllJoints.size(); ++i)
+				instance.SkinMatrices[i].setbyproduct(instance.Joints[i].GlobalAnimatedMatrix, AllJoints[i]->GlobalInversedMatrix);
+
+			skinInfluences(instance.SkinMatrices, instance.Buffers);
+		}
+		else
+		{
+			//clear skinning helper array
+			for (i=0; i<instance.Vertices_Moved.size(); ++i)
+				for (u32 j=0; j<instance.Vertices_Moved[i].size(); ++j)
+					instance.Vertices_Moved[i][j]=false;
+
+			//skin with parents first, like skinJoint
+			for (i=0; i<JointOrder.size(); ++i)
+				skinWeights(AllJoints[JointOrder[i]], instance.Joints[JointOrder[i]].GlobalAnimatedMatrix,
+						instance.Buffers, instance.Vertices_Moved);
+		}
+
+		for (i=0; i<instance.Buffers.size(); ++i)
+			instance.Buffers[i]->setDirty(EBT_VERTEX);
+
+		updateBoundingBox(instance.Buffers, instance.BoundingBox);
+	}
+}
+
+
+//! Recovers the joints from an instance
+void CSkinnedMesh::recoverJointsFromMesh(const CSkinnedMeshInstance& instance,
+		core::array<IBoneSceneNode*> &jointChildSceneNodes) const
+{
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		IBoneSceneNode* node=jointChildSceneNodes[i];
+		const CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+		node->setPosition(pose.LocalAnimatedMatrix.getTranslation());
+		node->setRotation(pose.LocalAnimatedMatrix.getRotationDegrees());
+		node->setScale(pose.LocalAnimatedMatrix.getScale());
+
+		node->positionHint=pose.positionHint;
+		node->scaleHint=pose.scaleHint;
+		node->rotationHint=pose.rotationHint;
+
+		node->updateAbsolutePosition();
+	}
+}
+
+
+//! Tranfers the joint data to an instance
+void CSkinnedMesh::transferJointsToMesh(CSkinnedMeshInstance& instance,
+		const core::array<IBoneSceneNode*> &jointChildSceneNodes) const
+{
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		const IBoneSceneNode* const node=jointChildSceneNodes[i];
+		CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+
+		pose.LocalAnimatedMatrix.setRotationDegrees(node->getRotation());
+		pose.LocalAnimatedMatrix.setTranslation(node->getPosition());
+		pose.LocalAnimatedMatrix *= core::matrix4().setScale(node->getScale());
+
+		pose.positionHint=node->positionHint;
+		pose.scaleHint=node->scaleHint;
+		pose.rotationHint=node->rotationHint;
+
+		pose.GlobalSkinningSpace=(node->getSkinningSpace()==EBSS_GLOBAL);
+	}
+	// Make sure we recalc the next frame
+	instance.LastAnimatedFrame=-1;
+	instance.SkinnedLastFrame=false;
+}
+
+
+//! Tranfers the joint hints to an instance
+void CSkinnedMesh::transferOnlyJointsHintsToMesh(CSkinnedMeshInstance& instance,
+		const core::array<IBoneSceneNode*> &jointChildSceneNodes) const
+{
+	for (u32 i=0; i<AllJoints.size(); ++i)
+	{
+		const IBoneSceneNode* const node=jointChildSceneNodes[i];
+		CSkinnedMeshInstance::SJointPose& pose = instance.Joints[i];
+
+		pose.positionHint=node->positionHint;
+		pose.scaleHint=node->scaleHint;
+		pose.rotationHint=node->rotationHint;
+	}
+	instance.SkinnedLastFrame=false;
+}
+
+
+void CSkinnedMesh::buildJointOrder(SJoint *joint, s32 parent)
+{
+	const s32 index = AllJoints.linear_search(joint);
+	if (index < 0)
+		return;
+
+	JointParents[index] = parent;
+	JointOrder.push_back(index);
+
+	for (u32 j=0; j<joint->Children.size(); ++j)
+		buildJointOrder(joint->Children[j], index);
+}
+
+
 void CSkinnedMesh::convertMeshToTangents()
 {
 	// now calculate tangents
@@ -13,6 +13,7 @@
 #include "irrString.h"
 #include "matrix4.h"
 #include "quaternion.h"
+#include "SAnimationLayer.h"
 
 namespace irr
 {
@@ -21,6 +22,7 @@ namespace scene
 
 	class IAnimatedMeshSceneNode;
 	class IBoneSceneNode;
+	class CSkinnedMeshInstance;
 
 	class CSkinnedMesh: public ISkinnedMesh
 	{
@@ -104,6 +106,12 @@ namespace scene
 		//! Sets Interpolation Mode
 		virtual void setInterpolationMode(E_INTERPOLATION_MODE mode) IRR_OVERRIDE;
 
+		//! Stores the animation keys of all joints in a compressed format
+		virtual void compressKeys(f32 tolerance) IRR_OVERRIDE;
+
+		//! Resamples the animation keys of all joints at a constant rate
+		virtual void setKeyResampling(f32 framesPerKey) IRR_OVERRIDE;
+
 		//! Convertes the mesh to contain tangent information
 		virtual void convertMeshToTangents() IRR_OVERRIDE;
 
@@ -125,6 +133,10 @@ namespace scene
 		//! alternative method for adding joints
 		virtual const core::array<SJoint*> &getAllJoints() const IRR_OVERRIDE;
 
+		//! Copies the animation keys of a joint, also compressed ones
+		virtual void getJointKeys(const SJoint* joint, core::array<SPositionKey>& positionKeys,
+			core::array<SScaleKey>& scaleKeys, core::array<SRotationKey>& rotationKeys) const IRR_OVERRIDE;
+
 		//! loaders should call this after populating the mesh
 		virtual void finalize() IRR_OVERRIDE;
 
@@ -160,6 +172,35 @@ namespace scene
 				IAnimatedMeshSceneNode* node,
 				ISceneManager* smgr);
 
+		//! Creates an instance with its own joint pose and skinned meshbuffers
+		/** The instance is animated and skinned by the functions below, which
+		don't change the mesh. It has to be dropped after use. */
+		CSkinnedMeshInstance* createInstance() const;
+
+		//! Animates the joints of an instance based on frame input
+		void animateMesh(CSkinnedMeshInstance& instance, f32 frame) const;
+
+		//! Animates the joints of an instance and blends layers over them
+		/** The local positions, scales and rotations of the joints are
+		sampled at the frame and each layer is blended over them in turn. */
+		void animateMesh(CSkinnedMeshInstance& instance, f32 frame,
+				const SAnimationLayer* layers, u32 layerCount) const;
+
+		//! Preforms a software skin on the meshbuffers of an instance based on its joint positions
+		void skinMesh(CSkinnedMeshInstance& instance) const;
+
+		//! Recovers the joints from an instance
+		void recoverJointsFromMesh(const CSkinnedMeshInstance& instance,
+				core::array<IBoneSceneNode*> &jointChildSceneNodes) const;
+
+		//! Tranfers the joint data to an instance
+		void transferJointsToMesh(CSkinnedMeshInstance& instance,
+				const core::array<IBoneSceneNode*> &jointChildSceneNodes) const;
+
+		//! Tranfers the joint hints to an instance
+		void transferOnlyJointsHintsToMesh(CSkinnedMeshInstance& instance,
+				const core::array<IBoneSceneNode*> &jointChildSceneNodes) const;
+
 private:
 		void checkForAnimation();
 
@@ -167,17 +208,42 @@ private:
 
 		void buildAllLocalAnimatedMatrices();
 
+		void buildLocalAnimatedMatrices(CSkinnedMeshInstance& instance) const;
+
 		void buildAllGlobalAnimatedMatrices(SJoint *Joint=0, SJoint *ParentJoint=0);
 
-		void getFrameData(f32 frame, SJoint *Node,
+		void buildLocalAnimatedMatrix(const SJoint *joint, const core::vector3df &position,
+				const core::vector3df &scale, const core::quaternion &rotation,
+				core::matrix4 &matrix) const;
+
+		void buildJointOrder(SJoint *joint, s32 parent);
+
+		void resampleKeys();
+
+		//! true if the joint has animation keys, compressed or not
+		bool hasKeys(const SJoint* joint) const;
+
+		void getFrameData(f32 frame, const SJoint *Node,
 				core::vector3df &position, s32 &positionHint,
 				core::vector3df &scale, s32 &scaleHint,
-				core::quaternion &rotation, s32 &rotationHint);
+				core::quaternion &rotation, s32 &rotationHint) const;
 
 		void calculateGlobalMatrices(SJoint *Joint,SJoint *ParentJoint);
 
 		void skinJoint(SJoint *Joint, SJoint *ParentJoint);
 
+		void skinWeights(const SJoint *joint, const core::matrix4 &globalAnimatedMatrix,
+				core::array<SSkinMeshBuffer*> &buffers,
+				core::array< core::array<bool> > &verticesMoved) const;
+
+		void buildInfluences();
+
+		void skinInfluences(const core::array<core::matrix4> &skinMatrices,
+				core::array<SSkinMeshBuffer*> &buffers) const;
+
+		void updateBoundingBox(const core::array<SSkinMeshBuffer*> &buffers,
+				core::aabbox3d<f32> &box) const;
+
 		void calculateTangents(core::vector3df& normal,
 			core::vector3df& tangent, core::vector3df& binormal,
 			const core::vector3df& vt1, const core::vector3df& vt2, const core::vector3df& vt3,
@@ -190,12 +256,38 @@ private:
 		core::array<SJoint*> AllJoints;
 		core::array<SJoint*> RootJoints;
 
+		// indices of the joints with parents first and of their parents, for instances
+		core::array<u32> JointOrder;
+		core::array<s32> JointParents;
+
 		core::array< core::array<bool> > Vertices_Moved;
 
+		//! up to 4 weighted joints of a skinned vertex, in the order of skinJoint
+		struct SInfluence
+		{
+			core::vector3df StaticPos;
+			core::vector3df StaticNormal;
+			u32 Vertex;
+			u32 Count;
+			u16 Joint[4];
+			f32 Weight[4];
+
+			bool operator<(const SInfluence& other) const
+			{
+				return Vertex < other.Vertex;
+			}
+		};
+
+		// influences of the skinned vertices per meshbuffer, sorted by vertex.
+		// Empty if a vertex has more weights, then the mesh is skinned by joints.
+		core::array< core::array<SInfluence> > Influences;
+		core::array<core::matrix4> SkinMatrices;
+
 		core::aabbox3d<f32> BoundingBox;
 
 		f32 EndFrame;
 		f32 FramesPerSecond;
+		f32 FramesPerKey;
 
 		f32 LastAnimatedFrame;
 		bool SkinnedLastFrame;
@@ -0,0 +1,138 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+#ifdef _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
+
+#include "CSkinnedMeshInstance.h"
+#include "CSkinnedMesh.h"
+
+namespace irr
+{
+namespace scene
+{
+
+
+//! constructor
+CSkinnedMeshInstance::CSkinnedMeshInstance(const CSkinnedMesh* mesh)
+: Mesh(mesh), LastAnimatedFrame(-1), SkinnedLastFrame(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CSkinnedMeshInstance");
+	#endif
+
+	Mesh->grab();
+	BoundingBox = Mesh->getBoundingBox();
+}
+
+
+//! destructor
+CSkinnedMeshInstance::~CSkinnedMeshInstance()
+{
+	for (u32 i=0; i<Buffers.size(); ++i)
+		Buffers[i]->drop();
+
+	Mesh->drop();
+}
+
+
+//! returns amount of mesh buffers.
+u32 CSkinnedMeshInstance::getMeshBufferCount() const
+{
+	return Mesh->getMeshBufferCount();
+}
+
+
+//! returns pointer to a mesh buffer
+IMeshBuffer* CSkinnedMeshInstance::getMeshBuffer(u32 nr) const
+{
+	if (Buffers.empty())
+		return Mesh->getMeshBuffer(nr);
+
+	if (nr < Buffers.size())
+		return Buffers[nr];
+	else
+		return 0;
+}
+
+
+//! Returns pointer to a mesh buffer which fits a material
+IMeshBuffer* CSkinnedMeshInstance::getMeshBuffer(const video::SMaterial &material) const
+{
+	if (Buffers.empty())
+		return Mesh->getMeshBuffer(material);
+
+	for (u32 i=0; i<Buffers.size(); ++i)
+	{
+		if (Buffers[i]->getMaterial() == material)
+			return Buffers[i];
+	}
+	return 0;
+}
+
+
+//! returns an axis aligned bounding box
+const core::aabbox3d<f32>& CSkinnedMeshInstance::getBoundingBox() const
+{
+	return BoundingBox;
+}
+
+
+//! set user axis aligned bounding box
+void CSkinnedMeshInstance::setBoundingBox(const core::aabbox3df& box)
+{
+	BoundingBox = box;
+}
+
+
+//! sets a flag of all own materials to a new value
+void CSkinnedMeshInstance::setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalue)
+{
+	for (u32 i=0; i<Buffers.size(); ++i)
+		Buffers[i]->Material.setFlag(flag, newvalue);
+}
+
+
+//! set the hardware mapping hint of the own meshbuffers, for driver
+void CSkinnedMeshInstance::setHardwareMappingHint(E_HARDWARE_MAPPING newMappingHint,
+		E_BUFFER_TYPE buffer)
+{
+	for (u32 i=0; i<Buffers.size(); ++i)
+		Buffers[i]->setHardwareMappingHint(newMappingHint, buffer);
+}
+
+
+//! flags the own meshbuffers as changed, reloads hardware buffers
+void CSkinnedMeshInstance::setDirty(E_BUFFER_TYPE buffer)
+{
+	for (u32 i=0; i<Buffers.size(); ++i)
+		Buffers[i]->setDirty(buffer);
+}
+
+
+//! Returns the global animated matrix of a joint
+const core::matrix4& CSkinnedMeshInstance::getGlobalAnimatedMatrix(u32 joint) const
+{
+	if (joint < Joints.size())
+		return Joints[joint].GlobalAnimatedMatrix;
+	return core::IdentityMatrix;
+}
+
+
+//! Copies the materials of the mesh into the own meshbuffers
+void CSkinnedMeshInstance::updateMaterials()
+{
+	for (u32 i=0; i<Buffers.size(); ++i)
+	{
+		const video::SMaterial& material = Mesh->getMeshBuffer(i)->getMaterial();
+		if (Buffers[i]->Material != material)
+			Buffers[i]->Material = material;
+	}
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_SKINNED_MESH_SUPPORT_
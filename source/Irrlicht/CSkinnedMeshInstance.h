@@ -0,0 +1,110 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_SKINNED_MESH_INSTANCE_H_INCLUDED
+#define IRR_C_SKINNED_MESH_INSTANCE_H_INCLUDED
+
+#include "IMesh.h"
+#include "SSkinMeshBuffer.h"
+#include "irrArray.h"
+#include "matrix4.h"
+#include "quaternion.h"
+
+namespace irr
+{
+namespace scene
+{
+	class CSkinnedMesh;
+
+	//! Joint pose and skinned meshbuffers of one user of a shared skinned mesh
+	/** Created with CSkinnedMesh::createInstance() and animated and skinned by
+	the const functions of the mesh, which only read the mesh. So any amount
+	of scene nodes can share one mesh at different frames, and instances can
+	be animated on different threads.
+	Until the mesh is skinned for the first time the instance returns the
+	meshbuffers of the mesh. Static meshes are never copied. */
+	class CSkinnedMeshInstance : public IMesh
+	{
+	public:
+
+		//! constructor
+		CSkinnedMeshInstance(const CSkinnedMesh* mesh);
+
+		//! destructor
+		virtual ~CSkinnedMeshInstance();
+
+		//! returns amount of mesh buffers.
+		virtual u32 getMeshBufferCount() const IRR_OVERRIDE;
+
+		//! returns pointer to a mesh buffer
+		virtual IMeshBuffer* getMeshBuffer(u32 nr) const IRR_OVERRIDE;
+
+		//! Returns pointer to a mesh buffer which fits a material
+		virtual IMeshBuffer* getMeshBuffer(const video::SMaterial &material) const IRR_OVERRIDE;
+
+		//! returns an axis aligned bounding box
+		virtual const core::aabbox3d<f32>& getBoundingBox() const IRR_OVERRIDE;
+
+		//! set user axis aligned bounding box
+		virtual void setBoundingBox(const core::aabbox3df& box) IRR_OVERRIDE;
+
+		//! sets a flag of all own materials to a new value
+		virtual void setMaterialFlag(video::E_MATERIAL_FLAG flag, bool newvalue) IRR_OVERRIDE;
+
+		//! set the hardware mapping hint of the own meshbuffers, for driver
+		virtual void setHardwareMappingHint(E_HARDWARE_MAPPING newMappingHint, E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX) IRR_OVERRIDE;
+
+		//! flags the own meshbuffers as changed, reloads hardware buffers
+		virtual void setDirty(E_BUFFER_TYPE buffer=EBT_VERTEX_AND_INDEX) IRR_OVERRIDE;
+
+		//! Returns the mesh this is an instance of
+		const CSkinnedMesh* getSkinnedMesh() const { return Mesh; }
+
+		//! Returns the global animated matrix of a joint
+		const core::matrix4& getGlobalAnimatedMatrix(u32 joint) const;
+
+		//! Copies the materials of the mesh into the own meshbuffers
+		/** Needed for read only materials, which follow changes of the mesh. */
+		void updateMaterials();
+
+	private:
+
+		friend class CSkinnedMesh;
+
+		//! animated state of a joint, see ISkinnedMesh::SJoint
+		struct SJointPose
+		{
+			core::matrix4 LocalAnimatedMatrix;
+			core::matrix4 GlobalAnimatedMatrix;
+			core::vector3df Animatedposition;
+			core::vector3df Animatedscale;
+			core::quaternion Animatedrotation;
+
+			s32 positionHint;
+			s32 scaleHint;
+			s32 rotationHint;
+
+			bool GlobalSkinningSpace;
+		};
+
+		const CSkinnedMesh* Mesh;
+
+		core::array<SJointPose> Joints;
+		core::array<SSkinMeshBuffer*> Buffers;
+		core::array< core::array<bool> > Vertices_Moved;
+		core::array<core::matrix4> SkinMatrices;
+
+		// key hints of the animation layers, 3 per joint and layer
+		core::array<s32> LayerHints;
+
+		core::aabbox3d<f32> BoundingBox;
+
+		f32 LastAnimatedFrame;
+		bool SkinnedLastFrame;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
@@ -14,6 +14,7 @@
 #include "S3DVertex.h"
 #include "S4DVertex.h"
 #include "CBlit.h"
+#include "CThreadPool.h"
 
 
 // Matrix now here
@@ -535,12 +536,59 @@ void fpu_exception(int on)
 
 burning_namespace_start
 
+//! create the triangle renderer for a fixed function shader slot
+static IBurningShader* createBurningShader(const size_t shader, CBurningVideoDriver* driver)
+{
+	switch (shader)
+	{
+	//case ETR_FLAT: return createTRFlat2(driver);
+	//case ETR_FLAT_WIRE: return createTRFlatWire2(driver);
+	case ETR_GOURAUD: return createTriangleRendererGouraud2(driver);
+	case ETR_GOURAUD_NOZ: return createTriangleRendererGouraudNoZ2(driver);
+	//case ETR_GOURAUD_ALPHA: return createTriangleRendererGouraudAlpha2(driver );
+	case ETR_GOURAUD_ALPHA_NOZ: return createTRGouraudAlphaNoZ2(driver); // 2D
+	//case ETR_GOURAUD_WIRE: return createTriangleRendererGouraudWire2(driver);
+	//case ETR_TEXTURE_FLAT: return createTriangleRendererTextureFlat2(driver);
+	//case ETR_TEXTURE_FLAT_WIRE: return createTriangleRendererTextureFlatWire2(driver);
+	case ETR_TEXTURE_GOURAUD: return createTriangleRendererTextureGouraud2(driver);
+	case ETR_TEXTURE_GOURAUD_LIGHTMAP_M1: return createTriangleRendererTextureLightMap2_M1(driver);
+	case ETR_TEXTURE_GOURAUD_LIGHTMAP_M2: return createTriangleRendererTextureLightMap2_M2(driver);
+	case ETR_TEXTURE_GOURAUD_LIGHTMAP_M4: return createTriangleRendererGTextureLightMap2_M4(driver);
+	case ETR_TEXTURE_LIGHTMAP_M4: return createTriangleRendererTextureLightMap2_M4(driver);
+	case ETR_TEXTURE_GOURAUD_LIGHTMAP_ADD: return createTriangleRendererTextureLightMap2_Add(driver);
+	case ETR_TEXTURE_GOURAUD_DETAIL_MAP: return createTriangleRendererTextureDetailMap2(driver);
+
+	case ETR_TEXTURE_GOURAUD_WIRE: return createTriangleRendererTextureGouraudWire2(driver);
+	case ETR_TEXTURE_GOURAUD_NOZ: return createTRTextureGouraudNoZ2(driver);
+	case ETR_TEXTURE_GOURAUD_ADD: return createTRTextureGouraudAdd2(driver);
+	case ETR_TEXTURE_GOURAUD_ADD_NO_Z: return createTRTextureGouraudAddNoZ2(driver);
+	case ETR_TEXTURE_GOURAUD_VERTEX_ALPHA: return createTriangleRendererTextureVertexAlpha2(driver);
+
+	case ETR_TEXTURE_GOURAUD_ALPHA: return createTRTextureGouraudAlpha(driver);
+	case ETR_TEXTURE_GOURAUD_ALPHA_NOZ: return createTRTextureGouraudAlphaNoZ(driver);
+
+	//case ETR_NORMAL_MAP_SOLID: return createTRNormalMap(driver, EMT_NORMAL_MAP_SOLID);
+	case ETR_STENCIL_SHADOW: return createTRStencilShadow(driver);
+	case ETR_TEXTURE_BLEND: return createTRTextureBlend(driver);
+
+	case ETR_TRANSPARENT_REFLECTION_2_LAYER: return createTriangleRendererTexture_transparent_reflection_2_layer(driver);
+	//case ETR_REFERENCE: return createTriangleRendererReference ( driver );
+
+	case ETR_COLOR: return create_burning_shader_color(driver);
+	default: return 0;
+	}
+}
+
 //! constructor
 CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters& params, io::IFileSystem* io, video::IImagePresenter* presenter)
 	: CNullDriver(io, params.WindowSize), BackBuffer(0), Presenter(presenter),
 	WindowId(0), SceneSourceRect(0),
 	RenderTargetTexture(0), RenderTargetSurface(0), CurrentShader(0),
-	DepthBuffer(0), StencilBuffer(0)
+	DepthBuffer(0), StencilBuffer(0),
+	RasterThreads(0), RasterTiled(params.TiledRasterizer), RasterTriangleCount(0), RasterShaderId(ETR2_COUNT),
+	VertexSIMD(BURNING_SIMD_NONE), FragmentProfile(params.FastTextureMapping ? 0 : BF_DEFAULT),
+	TransformCacheLink(0), TransformCacheEntry(0), TransformCacheBytes(0), TransformCacheStamp(0),
+	InstanceColor(0xFFFFFFFF)
 {
 	//enable fpu exception
 	fpu_exception(1);
@@ -550,6 +598,7 @@ CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters&
 #endif
 
 	VertexCache_map_source_format();
+	VertexSIMD = params.SIMDVertexTransform ? burning_simd_detect() : BURNING_SIMD_NONE;
 
 	//Use AntiAlias(hack) to shrink BackBuffer Size and keep ScreenSize the same as Input
 
@@ -584,42 +633,40 @@ CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters&
 	DriverAttributes->setAttribute("Version", 50);
 
 	// create triangle renderers
+	for (size_t i = 0; i < ETR2_COUNT; ++i)
+	{
+		BurningShader[i] = createBurningShader(i, this);
+	}
+
+	// bin triangles and submit them in batches
+	RasterVertex.resize(SOFTWARE_DRIVER_2_RASTER_BATCH * 3);
+	RasterTriangle.set_used(SOFTWARE_DRIVER_2_RASTER_BATCH);
+
+	// rasterize horizontal bands in parallel
+	if (params.DriverMultithreaded)
+	{
+		RasterThreads = new CThreadPool(core::min_(CThreadPool::getProcessorCount(), (u32)SOFTWARE_DRIVER_2_RASTER_MAX_THREADS));
+		if (RasterThreads->getThreadCount() > 1)
+		{
+			RasterShader.set_used((RasterTiled ? SOFTWARE_DRIVER_2_RASTER_MAX_BANDS : RasterThreads->getThreadCount()) * ETR2_COUNT);
+			for (u32 i = 0; i < RasterShader.size(); ++i)
+				RasterShader[i] = 0;
+
+			char buf[64];
+			snprintf_irr(buf, sizeof(buf), "Burningvideo: Rasterizer threads:%u", RasterThreads->getThreadCount());
+			os::Printer::log(buf, ELL_INFORMATION);
+		}
+		else
+		{
+			RasterThreads->drop();
+			RasterThreads = 0;
+		}
+	}
+	DriverAttributes->setAttribute("RasterThreads", RasterThreads ? (s32)RasterThreads->getThreadCount() : 1);
+	DriverAttributes->setAttribute("VertexSIMD", (s32)VertexSIMD);
 
-	memset(BurningShader, 0, sizeof(BurningShader));
-	//BurningShader[ETR_FLAT] = createTRFlat2(DepthBuffer);
-	//BurningShader[ETR_FLAT_WIRE] = createTRFlatWire2(DepthBuffer);
-	BurningShader[ETR_GOURAUD] = createTriangleRendererGouraud2(this);
-	BurningShader[ETR_GOURAUD_NOZ] = createTriangleRendererGouraudNoZ2(this);
-	//BurningShader[ETR_GOURAUD_ALPHA] = createTriangleRendererGouraudAlpha2(this );
-	BurningShader[ETR_GOURAUD_ALPHA_NOZ] = createTRGouraudAlphaNoZ2(this); // 2D
-	//BurningShader[ETR_GOURAUD_WIRE] = createTriangleRendererGouraudWire2(DepthBuffer);
-	//BurningShader[ETR_TEXTURE_FLAT] = createTriangleRendererTextureFlat2(DepthBuffer);
-	//BurningShader[ETR_TEXTURE_FLAT_WIRE] = createTriangleRendererTextureFlatWire2(DepthBuffer);
-	BurningShader[ETR_TEXTURE_GOURAUD] = createTriangleRendererTextureGouraud2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_M1] = createTriangleRendererTextureLightMap2_M1(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_M2] = createTriangleRendererTextureLightMap2_M2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_M4] = createTriangleRendererGTextureLightMap2_M4(this);
-	BurningShader[ETR_TEXTURE_LIGHTMAP_M4] = createTriangleRendererTextureLightMap2_M4(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_LIGHTMAP_ADD] = createTriangleRendererTextureLightMap2_Add(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_DETAIL_MAP] = createTriangleRendererTextureDetailMap2(this);
-
-	BurningShader[ETR_TEXTURE_GOURAUD_WIRE] = createTriangleRendererTextureGouraudWire2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_NOZ] = createTRTextureGouraudNoZ2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_ADD] = createTRTextureGouraudAdd2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_ADD_NO_Z] = createTRTextureGouraudAddNoZ2(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_VERTEX_ALPHA] = createTriangleRendererTextureVertexAlpha2(this);
-
-	BurningShader[ETR_TEXTURE_GOURAUD_ALPHA] = createTRTextureGouraudAlpha(this);
-	BurningShader[ETR_TEXTURE_GOURAUD_ALPHA_NOZ] = createTRTextureGouraudAlphaNoZ(this);
-
-	//BurningShader[ETR_NORMAL_MAP_SOLID] = createTRNormalMap(this, EMT_NORMAL_MAP_SOLID);
-	BurningShader[ETR_STENCIL_SHADOW] = createTRStencilShadow(this);
-	BurningShader[ETR_TEXTURE_BLEND] = createTRTextureBlend(this);
-
-	BurningShader[ETR_TRANSPARENT_REFLECTION_2_LAYER] = createTriangleRendererTexture_transparent_reflection_2_layer(this);
-	//BurningShader[ETR_REFERENCE] = createTriangleRendererReference ( this );
-
-	BurningShader[ETR_COLOR] = create_burning_shader_color(this);
+	// a single thread would set up every triangle once per tile row it touches without any gain
+	RasterTiled = RasterTiled && RasterThreads;
 
 	// add the same renderer for all solid types
 	CSoftware2MaterialRenderer_SOLID* smr = new CSoftware2MaterialRenderer_SOLID(this);
@@ -687,6 +734,9 @@ CBurningVideoDriver::CBurningVideoDriver(const irr::SIrrlichtCreationParameters&
 //! destructor
 CBurningVideoDriver::~CBurningVideoDriver()
 {
+	// free post transform cache. CNullDriver can't call the derived deleteHardwareBuffer
+	removeAllHardwareBuffers();
+
 	// delete Backbuffer
 	if (BackBuffer)
 	{
@@ -708,6 +758,18 @@ CBurningVideoDriver::~CBurningVideoDriver()
 			BurningShader[i] = 0;
 		}
 	}
+	for (u32 i = 0; i < RasterShader.size(); ++i)
+	{
+		if (RasterShader[i])
+			RasterShader[i]->drop();
+	}
+	RasterShader.clear();
+
+	if (RasterThreads)
+	{
+		RasterThreads->drop();
+		RasterThreads = 0;
+	}
 	//deleteMaterialRenders();
 
 	// delete Additional buffer
@@ -782,6 +844,7 @@ bool CBurningVideoDriver::queryFeature(E_VIDEO_DRIVER_FEATURE feature) const
 		on = 0;
 		break;
 	case EVDF_DEPTH_CLAMP: // shadow
+	case EVDF_DEPTH_PREPASS:
 		on = 1;
 		break;
 #endif
@@ -960,6 +1023,8 @@ void CBurningVideoDriver::setTransform(E_TRANSFORMATION_STATE state, const core:
 			{
 				flag[state] |= ETF_TEXGEN_MATRIX;
 			}
+			// next setMaterial has to set the texture matrices of the material again
+			Material.resetRenderStates = true;
 			break;
 		default:
 			break;
@@ -983,6 +1048,7 @@ bool CBurningVideoDriver::beginScene(u16 clearFlag, SColor clearColor, f32 clear
 #endif
 
 	Interlaced.nr = (Interlaced.nr + 1) & interlace_control_mask;
+	Material.resetRenderStates = true;
 	WindowId = videoData.D3D9.HWnd;
 	SceneSourceRect = sourceRect;
 
@@ -1101,6 +1167,7 @@ void CBurningVideoDriver::setRenderTargetImage2(video::IImage* color, video::IIm
 	burning_setbit(TransformationFlag[1][ETS_PROJECTION], not_changed, ETF_VALID);
 
 	setViewPort(core::recti(RenderTargetSize));
+	Material.resetRenderStates = true;
 
 	if (DepthBuffer)
 		DepthBuffer->setSize(RenderTargetSize);
@@ -1810,8 +1877,10 @@ void CBurningVideoDriver::VertexCache_map_source_format()
 /*!
 	fill a cache line with transformed, light and clip test triangles
 	overhead - if primitive is outside or culled, vertexLighting and TextureTransform is still done
+	batch - position, clip test, eyespace, fog and texture matrix already done in lane
 */
-void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 destIndex)
+void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 destIndex,
+	const sVertexBatch* batch, const u32 lane)
 {
 	const u8* burning_restrict source;
 	s4DVertex* burning_restrict dest;
@@ -1843,7 +1912,7 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 		// Vertex program attribute inputs:
 		sVec4 gl_Vertex(base->Pos.X, base->Pos.Y, base->Pos.Z, 1.f);
 		sVec4 gl_Normal(base->Normal.X, base->Normal.Y, base->Normal.Z, 1.f);
-		sVec4 gl_Color; gl_Color.setA8R8G8B8(base->Color.color);
+		sVec4 gl_Color; gl_Color.setA8R8G8B8(instance_color(base->Color.color));
 
 		// Irrlicht TCoords and TCoords2 must be contiguous memory. baseTCoord has no 4 byte aligned start address!
 		sVec4 gl_MultiTexCoord[4];
@@ -2104,7 +2173,17 @@ void CBurningVideoDriver::VertexCache_fill(const u32 sourceIndex, const u32 dest
 
 fftransform:
 	// transform Model * World * Camera * Projection * NDCSpace matrix
-	matrix[ETS_MODEL_VIEW_PROJ].transformVect(&dest[0].Pos.x, base->Pos);
+	if (batch)
+	{
+		dest->Pos.x = batch->x[lane];
+		dest->Pos.y = batch->y[lane];
+		dest->Pos.z = batch->z[lane];
+		dest->Pos.w = batch->w[lane];
+	}
+	else
+	{
+		matrix[ETS_MODEL_VIEW_PROJ].transformVect(&dest[0].Pos.x, base->Pos);
+	}
 
 /*
 	ieee754* p = (ieee754*) &dest[0].Pos.x;
@@ -2130,7 +2209,8 @@ fftransform:
 		//	dest->Pos.z = dest->Pos.w*0.99f;
 
 		//glPolygonOffset // self shadow wanted or not?
-		dest->Pos.w *= 1.005f;
+		if (!batch)
+			dest->Pos.w *= 1.005f;
 
 		//flag |= v->Pos.z <= v->Pos.w ? VERTEX4D_CLIP_NEAR : 0;
 		//flag |= -v->Pos.z <= v->Pos.w ? VERTEX4D_CLIP_FAR : 0;
@@ -2144,14 +2224,24 @@ fftransform:
 	// vertex, normal in light(eye) space
 	if (EyeSpace.TL_Flag & (TL_TEXTURE_TRANSFORM | TL_FOG | TL_LIGHT))
 	{
-		sVec4 vertex4; //eye coordinate position of vertex
-		matrix[ETS_MODEL_VIEW].transformVect(&vertex4.x, base->Pos);
-
-		f32 iw = reciprocal_zero_pos_underflow(vertex4.w);
-		EyeSpace.vertex.x = vertex4.x * iw;
-		EyeSpace.vertex.y = vertex4.y * iw;
-		EyeSpace.vertex.z = vertex4.z * iw;
-		EyeSpace.vertex.w = iw;
+		if (batch && batch->eye)
+		{
+			EyeSpace.vertex.x = batch->ex[lane];
+			EyeSpace.vertex.y = batch->ey[lane];
+			EyeSpace.vertex.z = batch->ez[lane];
+			EyeSpace.vertex.w = batch->ew[lane];
+		}
+		else
+		{
+			sVec4 vertex4; //eye coordinate position of vertex
+			matrix[ETS_MODEL_VIEW].transformVect(&vertex4.x, base->Pos);
+
+			f32 iw = reciprocal_zero_pos_underflow(vertex4.w);
+			EyeSpace.vertex.x = vertex4.x * iw;
+			EyeSpace.vertex.y = vertex4.y * iw;
+			EyeSpace.vertex.z = vertex4.z * iw;
+			EyeSpace.vertex.w = iw;
+		}
 
 		//EyeSpace.cam_distance = EyeSpace.vertex.length_xyz();
 /*
@@ -2182,14 +2272,14 @@ fftransform:
 #if defined (SOFTWARE_DRIVER_2_LIGHTING)
 	if (EyeSpace.TL_Flag & TL_LIGHT)
 	{
-		lightVertex_eye(dest, base->Color.color);
+		lightVertex_eye(dest, instance_color(base->Color.color));
 	}
 	else
 	{
-		dest->Color[0].setA8R8G8B8(base->Color.color);
+		dest->Color[0].setA8R8G8B8(instance_color(base->Color.color));
 	}
 #else
-	dest->Color[0].setA8R8G8B8(base->Color.color);
+	dest->Color[0].setA8R8G8B8(instance_color(base->Color.color));
 #endif
 #endif
 
@@ -2203,7 +2293,9 @@ fftransform:
 		fog_frag_coord.f = EyeSpace.vertex.z;
 		fog_frag_coord.fields.sign = 0;
 
-		switch (FogType)
+		if (batch && batch->fogValid)
+			fog_factor = batch->fog[lane];
+		else switch (FogType)
 		{
 		case EFT_FOG_LINEAR:
 			fog_factor = (FogEnd - fog_frag_coord.f) * EyeSpace.fog_scale;
@@ -2294,6 +2386,14 @@ fftransform:
 #endif
 
 		//Texture Matrix Transform
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+		if (batch && (batch->texMask & (1 << m)))
+		{
+			tx = batch->tu[m][lane];
+			ty = batch->tv[m][lane];
+		}
+		else
+#endif
 		if (flag & ETF_TEXGEN_MATRIX) // !(flag & ETF_IDENTITY)
 		{
 			/*
@@ -2460,7 +2560,7 @@ fftransform:
 clipandproject:
 
 	// test vertex visibility
-	const u32 flag = clipToFrustumTest(dest) | VertexShader.vSize[VertexShader.vType].Format;
+	const u32 flag = (batch ? batch->clip[lane] : clipToFrustumTest(dest)) | VertexShader.vSize[VertexShader.vType].Format;
 
 	dest[s4DVertex_ofs(0)].flag =
 		dest[s4DVertex_pro(0)].flag = flag;
@@ -2474,6 +2574,108 @@ clipandproject:
 }
 
 
+/*!
+	fill the missing cache lines of the next primitives.
+	fixed function vertices are transformed and clip tested as SIMD batch first
+*/
+void CBurningVideoDriver::VertexCache_fill_list(const u32* sourceIndex, const u32* destIndex, u32 count)
+{
+	const sVertexBatch* batch = 0;
+
+	// take vertices from post transform cache, fill only the missing
+	u32 missSource[VERTEXCACHE_ELEMENT];
+	u32 missDest[VERTEXCACHE_ELEMENT];
+	STransformCacheEntry* cache = TransformCacheEntry;
+	if (cache)
+	{
+		u32 miss = 0;
+		for (u32 i = 0; i != count; ++i)
+		{
+			const u32 s = sourceIndex[i];
+			if (cache->Valid[s >> 5] & (1 << (s & 31)))
+			{
+				memcpy((void*)(VertexShader.mem.data + s4DVertex_ofs(destIndex[i])),
+					cache->Vertex.data + s4DVertex_ofs(s), sizeof_s4DVertex * sizeof_s4DVertexPairRel);
+				VertexShader.info[destIndex[i]].index = s;
+				VertexShader.info[destIndex[i]].hit = 0;
+			}
+			else
+			{
+				missSource[miss] = s;
+				missDest[miss] = destIndex[i];
+				miss += 1;
+			}
+		}
+		sourceIndex = missSource;
+		destIndex = missDest;
+		count = miss;
+	}
+
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX)
+	if (VertexSIMD != BURNING_SIMD_NONE && Material.VertexShader == BVT_Fix && count > 1)
+	{
+		const SVSize& vSize = VertexShader.vSize[VertexShader.vType];
+		const core::matrix4* matrix = Transformation[TransformationStack];
+
+		sVertexBatchSetup setup;
+		setup.vertices = (const u8*)VertexShader.vertices;
+		setup.pitch = vSize.Pitch;
+		setup.modelViewProj = matrix[ETS_MODEL_VIEW_PROJ].pointer();
+		setup.wScale = 1.f;
+		setup.modelView = 0;
+		setup.fog = 0;
+		setup.fogType = FogType;
+		setup.fogEnd = FogEnd;
+		setup.fogScale = EyeSpace.fog_scale;
+		setup.fogDensity = FogDensity;
+		setup.texCooSize = vSize.TexCooSize;
+		for (u32 m = 0; m < BURNING_MATERIAL_MAX_TEXTURES; ++m)
+			setup.texMatrix[m] = 0;
+
+		if (VertexShader.vType == E4VT_SHADOW)
+		{
+			setup.wScale = 1.005f;
+		}
+		else
+		{
+#if defined (SOFTWARE_DRIVER_2_LIGHTING) || defined ( SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM )
+			if (EyeSpace.TL_Flag & (TL_TEXTURE_TRANSFORM | TL_FOG | TL_LIGHT))
+			{
+				setup.modelView = matrix[ETS_MODEL_VIEW].pointer();
+				setup.fog = EyeSpace.TL_Flag & TL_FOG;
+			}
+#endif
+			for (u32 m = 0; m < vSize.TexSize; ++m)
+			{
+				const size_t flag = TransformationFlag[TransformationStack][ETS_TEXTURE_0 + m];
+				if ((flag & ETF_TEXGEN_MATRIX) && !(flag & (ETF_TEXGEN_CAMERA_SPHERE | ETF_TEXGEN_CAMERA_REFLECTION)))
+					setup.texMatrix[m] = matrix[ETS_TEXTURE_0 + m].pointer();
+			}
+		}
+
+		burning_vertex_batch(VertexBatch, setup, sourceIndex, count, VertexSIMD);
+		batch = &VertexBatch;
+	}
+#endif
+
+	for (u32 i = 0; i != count; ++i)
+	{
+		VertexCache_fill(sourceIndex[i], destIndex[i], batch, i);
+	}
+
+	if (cache)
+	{
+		for (u32 i = 0; i != count; ++i)
+		{
+			const u32 s = sourceIndex[i];
+			memcpy((void*)(cache->Vertex.data + s4DVertex_ofs(s)),
+				VertexShader.mem.data + s4DVertex_ofs(destIndex[i]), sizeof_s4DVertex * sizeof_s4DVertexPairRel);
+			cache->Valid[s >> 5] |= 1 << (s & 31);
+		}
+	}
+}
+
+
 void SVertexShader::setIndices(const void* _indices, const video::E_INDEX_TYPE _iType)
 {
 	indices = _indices;
@@ -2647,7 +2849,10 @@ void SVertexShader::getPrimitive(s4DVertexPair* face[4], CBurningVideoDriver* dr
 		// get the next unique indices cache line
 		get_next_index_cacheline();
 
-		// fill new
+		// fill new. collect free cache lines first, so the driver can transform them as batch
+		u32 fillSource[VERTEXCACHE_ELEMENT] = { 0 };
+		u32 fillDest[VERTEXCACHE_ELEMENT] = { 0 };
+		u32 fillCount = 0;
 		for (u32 i = 0; i != fillIndex; ++i)
 		{
 			if (info_temp[i].hit != VERTEXCACHE_MISS)
@@ -2657,13 +2862,21 @@ void SVertexShader::getPrimitive(s4DVertexPair* face[4], CBurningVideoDriver* dr
 			{
 				if (0 == info[dIndex].hit)
 				{
-					driver->VertexCache_fill(info_temp[i].index, dIndex);
+					fillSource[fillCount] = info_temp[i].index;
+					fillDest[fillCount] = dIndex;
+					fillCount += 1;
 					info[dIndex].hit += 1;
 					info_temp[i].hit = dIndex;
 					break;
 				}
 			}
 		}
+
+		driver->VertexCache_fill_list(fillSource, fillDest, fillCount);
+		for (u32 i = 0; i != fillCount; ++i)
+		{
+			info[fillDest[i]].hit = 1;
+		}
 	}
 
 	// all primitive indices are in the index cache line
@@ -2700,6 +2913,7 @@ int CBurningVideoDriver::VertexCache_reset(const void* vertices, u32 vertexCount
 	E_INDEX_TYPE iType)
 {
 
+	TransformCacheEntry = 0;
 	if (0 == CurrentShader)
 	{
 		return 1;
@@ -2746,10 +2960,261 @@ int CBurningVideoDriver::VertexCache_reset(const void* vertices, u32 vertexCount
 	VertexShader.setPrimitiveType(pType, primitiveCount);
 
 	VertexShader.set_info_miss();
+	TransformCache_lookup();
 	return 0;
 }
 
 
+static inline void key_f32(core::array<u32>& key, const f32* v, const u32 count)
+{
+	for (u32 i = 0; i != count; ++i)
+		key.push_back(core::IR(v[i]));
+}
+
+/*!
+	select the post transform cache entry for the current draw call.
+	The key is a value snapshot of everything the fixed function vertex pipeline reads,
+	so equal keys give bit identical vertices.
+*/
+void CBurningVideoDriver::TransformCache_lookup()
+{
+	TransformCacheEntry = 0;
+
+	SHWBufferLink_burning* link = TransformCacheLink;
+	if (!link || Material.VertexShader != BVT_Fix || VertexShader.vertices != link->MeshBuffer->getVertices())
+		return;
+
+	const SVSize& vSize = VertexShader.vSize[VertexShader.vType];
+	const core::matrix4* matrix = Transformation[TransformationStack];
+
+	core::array<u32>& key = TransformCacheKey;
+	key.set_used(0);
+	key.push_back(VertexShader.vType);
+	key.push_back(vSize.Format);
+	key.push_back(vSize.TexSize);
+	key.push_back(vSize.TexCooSize);
+	key.push_back(VertexShader.vertexCount);
+	key.push_back((u32)TransformationStack);
+	key_f32(key, matrix[ETS_WORLD].pointer(), 16);
+	key_f32(key, matrix[ETS_VIEW].pointer(), 16);
+	key_f32(key, matrix[ETS_PROJECTION].pointer(), 16);
+	key_f32(key, Transformation_ETS_CLIPSCALE[TransformationStack], 4);
+
+	for (u32 m = 0; m < vSize.TexSize; ++m)
+	{
+		key.push_back((u32)TransformationFlag[TransformationStack][ETS_TEXTURE_0 + m]);
+		key_f32(key, matrix[ETS_TEXTURE_0 + m].pointer(), 16);
+		key.push_back(Material.org.TextureLayer[m].TextureWrapU);
+		key.push_back(Material.org.TextureLayer[m].TextureWrapV);
+	}
+
+	key.push_back((u32)EyeSpace.TL_Flag);
+	key.push_back(Material.org.FogEnable ? 1 : 0);
+	if (EyeSpace.TL_Flag & TL_FOG)
+	{
+		key.push_back(FogType);
+		key_f32(key, &FogStart, 1);
+		key_f32(key, &FogEnd, 1);
+		key_f32(key, &FogDensity, 1);
+	}
+
+	if (EyeSpace.TL_Flag & (TL_LIGHT | TL_LIGHT0_IS_NORMAL_MAP))
+	{
+		key_f32(key, &EyeSpace.Global_AmbientLight.x, 4);
+		key_f32(key, &Material.AmbientColor.x, 4);
+		key_f32(key, &Material.DiffuseColor.x, 4);
+		key_f32(key, &Material.SpecularColor.x, 4);
+		key_f32(key, &Material.EmissiveColor.x, 4);
+		key_f32(key, &Material.org.Shininess, 1);
+
+		for (u32 i = 0; i < EyeSpace.Light.size(); ++i)
+		{
+			const SBurningShaderLight& light = EyeSpace.Light[i];
+			key.push_back(light.LightIsOn ? 1 : 0);
+			if (!light.LightIsOn)
+				continue;
+			key.push_back(light.Type);
+			key_f32(key, &light.pos.x, 4);
+			key_f32(key, &light.pos4.x, 4);
+			key_f32(key, &light.spotDirection4.x, 4);
+			key_f32(key, &light.linearAttenuation, 3);
+			key_f32(key, &light.spotCosCutoff, 3);
+			key_f32(key, &light.AmbientColor.x, 4);
+			key_f32(key, &light.DiffuseColor.x, 4);
+			key_f32(key, &light.SpecularColor.x, 4);
+			key_f32(key, &light.nmap_linearAttenuation, 1);
+		}
+	}
+
+	// search, remember oldest entry of link
+	s32 oldest = -1;
+	u32 linkEntries = 0;
+	for (u32 i = 0; i < TransformCache.size(); ++i)
+	{
+		STransformCacheEntry* e = TransformCache[i];
+		if (e->Link != link)
+			continue;
+
+		if (e->Key == key)
+		{
+			e->LastUsed = ++TransformCacheStamp;
+			TransformCacheEntry = e;
+			return;
+		}
+		linkEntries += 1;
+		if (oldest < 0 || e->LastUsed < TransformCache[oldest]->LastUsed)
+			oldest = i;
+	}
+
+	const size_t bytes = VertexShader.vertexCount * sizeof_s4DVertex * sizeof_s4DVertexPairRel;
+	if (bytes > SOFTWARE_DRIVER_2_TRANSFORM_CACHE_BUDGET)
+		return;
+
+	if (linkEntries >= SOFTWARE_DRIVER_2_TRANSFORM_CACHE_KEYS)
+		TransformCache_remove(oldest);
+
+	// evict least recently used until the new entry fits
+	while (TransformCacheBytes + bytes > SOFTWARE_DRIVER_2_TRANSFORM_CACHE_BUDGET && TransformCache.size())
+	{
+		u32 lru = 0;
+		for (u32 i = 1; i < TransformCache.size(); ++i)
+		{
+			if (TransformCache[i]->LastUsed < TransformCache[lru]->LastUsed)
+				lru = i;
+		}
+		TransformCache_remove(lru);
+	}
+
+	STransformCacheEntry* e = new STransformCacheEntry;
+	e->Link = link;
+	e->Key = key;
+	e->Vertex.resize(VertexShader.vertexCount * sizeof_s4DVertexPairRel);
+	e->Valid.set_used((VertexShader.vertexCount + 31) >> 5);
+	for (u32 i = 0; i < e->Valid.size(); ++i)
+		e->Valid[i] = 0;
+	e->LastUsed = ++TransformCacheStamp;
+	e->Bytes = bytes;
+
+	TransformCache.push_back(e);
+	TransformCacheBytes += bytes;
+	TransformCacheEntry = e;
+}
+
+
+void CBurningVideoDriver::TransformCache_remove(u32 index)
+{
+	STransformCacheEntry* e = TransformCache[index];
+	if (e == TransformCacheEntry)
+		TransformCacheEntry = 0;
+	TransformCacheBytes -= e->Bytes;
+	delete e;
+	TransformCache.erase(index);
+}
+
+
+void CBurningVideoDriver::TransformCache_removeLink(const SHWBufferLink_burning* link)
+{
+	for (s32 i = (s32)TransformCache.size() - 1; i >= 0; --i)
+	{
+		if (TransformCache[i]->Link == link)
+			TransformCache_remove(i);
+	}
+}
+
+
+//! Only static vertex data gets a post transform cache
+CBurningVideoDriver::SHWBufferLink* CBurningVideoDriver::createHardwareBuffer(const scene::IMeshBuffer* mb)
+{
+	if (!mb || mb->getHardwareMappingHint_Vertex() != scene::EHM_STATIC)
+		return 0;
+
+	SHWBufferLink_burning* HWBuffer = new SHWBufferLink_burning(mb);
+
+	//add to map
+	HWBufferMap.insert(HWBuffer->MeshBuffer, HWBuffer);
+
+	HWBuffer->ChangedID_Vertex = HWBuffer->MeshBuffer->getChangedID_Vertex();
+	HWBuffer->ChangedID_Index = HWBuffer->MeshBuffer->getChangedID_Index();
+	HWBuffer->Mapped_Vertex = mb->getHardwareMappingHint_Vertex();
+	HWBuffer->Mapped_Index = mb->getHardwareMappingHint_Index();
+	HWBuffer->LastUsed = 0;
+
+	return HWBuffer;
+}
+
+
+//! drops cached vertices if the meshbuffer changed
+bool CBurningVideoDriver::updateHardwareBuffer(SHWBufferLink* HWBuffer)
+{
+	if (!HWBuffer)
+		return false;
+
+	const scene::IMeshBuffer* mb = HWBuffer->MeshBuffer;
+	if (HWBuffer->ChangedID_Vertex != mb->getChangedID_Vertex() ||
+		HWBuffer->Mapped_Vertex != mb->getHardwareMappingHint_Vertex())
+	{
+		TransformCache_removeLink((SHWBufferLink_burning*)HWBuffer);
+		HWBuffer->ChangedID_Vertex = mb->getChangedID_Vertex();
+		HWBuffer->Mapped_Vertex = mb->getHardwareMappingHint_Vertex();
+	}
+	HWBuffer->ChangedID_Index = mb->getChangedID_Index();
+	HWBuffer->Mapped_Index = mb->getHardwareMappingHint_Index();
+
+	return true;
+}
+
+
+//! Draw hardware buffer
+void CBurningVideoDriver::drawHardwareBuffer(SHWBufferLink* _HWBuffer)
+{
+	if (!_HWBuffer)
+		return;
+
+	updateHardwareBuffer(_HWBuffer); //check if update is needed
+	_HWBuffer->LastUsed = 0; //reset count
+
+	const scene::IMeshBuffer* mb = _HWBuffer->MeshBuffer;
+	TransformCacheLink = _HWBuffer->Mapped_Vertex == scene::EHM_STATIC ? (SHWBufferLink_burning*)_HWBuffer : 0;
+	drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	TransformCacheLink = 0;
+	TransformCacheEntry = 0;
+}
+
+
+/*!
+	draws a meshbuffer for every transformation. Material and shader stay set,
+	only the world matrix dependent transforms are recalculated per instance.
+	Bypasses the post transform cache, its key does not contain the instance color
+	and an entry per instance would only evict the static meshbuffers.
+*/
+void CBurningVideoDriver::drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+	const core::array<core::matrix4>& transforms, const core::array<SColor>* colors)
+{
+	if (!mb || transforms.empty())
+		return;
+
+	const core::matrix4 world = Transformation[TransformationStack][ETS_WORLD];
+	for (u32 i = 0; i < transforms.size(); ++i)
+	{
+		setTransform(ETS_WORLD, transforms[i]);
+		InstanceColor = colors ? (*colors)[i].color : 0xFFFFFFFF;
+		drawVertexPrimitiveList(mb->getVertices(), mb->getVertexCount(), mb->getIndices(), mb->getPrimitiveCount(), mb->getVertexType(), mb->getPrimitiveType(), mb->getIndexType());
+	}
+	InstanceColor = 0xFFFFFFFF;
+	setTransform(ETS_WORLD, world);
+}
+
+
+void CBurningVideoDriver::deleteHardwareBuffer(SHWBufferLink* HWBuffer)
+{
+	if (!HWBuffer)
+		return;
+
+	TransformCache_removeLink((SHWBufferLink_burning*)HWBuffer);
+	CNullDriver::deleteHardwareBuffer(HWBuffer);
+}
+
+
 //! draws a vertex primitive list
 void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vertexCount,
 	const void* indexList, u32 primitiveCount,
@@ -2816,7 +3281,13 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 	// magnitude crossproduct (area of parallelogram * 0.5 = triangle screen size, winding)
 	ieee754 dc_area;
 
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+	if (DepthBuffer)
+		((CDepthBuffer*)DepthBuffer)->hiz_next();
+#endif
+
 	CurrentShader->fragment_draw_count = 0;
+	const int batch = RasterBatch_begin(primitiveCount);
 	for (VertexShader.primitiveRun = 0; VertexShader.primitiveRun < primitiveCount; ++VertexShader.primitiveRun)
 	{
 		//collect pointer to face vertices
@@ -3047,10 +3518,21 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 					CurrentShader->drawLine(face[0] + s4DVertex_pro(0), face[1] + s4DVertex_pro(0));
 					break;
 				case 3:
+					if (batch)
+					{
+						RasterBatch_add(face[0] + s4DVertex_pro(0), face[1] + s4DVertex_pro(0), face[2] + s4DVertex_pro(0));
+						break;
+					}
 					CurrentShader->drawWireFrameTriangle(face[0] + s4DVertex_pro(0), face[1] + s4DVertex_pro(0), face[2] + s4DVertex_pro(0));
 					break;
 				case 4:
 					//todo:
+					if (batch)
+					{
+						RasterBatch_add(face[0] + s4DVertex_pro(0), face[1] + s4DVertex_pro(0), face[2] + s4DVertex_pro(0));
+						RasterBatch_add(face[0] + s4DVertex_pro(0), face[2] + s4DVertex_pro(0), face[3] + s4DVertex_pro(0));
+						break;
+					}
 					CurrentShader->drawWireFrameTriangle(face[0] + s4DVertex_pro(0), face[1] + s4DVertex_pro(0), face[2] + s4DVertex_pro(0));
 					CurrentShader->drawWireFrameTriangle(face[0] + s4DVertex_pro(0), face[2] + s4DVertex_pro(0), face[3] + s4DVertex_pro(0));
 					break;
@@ -3062,6 +3544,9 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 
 	}
 
+	if (batch)
+		RasterBatch_flush();
+
 	this->samples_passed += CurrentShader->fragment_draw_count;
 
 	//release texture
@@ -3072,6 +3557,135 @@ void CBurningVideoDriver::drawVertexPrimitiveList(const void* vertices, u32 vert
 }
 
 
+//! Triangle batches. returns 1 if the triangles of this draw call are binned
+int CBurningVideoDriver::RasterBatch_begin(const u32 primitiveCount)
+{
+	RasterShaderId = ETR2_COUNT;
+	RasterTriangleCount = 0;
+
+	if (!CurrentShader || !RenderTargetSurface || primitiveCount < SOFTWARE_DRIVER_2_RASTER_BATCH_MIN)
+		return 0;
+	if (VertexShader.primitiveHasVertex < 3)
+		return 0;
+
+	// only build-in shaders can be cloned for the worker threads, others are batched on the driver thread
+	// wire shader draws lines without scanline conversion, stencil shadow is not binned
+	for (size_t i = 0; i < ETR2_COUNT; ++i)
+	{
+		if (BurningShader[i] && BurningShader[i] == CurrentShader)
+		{
+			if (i == ETR_STENCIL_SHADOW)
+				return 0;
+			if (RasterThreads && i != ETR_TEXTURE_GOURAUD_WIRE)
+				RasterShaderId = i;
+			break;
+		}
+	}
+
+	return 1;
+}
+
+//! store projected triangle and the current sampler state
+void CBurningVideoDriver::RasterBatch_add(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c)
+{
+	s4DVertex* v = RasterVertex.data + RasterTriangleCount * 3;
+	memcpy((void*)(v + 0), a, sizeof_s4DVertex);
+	memcpy((void*)(v + 1), b, sizeof_s4DVertex);
+	memcpy((void*)(v + 2), c, sizeof_s4DVertex);
+
+	sRasterTriangle& t = RasterTriangle[RasterTriangleCount];
+
+	// lines are drawn as degenerate triangle one scanline below
+	const f32 y0 = core::min_(a->Pos.y, b->Pos.y, c->Pos.y);
+	const f32 y1 = core::max_(a->Pos.y, b->Pos.y, c->Pos.y);
+	t.y0 = (s32)floorf(y0) - 1;
+	t.y1 = (s32)ceilf(y1) + 1;
+
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+	for (u32 m = 0; m < BURNING_MATERIAL_MAX_TEXTURES; ++m)
+	{
+		t.IT[m] = CurrentShader->getTextureParam(m);
+	}
+#endif
+
+	// flush after the add. drawing on the driver thread leaves the sampler state of the last triangle
+	RasterTriangleCount += 1;
+	if (RasterTriangleCount >= SOFTWARE_DRIVER_2_RASTER_BATCH)
+		RasterBatch_flush();
+}
+
+//! draw all binned triangles. one band of the render target per thread or tile row
+void CBurningVideoDriver::RasterBatch_flush()
+{
+	if (RasterTriangleCount == 0)
+		return;
+
+	if (RasterShaderId == ETR2_COUNT)
+	{
+		CurrentShader->drawTriangles(RasterVertex.data, RasterTriangle.const_pointer(), RasterTriangleCount);
+		RasterTriangleCount = 0;
+		return;
+	}
+
+	const s32 height = RenderTargetSurface->getDimension().Height;
+	u32 bands;
+
+	if (RasterTiled)
+	{
+		// tile rows. the first and last band are open, triangles may reach outside of the render target
+		bands = core::s32_clamp((height + (1 << SOFTWARE_DRIVER_2_RASTER_TILE_SHIFT) - 1) >> SOFTWARE_DRIVER_2_RASTER_TILE_SHIFT,
+			1, SOFTWARE_DRIVER_2_RASTER_MAX_BANDS);
+		for (u32 band = 0; band < bands; ++band)
+		{
+			raster_band& r = RasterBands[band];
+			r.y0 = band == 0 ? -0x7fffffff : (s32)(band << SOFTWARE_DRIVER_2_RASTER_TILE_SHIFT);
+			r.y1 = band + 1 == bands ? 0x7fffffff : (s32)((band + 1) << SOFTWARE_DRIVER_2_RASTER_TILE_SHIFT) - 1;
+		}
+	}
+	else
+	{
+		// bands start on a depth tile row. each tile is only touched by one thread
+		bands = RasterThreads->getThreadCount();
+		for (u32 band = 0; band < bands; ++band)
+		{
+			raster_band& r = RasterBands[band];
+			r.y0 = band == 0 ? -0x7fffffff : (s32)(((band * height) / bands) & ~((1 << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT) - 1));
+			r.y1 = band + 1 == bands ? 0x7fffffff : (s32)((((band + 1) * height) / bands) & ~((1 << SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT) - 1)) - 1;
+		}
+	}
+
+	for (u32 band = 0; band < bands; ++band)
+	{
+		IBurningShader*& shader = RasterShader[band * ETR2_COUNT + RasterShaderId];
+		if (!shader)
+			shader = createBurningShader(RasterShaderId, this);
+
+		const raster_band& r = RasterBands[band];
+		shader->OnSetMaterialBurning(Material);
+		shader->setRasterState(CurrentShader, r.y0, r.y1);
+		shader->fragment_draw_count = 0;
+	}
+
+	RasterThreads->run(RasterBatch_band, this, bands);
+
+	for (u32 band = 0; band < bands; ++band)
+	{
+		CurrentShader->fragment_draw_count += RasterShader[band * ETR2_COUNT + RasterShaderId]->fragment_draw_count;
+	}
+
+	RasterTriangleCount = 0;
+}
+
+//! worker thread. draws all triangles touching the band in submission order
+void CBurningVideoDriver::RasterBatch_band(void* data, u32 band)
+{
+	CBurningVideoDriver* driver = (CBurningVideoDriver*)data;
+	IBurningShader* shader = driver->RasterShader[band * ETR2_COUNT + driver->RasterShaderId];
+
+	shader->drawTriangles(driver->RasterVertex.data, driver->RasterTriangle.const_pointer(), driver->RasterTriangleCount);
+}
+
+
 //! Sets the dynamic ambient light color. The default color is
 //! (0,0,0,0) which means it is dark.
 //! \param color: New color of the ambient light.
@@ -3247,6 +3861,15 @@ size_t compare_3d_material(const SMaterial& a, const SMaterial& b)
 //! sets a material
 void CBurningVideoDriver::setMaterial(const SMaterial& material)
 {
+	// skip if the states of the last call are still set. states changed elsewhere set resetRenderStates
+	if (!Material.resetRenderStates && !OverrideMaterial.Enabled &&
+		material == Material.lastMaterial && (u32)getWriteZBuffer(material) == Material.depth_write)
+	{
+		MaterialChanges[1] += 1;
+		return;
+	}
+	MaterialChanges[0] += 1;
+
 	// ---------- Override
 	Material.org = material;
 	OverrideMaterial.apply(Material.org);
@@ -3255,6 +3878,16 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 
 	const u32 shaderid = (u32)in.MaterialType;
 
+#ifdef SOFTWARE_DRIVER_2_TEXTURE_TRANSFORM
+	// texture stages with a different matrix than the last material
+	u32 textureMatrixChanged = Material.resetRenderStates ? ~0u : 0;
+	for (u32 m = 0; m < BURNING_MATERIAL_MAX_TEXTURES; ++m)
+	{
+		if (in.getTextureMatrix(m) != Material.lastMaterial.getTextureMatrix(m))
+			textureMatrixChanged |= 1 << m;
+	}
+#endif
+
 	//basically set always. 2d does its own compare
 	//if (TransformationStack == ETF_STACK_2D ||	Material.resetRenderStates || compare_3d_material(Material.lastMaterial,in))
 	{
@@ -3275,7 +3908,6 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 		}
 
 		Material.lastMaterial = in;
-		Material.resetRenderStates = false;
 	}
 
 	//CSoftware2MaterialRenderer sets Material.Fallback_MaterialType
@@ -3296,7 +3928,10 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 	for (u32 m = 0; m < BURNING_MATERIAL_MAX_TEXTURES /*VertexShader.vSize[VertexShader.vType].TexSize*/; ++m)
 	{
 		flag[ETS_TEXTURE_0 + m] &= ~ETF_TEXGEN_MASK;
-		setTransform((E_TRANSFORMATION_STATE)(ETS_TEXTURE_0 + m), in.getTextureMatrix(m));
+		if (textureMatrixChanged & (1 << m))
+			setTransform((E_TRANSFORMATION_STATE)(ETS_TEXTURE_0 + m), in.getTextureMatrix(m));
+		else if (0 == (flag[ETS_TEXTURE_0 + m] & ETF_IDENTITY))
+			flag[ETS_TEXTURE_0 + m] |= ETF_TEXGEN_MATRIX;
 	}
 #endif
 
@@ -3338,8 +3973,9 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 
 
 	//todo: seperate depth test from depth write
+	//ECFN_EQUAL shades a depth prepass. the w compare is >=, writing the same w again is harmless
 	Material.depth_write = getWriteZBuffer(in);
-	Material.depth_test = in.ZBuffer != ECFN_DISABLED && Material.depth_write;
+	Material.depth_test = in.ZBuffer != ECFN_DISABLED && (Material.depth_write || in.ZBuffer == ECFN_EQUAL);
 
 	EBurningFFShader shader = Material.depth_test ? ETR_TEXTURE_GOURAUD : ETR_TEXTURE_GOURAUD_NOZ;
 
@@ -3456,6 +4092,32 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 		shader = ETR_COLOR;
 	}
 
+	// depth only. every covered pixel writes depth, no alpha test
+	if (in.ColorMask == ECP_NONE && Material.depth_write && Material.depth_test)
+	{
+		switch (Material.Fallback_MaterialType)
+		{
+		case EMT_SOLID:
+		case EMT_SOLID_2_LAYER:
+		case EMT_LIGHTMAP:
+		case EMT_LIGHTMAP_ADD:
+		case EMT_LIGHTMAP_M2:
+		case EMT_LIGHTMAP_M4:
+		case EMT_LIGHTMAP_LIGHTING:
+		case EMT_LIGHTMAP_LIGHTING_M2:
+		case EMT_LIGHTMAP_LIGHTING_M4:
+		case EMT_DETAIL_MAP:
+		case EMT_SPHERE_MAP:
+		case EMT_REFLECTION_2_LAYER:
+		case EMT_NORMAL_MAP_SOLID:
+		case EMT_PARALLAX_MAP_SOLID:
+			shader = ETR_COLOR;
+			break;
+		default:
+			break;
+		}
+	}
+
 	if (in.Wireframe)
 	{
 		IBurningShader* candidate = BurningShader[shader];
@@ -3486,6 +4148,7 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 	if (CurrentShader)
 	{
 		CurrentShader->setTLFlag(EyeSpace.TL_Flag);
+		CurrentShader->setFragmentFlag(FragmentProfile);
 		if (EyeSpace.TL_Flag & TL_FOG) CurrentShader->setFog(FogColor);
 		if (EyeSpace.TL_Flag & TL_SCISSOR) CurrentShader->setScissor(Scissor);
 		CurrentShader->setRenderTarget(RenderTargetSurface, ViewPort, Interlaced);
@@ -3493,6 +4156,8 @@ void CBurningVideoDriver::setMaterial(const SMaterial& material)
 		CurrentShader->setEdgeTest(in.Wireframe, in.PointCloud);
 	}
 
+	Material.resetRenderStates = false;
+
 
 #if 0
 	{
@@ -3509,6 +4174,7 @@ void CBurningVideoDriver::setFog(SColor color, E_FOG_TYPE fogType, f32 start,
 	f32 end, f32 density, bool pixelFog, bool rangeFog)
 {
 	CNullDriver::setFog(color, fogType, start, end, density, pixelFog, rangeFog);
+	Material.resetRenderStates = true;
 
 	EyeSpace.fog_scale = reciprocal_zero(FogEnd - FogStart);
 }
@@ -3922,6 +4588,8 @@ void CBurningVideoDriver::setRenderStates2DMode(const video::SColor& color, cons
 
 	//switch to 2D Matrix Stack [ Material set Texture Matrix ]
 	//if (TransformationStack != ETF_STACK_2D) cmp_mat |= 256;
+	if (TransformationStack != ETF_STACK_2D)
+		Material.resetRenderStates = true;
 	TransformationStack = ETF_STACK_2D;
 
 	//2D GUI Matrix
@@ -3971,6 +4639,8 @@ void CBurningVideoDriver::setRenderStates3DMode()
 
 	//setMaterial(Material.save3D);
 	//switch to 3D Matrix Stack
+	if (TransformationStack != ETF_STACK_3D)
+		Material.resetRenderStates = true;
 	TransformationStack = ETF_STACK_3D;
 }
 
@@ -4367,6 +5037,9 @@ void CBurningVideoDriver::pushShader(scene::E_PRIMITIVE_TYPE pType, int testCurr
 			shader->OnSetMaterialBurning(Material);
 		}
 		shader->setEdgeTest(wireFrame, pointCloud);
+
+		// shader and edge test differ from the last setMaterial
+		Material.resetRenderStates = true;
 	}
 }
 
@@ -4523,6 +5196,7 @@ void CBurningVideoDriver::drawStencilShadowVolume(const core::array<core::vector
 	Material.org.ZBuffer = ECFN_LESS;
 
 	CurrentShader = BurningShader[ETR_STENCIL_SHADOW];
+	Material.resetRenderStates = true;
 
 	CurrentShader->setRenderTarget(RenderTargetSurface, ViewPort, Interlaced);
 	CurrentShader->setEdgeTest(Material.org.Wireframe, 0);
@@ -4591,7 +5265,7 @@ void CBurningVideoDriver::drawStencilShadow(bool clearStencilBuffer, video::SCol
 	interlace_scanline_data line;
 	for (line.y = 0; line.y < h; line.y += SOFTWARE_DRIVER_2_STEP_Y)
 	{
-		if_interlace_scanline
+		if_interlace_scanline_noband
 		{
 			tVideoSample * dst = (tVideoSample*)RenderTargetSurface->getData() + (line.y * w);
 			const tStencilSample* stencil = (tStencilSample*)StencilBuffer->lock() + (line.y * w);
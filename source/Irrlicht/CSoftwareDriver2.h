@@ -7,6 +7,7 @@
 
 #include "SoftwareDriver2_compile_config.h"
 #include "IBurningShader.h"
+#include "burning_vertex_simd.h"
 #include "CNullDriver.h"
 #include "CImage.h"
 #include "os.h"
@@ -16,6 +17,8 @@
 
 namespace irr
 {
+class CThreadPool;
+
 namespace video
 {
 	class CBurningVideoDriver : public CNullDriver, public IMaterialRendererServices
@@ -113,6 +116,11 @@ namespace video
 				const void* indexList, u32 primitiveCount,
 				E_VERTEX_TYPE vType, scene::E_PRIMITIVE_TYPE pType, E_INDEX_TYPE iType) IRR_OVERRIDE;
 
+		//! Draws a mesh buffer once for every transformation
+		virtual void drawMeshBufferInstanced(const scene::IMeshBuffer* mb,
+			const core::array<core::matrix4>& transforms,
+			const core::array<SColor>* colors=0) IRR_OVERRIDE;
+
 		//! draws a vertex primitive list in 2d
 		virtual void draw2DVertexPrimitiveList(const void* vertices, u32 vertexCount,
 			const void* indexList, u32 primitiveCount,
@@ -351,6 +359,25 @@ namespace video
 		IDepthBuffer* DepthBuffer;
 		IStencilBuffer* StencilBuffer;
 
+		// Triangle batches
+		// Triangles of a draw call are binned on the driver thread (transform,clip,mipmap selection)
+		// and submitted with one drawTriangles call to the current shader, or with
+		// the multithreaded rasterizer to one worker shader per horizontal band of the render target.
+		// The tiled rasterizer uses one band per tile row, drawn one after the other or by the threads.
+		CThreadPool* RasterThreads;
+		bool RasterTiled;
+		core::array<IBurningShader*> RasterShader; // [band * ETR2_COUNT + shader]
+		raster_band RasterBands[SOFTWARE_DRIVER_2_RASTER_MAX_BANDS];
+		SAligned4DVertex RasterVertex; // 3 vertices per triangle
+		core::array<sRasterTriangle> RasterTriangle;
+		u32 RasterTriangleCount;
+		size_t RasterShaderId; // EBurningFFShader of the worker shaders. ETR2_COUNT if drawn by CurrentShader
+
+		int RasterBatch_begin(const u32 primitiveCount);
+		void RasterBatch_add(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c);
+		void RasterBatch_flush();
+		static void RasterBatch_band(void* driver, u32 band);
+
 
 		/*
 			extend Matrix Stack
@@ -405,6 +432,53 @@ namespace video
 		// Vertex Cache
 		SVertexShader VertexShader;
 
+		// SIMD transform of the missing vertices of a cache line
+		e_burning_simd VertexSIMD;
+		sVertexBatch VertexBatch;
+
+		// eBurningFragmentFlags of all materials. BF_DEFAULT unless SIrrlichtCreationParameters::FastTextureMapping
+		size_t FragmentProfile;
+
+		// Post transform cache of static meshbuffers (hardware buffer link EHM_STATIC)
+		// Transformed, lit and projected vertex pairs are kept per state key across draw calls and frames.
+		struct SHWBufferLink_burning : public SHWBufferLink
+		{
+			SHWBufferLink_burning(const scene::IMeshBuffer* _MeshBuffer) : SHWBufferLink(_MeshBuffer) {}
+		};
+
+		struct STransformCacheEntry
+		{
+			SHWBufferLink_burning* Link;
+			core::array<u32> Key;		// snapshot of all state VertexCache_fill depends on
+			SAligned4DVertex Vertex;	// s4DVertexPair per source vertex
+			core::array<u32> Valid;		// bit per source vertex
+			u32 LastUsed;				// lru stamp
+			size_t Bytes;
+		};
+
+		core::array<STransformCacheEntry*> TransformCache;
+		core::array<u32> TransformCacheKey;
+		SHWBufferLink_burning* TransformCacheLink;	// link of current draw call
+		STransformCacheEntry* TransformCacheEntry;	// entry of current draw call
+		size_t TransformCacheBytes;
+		u32 TransformCacheStamp;
+
+		void TransformCache_lookup();
+		void TransformCache_remove(u32 index);
+		void TransformCache_removeLink(const SHWBufferLink_burning* link);
+
+		// color of the current instance in drawMeshBufferInstanced, multiplied with the vertex color
+		u32 InstanceColor;
+		inline u32 instance_color(const u32 color) const
+		{
+			return InstanceColor == 0xFFFFFFFF ? color : PixelMul32_2(color, InstanceColor);
+		}
+
+		virtual SHWBufferLink* createHardwareBuffer(const scene::IMeshBuffer* mb) IRR_OVERRIDE;
+		virtual bool updateHardwareBuffer(SHWBufferLink* HWBuffer) IRR_OVERRIDE;
+		virtual void drawHardwareBuffer(SHWBufferLink* HWBuffer) IRR_OVERRIDE;
+		virtual void deleteHardwareBuffer(SHWBufferLink* HWBuffer) IRR_OVERRIDE;
+
 		int VertexCache_reset (const void* vertices, u32 vertexCount,
 					const void* indices, u32 indexCount,
 					E_VERTEX_TYPE vType,scene::E_PRIMITIVE_TYPE pType,
@@ -418,7 +492,9 @@ namespace video
 		//size_t inline clipToHyperPlane (s4DVertexPair* burning_restrict dest, const s4DVertexPair* burning_restrict source, const size_t inCount, const sVec4 &plane );
 		//size_t inline clipToFrustumTest ( const s4DVertex * v  ) const;
 		public:
-		void VertexCache_fill(const u32 sourceIndex, const u32 destIndex);
+		void VertexCache_fill(const u32 sourceIndex, const u32 destIndex,
+			const sVertexBatch* batch = 0, const u32 lane = 0);
+		void VertexCache_fill_list(const u32* sourceIndex, const u32* destIndex, u32 count);
 		u32 clipToFrustum( const u32 vIn /*, const size_t clipmask_for_face*/ );
 		protected:
 
@@ -91,6 +91,10 @@ CSoftwareTexture2::CSoftwareTexture2(IImage* image, const io::path& name, u32 fl
 	HasMipMaps = (Flags & GEN_MIPMAP) != 0;
 
 	for (size_t i = 0; i < array_size(MipMap); ++i) MipMap[i] = 0;
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+	for (size_t i = 0; i < array_size(Tiled); ++i) Tiled[i] = 0;
+	TiledDirty = false;
+#endif
 	if (!image)
 	{
 		calcDerivative();
@@ -202,6 +206,9 @@ CSoftwareTexture2::~CSoftwareTexture2()
 			MipMap[i] = 0;
 		}
 	}
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+	releaseTiled();
+#endif
 }
 
 
@@ -367,9 +374,70 @@ void CSoftwareTexture2::regenerateMipMapLevels(void* data)
 			}
 	}
 #endif
+
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+	updateTiled();
+#endif
 	calcDerivative();
 }
 
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+void CSoftwareTexture2::releaseTiled()
+{
+	for (size_t i = 0; i < array_size(Tiled); ++i)
+	{
+		if (Tiled[i])
+		{
+			Tiled[i]->drop();
+			Tiled[i] = 0;
+		}
+	}
+}
+
+void CSoftwareTexture2::updateTiled()
+{
+	TiledDirty = false;
+	releaseTiled();
+
+	//render targets are written by the rasterizer every frame
+	if (Flags & IS_RENDERTARGET)
+		return;
+
+	const size_t texel = (size_t)1 << SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY;
+	for (size_t i = 0; i < array_size(MipMap); ++i)
+	{
+		const CImage* src = MipMap[i];
+		if (!src || !src->getData())
+			continue;
+
+		const core::dimension2du& dim = src->getDimension();
+		if (dim.Width < 4 || dim.Height < 4 || (dim.Width & 3) || (dim.Height & 3) ||
+			src->getPitch() != dim.Width * texel)
+			continue;
+
+		Tiled[i] = new CImage(src->getColorFormat(), dim);
+
+		//tile rows of 4 texel rows, tiles of 4x4 texels
+		const u8* s = (const u8*)src->getData();
+		u8* d = (u8*)Tiled[i]->getData();
+		const size_t pitch = src->getPitch();
+		for (u32 y = 0; y < dim.Height; y += 4)
+		{
+			for (u32 x = 0; x < dim.Width; x += 4)
+			{
+				const u8* row = s + y * pitch + x * texel;
+				for (u32 j = 0; j < 4; ++j)
+				{
+					memcpy(d, row, 4 * texel);
+					row += pitch;
+					d += 4 * texel;
+				}
+			}
+		}
+	}
+}
+#endif
+
 void CSoftwareTexture2::calcDerivative()
 {
 	//reset current MipMap
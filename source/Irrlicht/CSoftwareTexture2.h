@@ -90,12 +90,30 @@ public:
 			Pitch = MipMap[MipMapLOD]->getPitch();
 		}
 
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+		if (mode != ETLM_READ_ONLY)
+			TiledDirty = true;
+#endif
 		return MipMap[MipMapLOD]->getData();
 	}
 
 	//! unlock function
 	virtual void unlock() IRR_OVERRIDE
 	{
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+		if (TiledDirty)
+			updateTiled();
+#endif
+	}
+
+	//! texels of the locked mipmap level in 4x4 texel tiles, 0 if the level is stored linear only
+	const void* getTiledData() const
+	{
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+		return Tiled[MipMapLOD] ? Tiled[MipMapLOD]->getData() : 0;
+#else
+		return 0;
+#endif
 	}
 
 	//! returns unoptimized surface (misleading name. burning can scale down originalimage)
@@ -153,6 +171,15 @@ public:
 private:
 	void calcDerivative();
 
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+	//! copies all mipmap levels into Tiled
+	void updateTiled();
+	void releaseTiled();
+
+	CImage* Tiled[SOFTWARE_DRIVER_2_MIPMAPPING_MAX];
+	bool TiledDirty;
+#endif
+
 	//! controls MipmapSelection. relation between drawn area and image size
 	u32 MipMapLOD; // 0 .. original Texture pot -SOFTWARE_DRIVER_2_MIPMAPPING_MAX
 	u32 Flags; //eTex2Flags
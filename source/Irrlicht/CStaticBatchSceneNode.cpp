@@ -0,0 +1,570 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CStaticBatchSceneNode.h"
+#include "IVideoDriver.h"
+#include "ISceneManager.h"
+#include "ICameraSceneNode.h"
+#include "SViewFrustum.h"
+
+namespace irr
+{
+namespace scene
+{
+
+namespace
+{
+	//! copies the vertices with positions and normals in world space
+	template <class T>
+	void appendVertices(IVertexBuffer& dst, const IMeshBuffer* src,
+		const core::matrix4& world, const core::matrix4& normalMatrix)
+	{
+		const T* vertices = static_cast<const T*>(src->getVertices());
+		const u32 count = src->getVertexCount();
+		for (u32 i=0; i<count; ++i)
+		{
+			T v(vertices[i]);
+			world.transformVect(v.Pos);
+			normalMatrix.rotateVect(v.Normal);
+			v.Normal.normalize();
+			dst.push_back(v);
+		}
+	}
+
+	void appendTangentVertices(IVertexBuffer& dst, const IMeshBuffer* src,
+		const core::matrix4& world, const core::matrix4& normalMatrix)
+	{
+		const video::S3DVertexTangents* vertices = static_cast<const video::S3DVertexTangents*>(src->getVertices());
+		const u32 count = src->getVertexCount();
+		for (u32 i=0; i<count; ++i)
+		{
+			video::S3DVertexTangents v(vertices[i]);
+			world.transformVect(v.Pos);
+			normalMatrix.rotateVect(v.Normal);
+			v.Normal.normalize();
+			world.rotateVect(v.Tangent);
+			v.Tangent.normalize();
+			world.rotateVect(v.Binormal);
+			v.Binormal.normalize();
+			dst.push_back(v);
+		}
+	}
+
+	//! copies the indices of a triangle list, flipped for mirroring transformations
+	template <class T>
+	void appendIndices(IIndexBuffer& dst, const T* indices, u32 count, u32 base, bool flip)
+	{
+		count -= count % 3;
+		for (u32 i=0; i<count; i+=3)
+		{
+			dst.push_back(base + indices[i]);
+			dst.push_back(base + indices[flip ? i+2 : i+1]);
+			dst.push_back(base + indices[flip ? i+1 : i+2]);
+		}
+	}
+}
+
+
+//! constructor
+CStaticBatchSceneNode::CStaticBatchSceneNode(f32 chunkSize, ISceneNode* parent, ISceneManager* mgr, s32 id)
+: IStaticBatchSceneNode(parent, mgr, id), ChunkSize(chunkSize > 0.f ? chunkSize : 256.f), Dirty(false)
+{
+	#ifdef _DEBUG
+	setDebugName("CStaticBatchSceneNode");
+	#endif
+
+	Box.reset(0.f, 0.f, 0.f);
+}
+
+
+//! destructor
+CStaticBatchSceneNode::~CStaticBatchSceneNode()
+{
+	for (u32 i=0; i<Members.size(); ++i)
+	{
+		Members[i].Node->setVisible(true);
+		Members[i].Node->drop();
+	}
+
+	video::IVideoDriver* driver = SceneManager ? SceneManager->getVideoDriver() : 0;
+	for (u32 c=0; c<Chunks.size(); ++c)
+	{
+		for (u32 b=0; b<Chunks[c].Buffers.size(); ++b)
+		{
+			if (driver)
+				driver->removeHardwareBuffer(Chunks[c].Buffers[b].Buffer);
+			Chunks[c].Buffers[b].Buffer->drop();
+		}
+	}
+}
+
+
+//! checks the members for changes and rebuilds their chunks
+void CStaticBatchSceneNode::OnAnimate(u32 timeMs)
+{
+	ISceneNode::OnAnimate(timeMs);
+
+	if (!IsVisible)
+		return;
+
+	for (u32 i=0; i<Members.size(); )
+	{
+		SMember& member = Members[i];
+		IMeshSceneNode* node = member.Node;
+
+		// shown again or taken out of the scene
+		if (node->isVisible() || !node->getParent())
+		{
+			releaseMember(i, true);
+			continue;
+		}
+
+		// members are hidden, so nobody else updates them
+		node->updateAbsolutePosition();
+
+		const bool shown = node->getParent()->isTrulyVisible();
+		const u32 version = node->getTransformationVersion();
+		if (shown == member.Shown && version == member.Version && node->getMesh() == member.Mesh)
+		{
+			++i;
+			continue;
+		}
+
+		if (node->getMesh() != member.Mesh && !canBatch(node))
+		{
+			releaseMember(i, true);
+			continue;
+		}
+
+		if (member.Chunk >= 0)
+		{
+			SChunk& chunk = Chunks[member.Chunk];
+			const s32 k = chunk.Nodes.linear_search(node);
+			if (k >= 0)
+				chunk.Nodes.erase(k);
+			chunk.Dirty = true;
+		}
+
+		member.Mesh = node->getMesh();
+		member.Version = version;
+		member.Shown = shown;
+		member.Chunk = shown ? getChunk(node) : -1;
+		if (member.Chunk >= 0)
+		{
+			Chunks[member.Chunk].Nodes.push_back(node);
+			Chunks[member.Chunk].Dirty = true;
+		}
+		Dirty = true;
+		++i;
+	}
+
+	if (Dirty)
+		rebuildDirtyChunks();
+}
+
+
+//! culls the chunks and registers the node if any is visible
+/** The frustum is transformed into node space once. Each chunk box is
+then tested against the planes with its corner closest to the inside. */
+void CStaticBatchSceneNode::OnRegisterSceneNode()
+{
+	if (!IsVisible)
+		return;
+
+	VisibleChunks.set_used(0);
+	DrawList.set_used(0);
+
+	const ICameraSceneNode* cam = SceneManager->getActiveCamera();
+	const bool cull = cam && getAutomaticCulling() != EAC_OFF;
+
+	SViewFrustum frust;
+	if (cull)
+	{
+		frust = *cam->getViewFrustum();
+		frust.transform(core::matrix4(AbsoluteTransformation, core::matrix4::EM4CONST_INVERSE));
+	}
+
+	for (u32 c=0; c<Chunks.size(); ++c)
+	{
+		const SChunk& chunk = Chunks[c];
+		if (chunk.Buffers.empty())
+			continue;
+
+		if (cull)
+		{
+			const core::aabbox3d<f32>& box = chunk.Box;
+			bool outside = false;
+			for (u32 p=0; p<SViewFrustum::VF_PLANE_COUNT && !outside; ++p)
+			{
+				const core::plane3d<f32>& plane = frust.planes[p];
+				const core::vector3df corner(
+					plane.Normal.X > 0.f ? box.MinEdge.X : box.MaxEdge.X,
+					plane.Normal.Y > 0.f ? box.MinEdge.Y : box.MaxEdge.Y,
+					plane.Normal.Z > 0.f ? box.MinEdge.Z : box.MaxEdge.Z);
+				outside = plane.Normal.dotProduct(corner) + plane.D > core::ROUNDING_ERROR_f32;
+			}
+			if (outside)
+				continue;
+		}
+
+		VisibleChunks.push_back(c);
+		for (u32 b=0; b<chunk.Buffers.size(); ++b)
+			DrawList.push_back(chunk.Buffers[b]);
+	}
+
+	if (!DrawList.empty())
+	{
+		// each material is set once
+		DrawList.sort();
+		SceneManager->registerNodeForRendering(this, scene::ESNRP_SOLID);
+	}
+
+	ISceneNode::OnRegisterSceneNode();
+}
+
+
+//! renders the visible chunks
+void CStaticBatchSceneNode::render()
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+
+	if (!driver || DrawList.empty())
+		return;
+
+	driver->setTransform(video::ETS_WORLD, AbsoluteTransformation);
+
+	u32 material = 0xffffffff;
+	for (u32 i=0; i<DrawList.size(); ++i)
+	{
+		if (DrawList[i].Material != material)
+		{
+			material = DrawList[i].Material;
+			driver->setMaterial(Materials[material]);
+		}
+		driver->drawMeshBuffer(DrawList[i].Buffer);
+	}
+
+	// for debug purposes only:
+	if (DebugDataVisible & scene::EDS_BBOX)
+	{
+		video::SMaterial m;
+		m.Lighting = false;
+		m.AntiAliasing=0;
+		driver->setMaterial(m);
+		driver->draw3DBox(Box, video::SColor(255,255,255,255));
+
+		if (DebugDataVisible & scene::EDS_BBOX_BUFFERS)
+		{
+			for (u32 i=0; i<VisibleChunks.size(); ++i)
+				driver->draw3DBox(Chunks[VisibleChunks[i]].Box, video::SColor(255,190,128,128));
+		}
+	}
+}
+
+
+//! returns the axis aligned bounding box of all chunks
+const core::aabbox3d<f32>& CStaticBatchSceneNode::getBoundingBox() const
+{
+	return Box;
+}
+
+
+//! Adds all suitable mesh scene nodes of a subtree
+u32 CStaticBatchSceneNode::addNodes(ISceneNode* root)
+{
+	if (!root)
+		return 0;
+
+	const u32 added = addSubtree(root);
+	if (Dirty)
+		rebuildDirtyChunks();
+
+	return added;
+}
+
+
+//! Takes a node out of the batch and makes it visible again
+bool CStaticBatchSceneNode::removeNode(ISceneNode* node)
+{
+	const s32 index = findMember(node);
+	if (index < 0)
+		return false;
+
+	releaseMember(index, true);
+	rebuildDirtyChunks();
+	return true;
+}
+
+
+//! Rebuilds the chunk of a member
+void CStaticBatchSceneNode::nodeChanged(ISceneNode* node)
+{
+	const s32 index = findMember(node);
+	if (index < 0)
+		return;
+
+	if (!canBatch(node))
+		releaseMember(index, true);
+	else if (Members[index].Chunk >= 0)
+		Chunks[Members[index].Chunk].Dirty = true;
+
+	Dirty = true;
+	rebuildDirtyChunks();
+}
+
+
+//! Get the amount of merged meshbuffers of all chunks
+u32 CStaticBatchSceneNode::getMeshBufferCount() const
+{
+	u32 count = 0;
+	for (u32 c=0; c<Chunks.size(); ++c)
+		count += Chunks[c].Buffers.size();
+	return count;
+}
+
+
+//! if a node can be merged
+bool CStaticBatchSceneNode::canBatch(ISceneNode* node) const
+{
+	if (node == this || node->getType() != ESNT_MESH || !node->getParent() ||
+		!node->getChildren().empty() || !node->getAnimators().empty())
+		return false;
+
+	const IMesh* mesh = static_cast<IMeshSceneNode*>(node)->getMesh();
+	if (!mesh || !mesh->getMeshBufferCount())
+		return false;
+
+	// transparent buffers have to be sorted with the other nodes
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+	{
+		if (mesh->getMeshBuffer(i)->getPrimitiveType() != EPT_TRIANGLES)
+			return false;
+		if (i >= node->getMaterialCount() ||
+			(driver && driver->needsTransparentRenderPass(node->getMaterial(i))))
+			return false;
+	}
+
+	return true;
+}
+
+
+//! adds the suitable nodes of a subtree
+u32 CStaticBatchSceneNode::addSubtree(ISceneNode* node)
+{
+	if (!node->isVisible())
+		return 0;
+
+	if (canBatch(node))
+	{
+		IMeshSceneNode* meshNode = static_cast<IMeshSceneNode*>(node);
+		meshNode->grab();
+		meshNode->setVisible(false);
+		meshNode->updateAbsolutePosition();
+
+		SMember member;
+		member.Node = meshNode;
+		member.Mesh = meshNode->getMesh();
+		member.Version = meshNode->getTransformationVersion();
+		member.Shown = meshNode->getParent()->isTrulyVisible();
+		member.Chunk = member.Shown ? getChunk(meshNode) : -1;
+		if (member.Chunk >= 0)
+		{
+			Chunks[member.Chunk].Nodes.push_back(meshNode);
+			Chunks[member.Chunk].Dirty = true;
+		}
+		Members.push_back(member);
+		Dirty = true;
+		return 1;
+	}
+
+	u32 added = 0;
+	ISceneNodeList::ConstIterator it = node->getChildren().begin();
+	for (; it != node->getChildren().end(); ++it)
+		added += addSubtree(*it);
+
+	return added;
+}
+
+
+//! chunk for the world space box of a node
+s32 CStaticBatchSceneNode::getChunk(IMeshSceneNode* node)
+{
+	core::aabbox3df box(node->getMesh()->getBoundingBox());
+	node->getAbsoluteTransformation().transformBoxEx(box);
+	const core::vector3df center = box.getCenter() / ChunkSize;
+	const core::vector3d<s32> cell(core::floor32(center.X), core::floor32(center.Y), core::floor32(center.Z));
+
+	core::map<core::vector3d<s32>, u32>::Node* found = ChunkCells.find(cell);
+	if (found)
+		return found->getValue();
+
+	SChunk chunk;
+	chunk.Box.reset(0.f, 0.f, 0.f);
+	chunk.Dirty = false;
+	Chunks.push_back(chunk);
+	ChunkCells.insert(cell, Chunks.size() - 1);
+	return Chunks.size() - 1;
+}
+
+
+//! removes a member, optionally showing its node again
+void CStaticBatchSceneNode::releaseMember(u32 index, bool show)
+{
+	SMember& member = Members[index];
+	if (member.Chunk >= 0)
+	{
+		SChunk& chunk = Chunks[member.Chunk];
+		const s32 k = chunk.Nodes.linear_search(member.Node);
+		if (k >= 0)
+			chunk.Nodes.erase(k);
+		chunk.Dirty = true;
+	}
+
+	if (show)
+		member.Node->setVisible(true);
+	member.Node->drop();
+
+	Members[index] = Members.getLast();
+	Members.erase(Members.size() - 1);
+	Dirty = true;
+}
+
+
+//! index of the member of a node, -1 if it isn't one
+s32 CStaticBatchSceneNode::findMember(const ISceneNode* node) const
+{
+	for (u32 i=0; i<Members.size(); ++i)
+		if (Members[i].Node == node)
+			return (s32)i;
+	return -1;
+}
+
+
+//! index of a material in Materials, adds it if it's new
+u32 CStaticBatchSceneNode::getMaterialIndex(const video::SMaterial& material)
+{
+	for (u32 i=0; i<Materials.size(); ++i)
+		if (Materials[i] == material)
+			return i;
+
+	Materials.push_back(material);
+	return Materials.size() - 1;
+}
+
+
+//! merges the geometry of the shown members of a chunk again
+void CStaticBatchSceneNode::rebuildChunk(SChunk& chunk)
+{
+	video::IVideoDriver* driver = SceneManager->getVideoDriver();
+	for (u32 b=0; b<chunk.Buffers.size(); ++b)
+	{
+		if (driver)
+			driver->removeHardwareBuffer(chunk.Buffers[b].Buffer);
+		chunk.Buffers[b].Buffer->drop();
+	}
+	chunk.Buffers.set_used(0);
+	chunk.Dirty = false;
+
+	for (u32 n=0; n<chunk.Nodes.size(); ++n)
+	{
+		IMeshSceneNode* node = chunk.Nodes[n];
+		const IMesh* mesh = node->getMesh();
+		const core::matrix4& world = node->getAbsoluteTransformation();
+		const core::matrix4 normalMatrix(world, core::matrix4::EM4CONST_INVERSE_TRANSPOSED);
+
+		// mirroring transformations turn the triangles around
+		const f32 det = world[0] * (world[5] * world[10] - world[6] * world[9]) -
+			world[1] * (world[4] * world[10] - world[6] * world[8]) +
+			world[2] * (world[4] * world[9] - world[5] * world[8]);
+		const bool flip = det < 0.f;
+
+		for (u32 i=0; i<mesh->getMeshBufferCount(); ++i)
+		{
+			const IMeshBuffer* src = mesh->getMeshBuffer(i);
+			if (!src->getVertexCount() || !src->getIndexCount())
+				continue;
+
+			const u32 material = getMaterialIndex(node->getMaterial(i));
+			const video::E_VERTEX_TYPE vertexType = src->getVertexType();
+
+			CDynamicMeshBuffer* dst = 0;
+			for (u32 b=0; b<chunk.Buffers.size() && !dst; ++b)
+			{
+				if (chunk.Buffers[b].Material == material &&
+					chunk.Buffers[b].Buffer->getVertexType() == vertexType)
+					dst = chunk.Buffers[b].Buffer;
+			}
+			if (!dst)
+			{
+				SBuffer buffer;
+				buffer.Material = material;
+				buffer.Buffer = new CDynamicMeshBuffer(vertexType, video::EIT_32BIT);
+				buffer.Buffer->setHardwareMappingHint(EHM_STATIC);
+				chunk.Buffers.push_back(buffer);
+				dst = buffer.Buffer;
+			}
+
+			const u32 base = dst->getVertexCount();
+			switch (vertexType)
+			{
+			case video::EVT_STANDARD:
+				appendVertices<video::S3DVertex>(dst->getVertexBuffer(), src, world, normalMatrix);
+				break;
+			case video::EVT_2TCOORDS:
+				appendVertices<video::S3DVertex2TCoords>(dst->getVertexBuffer(), src, world, normalMatrix);
+				break;
+			case video::EVT_TANGENTS:
+				appendTangentVertices(dst->getVertexBuffer(), src, world, normalMatrix);
+				break;
+			}
+
+			if (src->getIndexType() == video::EIT_32BIT)
+				appendIndices(dst->getIndexBuffer(), (const u32*)src->getIndices(), src->getIndexCount(), base, flip);
+			else
+				appendIndices(dst->getIndexBuffer(), src->getIndices(), src->getIndexCount(), base, flip);
+		}
+	}
+
+	for (u32 b=0; b<chunk.Buffers.size(); ++b)
+	{
+		chunk.Buffers[b].Buffer->recalculateBoundingBox();
+		if (b)
+			chunk.Box.addInternalBox(chunk.Buffers[b].Buffer->getBoundingBox());
+		else
+			chunk.Box = chunk.Buffers[b].Buffer->getBoundingBox();
+	}
+}
+
+
+//! rebuilds the dirty chunks and the bounding box
+void CStaticBatchSceneNode::rebuildDirtyChunks()
+{
+	bool empty = true;
+	for (u32 c=0; c<Chunks.size(); ++c)
+	{
+		SChunk& chunk = Chunks[c];
+		if (chunk.Dirty)
+			rebuildChunk(chunk);
+
+		if (chunk.Buffers.empty())
+			continue;
+
+		if (empty)
+			Box = chunk.Box;
+		else
+			Box.addInternalBox(chunk.Box);
+		empty = false;
+	}
+
+	if (empty)
+		Box.reset(0.f, 0.f, 0.f);
+
+	Dirty = false;
+}
+
+
+} // end namespace scene
+} // end namespace irr
+
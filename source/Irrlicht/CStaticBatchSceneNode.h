@@ -0,0 +1,135 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_STATIC_BATCH_SCENE_NODE_H_INCLUDED
+#define IRR_C_STATIC_BATCH_SCENE_NODE_H_INCLUDED
+
+#include "IStaticBatchSceneNode.h"
+#include "IMeshSceneNode.h"
+#include "CDynamicMeshBuffer.h"
+#include "irrMap.h"
+
+namespace irr
+{
+namespace scene
+{
+
+	class CStaticBatchSceneNode : public IStaticBatchSceneNode
+	{
+	public:
+
+		//! constructor
+		CStaticBatchSceneNode(f32 chunkSize, ISceneNode* parent, ISceneManager* mgr, s32 id);
+
+		//! destructor
+		virtual ~CStaticBatchSceneNode();
+
+		//! checks the members for changes and rebuilds their chunks
+		virtual void OnAnimate(u32 timeMs) IRR_OVERRIDE;
+
+		//! culls the chunks and registers the node if any is visible
+		virtual void OnRegisterSceneNode() IRR_OVERRIDE;
+
+		//! renders the visible chunks
+		virtual void render() IRR_OVERRIDE;
+
+		//! returns the axis aligned bounding box of all chunks
+		virtual const core::aabbox3d<f32>& getBoundingBox() const IRR_OVERRIDE;
+
+		//! Returns type of the scene node
+		virtual ESCENE_NODE_TYPE getType() const IRR_OVERRIDE { return ESNT_STATIC_BATCH; }
+
+		//! Adds all suitable mesh scene nodes of a subtree
+		virtual u32 addNodes(ISceneNode* root) IRR_OVERRIDE;
+
+		//! Takes a node out of the batch and makes it visible again
+		virtual bool removeNode(ISceneNode* node) IRR_OVERRIDE;
+
+		//! Rebuilds the chunk of a member
+		virtual void nodeChanged(ISceneNode* node) IRR_OVERRIDE;
+
+		//! Get the amount of member nodes
+		virtual u32 getNodeCount() const IRR_OVERRIDE { return Members.size(); }
+
+		//! Get the amount of chunks
+		virtual u32 getChunkCount() const IRR_OVERRIDE { return Chunks.size(); }
+
+		//! Get the amount of merged meshbuffers of all chunks
+		virtual u32 getMeshBufferCount() const IRR_OVERRIDE;
+
+		//! Get the amount of chunks which passed culling in the last frame
+		virtual u32 getVisibleChunkCount() const IRR_OVERRIDE { return VisibleChunks.size(); }
+
+	private:
+
+		struct SMember
+		{
+			IMeshSceneNode* Node;
+			const IMesh* Mesh;	// only compared, the node holds it
+			u32 Version;		// transformation version of the node
+			s32 Chunk;
+			bool Shown;			// parents are visible
+		};
+
+		struct SBuffer
+		{
+			u32 Material;
+			CDynamicMeshBuffer* Buffer;
+
+			bool operator<(const SBuffer& other) const
+			{
+				return Material < other.Material;
+			}
+		};
+
+		struct SChunk
+		{
+			core::array<IMeshSceneNode*> Nodes;
+			core::array<SBuffer> Buffers;
+			core::aabbox3df Box;
+			bool Dirty;
+		};
+
+		//! if a node can be merged
+		bool canBatch(ISceneNode* node) const;
+
+		//! adds the suitable nodes of a subtree
+		u32 addSubtree(ISceneNode* node);
+
+		//! chunk for the world space box of a node
+		s32 getChunk(IMeshSceneNode* node);
+
+		//! removes a member, optionally showing its node again
+		void releaseMember(u32 index, bool show);
+
+		//! index of the member of a node, -1 if it isn't one
+		s32 findMember(const ISceneNode* node) const;
+
+		//! index of a material in Materials, adds it if it's new
+		u32 getMaterialIndex(const video::SMaterial& material);
+
+		//! merges the geometry of the shown members of a chunk again
+		void rebuildChunk(SChunk& chunk);
+
+		//! rebuilds the dirty chunks and the bounding box
+		void rebuildDirtyChunks();
+
+		core::array<SMember> Members;
+		core::array<SChunk> Chunks;
+		core::map<core::vector3d<s32>, u32> ChunkCells;
+		core::array<video::SMaterial> Materials;
+
+		core::array<u32> VisibleChunks;
+		core::array<SBuffer> DrawList;	// buffers of the visible chunks sorted by material
+
+		core::aabbox3d<f32> Box;
+		f32 ChunkSize;
+		bool Dirty;
+	};
+
+} // end namespace scene
+} // end namespace irr
+
+#endif
+
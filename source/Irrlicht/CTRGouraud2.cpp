@@ -87,7 +87,7 @@ public:
 	//virtual bool canWireFrame () { return true; }
 
 protected:
-	virtual void fragmentShader();
+	void fragmentShader();
 
 };
 
@@ -98,6 +98,8 @@ CTRGouraud2::CTRGouraud2(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRGouraud2");
 	#endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 }
 
 
@@ -142,6 +144,11 @@ void CTRGouraud2::fragmentShader()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -350,6 +357,7 @@ void CTRGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const s4DVer
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -511,6 +519,7 @@ void CTRGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const s4DVer
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
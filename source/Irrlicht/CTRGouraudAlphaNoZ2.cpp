@@ -98,6 +98,7 @@ CTRGouraudAlphaNoZ2::CTRGouraudAlphaNoZ2(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRGouraudAlphaNoZ2");
 	#endif
+	HiZ_Write = 0;
 }
 
 
@@ -361,6 +362,7 @@ void CTRGouraudAlphaNoZ2::drawTriangle(const s4DVertex* burning_restrict a, cons
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -520,6 +522,7 @@ void CTRGouraudAlphaNoZ2::drawTriangle(const s4DVertex* burning_restrict a, cons
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 
@@ -87,7 +87,7 @@ public:
 	virtual bool canWireFrame () IRR_OVERRIDE { return true; }
 
 protected:
-	virtual void fragmentShader();
+	void fragmentShader();
 };
 
 //! constructor
@@ -97,6 +97,7 @@ CTRGouraudNoZ2::CTRGouraudNoZ2(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRGouraudNoZ2");
 	#endif
+	HiZ_Write = 0;
 }
 
 
@@ -348,6 +349,7 @@ void CTRGouraudNoZ2::drawTriangle(const s4DVertex* burning_restrict a, const s4D
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -509,6 +511,7 @@ void CTRGouraudNoZ2::drawTriangle(const s4DVertex* burning_restrict a, const s4D
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
@@ -124,6 +124,8 @@ CTRNormalMap::CTRNormalMap(CBurningVideoDriver* driver, s32& outMaterialTypeNr,
 #ifdef _DEBUG
 	setDebugName("CTRNormalMap");
 #endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 	CallBack = this;
 	outMaterialTypeNr = driver->addMaterialRenderer(this);
 }
@@ -182,6 +184,11 @@ void CTRNormalMap::fragmentShader()
 	if (dx < 0)
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x(line.x[1] - line.x[0]);
 
@@ -602,6 +609,7 @@ void CTRNormalMap::drawTriangle(const s4DVertex* burning_restrict a, const s4DVe
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(a->Pos.y);
 		yEnd = fill_convention_down(b->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ((f32)yStart) - a->Pos.y;
@@ -876,6 +884,7 @@ void CTRNormalMap::drawTriangle(const s4DVertex* burning_restrict a, const s4DVe
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(b->Pos.y);
 		yEnd = fill_convention_down(c->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ((f32)yStart) - b->Pos.y;
@@ -127,6 +127,8 @@ CBurningParallaxMap::CBurningParallaxMap(CBurningVideoDriver* driver, s32& outMa
 #ifdef _DEBUG
 	setDebugName("CTRNormalMap");
 #endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 	CallBack = this;
 	outMaterialTypeNr = driver->addMaterialRenderer(this);
 	CurrentScale = 0.02f;
@@ -197,6 +199,11 @@ void CBurningParallaxMap::fragmentShader()
 	if (dx < 0)
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x(line.x[1] - line.x[0]);
 
@@ -639,6 +646,7 @@ void CBurningParallaxMap::drawTriangle(const s4DVertex* burning_restrict a, cons
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(a->Pos.y);
 		yEnd = fill_convention_down(b->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ((f32)yStart) - a->Pos.y;
@@ -913,6 +921,7 @@ void CBurningParallaxMap::drawTriangle(const s4DVertex* burning_restrict a, cons
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(b->Pos.y);
 		yEnd = fill_convention_down(c->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ((f32)yStart) - b->Pos.y;
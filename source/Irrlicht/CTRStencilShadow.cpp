@@ -98,6 +98,7 @@ CTRStencilShadow::CTRStencilShadow(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRStencilShadow");
 	#endif
+	HiZ_Write = 0;
 }
 
 
@@ -336,6 +337,7 @@ void CTRStencilShadow::drawTriangle(const s4DVertex* burning_restrict a, const s
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -543,6 +545,7 @@ void CTRStencilShadow::drawTriangle(const s4DVertex* burning_restrict a, const s
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
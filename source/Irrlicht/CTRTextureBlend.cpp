@@ -113,6 +113,8 @@ CTRTextureBlend::CTRTextureBlend(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRTextureBlend");
 	#endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 
 	depth_func = ECFN_LESSEQUAL;
 	fragmentShader = &CTRTextureBlend::fragment_dst_color_zero;
@@ -252,6 +254,11 @@ void CTRTextureBlend::fragment_dst_color_src_alpha ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -437,6 +444,11 @@ void CTRTextureBlend::fragment_src_color_src_alpha ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -632,6 +644,11 @@ void CTRTextureBlend::fragment_one_one_minus_src_alpha()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -833,6 +850,11 @@ void CTRTextureBlend::fragment_one_minus_dst_alpha_one ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -1033,6 +1055,11 @@ void CTRTextureBlend::fragment_src_alpha_one ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -1263,6 +1290,11 @@ void CTRTextureBlend::fragment_src_alpha_one_minus_src_alpha()
 	if (dx < 0)
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x(line.x[1] - line.x[0]);
 
@@ -1417,6 +1449,11 @@ void CTRTextureBlend::fragment_dst_color_one_minus_dst_alpha ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -1616,6 +1653,11 @@ void CTRTextureBlend::fragment_dst_color_zero ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -1813,6 +1855,11 @@ void CTRTextureBlend::fragment_dst_color_one ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -2013,6 +2060,11 @@ void CTRTextureBlend::fragment_zero_one_minus_scr_color ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -2276,6 +2328,7 @@ void CTRTextureBlend::drawTriangle(const s4DVertex* burning_restrict a, const s4
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -2435,6 +2488,7 @@ void CTRTextureBlend::drawTriangle(const s4DVertex* burning_restrict a, const s4
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
@@ -99,6 +99,8 @@ CTRTextureDetailMap2::CTRTextureDetailMap2(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRTextureDetailMap2");
 	#endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 }
 
 
@@ -143,6 +145,11 @@ void CTRTextureDetailMap2::fragmentShader()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -359,6 +366,7 @@ void CTRTextureDetailMap2::drawTriangle(const s4DVertex* burning_restrict a, con
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -521,6 +529,7 @@ void CTRTextureDetailMap2::drawTriangle(const s4DVertex* burning_restrict a, con
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
@@ -103,10 +103,15 @@ public:
 
 	//! draws an indexed triangle list
 	virtual void drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c) IRR_OVERRIDE;
+	virtual void drawTriangles(s4DVertex* v, const sRasterTriangle* t, const u32 count) IRR_OVERRIDE;
 	virtual bool canWireFrame () IRR_OVERRIDE { return true; }
 
 
 private:
+	// specialized for TL_Flag & (TL_FOG | TL_SPECULAR) | Fragment_Flag
+	template <size_t variant>
+	void drawTriangle_t(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c);
+	template <size_t variant>
 	void fragmentShader ();
 };
 
@@ -117,13 +122,16 @@ CTRTextureGouraud2::CTRTextureGouraud2(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRTextureGouraud2");
 	#endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 }
 
 
 
 /*!
 */
-void CTRTextureGouraud2::fragmentShader ()
+template <size_t variant>
+REALINLINE void CTRTextureGouraud2::fragmentShader ()
 {
 	tVideoSample *dst;
 
@@ -166,6 +174,11 @@ void CTRTextureGouraud2::fragmentShader ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -223,6 +236,28 @@ void CTRTextureGouraud2::fragmentShader ()
 #endif
 #endif
 
+#ifdef INVERSE_W
+	// affine: divide by w at both ends of the span, interpolate linear in between
+	if (!(variant & BF_PERSPECTIVE))
+	{
+		const f32 iw0 = reciprocal_zero(line.w[0]);
+		const f32 iw1 = reciprocal_zero(line.w[0] + slopeW * (f32)dx);
+		const f32 invDx = reciprocal_zero((f32)dx);
+#ifdef IPOL_C0
+		slopeC[0] = ((line.c[0][0] + slopeC[0] * (f32)dx) * iw1 - line.c[0][0] * iw0) * invDx;
+		line.c[0][0] = line.c[0][0] * iw0;
+#endif
+#ifdef IPOL_C1
+		slopeC[1] = ((line.c[1][0] + slopeC[1] * (f32)dx) * iw1 - line.c[1][0] * iw0) * invDx;
+		line.c[1][0] = line.c[1][0] * iw0;
+#endif
+#ifdef IPOL_T0
+		slopeT[0] = ((line.t[0][0] + slopeT[0] * (f32)dx) * iw1 - line.t[0][0] * iw0) * invDx;
+		line.t[0][0] = line.t[0][0] * iw0;
+#endif
+	}
+#endif
+
 	SOFTWARE_DRIVER_2_CLIPCHECK;
 	dst = (tVideoSample*)RenderTarget->getData() + ( line.y * RenderTarget->getDimension().Width ) + xStart;
 
@@ -274,12 +309,13 @@ void CTRTextureGouraud2::fragmentShader ()
 #endif
 
 #ifdef INVERSE_W
-			inversew = fix_inverse32 ( line.w[0] );
+			if (variant & BF_PERSPECTIVE)
+				inversew = fix_inverse32 ( line.w[0] );
 #endif
 
 #ifdef IPOL_C1
 			//complete inside fog
-			if (TL_Flag & TL_FOG)
+			if (variant & TL_FOG)
 			{
 				aFog = tofix(line.c[1][0].a, inversew);
 				if (aFog <= 0)
@@ -295,7 +331,7 @@ void CTRTextureGouraud2::fragmentShader ()
 
 #ifdef IPOL_C0
 
-			getSample_texture(r0, g0, b0, &IT[0], tx0, ty0);
+			getSample_texture_f<variant & BF_BILINEAR>(r0, g0, b0, &IT[0], tx0, ty0);
 			vec4_to_fix(r1, g1, b1, line.c[0][0], inversew);
 
 			r0 = imulFix_simple(r0, r1);
@@ -305,7 +341,7 @@ void CTRTextureGouraud2::fragmentShader ()
 #ifdef IPOL_C1
 
 			//specular highlight
-			if (TL_Flag & TL_SPECULAR)
+			if (variant & TL_SPECULAR)
 			{
 				vec4_to_fix(r1, g1, b1, line.c[1][0], inversew*COLOR_MAX);
 				r0 = clampfix_maxcolor(r1 + r0);
@@ -335,7 +371,7 @@ void CTRTextureGouraud2::fragmentShader ()
 			const tFixPointu d = dithermask [ dIndex | ( i ) & 3 ];
 			dst[i] = getTexel_plain ( &IT[0], d + tx0, d + ty0 );
 #else
-			getSample_texture ( r0, g0, b0, &IT[0], tx0,ty0 );
+			getSample_texture_f<variant & BF_BILINEAR> ( r0, g0, b0, &IT[0], tx0,ty0 );
 			dst[i] = fix_to_sample( r0, g0, b0 );
 #endif
 
@@ -371,7 +407,35 @@ void CTRTextureGouraud2::fragmentShader ()
 
 }
 
+// all variants of the span loop
+#define tg2_fragment(X, tl) X(tl) X(tl | BF_PERSPECTIVE) X(tl | BF_BILINEAR) X(tl | BF_QUALITY)
+#define tg2_variants(X) tg2_fragment(X, 0) tg2_fragment(X, TL_FOG) tg2_fragment(X, TL_SPECULAR) tg2_fragment(X, TL_FOG | TL_SPECULAR)
+
 void CTRTextureGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c)
+{
+#define tg2_case(v) case v: drawTriangle_t<v>(a, b, c); break;
+	switch ((TL_Flag & (TL_FOG | TL_SPECULAR)) | (Fragment_Flag & BF_QUALITY))
+	{
+		tg2_variants(tg2_case)
+	}
+#undef tg2_case
+}
+
+void CTRTextureGouraud2::drawTriangles(s4DVertex* v, const sRasterTriangle* t, const u32 count)
+{
+#define tg2_case(f) case f: drawTriangles_t<CTRTextureGouraud2, &CTRTextureGouraud2::drawTriangle_t<f> >(v, t, count); break;
+	switch ((TL_Flag & (TL_FOG | TL_SPECULAR)) | (Fragment_Flag & BF_QUALITY))
+	{
+		tg2_variants(tg2_case)
+	}
+#undef tg2_case
+}
+
+#undef tg2_variants
+#undef tg2_fragment
+
+template <size_t variant>
+void CTRTextureGouraud2::drawTriangle_t(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c)
 {
 	// sort on height, y
 	if ( F32_A_GREATER_B ( a->Pos.y , b->Pos.y ) ) swapVertexPointer(&a, &b);
@@ -502,6 +566,7 @@ void CTRTextureGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -601,7 +666,7 @@ void CTRTextureGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const
 #endif
 
 			// render a scanline
-			if_interlace_scanline fragmentShader ();
+			if_interlace_scanline fragmentShader<variant> ();
 			if ( EdgeTestPass & edge_test_first_line ) break;
 
 
@@ -734,6 +799,7 @@ void CTRTextureGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
@@ -832,7 +898,7 @@ void CTRTextureGouraud2::drawTriangle(const s4DVertex* burning_restrict a, const
 #endif
 
 			// render a scanline
-			if_interlace_scanline fragmentShader ();
+			if_interlace_scanline fragmentShader<variant> ();
 			if ( EdgeTestPass & edge_test_first_line ) break;
 
 
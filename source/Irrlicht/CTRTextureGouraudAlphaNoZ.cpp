@@ -108,6 +108,7 @@ CTRTextureGouraudAlphaNoZ::CTRTextureGouraudAlphaNoZ(CBurningVideoDriver* driver
 	#ifdef _DEBUG
 	setDebugName("CTRTextureGouraudAlphaNoZ");
 	#endif
+	HiZ_Write = 0;
 
 	fragmentShader = &CTRTextureGouraudAlphaNoZ::fragment_linear;
 }
@@ -135,6 +136,7 @@ void CTRTextureGouraudAlphaNoZ::OnSetMaterialBurning(const SBurningShaderMateria
 #endif
 		fragmentShader = &CTRTextureGouraudAlphaNoZ::fragment_point_noz;
 
+	HiZ_Reject = fragmentShader != &CTRTextureGouraudAlphaNoZ::fragment_point_noz;
 }
 
 /*!
@@ -178,6 +180,11 @@ void CTRTextureGouraudAlphaNoZ::fragment_linear()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -398,6 +405,11 @@ void CTRTextureGouraudAlphaNoZ::fragment_linear_alpharef()
 	if (dx < 0)
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x(line.x[1] - line.x[0]);
 
@@ -908,6 +920,7 @@ void CTRTextureGouraudAlphaNoZ::drawTriangle(const s4DVertex* burning_restrict a
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -1093,6 +1106,7 @@ void CTRTextureGouraudAlphaNoZ::drawTriangle(const s4DVertex* burning_restrict a
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - b->Pos.y;
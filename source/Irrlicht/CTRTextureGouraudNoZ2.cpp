@@ -105,6 +105,7 @@ CTRTextureGouraudNoZ2::CTRTextureGouraudNoZ2(CBurningVideoDriver* driver)
 #ifdef _DEBUG
 	setDebugName("CTRTextureGouraudNoZ2");
 #endif
+	HiZ_Write = 0;
 
 	fragmentShader = &CTRTextureGouraudNoZ2::fragment_linear;
 }
@@ -513,6 +514,7 @@ void CTRTextureGouraudNoZ2::drawTriangle(const s4DVertex* burning_restrict a, co
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(a->Pos.y);
 		yEnd = fill_convention_down(b->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ((f32)yStart) - a->Pos.y;
@@ -678,6 +680,7 @@ void CTRTextureGouraudNoZ2::drawTriangle(const s4DVertex* burning_restrict a, co
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(b->Pos.y);
 		yEnd = fill_convention_down(c->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 
@@ -83,11 +83,15 @@ public:
 
 	//! draws an indexed triangle list
 	virtual void drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c) IRR_OVERRIDE;
+	virtual void OnSetMaterialBurning(const SBurningShaderMaterial& material) IRR_OVERRIDE;
 
 
 private:
 	void scanline_bilinear2 ();
 
+	//! ECFN_EQUAL shades a depth prepass. the first visible pixel has the same w as the depth buffer
+	bool DepthEqual;
+
 };
 
 //! constructor
@@ -97,6 +101,14 @@ CTRTextureLightMap2_M2::CTRTextureLightMap2_M2(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRTextureLightMap2_M2");
 	#endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
+	DepthEqual = false;
+}
+
+void CTRTextureLightMap2_M2::OnSetMaterialBurning(const SBurningShaderMaterial& material)
+{
+	DepthEqual = material.org.ZBuffer == ECFN_EQUAL;
 }
 
 /*!
@@ -120,6 +132,11 @@ REALINLINE void CTRTextureLightMap2_M2::scanline_bilinear2 ()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x( line.x[1] - line.x[0] );
 
@@ -135,7 +152,7 @@ REALINLINE void CTRTextureLightMap2_M2::scanline_bilinear2 ()
 
 	i = 0;
 
-	while ( a <= z[i] )
+	while ( DepthEqual ? a < z[i] : a <= z[i] )
 	{
 		a += b;
 
@@ -344,6 +361,7 @@ void CTRTextureLightMap2_M2::drawTriangle(const s4DVertex* burning_restrict a, c
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -504,6 +522,7 @@ void CTRTextureLightMap2_M2::drawTriangle(const s4DVertex* burning_restrict a, c
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 
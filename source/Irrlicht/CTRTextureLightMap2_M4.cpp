@@ -79,6 +79,7 @@ public:
 
 	//! draws an indexed triangle list
 	virtual void drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c) IRR_OVERRIDE;
+	virtual void OnSetMaterialBurning(const SBurningShaderMaterial& material) IRR_OVERRIDE;
 
 private:
 
@@ -89,6 +90,9 @@ private:
 
 	tFragmentShader fragmentShader;
 
+	//! ECFN_EQUAL shades a depth prepass. the first visible pixel has the same w as the depth buffer
+	bool DepthEqual;
+
 };
 
 //! constructor
@@ -98,7 +102,15 @@ CTRTextureLightMap2_M4::CTRTextureLightMap2_M4(CBurningVideoDriver* driver)
 	#ifdef _DEBUG
 	setDebugName("CTRTextureLightMap2_M4");
 	#endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 	fragmentShader = &CTRTextureLightMap2_M4::fragment_linear_mag;
+	DepthEqual = false;
+}
+
+void CTRTextureLightMap2_M4::OnSetMaterialBurning(const SBurningShaderMaterial& material)
+{
+	DepthEqual = material.org.ZBuffer == ECFN_EQUAL;
 }
 
 
@@ -120,6 +132,11 @@ void CTRTextureLightMap2_M4::fragment_linear_mag()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	SOFTWARE_DRIVER_2_CLIPCHECK;
 
 	// slopes
@@ -272,6 +289,11 @@ void CTRTextureLightMap2_M4::fragment_nearest_min()
 	if ( dx < 0 )
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	SOFTWARE_DRIVER_2_CLIPCHECK;
 
 	// slopes
@@ -289,7 +311,7 @@ void CTRTextureLightMap2_M4::fragment_nearest_min()
 
 	i = 0;
 
-	while ( a <= z[i] )
+	while ( DepthEqual ? a < z[i] : a <= z[i] )
 	{
 		a += b;
 
@@ -488,6 +510,7 @@ void CTRTextureLightMap2_M4::drawTriangle ( const s4DVertex* burning_restrict a,
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( a->Pos.y );
 		yEnd = fill_convention_down( b->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ( (f32) yStart ) - a->Pos.y;
@@ -652,6 +675,7 @@ void CTRTextureLightMap2_M4::drawTriangle ( const s4DVertex* burning_restrict a,
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top( b->Pos.y );
 		yEnd = fill_convention_down( c->Pos.y );
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 
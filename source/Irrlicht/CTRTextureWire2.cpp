@@ -103,6 +103,7 @@ CTRTextureWire2::CTRTextureWire2(CBurningVideoDriver* driver)
 #ifdef _DEBUG
 	setDebugName("CTRTextureWire2");
 #endif
+	HiZ_Write = 0;
 	renderZero = 0;
 	depth_pass = 1;
 	depth_write = 0;
@@ -112,6 +113,7 @@ void CTRTextureWire2::OnSetMaterialBurning(const SBurningShaderMaterial& materia
 {
 	depth_pass = material.depth_test == 0;
 	depth_write = material.depth_write;
+	HiZ_Write = depth_write ? (depth_pass ? 2 : 1) : 0;
 }
 
 
@@ -311,6 +313,7 @@ void CTRTextureWire2::drawLine(const s4DVertex* a, const s4DVertex* b)
 	if (F32_A_GREATER_B(a->Pos.y, b->Pos.y)) swapVertexPointer(&a, &b);
 
 	renderLine(a, b);
+	hiz_mark(a, b, b);
 }
 
 void CTRTextureWire2::drawPoint(const s4DVertex* a)
@@ -320,6 +323,7 @@ void CTRTextureWire2::drawPoint(const s4DVertex* a)
 		renderZero = 1;
 		renderLine(a, a);
 		renderZero = 0;
+		hiz_mark(a, a, a);
 	}
 }
 
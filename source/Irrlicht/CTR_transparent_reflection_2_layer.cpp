@@ -103,6 +103,8 @@ CTR_transparent_reflection_2_layer::CTR_transparent_reflection_2_layer(CBurningV
 #ifdef _DEBUG
 	setDebugName("CTR_transparent_reflection_2_layer");
 #endif
+	HiZ_Reject = 1;
+	HiZ_Write = 1;
 }
 
 void CTR_transparent_reflection_2_layer::OnSetMaterialBurning(const SBurningShaderMaterial& material)
@@ -152,6 +154,11 @@ void CTR_transparent_reflection_2_layer::fragmentShader()
 	if (dx < 0)
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x(line.x[1] - line.x[0]);
 
@@ -499,6 +506,7 @@ void CTR_transparent_reflection_2_layer::drawTriangle(const s4DVertex* burning_r
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(a->Pos.y);
 		yEnd = fill_convention_down(b->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 		subPixel = ((f32)yStart) - a->Pos.y;
@@ -682,6 +690,7 @@ void CTR_transparent_reflection_2_layer::drawTriangle(const s4DVertex* burning_r
 		// apply top-left fill convention, top part
 		yStart = fill_convention_top(b->Pos.y);
 		yEnd = fill_convention_down(c->Pos.y);
+		raster_band_clip(yStart, yEnd);
 
 #ifdef SUBTEXEL
 
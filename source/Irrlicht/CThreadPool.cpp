@@ -0,0 +1,273 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "CThreadPool.h"
+#include "IrrCompileConfig.h"
+#include "irrMath.h"
+#include "os.h"
+
+#if defined(_IRR_WINDOWS_API_) && defined(_WIN32_WINNT) && (_WIN32_WINNT >= 0x0600)
+	#define _IRR_THREADPOOL_WIN32_
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#elif defined(_IRR_POSIX_API_) && !defined(_IRR_EMSCRIPTEN_PLATFORM_)
+	#define _IRR_THREADPOOL_PTHREAD_
+	#include <pthread.h>
+	#include <unistd.h>
+#endif
+
+namespace irr
+{
+
+#if defined(_IRR_THREADPOOL_WIN32_)
+	typedef HANDLE thread_handle;
+	typedef CRITICAL_SECTION thread_mutex;
+	typedef CONDITION_VARIABLE thread_cond;
+
+	static inline void mutex_init(thread_mutex& m) { InitializeCriticalSection(&m); }
+	static inline void mutex_destroy(thread_mutex& m) { DeleteCriticalSection(&m); }
+	static inline void mutex_lock(thread_mutex& m) { EnterCriticalSection(&m); }
+	static inline void mutex_unlock(thread_mutex& m) { LeaveCriticalSection(&m); }
+	static inline void cond_init(thread_cond& c) { InitializeConditionVariable(&c); }
+	static inline void cond_destroy(thread_cond& c) {}
+	static inline void cond_wait(thread_cond& c, thread_mutex& m) { SleepConditionVariableCS(&c, &m, INFINITE); }
+	static inline void cond_signal(thread_cond& c) { WakeConditionVariable(&c); }
+	static inline void cond_broadcast(thread_cond& c) { WakeAllConditionVariable(&c); }
+#elif defined(_IRR_THREADPOOL_PTHREAD_)
+	typedef pthread_t thread_handle;
+	typedef pthread_mutex_t thread_mutex;
+	typedef pthread_cond_t thread_cond;
+
+	static inline void mutex_init(thread_mutex& m) { pthread_mutex_init(&m, 0); }
+	static inline void mutex_destroy(thread_mutex& m) { pthread_mutex_destroy(&m); }
+	static inline void mutex_lock(thread_mutex& m) { pthread_mutex_lock(&m); }
+	static inline void mutex_unlock(thread_mutex& m) { pthread_mutex_unlock(&m); }
+	static inline void cond_init(thread_cond& c) { pthread_cond_init(&c, 0); }
+	static inline void cond_destroy(thread_cond& c) { pthread_cond_destroy(&c); }
+	static inline void cond_wait(thread_cond& c, thread_mutex& m) { pthread_cond_wait(&c, &m); }
+	static inline void cond_signal(thread_cond& c) { pthread_cond_signal(&c); }
+	static inline void cond_broadcast(thread_cond& c) { pthread_cond_broadcast(&c); }
+#endif
+
+#if defined(_IRR_THREADPOOL_WIN32_) || defined(_IRR_THREADPOOL_PTHREAD_)
+
+struct SThreadPoolData
+{
+	thread_mutex Mutex;
+	thread_cond Wake;	// workers wait for a new run
+	thread_cond Done;	// caller waits for the last job
+
+	thread_handle* Thread;
+#if defined(_IRR_THREADPOOL_WIN32_)
+	DWORD* ThreadId;
+#endif
+	u32 WorkerCount;
+
+	// current run. guarded by Mutex
+	ThreadPoolJob Job;
+	void* UserData;
+	u32 JobCount;
+	u32 NextJob;
+	u32 FinishedJobs;
+	u32 Generation;
+	bool Quit;
+
+	//! work on jobs of the current run. Mutex has to be locked
+	void work()
+	{
+		while (NextJob < JobCount)
+		{
+			const u32 job = NextJob++;
+			ThreadPoolJob func = Job;
+			void* userData = UserData;
+
+			mutex_unlock(Mutex);
+			func(userData, job);
+			mutex_lock(Mutex);
+
+			if (++FinishedJobs == JobCount)
+				cond_signal(Done);
+		}
+	}
+
+	void workerLoop()
+	{
+		mutex_lock(Mutex);
+		u32 seen = Generation;
+		for (;;)
+		{
+			while (!Quit && Generation == seen)
+				cond_wait(Wake, Mutex);
+			if (Quit)
+				break;
+
+			seen = Generation;
+			work();
+		}
+		mutex_unlock(Mutex);
+	}
+};
+
+#if defined(_IRR_THREADPOOL_WIN32_)
+static DWORD WINAPI threadPoolWorker(LPVOID data)
+#else
+static void* threadPoolWorker(void* data)
+#endif
+{
+	((SThreadPoolData*)data)->workerLoop();
+	return 0;
+}
+
+#endif
+
+
+CThreadPool::CThreadPool(u32 threadCount)
+	: Data(0), ThreadCount(1)
+{
+#ifdef _DEBUG
+	setDebugName("CThreadPool");
+#endif
+
+	if (threadCount == 0)
+		threadCount = getProcessorCount();
+
+#if defined(_IRR_THREADPOOL_WIN32_) || defined(_IRR_THREADPOOL_PTHREAD_)
+	if (threadCount < 2)
+		return;
+
+	Data = new SThreadPoolData;
+	mutex_init(Data->Mutex);
+	cond_init(Data->Wake);
+	cond_init(Data->Done);
+	Data->Job = 0;
+	Data->UserData = 0;
+	Data->JobCount = 0;
+	Data->NextJob = 0;
+	Data->FinishedJobs = 0;
+	Data->Generation = 0;
+	Data->Quit = false;
+	Data->WorkerCount = 0;
+	Data->Thread = new thread_handle[threadCount - 1];
+#if defined(_IRR_THREADPOOL_WIN32_)
+	Data->ThreadId = new DWORD[threadCount - 1];
+#endif
+
+	for (u32 i = 0; i != threadCount - 1; ++i)
+	{
+#if defined(_IRR_THREADPOOL_WIN32_)
+		Data->Thread[i] = CreateThread(0, 0, threadPoolWorker, Data, 0, &Data->ThreadId[i]);
+		if (!Data->Thread[i])
+			break;
+#else
+		if (pthread_create(&Data->Thread[i], 0, threadPoolWorker, Data) != 0)
+			break;
+#endif
+		Data->WorkerCount += 1;
+	}
+
+	if (Data->WorkerCount + 1 < threadCount)
+		os::Printer::log("Could not create all worker threads", ELL_WARNING);
+
+	ThreadCount = Data->WorkerCount + 1;
+#endif
+}
+
+
+CThreadPool::~CThreadPool()
+{
+#if defined(_IRR_THREADPOOL_WIN32_) || defined(_IRR_THREADPOOL_PTHREAD_)
+	if (!Data)
+		return;
+
+	mutex_lock(Data->Mutex);
+	Data->Quit = true;
+	cond_broadcast(Data->Wake);
+	mutex_unlock(Data->Mutex);
+
+	for (u32 i = 0; i != Data->WorkerCount; ++i)
+	{
+#if defined(_IRR_THREADPOOL_WIN32_)
+		WaitForSingleObject(Data->Thread[i], INFINITE);
+		CloseHandle(Data->Thread[i]);
+#else
+		pthread_join(Data->Thread[i], 0);
+#endif
+	}
+
+	cond_destroy(Data->Done);
+	cond_destroy(Data->Wake);
+	mutex_destroy(Data->Mutex);
+	delete [] Data->Thread;
+#if defined(_IRR_THREADPOOL_WIN32_)
+	delete [] Data->ThreadId;
+#endif
+	delete Data;
+#endif
+}
+
+
+u32 CThreadPool::getThreadIndex() const
+{
+#if defined(_IRR_THREADPOOL_WIN32_) || defined(_IRR_THREADPOOL_PTHREAD_)
+	if (Data)
+	{
+#if defined(_IRR_THREADPOOL_WIN32_)
+		const DWORD self = GetCurrentThreadId();
+		for (u32 i = 0; i != Data->WorkerCount; ++i)
+			if (Data->ThreadId[i] == self)
+				return i + 1;
+#else
+		const pthread_t self = pthread_self();
+		for (u32 i = 0; i != Data->WorkerCount; ++i)
+			if (pthread_equal(Data->Thread[i], self))
+				return i + 1;
+#endif
+	}
+#endif
+	return 0;
+}
+
+
+void CThreadPool::run(ThreadPoolJob job, void* userData, u32 jobCount)
+{
+#if defined(_IRR_THREADPOOL_WIN32_) || defined(_IRR_THREADPOOL_PTHREAD_)
+	if (Data && jobCount > 1)
+	{
+		mutex_lock(Data->Mutex);
+		Data->Job = job;
+		Data->UserData = userData;
+		Data->JobCount = jobCount;
+		Data->NextJob = 0;
+		Data->FinishedJobs = 0;
+		Data->Generation += 1;
+		cond_broadcast(Data->Wake);
+
+		Data->work();
+		while (Data->FinishedJobs < jobCount)
+			cond_wait(Data->Done, Data->Mutex);
+		mutex_unlock(Data->Mutex);
+		return;
+	}
+#endif
+
+	for (u32 i = 0; i != jobCount; ++i)
+		job(userData, i);
+}
+
+
+u32 CThreadPool::getProcessorCount()
+{
+#if defined(_IRR_THREADPOOL_WIN32_)
+	SYSTEM_INFO sysinfo;
+	GetSystemInfo(&sysinfo);
+	return core::max_(1u, (u32)sysinfo.dwNumberOfProcessors);
+#elif defined(_IRR_THREADPOOL_PTHREAD_) && defined(_SC_NPROCESSORS_ONLN)
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 1 ? (u32)count : 1;
+#else
+	return 1;
+#endif
+}
+
+} // end namespace irr
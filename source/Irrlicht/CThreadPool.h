@@ -0,0 +1,59 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef IRR_C_THREAD_POOL_H_INCLUDED
+#define IRR_C_THREAD_POOL_H_INCLUDED
+
+#include "IReferenceCounted.h"
+#include "irrTypes.h"
+
+namespace irr
+{
+	//! Function called by CThreadPool once for every job index of a run
+	typedef void (*ThreadPoolJob)(void* userData, u32 job);
+
+	struct SThreadPoolData;
+
+	//! Minimal pool of worker threads for data parallel work inside the engine
+	/** A run hands out the job indices [0,jobCount) to the workers and the
+	calling thread and returns after all jobs are finished. There is no
+	queue. On platforms without thread support all jobs are executed by
+	the calling thread. */
+	class CThreadPool : public virtual IReferenceCounted
+	{
+	public:
+
+		//! constructor
+		/** \param threadCount Number of threads working on a run including
+		the calling thread. 0 uses the number of processors. */
+		CThreadPool(u32 threadCount = 0);
+
+		//! destructor. Stops and joins all worker threads.
+		virtual ~CThreadPool();
+
+		//! Number of threads working on a run, including the calling thread
+		u32 getThreadCount() const { return ThreadCount; }
+
+		//! Index of the calling thread in [0,getThreadCount())
+		/** Workers are numbered from 1. Threads which are not owned by
+		the pool, like the one calling run(), get 0. */
+		u32 getThreadIndex() const;
+
+		//! Calls job(userData, i) for every i in [0,jobCount)
+		/** Blocks until all jobs are done. The order in which jobs are
+		started is not defined. Jobs must not call run() of the same pool. */
+		void run(ThreadPoolJob job, void* userData, u32 jobCount);
+
+		//! Number of processors available to this process
+		static u32 getProcessorCount();
+
+	private:
+
+		SThreadPoolData* Data;
+		u32 ThreadCount;
+	};
+
+} // end namespace irr
+
+#endif
@@ -15,7 +15,7 @@ namespace scene
 
 //! constructor
 CTriangleSelector::CTriangleSelector(ISceneNode* node)
-: SceneNode(node), MeshBuffer(0), MaterialIndex(0), AnimatedNode(0), LastMeshFrame(0)
+: SceneNode(node), MeshBuffer(0), MaterialIndex(0), AnimatedNode(0), LastMeshFrame(0), InverseNodeCached(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CTriangleSelector");
@@ -27,7 +27,7 @@ CTriangleSelector::CTriangleSelector(ISceneNode* node)
 
 //! constructor
 CTriangleSelector::CTriangleSelector(const core::aabbox3d<f32>& box, ISceneNode* node)
-: SceneNode(node), MeshBuffer(0), MaterialIndex(0), AnimatedNode(0), LastMeshFrame(0)
+: SceneNode(node), MeshBuffer(0), MaterialIndex(0), AnimatedNode(0), LastMeshFrame(0), InverseNodeCached(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CTriangleSelector");
@@ -40,7 +40,7 @@ CTriangleSelector::CTriangleSelector(const core::aabbox3d<f32>& box, ISceneNode*
 
 //! constructor
 CTriangleSelector::CTriangleSelector(const IMesh* mesh, ISceneNode* node, bool separateMeshbuffers)
-: SceneNode(node), MeshBuffer(0), MaterialIndex(0), AnimatedNode(0), LastMeshFrame(0)
+: SceneNode(node), MeshBuffer(0), MaterialIndex(0), AnimatedNode(0), LastMeshFrame(0), InverseNodeCached(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CTriangleSelector");
@@ -50,7 +50,7 @@ CTriangleSelector::CTriangleSelector(const IMesh* mesh, ISceneNode* node, bool s
 }
 
 CTriangleSelector::CTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 materialIndex, ISceneNode* node)
-	: SceneNode(node), MeshBuffer(meshBuffer), MaterialIndex(materialIndex), AnimatedNode(0), LastMeshFrame(0)
+	: SceneNode(node), MeshBuffer(meshBuffer), MaterialIndex(materialIndex), AnimatedNode(0), LastMeshFrame(0), InverseNodeCached(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CTriangleSelector");
@@ -60,7 +60,7 @@ CTriangleSelector::CTriangleSelector(const IMeshBuffer* meshBuffer, irr::u32 mat
 }
 
 CTriangleSelector::CTriangleSelector(IAnimatedMeshSceneNode* node, bool separateMeshbuffers)
-: SceneNode(node), AnimatedNode(node), LastMeshFrame(0)
+: SceneNode(node), AnimatedNode(node), LastMeshFrame(0), InverseNodeCached(false)
 {
 	#ifdef _DEBUG
 	setDebugName("CTriangleSelector");
@@ -259,6 +259,23 @@ void CTriangleSelector::update(void) const
 }
 
 
+//! Inverse of the absolute transformation of SceneNode
+bool CTriangleSelector::getInverseNodeTransformation(core::matrix4& out) const
+{
+	const u32 version = SceneNode->getTransformationVersion();
+	if (!InverseNodeCached || version != InverseNodeVersion)
+	{
+		InverseNodeValid = SceneNode->getAbsoluteTransformation().getInverse(InverseNodeTransformation);
+		InverseNodeVersion = version;
+		InverseNodeCached = true;
+	}
+
+	if (InverseNodeValid)
+		out = InverseNodeTransformation;
+	return InverseNodeValid;
+}
+
+
 //! Gets all triangles.
 void CTriangleSelector::getTriangles(core::triangle3df* triangles,
 					s32 arraySize, s32& outTriangleCount,
@@ -341,7 +358,7 @@ void CTriangleSelector::getTriangles(core::triangle3df* triangles,
 
 	if (SceneNode && useNodeTransform)
 	{
-		if ( SceneNode->getAbsoluteTransformation().getInverse(mat) )
+		if ( getInverseNodeTransformation(mat) )
 			mat.transformBoxEx(tBox);
 		else
 		{
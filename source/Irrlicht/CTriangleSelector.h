@@ -91,6 +91,11 @@ protected:
 	//! since the last time it was updated.
 	virtual void update(void) const;
 
+	//! Inverse of the absolute transformation of SceneNode
+	/** Only recalculated when the node moved since the last call.
+	\return False if the transformation can't be inverted. */
+	bool getInverseNodeTransformation(core::matrix4& out) const;
+
 	irr::core::array<SCollisionTriangleRange> BufferRanges;
 
 	ISceneNode* SceneNode;
@@ -101,6 +106,12 @@ protected:
 	irr::u32 MaterialIndex;		// Only set when MeshBuffer is non-zero
 	IAnimatedMeshSceneNode* AnimatedNode;
 	mutable u32 LastMeshFrame;
+
+	// cache of getInverseNodeTransformation()
+	mutable core::matrix4 InverseNodeTransformation;
+	mutable u32 InverseNodeVersion;
+	mutable bool InverseNodeValid;
+	mutable bool InverseNodeCached;
 };
 
 } // end namespace scene
@@ -43,6 +43,8 @@ void IBurningShader::constructor_IBurningShader(CBurningVideoDriver* driver, E_M
 	for (u32 i = 0; i < BURNING_MATERIAL_MAX_TEXTURES; ++i)
 	{
 		IT[i].Texture = 0;
+		IT[i].tileMask = 0;
+		IT[i].tileShift = SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY;
 	}
 
 	Driver = driver;
@@ -64,7 +66,12 @@ void IBurningShader::constructor_IBurningShader(CBurningVideoDriver* driver, E_M
 	AlphaRef = 0;
 	PrimitiveColor = COLOR_BRIGHT_WHITE;
 	TL_Flag = 0;
+	Fragment_Flag = BF_DEFAULT;
 	fragment_draw_count = 0;
+	RasterBand.y0 = -0x7fffffff;
+	RasterBand.y1 = 0x7fffffff;
+	HiZ_Reject = 0;
+	HiZ_Write = 2;
 	VertexShaderProgram_buildin = BVT_Fix;
 
 	//set default Transparent/Solid
@@ -242,9 +249,37 @@ void IBurningShader::setTextureParam(const size_t stage, video::CSoftwareTexture
 		const core::dimension2d<u32>& dim = it->Texture->getSize();
 		it->textureXMask = s32_to_fixPoint(dim.Width - 1) & FIX_POINT_UNSIGNED_MASK;
 		it->textureYMask = s32_to_fixPoint(dim.Height - 1) & FIX_POINT_UNSIGNED_MASK;
+
+		// sample from 4x4 texel tiles if the level has a tiled copy
+		const void* tiled = it->Texture->getTiledData();
+		if (tiled)
+			it->data = (tVideoSample*)tiled;
+		it->tileMask = tiled ? 3 : 0;
+		it->tileShift = SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY + (tiled ? 2 : 0);
 	}
 }
 
+void IBurningShader::setRasterState(const IBurningShader* master, const s32 y0, const s32 y1)
+{
+	setRenderTarget(master->RenderTarget, core::rect<s32>(), master->Interlaced);
+
+	ColorMask = master->ColorMask;
+	EdgeTestPass = master->EdgeTestPass;
+	for (size_t i = 0; i != array_size(stencilOp); ++i)
+		stencilOp[i] = master->stencilOp[i];
+	AlphaRef = master->AlphaRef;
+	PrimitiveColor = master->PrimitiveColor;
+	TL_Flag = master->TL_Flag;
+	Fragment_Flag = master->Fragment_Flag;
+	for (size_t i = 0; i != array_size(fog_color); ++i)
+		fog_color[i] = master->fog_color[i];
+	fog_color_sample = master->fog_color_sample;
+	Scissor = master->Scissor;
+
+	RasterBand.y0 = y0;
+	RasterBand.y1 = y1;
+}
+
 //emulate a line with degenerate triangle and special shader mode (not perfect...)
 void IBurningShader::drawLine(const s4DVertex* a, const s4DVertex* b)
 {
@@ -267,17 +302,60 @@ void IBurningShader::drawLine(const s4DVertex* a, const s4DVertex* b)
 	drawTriangle(a, b, &c);
 	EdgeTestPass &= ~edge_test_first_line;
 
+	hiz_mark(a, b, &c);
 }
 
 void IBurningShader::drawPoint(const s4DVertex* a)
 {
 }
 
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+//! pixel rectangle of a primitive inside the raster band. one pixel border for fill convention and line emulation
+//! not s32_min/s32_max, their difference overflows against the open band limits
+static inline void hiz_rect(AbsRectangle& r, const s4DVertex* a, const s4DVertex* b, const s4DVertex* c, const raster_band& band)
+{
+	r.x0 = (s32)floorf(core::min_(a->Pos.x, b->Pos.x, c->Pos.x)) - 1;
+	r.y0 = core::max_((s32)floorf(core::min_(a->Pos.y, b->Pos.y, c->Pos.y)) - 1, band.y0);
+	r.x1 = (s32)ceilf(core::max_(a->Pos.x, b->Pos.x, c->Pos.x)) + 1;
+	r.y1 = core::min_((s32)ceilf(core::max_(a->Pos.y, b->Pos.y, c->Pos.y)) + 1, band.y1);
+}
+#endif
+
+void IBurningShader::hiz_mark(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c)
+{
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+	if (!HiZ_Write || !DepthBuffer)
+		return;
+
+	AbsRectangle r;
+	hiz_rect(r, a, b, c, RasterBand);
+	DepthBuffer->hiz_mark(r, HiZ_Write == 2);
+#endif
+}
+
+//! whole triangle is behind the depth buffer. depth is linear in screen space, so the nearest vertex decides
+int IBurningShader::hiz_reject(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c)
+{
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+	if (!HiZ_Reject || !DepthBuffer)
+		return 0;
+
+	AbsRectangle r;
+	hiz_rect(r, a, b, c, RasterBand);
+	return DepthBuffer->hiz_reject(r, core::max_(a->Pos.w, b->Pos.w, c->Pos.w));
+#else
+	return 0;
+#endif
+}
+
 void IBurningShader::drawWireFrameTriangle(s4DVertex* a, s4DVertex* b, s4DVertex* c)
 {
 	if (EdgeTestPass & edge_test_pass)
 	{
+		if (hiz_reject(a, b, c))
+			return;
 		drawTriangle(a, b, c);
+		hiz_mark(a, b, c);
 	}
 	else if (EdgeTestPass & edge_test_point)
 	{
@@ -293,6 +371,19 @@ void IBurningShader::drawWireFrameTriangle(s4DVertex* a, s4DVertex* b, s4DVertex
 	}
 }
 
+//! batch of triangles in submission order. virtual drawTriangle per triangle
+void IBurningShader::drawTriangles(s4DVertex* v, const sRasterTriangle* t, const u32 count)
+{
+	for (u32 i = 0; i < count; ++i, v += 3)
+	{
+		if (t[i].y1 < RasterBand.y0 || t[i].y0 > RasterBand.y1)
+			continue;
+
+		setSamplerState(t[i]);
+		drawWireFrameTriangle(v + 0, v + 1, v + 2);
+	}
+}
+
 
 void IBurningShader::OnSetMaterial(const SMaterial& material, const SMaterial& lastMaterial,
 	bool resetAllRenderstates, IMaterialRendererServices* services)
@@ -77,6 +77,21 @@ enum eTransformLightFlags
 
 };
 
+//! fragment variant of the span loops. picked per material, resolved at compile time in the loop
+enum eBurningFragmentFlags
+{
+	BF_PERSPECTIVE = 0x01,	// texture coordinates and colors divided by w per pixel, else only at the span ends
+	BF_BILINEAR = 0x02,		// bilinear texture filter, else nearest
+	BF_QUALITY = BF_PERSPECTIVE | BF_BILINEAR,
+
+	// compile time configuration, used by all shaders without fragment variants
+#if defined(SOFTWARE_DRIVER_2_BILINEAR)
+	BF_DEFAULT = BF_QUALITY
+#else
+	BF_DEFAULT = BF_PERSPECTIVE
+#endif
+};
+
 struct SBurningShaderEyeSpace
 {
 	SBurningShaderEyeSpace() {}
@@ -252,6 +267,16 @@ struct BurningUniform
 
 };
 
+//! projected triangle of a batch. vertices are stored separately, 3 per triangle
+struct sRasterTriangle
+{
+	s32 y0; // conservative scanline range
+	s32 y1;
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+	sInternalTexture IT[BURNING_MATERIAL_MAX_TEXTURES]; // sampler state (mipmap level) of the triangle
+#endif
+};
+
 class IBurningShader;
 struct PushShaderData
 {
@@ -302,6 +327,11 @@ public:
 
 	void drawWireFrameTriangle(s4DVertex* a, s4DVertex* b, s4DVertex* c);
 
+	//! draws count triangles touching the raster band. v holds 3 vertices per triangle
+	/** One call per batch instead of one drawTriangle call per triangle.
+	Shaders override it with drawTriangles_t to get their scanline loop inlined. */
+	virtual void drawTriangles(s4DVertex* v, const sRasterTriangle* t, const u32 count);
+
 	virtual void OnSetMaterialBurning(const SBurningShaderMaterial& material) {};
 
 	void setEdgeTest(const int wireFrame, const int pointCloud)
@@ -384,6 +414,10 @@ public:
 	{
 		TL_Flag = in;
 	}
+	void setFragmentFlag(size_t in /*eBurningFragmentFlags*/)
+	{
+		Fragment_Flag = in;
+	}
 	void setFog(SColor color_fog)
 	{
 		fog_color_sample = color_to_sample(color_fog);
@@ -394,8 +428,35 @@ public:
 		Scissor = scissor;
 	}
 
+	//! current sampler state of a texture stage (set by setTextureParam)
+	const sInternalTexture& getTextureParam(const size_t stage) const
+	{
+		return IT[stage];
+	}
+
+	//multithreaded rasterizer (worker shaders)
+	//! take over the render states of the shader used on the driver thread. restrict drawing to scanlines [y0,y1]
+	void setRasterState(const IBurningShader* master, const s32 y0, const s32 y1);
+
+	//! sampler state of a batched triangle. the texture reference set by setTextureParam is kept
+	void setSamplerState(const sRasterTriangle& t)
+	{
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+		for (size_t m = 0; m < BURNING_MATERIAL_MAX_TEXTURES; ++m)
+		{
+			video::CSoftwareTexture2* texture = IT[m].Texture;
+			IT[m] = t.IT[m];
+			IT[m].Texture = texture;
+		}
+#endif
+	}
+
 	u32 fragment_draw_count;
 
+	//hierarchical depth buffer
+	//! depth tiles below the primitive have to be recalculated. called after drawing
+	void hiz_mark(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c);
+
 	const f32* getUniform(const c8* name, EBurningUniformFlags flags) const;
 
 protected:
@@ -423,6 +484,54 @@ protected:
 
 	//draw degenerate triangle as line (left edge) drawTriangle -> holes,drawLine dda/bresenham
 	size_t EdgeTestPass; //edge_test_flag
+
+	//hierarchical depth buffer. what the shader does with the depth buffer
+	//HiZ_Reject: draws nothing where w < z. triangles behind the depth tiles are skipped
+	//HiZ_Write: 0 no depth write, 1 writes only where w >= z, 2 writes any depth
+	int HiZ_Reject;
+	int HiZ_Write;
+	int hiz_reject(const s4DVertex* a, const s4DVertex* b, const s4DVertex* c);
+
+	//! drawTriangles with the non virtual triangle setup and span loop of shader T
+	template <class T, void (T::*triangle)(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c)>
+	void drawTriangles_t(s4DVertex* v, const sRasterTriangle* t, const u32 count)
+	{
+		T* shader = static_cast<T*>(this);
+		for (u32 i = 0; i < count; ++i, v += 3)
+		{
+			if (t[i].y1 < RasterBand.y0 || t[i].y0 > RasterBand.y1)
+				continue;
+
+			setSamplerState(t[i]);
+			if (EdgeTestPass & edge_test_pass)
+			{
+				if (hiz_reject(v + 0, v + 1, v + 2))
+					continue;
+				(shader->*triangle)(v + 0, v + 1, v + 2);
+				hiz_mark(v + 0, v + 1, v + 2);
+			}
+			else
+			{
+				drawWireFrameTriangle(v + 0, v + 1, v + 2);
+			}
+		}
+	}
+
+	//! all pixels of scanline line.y [xStart,xEnd] are behind the depth buffer
+	//! call before subtexel correction, only in scanlines drawing nothing where w < z
+	inline int hiz_reject_span(const s32 xStart, const s32 xEnd)
+	{
+#if defined(SOFTWARE_DRIVER_2_HIZ)
+		AbsRectangle r;
+		r.x0 = xStart;
+		r.y0 = line.y;
+		r.x1 = xEnd;
+		r.y1 = line.y;
+		return DepthBuffer && DepthBuffer->hiz_reject(r, core::max_(line.w[0], line.w[1]));
+#else
+		return 0;
+#endif
+	}
 	interlaced_control Interlaced; // passed from driver
 
 	eBurningStencilOp stencilOp[4];
@@ -434,10 +543,12 @@ protected:
 	tVideoSample PrimitiveColor; //used if no color interpolation is defined
 
 	size_t /*eTransformLightFlags*/ TL_Flag;
+	size_t /*eBurningFragmentFlags*/ Fragment_Flag;
 	tFixPoint fog_color[4];
 	tVideoSample fog_color_sample;
 
 	AbsRectangle Scissor;
+	raster_band RasterBand;
 
 	//core::stringc VertexShaderProgram;
 	//core::stringc PixelShaderProgram;
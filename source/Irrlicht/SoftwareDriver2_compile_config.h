@@ -130,6 +130,47 @@
 #define SOFTWARE_DRIVER_2_STEP_X 1
 #define SOFTWARE_DRIVER_2_STEP_Y 1
 
+//Multithreaded rasterizer (SIrrlichtCreationParameters::DriverMultithreaded)
+//triangles binned before the bands are drawn in parallel. draw calls with less primitives stay on the driver thread
+#define SOFTWARE_DRIVER_2_RASTER_MAX_THREADS 16
+#define SOFTWARE_DRIVER_2_RASTER_BATCH 1024
+#define SOFTWARE_DRIVER_2_RASTER_BATCH_MIN 32
+
+//Tiled rasterizer (SIrrlichtCreationParameters::TiledRasterizer). tile rows of (1 << SHIFT) scanlines,
+//at least one depth tile row. the last tile row takes the rest of a render target higher than MAX_BANDS tile rows
+#define SOFTWARE_DRIVER_2_RASTER_TILE_SHIFT 5
+#define SOFTWARE_DRIVER_2_RASTER_MAX_BANDS 64
+
+//Post transform cache for meshbuffers with hardware mapping hint EHM_STATIC.
+//memory budget in bytes for all cached vertices and amount of transform states kept per meshbuffer
+#define SOFTWARE_DRIVER_2_TRANSFORM_CACHE_BUDGET (64 * 1024 * 1024)
+#define SOFTWARE_DRIVER_2_TRANSFORM_CACHE_KEYS 4
+
+//Hierarchical depth buffer. farthest depth of each tile rejects hidden triangles and scanlines
+//before any fragment work. tile size is (1 << SHIFT) pixel square. needs w-buffer
+#if defined(SOFTWARE_DRIVER_2_USE_WBUFFER) && !defined(BURNINGVIDEO_NO_HIZ)
+#define SOFTWARE_DRIVER_2_HIZ
+#endif
+#define SOFTWARE_DRIVER_2_HIZ_TILE_SHIFT 3
+
+//SIMD vertex transform and clip test of the fixed function pipeline (SSE2, AVX).
+//instruction set is selected at runtime, scalar code if the cpu has none of them
+#if !defined(BURNINGVIDEO_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SOFTWARE_DRIVER_2_SIMD_VERTEX
+#endif
+
+//SSE2 bilinear texture filter for 32 bit texels. results equal to the scalar filter
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX) && defined(SOFTWARE_DRIVER_2_32BIT)
+#define SOFTWARE_DRIVER_2_SIMD_SAMPLER
+#endif
+
+//Shaders sample mipmap levels of at least 4x4 texels from a copy stored in 4x4 texel tiles,
+//so texels of neighbouring rows share a cache line. lock() still returns linear texels.
+//Opt-in: the copy doubles the memory of every texture and costs a copy per unlock after writing
+#if defined(BURNINGVIDEO_TEXTURE_TILED)
+#define SOFTWARE_DRIVER_2_TEXTURE_TILED
+#endif
+
 // null check necessary (burningvideo only)
 #define fill_step_y(y) ((y) != 0.f ? (float)1.f / (y):0.f)
 static inline float fill_step_x(float x) { return x != 0.f ? (float)SOFTWARE_DRIVER_2_STEP_X / x : 0.f; }
@@ -169,13 +210,23 @@ static inline interlaced_control interlaced_disabled()
 */
 	return v;
 }
+//Multithreaded rasterizer: each worker shader draws only the scanlines [y0,y1] of its band
+struct raster_band { int y0; int y1; };
+#define raster_band_active ((line.y >= RasterBand.y0) & (line.y <= RasterBand.y1))
+#define if_raster_band if (raster_band_active)
+//clip the scanlines of a triangle half to the band. Rows below the band are dropped and a half above the band is skipped.
+//A half crossing the top of the band is still stepped row by row up to y0, so the edges stay bit identical to the unbanded walk.
+#define raster_band_clip(yStart,yEnd) do { if ((yEnd) > RasterBand.y1) (yEnd) = RasterBand.y1; if ((yEnd) < RasterBand.y0) (yEnd) = (yStart) - 1; } while (0)
+
 #if defined(SOFTWARE_DRIVER_2_INTERLACED)
 #define interlace_scanline_active ((line.y & interlace_control_mask) == Interlaced.nr)
 #define if_interlace_scanline_active if (interlace_scanline_active)
-#define if_interlace_scanline if ( Interlaced.bypass || interlace_scanline_active )
+#define if_interlace_scanline if ( (Interlaced.bypass || interlace_scanline_active) && raster_band_active )
+#define if_interlace_scanline_noband if ( Interlaced.bypass || interlace_scanline_active )
 #else
 #define if_interlace_scanline_active
-#define if_interlace_scanline
+#define if_interlace_scanline if_raster_band
+#define if_interlace_scanline_noband
 #endif
 
 #define if_scissor_test_y if ((~TL_Flag & TL_SCISSOR) || ((line.y >= Scissor.y0) & (line.y <= Scissor.y1)))
@@ -14,6 +14,10 @@ History:
 #include "CSoftwareTexture2.h"
 #include "SMaterial.h"
 
+#if defined(SOFTWARE_DRIVER_2_SIMD_SAMPLER)
+#include <emmintrin.h>
+#endif
+
 
 namespace irr
 {
@@ -835,10 +839,36 @@ struct sInternalTexture
 
 	size_t pitchlog2;
 
+	// texel layout. linear: tileMask 0, tileShift granularity. 4x4 tiles: 3, granularity + 2
+	size_t tileMask;
+	size_t tileShift;
+
 	video::CSoftwareTexture2* Texture;
 	s32 lodFactor; // magnify/minify
 };
 
+// byte offset of the texel row of fixpoint ty. row and column offset are added
+static REALINLINE size_t texel_row(const sInternalTexture* t, const tFixPointu ty)
+{
+	const size_t y = (ty & t->textureYMask) >> FIX_POINT_PRE;
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+	return ((y & ~t->tileMask) << t->pitchlog2) + ((y & t->tileMask) << (SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY + 2));
+#else
+	return y << t->pitchlog2;
+#endif
+}
+
+// byte offset of the texel column of fixpoint tx inside a row
+static REALINLINE size_t texel_column(const sInternalTexture* t, const tFixPointu tx)
+{
+#if defined(SOFTWARE_DRIVER_2_TEXTURE_TILED)
+	const size_t x = (tx & t->textureXMask) >> FIX_POINT_PRE;
+	return ((x & ~t->tileMask) << t->tileShift) + ((x & t->tileMask) << SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+#else
+	return (tx & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+#endif
+}
+
 
 
 // get video sample plain
@@ -846,8 +876,8 @@ static inline tVideoSample getTexel_plain(const sInternalTexture* t, const tFixP
 {
 	size_t ofs;
 
-	ofs = ((ty & t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-	ofs |= (tx & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(t, ty);
+	ofs += texel_column(t, tx);
 
 	// texel
 	return *((tVideoSample*)((u8*)t->data + ofs));
@@ -860,8 +890,8 @@ inline void getTexel_fix(tFixPoint& r, tFixPoint& g, tFixPoint& b,
 {
 	size_t ofs;
 
-	ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-	ofs |= ((tx + FIX_POINT_ZERO_DOT_FIVE) & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(t, ty + FIX_POINT_ZERO_DOT_FIVE);
+	ofs += texel_column(t, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 	// texel
 	tVideoSample t00;
@@ -880,8 +910,8 @@ inline void getTexel_fix(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
 {
 	size_t ofs;
 
-	ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-	ofs |= ((tx + FIX_POINT_ZERO_DOT_FIVE) & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(t, ty + FIX_POINT_ZERO_DOT_FIVE);
+	ofs += texel_column(t, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 	// texel
 	tVideoSample t00;
@@ -901,8 +931,8 @@ static REALINLINE void getTexel_fix(tFixPoint& a,
 {
 	size_t ofs;
 
-	ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-	ofs |= ((tx + FIX_POINT_ZERO_DOT_FIVE) & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(t, ty + FIX_POINT_ZERO_DOT_FIVE);
+	ofs += texel_column(t, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 	// texel
 	tVideoSample t00;
@@ -912,14 +942,30 @@ static REALINLINE void getTexel_fix(tFixPoint& a,
 }
 #endif
 
+#if defined(SOFTWARE_DRIVER_2_SIMD_SAMPLER)
+// weighted sum of 4 A8R8G8B8 texels (00,10,01,11). lanes b,g,r,a. same integer math as the scalar filter
+static REALINLINE __m128i bilinear_sse2(const tVideoSample* t, const tFixPointu* w)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	// 16 bit lanes b0 b1 g0 g1 r0 r1 a0 a1 of a texel pair
+	const __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(t[0]), _mm_cvtsi32_si128(t[1])), zero);
+	const __m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi8(_mm_cvtsi32_si128(t[2]), _mm_cvtsi32_si128(t[3])), zero);
+
+	// weights <= FIX_POINT_ONE fit into signed 16 bit
+	const __m128i wtop = _mm_shuffle_epi32(_mm_cvtsi32_si128(w[0] | (w[1] << 16)), 0);
+	const __m128i wbottom = _mm_shuffle_epi32(_mm_cvtsi32_si128(w[2] | (w[3] << 16)), 0);
+
+	return _mm_add_epi32(_mm_madd_epi16(top, wtop), _mm_madd_epi16(bottom, wbottom));
+}
+#endif
+
 /*
 	load a sample from internal texture at position tx,ty to fixpoint
 */
-#if defined(SOFTWARE_DRIVER_2_BILINEAR)
-
 #if 0
 // texture2D in fixpoint color range bilinear
-static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint& b,
+static REALINLINE void getSample_texture_bilinear(tFixPoint& r, tFixPoint& g, tFixPoint& b,
 	const sInternalTexture* burning_restrict t, const tFixPointu tx, const tFixPointu ty
 )
 {
@@ -928,8 +974,8 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 	{
 		size_t ofs;
 
-		ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-		ofs += ((tx + FIX_POINT_ZERO_DOT_FIVE) & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+		ofs = texel_row(t, ty + FIX_POINT_ZERO_DOT_FIVE);
+		ofs += texel_column(t, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 		// texel
 		tVideoSample t00;
@@ -951,10 +997,10 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 	tVideoSample t00;
 
 	//wraps positive (ignoring negative)
-	o0 = (((ty)&t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-	o1 = (((ty + FIX_POINT_ONE) & t->textureYMask) >> FIX_POINT_PRE) << t->pitchlog2;
-	o2 = ((tx)&t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
-	o3 = ((tx + FIX_POINT_ONE) & t->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	o0 = texel_row(t, ty);
+	o1 = texel_row(t, ty + FIX_POINT_ONE);
+	o2 = texel_column(t, tx);
+	o3 = texel_column(t, tx + FIX_POINT_ONE);
 
 	t00 = *((tVideoSample*)((u8*)t->data + (o0 + o2)));
 	r00 = (t00 & MASK_R) >> SHIFT_R;
@@ -1007,7 +1053,7 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 #else
 
 // texture2D in fixpoint color range bilinear
-static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint& b,
+static REALINLINE void getSample_texture_bilinear(tFixPoint& r, tFixPoint& g, tFixPoint& b,
 	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
 )
 {
@@ -1016,8 +1062,8 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 	{
 		//nearest neighbor
 		size_t ofs;
-		ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-		ofs += ((tx + FIX_POINT_ZERO_DOT_FIVE) & tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+		ofs = texel_row(tex, ty + FIX_POINT_ZERO_DOT_FIVE);
+		ofs += texel_column(tex, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 		tVideoSample t00;
 		t00 = *((tVideoSample*)((u8*)tex->data + ofs));
@@ -1029,7 +1075,7 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 	}
 #endif
 
-	//w00 w01 w10 w11
+	//w00 w10 w01 w11
 	tFixPointu w[4];
 	{
 		tFixPointu fracx = tx & FIX_POINT_FRACT_MASK;
@@ -1047,10 +1093,10 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 
 		// #if FIX_POINT_PRE > SOFTWARE_DRIVER_2_TEXTURE_MAXSIZE_LOG2 >> FIX_POINT_PRE - tex->pitchlog2
 
-		o0 = (((ty)&tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-		o1 = (((ty + FIX_POINT_ONE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-		o2 = ((tx)&tex->textureXMask) >> (unsigned)(FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
-		o3 = ((tx + FIX_POINT_ONE) & tex->textureXMask) >> (unsigned)(FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+		o0 = texel_row(tex, ty);
+		o1 = texel_row(tex, ty + FIX_POINT_ONE);
+		o2 = texel_column(tex, tx);
+		o3 = texel_column(tex, tx + FIX_POINT_ONE);
 
 		t[0] = *((tVideoSample*)((u8*)tex->data + (o0 + o2)));
 		t[1] = *((tVideoSample*)((u8*)tex->data + (o0 + o3)));
@@ -1058,6 +1104,12 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 		t[3] = *((tVideoSample*)((u8*)tex->data + (o1 + o3)));
 	}
 
+#if defined(SOFTWARE_DRIVER_2_SIMD_SAMPLER)
+	const __m128i sum = bilinear_sse2(t, w);
+	b = _mm_cvtsi128_si32(sum);
+	g = _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+	r = _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+#else
 	r = (((t[0] & MASK_R) >> SHIFT_R) * w[0]) +
 		(((t[1] & MASK_R) >> SHIFT_R) * w[1]) +
 		(((t[2] & MASK_R) >> SHIFT_R) * w[2]) +
@@ -1072,90 +1124,79 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 		((t[1] & MASK_B) * w[1]) +
 		((t[2] & MASK_B) * w[2]) +
 		((t[3] & MASK_B) * w[3]);
+#endif
 }
 
 #endif
 
 // get Sample bilinear
-static REALINLINE void getSample_texture(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
+static REALINLINE void getSample_texture_bilinear(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
 	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
 )
 {
+	//w00 w10 w01 w11
+	tFixPointu w[4];
+	{
+		const tFixPointu txFract = tx & FIX_POINT_FRACT_MASK;
+		const tFixPointu txFractInv = FIX_POINT_ONE - txFract;
 
-	tFixPointu a00, r00, g00, b00;
-	tFixPointu a01, r01, g01, b01;
-	tFixPointu a10, r10, g10, b10;
-	tFixPointu a11, r11, g11, b11;
-
-	size_t o0, o1, o2, o3;
-	tVideoSample t00;
-
-	o0 = (((ty)&tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	o1 = (((ty + FIX_POINT_ONE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	o2 = ((tx)&tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
-	o3 = ((tx + FIX_POINT_ONE) & tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+		const tFixPointu tyFract = ty & FIX_POINT_FRACT_MASK;
+		const tFixPointu tyFractInv = FIX_POINT_ONE - tyFract;
 
-	t00 = *((tVideoSample*)((u8*)tex->data + (o0 + o2)));
-	a00 = (t00 & MASK_A) >> SHIFT_A;
-	r00 = (t00 & MASK_R) >> SHIFT_R;
-	g00 = (t00 & MASK_G) >> SHIFT_G;
-	b00 = (t00 & MASK_B);
+		w[0] = imulFixu(txFractInv, tyFractInv);
+		w[1] = imulFixu(txFract, tyFractInv);
+		w[2] = imulFixu(txFractInv, tyFract);
+		w[3] = imulFixu(txFract, tyFract);
+	}
 
-	t00 = *((tVideoSample*)((u8*)tex->data + (o0 + o3)));
-	a10 = (t00 & MASK_A) >> SHIFT_A;
-	r10 = (t00 & MASK_R) >> SHIFT_R;
-	g10 = (t00 & MASK_G) >> SHIFT_G;
-	b10 = (t00 & MASK_B);
+	tVideoSample t[4];
+	{
+		size_t o0, o1, o2, o3;
 
-	t00 = *((tVideoSample*)((u8*)tex->data + (o1 + o2)));
-	a01 = (t00 & MASK_A) >> SHIFT_A;
-	r01 = (t00 & MASK_R) >> SHIFT_R;
-	g01 = (t00 & MASK_G) >> SHIFT_G;
-	b01 = (t00 & MASK_B);
+		o0 = texel_row(tex, ty);
+		o1 = texel_row(tex, ty + FIX_POINT_ONE);
+		o2 = texel_column(tex, tx);
+		o3 = texel_column(tex, tx + FIX_POINT_ONE);
 
-	t00 = *((tVideoSample*)((u8*)tex->data + (o1 + o3)));
-	a11 = (t00 & MASK_A) >> SHIFT_A;
-	r11 = (t00 & MASK_R) >> SHIFT_R;
-	g11 = (t00 & MASK_G) >> SHIFT_G;
-	b11 = (t00 & MASK_B);
+		t[0] = *((tVideoSample*)((u8*)tex->data + (o0 + o2)));
+		t[1] = *((tVideoSample*)((u8*)tex->data + (o0 + o3)));
+		t[2] = *((tVideoSample*)((u8*)tex->data + (o1 + o2)));
+		t[3] = *((tVideoSample*)((u8*)tex->data + (o1 + o3)));
+	}
 
-	const tFixPointu txFract = tx & FIX_POINT_FRACT_MASK;
-	const tFixPointu txFractInv = FIX_POINT_ONE - txFract;
+#if defined(SOFTWARE_DRIVER_2_SIMD_SAMPLER)
+	const __m128i sum = bilinear_sse2(t, w);
+	b = _mm_cvtsi128_si32(sum);
+	g = _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+	r = _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+	a = _mm_cvtsi128_si32(_mm_srli_si128(sum, 12));
+#else
+	a = (((t[0] & MASK_A) >> SHIFT_A) * w[0]) +
+		(((t[1] & MASK_A) >> SHIFT_A) * w[1]) +
+		(((t[2] & MASK_A) >> SHIFT_A) * w[2]) +
+		(((t[3] & MASK_A) >> SHIFT_A) * w[3]);
 
-	const tFixPointu tyFract = ty & FIX_POINT_FRACT_MASK;
-	const tFixPointu tyFractInv = FIX_POINT_ONE - tyFract;
+	r = (((t[0] & MASK_R) >> SHIFT_R) * w[0]) +
+		(((t[1] & MASK_R) >> SHIFT_R) * w[1]) +
+		(((t[2] & MASK_R) >> SHIFT_R) * w[2]) +
+		(((t[3] & MASK_R) >> SHIFT_R) * w[3]);
 
-	const tFixPointu w00 = imulFixu(txFractInv, tyFractInv);
-	const tFixPointu w10 = imulFixu(txFract, tyFractInv);
-	const tFixPointu w01 = imulFixu(txFractInv, tyFract);
-	const tFixPointu w11 = imulFixu(txFract, tyFract);
+	g = (((t[0] & MASK_G) >> SHIFT_G) * w[0]) +
+		(((t[1] & MASK_G) >> SHIFT_G) * w[1]) +
+		(((t[2] & MASK_G) >> SHIFT_G) * w[2]) +
+		(((t[3] & MASK_G) >> SHIFT_G) * w[3]);
 
-	a = (a00 * w00) +
-		(a01 * w01) +
-		(a10 * w10) +
-		(a11 * w11);
+	b = ((t[0] & MASK_B) * w[0]) +
+		((t[1] & MASK_B) * w[1]) +
+		((t[2] & MASK_B) * w[2]) +
+		((t[3] & MASK_B) * w[3]);
+#endif
 
 	fix_alpha_color_max(a);
-
-	r = (r00 * w00) +
-		(r01 * w01) +
-		(r10 * w10) +
-		(r11 * w11);
-
-	g = (g00 * w00) +
-		(g01 * w01) +
-		(g10 * w10) +
-		(g11 * w11);
-
-	b = (b00 * w00) +
-		(b01 * w01) +
-		(b10 * w10) +
-		(b11 * w11);
-
 }
 
 // get Sample bilinear
-static REALINLINE void getSample_texture(tFixPoint& a,
+static REALINLINE void getSample_texture_bilinear(tFixPoint& a,
 	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
 )
 {
@@ -1168,10 +1209,10 @@ static REALINLINE void getSample_texture(tFixPoint& a,
 	size_t o0, o1, o2, o3;
 	tVideoSample t00;
 
-	o0 = (((ty)&tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	o1 = (((ty + FIX_POINT_ONE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	o2 = ((tx)&tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
-	o3 = ((tx + FIX_POINT_ONE) & tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	o0 = texel_row(tex, ty);
+	o1 = texel_row(tex, ty + FIX_POINT_ONE);
+	o2 = texel_column(tex, tx);
+	o3 = texel_column(tex, tx + FIX_POINT_ONE);
 
 	t00 = *((tVideoSample*)((u8*)tex->data + (o0 + o2)));
 	a00 = (t00 & MASK_A) >> SHIFT_A;
@@ -1205,17 +1246,15 @@ static REALINLINE void getSample_texture(tFixPoint& a,
 
 }
 
-#else // SOFTWARE_DRIVER_2_BILINEAR
-
 // get Sample linear == getSample_fixpoint
 
-static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint& b,
+static REALINLINE void getSample_texture_nearest(tFixPoint& r, tFixPoint& g, tFixPoint& b,
 	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
 )
 {
 	size_t ofs;
-	ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	ofs += ((tx + FIX_POINT_ZERO_DOT_FIVE) & tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(tex, ty + FIX_POINT_ZERO_DOT_FIVE);
+	ofs += texel_column(tex, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 	// texel
 	const tVideoSample t00 = *((tVideoSample*)((u8*)tex->data + ofs));
@@ -1225,13 +1264,13 @@ static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint&
 	(tFixPointu&)b = (t00 & MASK_B) << (FIX_POINT_PRE - SHIFT_B);
 }
 
-static REALINLINE void getSample_texture(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
+static REALINLINE void getSample_texture_nearest(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
 	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
 )
 {
 	size_t ofs;
-	ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	ofs += ((tx + FIX_POINT_ZERO_DOT_FIVE) & tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(tex, ty + FIX_POINT_ZERO_DOT_FIVE);
+	ofs += texel_column(tex, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 	// texel
 	const tVideoSample t00 = *((tVideoSample*)((u8*)tex->data + ofs));
@@ -1244,14 +1283,14 @@ static REALINLINE void getSample_texture(tFixPoint& a, tFixPoint& r, tFixPoint&
 }
 
 
-// get Sample bilinear
-static REALINLINE void getSample_texture(tFixPoint& a,
+// get Sample nearest
+static REALINLINE void getSample_texture_nearest(tFixPoint& a,
 	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
 )
 {
 	size_t ofs;
-	ofs = (((ty + FIX_POINT_ZERO_DOT_FIVE) & tex->textureYMask) >> FIX_POINT_PRE) << tex->pitchlog2;
-	ofs += ((tx + FIX_POINT_ZERO_DOT_FIVE) & tex->textureXMask) >> (FIX_POINT_PRE - SOFTWARE_DRIVER_2_TEXTURE_GRANULARITY);
+	ofs = texel_row(tex, ty + FIX_POINT_ZERO_DOT_FIVE);
+	ofs += texel_column(tex, tx + FIX_POINT_ZERO_DOT_FIVE);
 
 	// texel
 	const tVideoSample t00 = *((tVideoSample*)((u8*)tex->data + ofs));
@@ -1260,7 +1299,59 @@ static REALINLINE void getSample_texture(tFixPoint& a,
 	fix_alpha_color_max(a);
 }
 
-#endif // SOFTWARE_DRIVER_2_BILINEAR
+// sampler with the compile time default filter
+static REALINLINE void getSample_texture(tFixPoint& r, tFixPoint& g, tFixPoint& b,
+	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
+)
+{
+#if defined(SOFTWARE_DRIVER_2_BILINEAR)
+	getSample_texture_bilinear(r, g, b, tex, tx, ty);
+#else
+	getSample_texture_nearest(r, g, b, tex, tx, ty);
+#endif
+}
+
+static REALINLINE void getSample_texture(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
+	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
+)
+{
+#if defined(SOFTWARE_DRIVER_2_BILINEAR)
+	getSample_texture_bilinear(a, r, g, b, tex, tx, ty);
+#else
+	getSample_texture_nearest(a, r, g, b, tex, tx, ty);
+#endif
+}
+
+static REALINLINE void getSample_texture(tFixPoint& a,
+	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
+)
+{
+#if defined(SOFTWARE_DRIVER_2_BILINEAR)
+	getSample_texture_bilinear(a, tex, tx, ty);
+#else
+	getSample_texture_nearest(a, tex, tx, ty);
+#endif
+}
+
+// sampler of a fragment variant. the filter is resolved at compile time
+template <int bilinear>
+static REALINLINE void getSample_texture_f(tFixPoint& r, tFixPoint& g, tFixPoint& b,
+	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
+)
+{
+	if (bilinear) getSample_texture_bilinear(r, g, b, tex, tx, ty);
+	else getSample_texture_nearest(r, g, b, tex, tx, ty);
+}
+
+template <int bilinear>
+static REALINLINE void getSample_texture_f(tFixPoint& a, tFixPoint& r, tFixPoint& g, tFixPoint& b,
+	const sInternalTexture* burning_restrict tex, const tFixPointu tx, const tFixPointu ty
+)
+{
+	if (bilinear) getSample_texture_bilinear(a, r, g, b, tex, tx, ty);
+	else getSample_texture_nearest(a, r, g, b, tex, tx, ty);
+}
+
 
 
 // 2D Region closed [x0;x1]
@@ -49,12 +49,17 @@ void burning_shader_class::OnSetMaterialBurning(const SBurningShaderMaterial& ma
 		break;
 	}
 
+	// w compare is >=. ECFN_EQUAL shades a depth prepass
+	const bool depth_less_equal = material.org.ZBuffer == ECFN_LESSEQUAL || material.org.ZBuffer == ECFN_EQUAL;
+
 	if (0 == RenderPass_ShaderIsTransparent)
 	{
-		if (material.org.ZBuffer == ECFN_LESSEQUAL)
+		if (depth_less_equal)
 		{
 			if (material.org.ColorMask == ECP_NONE)
-				fragmentShader = &burning_shader_class::fragment_depth_less_equal_no_depth_write_colormask_none;
+				fragmentShader = material.depth_write ?
+					&burning_shader_class::fragment_depth_less_equal_depth_write_colormask_none :
+					&burning_shader_class::fragment_depth_less_equal_no_depth_write_colormask_none;
 			else if (material.depth_write) fragmentShader = &burning_shader_class::fragment_depth_less_equal_depth_write_blend_one_zero;
 			else fragmentShader = &burning_shader_class::fragment_depth_less_equal_no_depth_write_blend_one_zero;
 		}
@@ -70,7 +75,7 @@ void burning_shader_class::OnSetMaterialBurning(const SBurningShaderMaterial& ma
 	}
 	else
 	{
-		if (material.org.ZBuffer == ECFN_LESSEQUAL)
+		if (depth_less_equal)
 		{
 			if (material.depth_write) fragmentShader = &burning_shader_class::fragment_depth_less_equal_depth_write_blend_src_alpha_one_minus_src_alpha;
 			else fragmentShader = &burning_shader_class::fragment_depth_less_equal_no_depth_write_blend_src_alpha_one_minus_src_alpha;
@@ -86,6 +91,12 @@ void burning_shader_class::OnSetMaterialBurning(const SBurningShaderMaterial& ma
 		}
 	}
 
+	HiZ_Reject = depth_less_equal;
+	HiZ_Write = fragmentShader == &burning_shader_class::fragment_depth_less_equal_depth_write_blend_one_zero ||
+		fragmentShader == &burning_shader_class::fragment_depth_less_equal_depth_write_colormask_none ||
+		fragmentShader == &burning_shader_class::fragment_depth_less_equal_depth_write_blend_src_alpha_one_minus_src_alpha;
+
+	setTriangleShader();
 }
 
 
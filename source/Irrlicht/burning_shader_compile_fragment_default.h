@@ -9,6 +9,7 @@ public:
 
 	//! draws an indexed triangle list
 	virtual void drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c) IRR_OVERRIDE;
+	virtual void drawTriangles(s4DVertex* v, const sRasterTriangle* t, const u32 count) IRR_OVERRIDE;
 	virtual bool canWireFrame() IRR_OVERRIDE { return true; }
 
 	virtual void OnSetMaterialBurning(const SBurningShaderMaterial& material) IRR_OVERRIDE;
@@ -28,9 +29,21 @@ private:
 	void fragment_nodepth_noperspective_blend_src_alpha_one_minus_src_alpha();
 
 	void fragment_depth_less_equal_no_depth_write_colormask_none();
+	void fragment_depth_less_equal_depth_write_colormask_none();
 
 	tFragmentShader fragmentShader;
 
+	// scanline conversion specialized for each fragment shader
+	typedef void (burning_shader_class::*tTriangleShader) (const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c);
+	typedef void (burning_shader_class::*tTriangleBatch) (s4DVertex* v, const sRasterTriangle* t, const u32 count);
+	template <tFragmentShader fragment>
+	void drawTriangle_t(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c);
+
+	//! select triangleShader,triangleBatch matching fragmentShader
+	void setTriangleShader();
+	tTriangleShader triangleShader;
+	tTriangleBatch triangleBatch;
+
 };
 
 
@@ -43,6 +56,7 @@ burning_shader_class::burning_shader_class(CBurningVideoDriver* driver)
 #endif
 
 	fragmentShader = &burning_shader_class::fragment_depth_less_equal_depth_write_blend_one_zero;
+	setTriangleShader();
 
 }
 
@@ -174,3 +188,51 @@ IBurningShader* burning_create(burning_shader_class)(CBurningVideoDriver* driver
 #include "burning_shader_compile_fragment_start.h"
 #include burning_shader_frag
 #include "burning_shader_compile_fragment_end.h"
+
+//depth prepass. same w interpolation as the shading pass
+#include "burning_shader_compile_start.h"
+#define burning_shader_fragment fragment_depth_less_equal_depth_write_colormask_none
+#define SUBTEXEL
+#define IPOL_W
+#define USE_ZBUFFER
+#define CMP_W
+#define WRITE_W
+#define burning_shader_colormask
+#include "burning_shader_compile_fragment_start.h"
+#include burning_shader_frag
+#include "burning_shader_compile_fragment_end.h"
+
+
+//! one instance of the triangle setup and span loop per fragment shader
+#define burning_shader_select(fragment) \
+	if (fragmentShader == &burning_shader_class::fragment) \
+	{ \
+		triangleShader = &burning_shader_class::drawTriangle_t<&burning_shader_class::fragment>; \
+		triangleBatch = &burning_shader_class::drawTriangles_t<burning_shader_class, &burning_shader_class::drawTriangle_t<&burning_shader_class::fragment> >; \
+		return; \
+	}
+
+void burning_shader_class::setTriangleShader()
+{
+	burning_shader_select(fragment_depth_less_equal_depth_write_blend_one_zero);
+	burning_shader_select(fragment_depth_less_equal_no_depth_write_blend_one_zero);
+	burning_shader_select(fragment_nodepth_perspective_blend_one_zero);
+	burning_shader_select(fragment_nodepth_noperspective_blend_one_zero);
+	burning_shader_select(fragment_depth_less_equal_depth_write_blend_src_alpha_one_minus_src_alpha);
+	burning_shader_select(fragment_depth_less_equal_no_depth_write_blend_src_alpha_one_minus_src_alpha);
+	burning_shader_select(fragment_nodepth_perspective_blend_src_alpha_one_minus_src_alpha);
+	burning_shader_select(fragment_nodepth_noperspective_blend_src_alpha_one_minus_src_alpha);
+	burning_shader_select(fragment_depth_less_equal_no_depth_write_colormask_none);
+	burning_shader_select(fragment_depth_less_equal_depth_write_colormask_none);
+}
+#undef burning_shader_select
+
+void burning_shader_class::drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c)
+{
+	(this->*triangleShader)(a, b, c);
+}
+
+void burning_shader_class::drawTriangles(s4DVertex* v, const sRasterTriangle* t, const u32 count)
+{
+	(this->*triangleBatch)(v, t, count);
+}
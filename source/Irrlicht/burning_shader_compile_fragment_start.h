@@ -2,7 +2,7 @@
 
 /*!
 */
-void burning_shader_class::burning_shader_fragment()
+REALINLINE void burning_shader_class::burning_shader_fragment()
 {
 #ifdef burning_shader_colormask
 #else
@@ -42,6 +42,11 @@ void burning_shader_class::burning_shader_fragment()
 	if (dx < 0)
 		return;
 
+#ifdef CMP_W
+	if (hiz_reject_span(xStart, xEnd))
+		return;
+#endif
+
 	// slopes
 	const f32 invDeltaX = fill_step_x(line.x[1] - line.x[0]);
 
@@ -1,7 +1,8 @@
 #include "burning_shader_compile_verify.h"
 
 
-void burning_shader_class::drawTriangle(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c)
+template <burning_shader_class::tFragmentShader fragment>
+void burning_shader_class::drawTriangle_t(const s4DVertex* burning_restrict a, const s4DVertex* burning_restrict b, const s4DVertex* burning_restrict c)
 {
 	// sort on height, y
 	if (a->Pos.y > b->Pos.y) swapVertexPointer(&a, &b);
@@ -194,7 +195,7 @@ void burning_shader_class::drawTriangle(const s4DVertex* burning_restrict a, con
 
 			// render a scanline
 			if_interlace_scanline
-			(this->*fragmentShader) ();
+			(this->*fragment) ();
 			if (EdgeTestPass & edge_test_first_line) break;
 
 			scan.x[0] += scan.slopeX[0];
@@ -378,7 +379,7 @@ void burning_shader_class::drawTriangle(const s4DVertex* burning_restrict a, con
 
 			// render a scanline
 			if_interlace_scanline
-			(this->*fragmentShader) ();
+			(this->*fragment) ();
 			if (EdgeTestPass & edge_test_first_line) break;
 
 			scan.x[0] += scan.slopeX[0];
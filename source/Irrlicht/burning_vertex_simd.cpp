@@ -0,0 +1,406 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt / Thomas Alten
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#include "IrrCompileConfig.h"
+#include "burning_vertex_simd.h"
+
+#ifdef _IRR_COMPILE_WITH_BURNINGSVIDEO_
+
+#include "S3DVertex.h"
+#include "IVideoDriver.h"
+#include <math.h>
+
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX)
+	#include <emmintrin.h>
+	#if defined(_MSC_VER) && _MSC_VER >= 1600
+		#include <intrin.h>
+		#include <immintrin.h>
+		#define BURNING_SIMD_COMPILE_AVX
+		#define burning_target_avx
+	#elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ * 100 + __GNUC_MINOR__) >= 409)
+		#include <cpuid.h>
+		#include <immintrin.h>
+		#define BURNING_SIMD_COMPILE_AVX
+		#define burning_target_avx __attribute__((target("avx")))
+	#elif defined(__GNUC__)
+		#include <cpuid.h>
+	#endif
+#endif
+
+namespace irr
+{
+
+namespace video
+{
+
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX)
+
+//! cpuid leaf. reg: eax,ebx,ecx,edx
+static void burning_cpuid(u32 leaf, u32 reg[4])
+{
+#if defined(_MSC_VER)
+	int r[4];
+	__cpuid(r, (int)leaf);
+	reg[0] = r[0]; reg[1] = r[1]; reg[2] = r[2]; reg[3] = r[3];
+#else
+	if (!__get_cpuid(leaf, &reg[0], &reg[1], &reg[2], &reg[3]))
+		reg[0] = reg[1] = reg[2] = reg[3] = 0;
+#endif
+}
+
+#if defined(BURNING_SIMD_COMPILE_AVX)
+//! extended control register 0. register state saved by the os
+static u32 burning_xgetbv0()
+{
+#if defined(_MSC_VER)
+	return (u32)_xgetbv(0);
+#else
+	u32 lo, hi;
+	__asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0)); // xgetbv
+	return lo;
+#endif
+}
+#endif
+
+#endif // SOFTWARE_DRIVER_2_SIMD_VERTEX
+
+
+e_burning_simd burning_simd_detect()
+{
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX)
+	u32 reg[4];
+	burning_cpuid(0, reg);
+	if (reg[0] < 1)
+		return BURNING_SIMD_NONE;
+
+	burning_cpuid(1, reg);
+	if (!(reg[3] & (1 << 26))) // sse2
+		return BURNING_SIMD_NONE;
+
+#if defined(BURNING_SIMD_COMPILE_AVX)
+	// avx, osxsave and os saves xmm,ymm
+	if ((reg[2] & (1 << 28)) && (reg[2] & (1 << 27)) && (burning_xgetbv0() & 6) == 6)
+		return BURNING_SIMD_AVX;
+#endif
+	return BURNING_SIMD_SSE2;
+#else
+	return BURNING_SIMD_NONE;
+#endif
+}
+
+
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX)
+
+// source attributes of a batch in SoA form. lanes up to a multiple of 8 are zero
+struct sVertexBatchSource
+{
+	f32 px[VERTEXCACHE_ELEMENT];
+	f32 py[VERTEXCACHE_ELEMENT];
+	f32 pz[VERTEXCACHE_ELEMENT];
+};
+
+/*
+	Operation order and rounding are the same as in CMatrix4::transformVect,
+	clipToFrustumTest and the scalar fog/texture code in VertexCache_fill.
+	No fused multiply-add, so every lane is bit identical to the scalar path.
+*/
+
+static void burning_vertex_batch_sse2(sVertexBatch& out, const sVertexBatchSetup& setup,
+	const sVertexBatchSource& in, const u32 count)
+{
+	const __m128 sign = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+
+	__m128 mvp[16];
+	__m128 mv[16];
+	const f32* M = setup.modelViewProj;
+	for (u32 k = 0; k != 16; ++k)
+	{
+		mvp[k] = _mm_set1_ps(M[k]);
+		mv[k] = setup.modelView ? _mm_set1_ps(setup.modelView[k]) : zero;
+	}
+	const __m128 wScale = _mm_set1_ps(setup.wScale);
+	const __m128 fogEnd = _mm_set1_ps(setup.fogEnd);
+	const __m128 fogScale = _mm_set1_ps(setup.fogScale);
+
+	const __m128i clipNear = _mm_set1_epi32(VERTEX4D_CLIP_NEAR);
+	const __m128i clipFar = _mm_set1_epi32(VERTEX4D_CLIP_FAR);
+	const __m128i clipLeft = _mm_set1_epi32(VERTEX4D_CLIP_LEFT);
+	const __m128i clipRight = _mm_set1_epi32(VERTEX4D_CLIP_RIGHT);
+	const __m128i clipBottom = _mm_set1_epi32(VERTEX4D_CLIP_BOTTOM);
+	const __m128i clipTop = _mm_set1_epi32(VERTEX4D_CLIP_TOP);
+
+	for (u32 i = 0; i < count; i += 4)
+	{
+		const __m128 px = _mm_loadu_ps(in.px + i);
+		const __m128 py = _mm_loadu_ps(in.py + i);
+		const __m128 pz = _mm_loadu_ps(in.pz + i);
+
+		// transform Model * World * Camera * Projection * NDCSpace matrix
+		const __m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mvp[0]), _mm_mul_ps(py, mvp[4])), _mm_mul_ps(pz, mvp[8])), mvp[12]);
+		const __m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mvp[1]), _mm_mul_ps(py, mvp[5])), _mm_mul_ps(pz, mvp[9])), mvp[13]);
+		const __m128 z = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mvp[2]), _mm_mul_ps(py, mvp[6])), _mm_mul_ps(pz, mvp[10])), mvp[14]);
+		__m128 w = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mvp[3]), _mm_mul_ps(py, mvp[7])), _mm_mul_ps(pz, mvp[11])), mvp[15]);
+		w = _mm_mul_ps(w, wScale);
+
+		_mm_storeu_ps(out.x + i, x);
+		_mm_storeu_ps(out.y + i, y);
+		_mm_storeu_ps(out.z + i, z);
+		_mm_storeu_ps(out.w + i, w);
+
+		// clip codes. bit set if inside
+		__m128i c;
+		c = _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(z, w)), clipNear);
+		c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(_mm_xor_ps(z, sign), w)), clipFar));
+		c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(x, w)), clipLeft));
+		c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(_mm_xor_ps(x, sign), w)), clipRight));
+		c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(y, w)), clipBottom));
+		c = _mm_or_si128(c, _mm_and_si128(_mm_castps_si128(_mm_cmple_ps(_mm_xor_ps(y, sign), w)), clipTop));
+		_mm_storeu_si128((__m128i*)(out.clip + i), c);
+
+		if (!setup.modelView)
+			continue;
+
+		// eye coordinate position of vertex
+		const __m128 vx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mv[0]), _mm_mul_ps(py, mv[4])), _mm_mul_ps(pz, mv[8])), mv[12]);
+		const __m128 vy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mv[1]), _mm_mul_ps(py, mv[5])), _mm_mul_ps(pz, mv[9])), mv[13]);
+		const __m128 vz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mv[2]), _mm_mul_ps(py, mv[6])), _mm_mul_ps(pz, mv[10])), mv[14]);
+		const __m128 vw = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, mv[3]), _mm_mul_ps(py, mv[7])), _mm_mul_ps(pz, mv[11])), mv[15]);
+
+		// reciprocal_zero_pos_underflow
+		const __m128 iw = _mm_andnot_ps(_mm_cmpeq_ps(vw, zero), _mm_div_ps(one, vw));
+		const __m128 ez = _mm_mul_ps(vz, iw);
+		_mm_storeu_ps(out.ex + i, _mm_mul_ps(vx, iw));
+		_mm_storeu_ps(out.ey + i, _mm_mul_ps(vy, iw));
+		_mm_storeu_ps(out.ez + i, ez);
+		_mm_storeu_ps(out.ew + i, iw);
+
+		if (setup.fog)
+		{
+			// GL_FRAGMENT_DEPTH -> abs(EyeSpace.vertex.z)
+			const __m128 fz = _mm_andnot_ps(sign, ez);
+			_mm_storeu_ps(out.fog + i, setup.fogType == EFT_FOG_LINEAR ? _mm_mul_ps(_mm_sub_ps(fogEnd, fz), fogScale) : fz);
+		}
+	}
+
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+	for (u32 m = 0; m != BURNING_MATERIAL_MAX_TEXTURES; ++m)
+	{
+		if (!(out.texMask & (1 << m)))
+			continue;
+
+		const f32* T = setup.texMatrix[m];
+		const __m128 t0 = _mm_set1_ps(T[0]);
+		const __m128 t1 = _mm_set1_ps(T[1]);
+		const __m128 t4 = _mm_set1_ps(T[4]);
+		const __m128 t5 = _mm_set1_ps(T[5]);
+		const __m128 t8 = _mm_set1_ps(T[8]);
+		const __m128 t9 = _mm_set1_ps(T[9]);
+		for (u32 i = 0; i < count; i += 4)
+		{
+			const __m128 u = _mm_loadu_ps(out.tu[m] + i);
+			const __m128 v = _mm_loadu_ps(out.tv[m] + i);
+			_mm_storeu_ps(out.tu[m] + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(t0, u), _mm_mul_ps(t4, v)), t8));
+			_mm_storeu_ps(out.tv[m] + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(t1, u), _mm_mul_ps(t5, v)), t9));
+		}
+	}
+#endif
+}
+
+
+#if defined(BURNING_SIMD_COMPILE_AVX)
+burning_target_avx
+static void burning_vertex_batch_avx(sVertexBatch& out, const sVertexBatchSetup& setup,
+	const sVertexBatchSource& in, const u32 count)
+{
+	const __m256 sign = _mm256_castsi256_ps(_mm256_set1_epi32(0x80000000));
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+
+	__m256 mvp[16];
+	__m256 mv[16];
+	const f32* M = setup.modelViewProj;
+	for (u32 k = 0; k != 16; ++k)
+	{
+		mvp[k] = _mm256_set1_ps(M[k]);
+		mv[k] = setup.modelView ? _mm256_set1_ps(setup.modelView[k]) : zero;
+	}
+	const __m256 wScale = _mm256_set1_ps(setup.wScale);
+	const __m256 fogEnd = _mm256_set1_ps(setup.fogEnd);
+	const __m256 fogScale = _mm256_set1_ps(setup.fogScale);
+
+	// no 256 bit integer ops without avx2. combine the bits as float masks
+	const __m256 clipNear = _mm256_castsi256_ps(_mm256_set1_epi32(VERTEX4D_CLIP_NEAR));
+	const __m256 clipFar = _mm256_castsi256_ps(_mm256_set1_epi32(VERTEX4D_CLIP_FAR));
+	const __m256 clipLeft = _mm256_castsi256_ps(_mm256_set1_epi32(VERTEX4D_CLIP_LEFT));
+	const __m256 clipRight = _mm256_castsi256_ps(_mm256_set1_epi32(VERTEX4D_CLIP_RIGHT));
+	const __m256 clipBottom = _mm256_castsi256_ps(_mm256_set1_epi32(VERTEX4D_CLIP_BOTTOM));
+	const __m256 clipTop = _mm256_castsi256_ps(_mm256_set1_epi32(VERTEX4D_CLIP_TOP));
+
+	for (u32 i = 0; i < count; i += 8)
+	{
+		const __m256 px = _mm256_loadu_ps(in.px + i);
+		const __m256 py = _mm256_loadu_ps(in.py + i);
+		const __m256 pz = _mm256_loadu_ps(in.pz + i);
+
+		// transform Model * World * Camera * Projection * NDCSpace matrix
+		const __m256 x = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mvp[0]), _mm256_mul_ps(py, mvp[4])), _mm256_mul_ps(pz, mvp[8])), mvp[12]);
+		const __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mvp[1]), _mm256_mul_ps(py, mvp[5])), _mm256_mul_ps(pz, mvp[9])), mvp[13]);
+		const __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mvp[2]), _mm256_mul_ps(py, mvp[6])), _mm256_mul_ps(pz, mvp[10])), mvp[14]);
+		__m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mvp[3]), _mm256_mul_ps(py, mvp[7])), _mm256_mul_ps(pz, mvp[11])), mvp[15]);
+		w = _mm256_mul_ps(w, wScale);
+
+		_mm256_storeu_ps(out.x + i, x);
+		_mm256_storeu_ps(out.y + i, y);
+		_mm256_storeu_ps(out.z + i, z);
+		_mm256_storeu_ps(out.w + i, w);
+
+		// clip codes. bit set if inside
+		__m256 c;
+		c = _mm256_and_ps(_mm256_cmp_ps(z, w, _CMP_LE_OS), clipNear);
+		c = _mm256_or_ps(c, _mm256_and_ps(_mm256_cmp_ps(_mm256_xor_ps(z, sign), w, _CMP_LE_OS), clipFar));
+		c = _mm256_or_ps(c, _mm256_and_ps(_mm256_cmp_ps(x, w, _CMP_LE_OS), clipLeft));
+		c = _mm256_or_ps(c, _mm256_and_ps(_mm256_cmp_ps(_mm256_xor_ps(x, sign), w, _CMP_LE_OS), clipRight));
+		c = _mm256_or_ps(c, _mm256_and_ps(_mm256_cmp_ps(y, w, _CMP_LE_OS), clipBottom));
+		c = _mm256_or_ps(c, _mm256_and_ps(_mm256_cmp_ps(_mm256_xor_ps(y, sign), w, _CMP_LE_OS), clipTop));
+		_mm256_storeu_ps((f32*)(out.clip + i), c);
+
+		if (!setup.modelView)
+			continue;
+
+		// eye coordinate position of vertex
+		const __m256 vx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mv[0]), _mm256_mul_ps(py, mv[4])), _mm256_mul_ps(pz, mv[8])), mv[12]);
+		const __m256 vy = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mv[1]), _mm256_mul_ps(py, mv[5])), _mm256_mul_ps(pz, mv[9])), mv[13]);
+		const __m256 vz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mv[2]), _mm256_mul_ps(py, mv[6])), _mm256_mul_ps(pz, mv[10])), mv[14]);
+		const __m256 vw = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, mv[3]), _mm256_mul_ps(py, mv[7])), _mm256_mul_ps(pz, mv[11])), mv[15]);
+
+		// reciprocal_zero_pos_underflow
+		const __m256 iw = _mm256_andnot_ps(_mm256_cmp_ps(vw, zero, _CMP_EQ_OQ), _mm256_div_ps(one, vw));
+		const __m256 ez = _mm256_mul_ps(vz, iw);
+		_mm256_storeu_ps(out.ex + i, _mm256_mul_ps(vx, iw));
+		_mm256_storeu_ps(out.ey + i, _mm256_mul_ps(vy, iw));
+		_mm256_storeu_ps(out.ez + i, ez);
+		_mm256_storeu_ps(out.ew + i, iw);
+
+		if (setup.fog)
+		{
+			// GL_FRAGMENT_DEPTH -> abs(EyeSpace.vertex.z)
+			const __m256 fz = _mm256_andnot_ps(sign, ez);
+			_mm256_storeu_ps(out.fog + i, setup.fogType == EFT_FOG_LINEAR ? _mm256_mul_ps(_mm256_sub_ps(fogEnd, fz), fogScale) : fz);
+		}
+	}
+
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+	for (u32 m = 0; m != BURNING_MATERIAL_MAX_TEXTURES; ++m)
+	{
+		if (!(out.texMask & (1 << m)))
+			continue;
+
+		const f32* T = setup.texMatrix[m];
+		const __m256 t0 = _mm256_set1_ps(T[0]);
+		const __m256 t1 = _mm256_set1_ps(T[1]);
+		const __m256 t4 = _mm256_set1_ps(T[4]);
+		const __m256 t5 = _mm256_set1_ps(T[5]);
+		const __m256 t8 = _mm256_set1_ps(T[8]);
+		const __m256 t9 = _mm256_set1_ps(T[9]);
+		for (u32 i = 0; i < count; i += 8)
+		{
+			const __m256 u = _mm256_loadu_ps(out.tu[m] + i);
+			const __m256 v = _mm256_loadu_ps(out.tv[m] + i);
+			_mm256_storeu_ps(out.tu[m] + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(t0, u), _mm256_mul_ps(t4, v)), t8));
+			_mm256_storeu_ps(out.tv[m] + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(t1, u), _mm256_mul_ps(t5, v)), t9));
+		}
+	}
+#endif
+
+	_mm256_zeroupper();
+}
+#endif // BURNING_SIMD_COMPILE_AVX
+
+#endif // SOFTWARE_DRIVER_2_SIMD_VERTEX
+
+
+void burning_vertex_batch(sVertexBatch& out, const sVertexBatchSetup& setup,
+	const u32* sourceIndex, const u32 count, const e_burning_simd simd)
+{
+#if defined(SOFTWARE_DRIVER_2_SIMD_VERTEX)
+	// gather positions and texture coordinates to SoA. pad to 8 lanes
+	sVertexBatchSource in;
+	const u32 padded = core::min_((count + 7) & ~7u, (u32)VERTEXCACHE_ELEMENT);
+
+	out.eye = setup.modelView ? 1 : 0;
+	out.fogValid = setup.modelView && setup.fog ? 1 : 0;
+	out.texMask = 0;
+
+	u32 i;
+	for (i = 0; i != count; ++i)
+	{
+		const f32* p = (const f32*)(setup.vertices + sourceIndex[i] * setup.pitch);
+		in.px[i] = p[0];
+		in.py[i] = p[1];
+		in.pz[i] = p[2];
+	}
+	for (; i != padded; ++i)
+	{
+		in.px[i] = 0.f;
+		in.py[i] = 0.f;
+		in.pz[i] = 0.f;
+	}
+
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+	for (u32 m = 0; m != BURNING_MATERIAL_MAX_TEXTURES; ++m)
+	{
+		if (!setup.texMatrix[m])
+			continue;
+		out.texMask |= 1 << m;
+
+		for (i = 0; i != count; ++i)
+		{
+			if (m < setup.texCooSize)
+			{
+				// Irrlicht TCoords and TCoords2 must be contiguous memory
+				const S3DVertex* base = (const S3DVertex*)(setup.vertices + sourceIndex[i] * setup.pitch);
+				const sVec2Pack* baseTCoord = (const sVec2Pack*)&base->TCoords.X;
+				out.tu[m][i] = baseTCoord[m].x;
+				out.tv[m][i] = baseTCoord[m].y;
+			}
+			else
+			{
+				out.tu[m][i] = 0.f;
+				out.tv[m][i] = 0.f;
+			}
+		}
+		for (; i != padded; ++i)
+		{
+			out.tu[m][i] = 0.f;
+			out.tv[m][i] = 0.f;
+		}
+	}
+#endif
+
+#if defined(BURNING_SIMD_COMPILE_AVX)
+	if (simd == BURNING_SIMD_AVX)
+		burning_vertex_batch_avx(out, setup, in, padded);
+	else
+#endif
+		burning_vertex_batch_sse2(out, setup, in, padded);
+
+	// exponential fog stays scalar
+	if (out.fogValid && setup.fogType != EFT_FOG_LINEAR)
+	{
+		const f32 d = setup.fogDensity;
+		for (i = 0; i != count; ++i)
+		{
+			const f32 f = out.fog[i];
+			out.fog[i] = setup.fogType == EFT_FOG_EXP2 ? (f32)exp(-d * d * f * f) : (f32)exp(-d * f);
+		}
+	}
+#endif
+}
+
+} // end namespace video
+} // end namespace irr
+
+#endif // _IRR_COMPILE_WITH_BURNINGSVIDEO_
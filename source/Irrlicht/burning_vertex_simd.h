@@ -0,0 +1,89 @@
+// Copyright (C) 2002-2012 Nikolaus Gebhardt / Thomas Alten
+// This file is part of the "Irrlicht Engine".
+// For conditions of distribution and use, see copyright notice in irrlicht.h
+
+#ifndef S_VIDEO_2_BURNING_VERTEX_SIMD_H_INCLUDED
+#define S_VIDEO_2_BURNING_VERTEX_SIMD_H_INCLUDED
+
+#include "SoftwareDriver2_compile_config.h"
+#include "S4DVertex.h"
+
+namespace irr
+{
+
+namespace video
+{
+
+//! instruction set used by the vertex batch transform. picked at runtime
+enum e_burning_simd
+{
+	BURNING_SIMD_NONE = 0,
+	BURNING_SIMD_SSE2,
+	BURNING_SIMD_AVX
+};
+
+//! best compiled in instruction set supported by cpu and operating system
+e_burning_simd burning_simd_detect();
+
+//! fixed function state of a vertex batch
+struct sVertexBatchSetup
+{
+	const u8* vertices;		// source vertices, position at offset 0
+	u32 pitch;				// sizeof source vertex
+
+	const f32* modelViewProj;
+	f32 wScale;				// clip space w scale (shadow volume offset)
+
+	const f32* modelView;	// eye space position. 0 if not needed
+
+	u32 fog;				// fog factor. needs modelView
+	u32 fogType;			// E_FOG_TYPE
+	f32 fogEnd;
+	f32 fogScale;			// 1 / (end - start)
+	f32 fogDensity;
+
+	u32 texCooSize;			// amount of source texture coordinates
+	const f32* texMatrix[BURNING_MATERIAL_MAX_TEXTURES]; // texture matrix of stage. 0 if not done in batch
+};
+
+//! transformed vertices of a cache line in SoA form
+struct sVertexBatch
+{
+	// clip space position
+	f32 x[VERTEXCACHE_ELEMENT];
+	f32 y[VERTEXCACHE_ELEMENT];
+	f32 z[VERTEXCACHE_ELEMENT];
+	f32 w[VERTEXCACHE_ELEMENT];
+
+	// eye space position divided by w, ew = 1/w
+	f32 ex[VERTEXCACHE_ELEMENT];
+	f32 ey[VERTEXCACHE_ELEMENT];
+	f32 ez[VERTEXCACHE_ELEMENT];
+	f32 ew[VERTEXCACHE_ELEMENT];
+
+	// unclamped fog factor
+	f32 fog[VERTEXCACHE_ELEMENT];
+
+#if BURNING_MATERIAL_MAX_TEXTURES > 0
+	// texture matrix applied, not wrapped
+	f32 tu[BURNING_MATERIAL_MAX_TEXTURES][VERTEXCACHE_ELEMENT];
+	f32 tv[BURNING_MATERIAL_MAX_TEXTURES][VERTEXCACHE_ELEMENT];
+#endif
+
+	// VERTEX4D_CLIP_* bit set if inside plane
+	u32 clip[VERTEXCACHE_ELEMENT];
+
+	u32 eye;		// ex,ey,ez,ew valid
+	u32 fogValid;	// fog valid
+	u32 texMask;	// bit m: tu[m],tv[m] valid
+};
+
+//! transform, clip test, fog and texture matrix for count <= VERTEXCACHE_ELEMENT source vertices
+/** Results are the same as the scalar fixed function pipeline. simd must not be BURNING_SIMD_NONE */
+void burning_vertex_batch(sVertexBatch& out, const sVertexBatchSetup& setup,
+	const u32* sourceIndex, const u32 count, const e_burning_simd simd);
+
+} // end namespace video
+} // end namespace irr
+
+#endif
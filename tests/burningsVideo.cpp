@@ -7,6 +7,488 @@ using namespace irr;
 using namespace scene;
 using namespace video;
 
+//! options of renderTexturedSpheres
+enum
+{
+	RENDER_MULTITHREADED = 1,
+	RENDER_DEPTH_PREPASS = 2,
+	RENDER_FAST_TEXTURE_MAPPING = 4,
+	RENDER_TILED = 8,
+	RENDER_FOG_TEXTURE_MATRIX = 16,
+	RENDER_SCALAR_VERTICES = 32
+};
+
+static IImage* renderTexturedSpheres(u32 flags, s32* rasterThreads = 0, s32* vertexSIMD = 0)
+{
+	SIrrlichtCreationParameters params;
+	params.DriverType = video::EDT_BURNINGSVIDEO;
+	params.WindowSize = core::dimension2du(160, 120);
+	params.DriverMultithreaded = (flags & RENDER_MULTITHREADED) != 0;
+	params.FastTextureMapping = (flags & RENDER_FAST_TEXTURE_MAPPING) != 0;
+	params.TiledRasterizer = (flags & RENDER_TILED) != 0;
+	params.SIMDVertexTransform = (flags & RENDER_SCALAR_VERTICES) == 0;
+
+	IrrlichtDevice *device = createDeviceEx(params);
+	if (!device)
+		return 0;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->getParameters()->setAttribute(scene::DEPTH_PREPASS_SOLID, (flags & RENDER_DEPTH_PREPASS) != 0);
+	if (rasterThreads)
+		*rasterThreads = driver->getDriverAttributes().getAttributeAsInt("RasterThreads");
+	if (vertexSIMD)
+		*vertexSIMD = driver->getDriverAttributes().getAttributeAsInt("VertexSIMD");
+	if (flags & RENDER_FOG_TEXTURE_MATRIX)
+		driver->setFog(video::SColor(0, 120, 100, 80), video::EFT_FOG_LINEAR, 15.f, 30.f);
+
+	ITexture* texture = driver->getTexture("../media/wall.bmp");
+	for (s32 i = 0; i < 4; ++i)
+	{
+		ISceneNode* node = smgr->addSphereSceneNode(6.f, 32, 0, -1, core::vector3df(-9.f + i * 6.f, (i & 1) * 4.f - 2.f, 20.f + i * 2.f));
+		node->setMaterialTexture(0, texture);
+		node->setMaterialFlag(video::EMF_LIGHTING, false);
+		node->setMaterialFlag(video::EMF_WIREFRAME, i == 2);
+		node->setMaterialFlag(video::EMF_ZWRITE_ENABLE, i != 1);
+		if (i == 3)
+			node->setMaterialType(video::EMT_TRANSPARENT_ADD_COLOR);
+		if (flags & RENDER_FOG_TEXTURE_MATRIX)
+		{
+			node->setMaterialFlag(video::EMF_FOG_ENABLE, true);
+			node->getMaterial(0).getTextureMatrix(0).setTextureScale(1.5f + i, 2.f);
+			node->getMaterial(0).getTextureMatrix(0).setTextureRotationCenter(0.3f * i);
+		}
+	}
+	smgr->addCameraSceneNode();
+
+	IImage* screenshot = 0;
+	device->run();
+	if (driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80)))
+	{
+		smgr->drawAll();
+		driver->endScene();
+		screenshot = driver->createScreenShot();
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return screenshot;
+}
+
+/** Renders the spheres with two sets of options and compares the pixels.
+With maxAverageDifference 0 the pixels have to be the same, otherwise they have
+to differ by less than maxAverageDifference per channel on average. */
+static bool compareRenders(u32 flagsA, u32 flagsB, const char* name, u32 maxAverageDifference = 0)
+{
+	s32 threads = 0;
+	s32 vertexSIMD = 0;
+	IImage* a = renderTexturedSpheres(flagsA, 0, &vertexSIMD);
+	IImage* b = renderTexturedSpheres(flagsB, &threads);
+
+	bool result = a && b && a->getImageDataSizeInBytes() == b->getImageDataSizeInBytes();
+
+	if (result && ((flagsA | flagsB) & RENDER_MULTITHREADED) && threads < 2)
+	{
+		// with one processor no thread pool is created, nothing to compare
+		logTestString("Burning's Video %s skipped, only one raster thread\n", name);
+	}
+	else if (result && (flagsB & RENDER_SCALAR_VERTICES) && vertexSIMD == 0)
+	{
+		// no SSE2, both renders use the scalar vertex transform
+		logTestString("Burning's Video %s skipped, no SIMD vertex transform\n", name);
+	}
+	else if (result)
+	{
+		const u8* pa = (const u8*)a->getData();
+		const u8* pb = (const u8*)b->getData();
+		const u32 size = a->getImageDataSizeInBytes();
+		u32 difference = 0;
+		for (u32 i = 0; i < size; ++i)
+			difference += core::abs_((s32)pa[i] - (s32)pb[i]);
+
+		result = maxAverageDifference == 0 ? difference == 0 :
+			difference > 0 && difference < size * maxAverageDifference;
+	}
+
+	if (!result)
+		logTestString("Burning's Video %s failed\n", name);
+
+	if (a)
+		a->drop();
+	if (b)
+		b->drop();
+
+	return result;
+}
+
+/** The multithreaded rasterizer has to produce exactly the same pixels */
+static bool multithreadedRasterizer()
+{
+	return compareRenders(0, RENDER_MULTITHREADED, "multithreaded rasterizer");
+}
+
+/** Drawing tile row by tile row has to produce exactly the same pixels. Without raster threads tiles are ignored */
+static bool tiledRasterizer()
+{
+	bool result = compareRenders(0, RENDER_TILED, "tiled rasterizer without threads");
+	result &= compareRenders(0, RENDER_TILED | RENDER_MULTITHREADED, "tiled rasterizer");
+	return result;
+}
+
+/** Shading after a depth prepass has to produce exactly the same pixels */
+static bool depthPrepass()
+{
+	return compareRenders(0, RENDER_DEPTH_PREPASS, "depth prepass");
+}
+
+/** The fast texture mapping profile only differs slightly from the quality profile */
+static bool fastTextureMapping()
+{
+	bool result = compareRenders(0, RENDER_FAST_TEXTURE_MAPPING, "fast texture mapping", 4);
+	result &= compareRenders(RENDER_FAST_TEXTURE_MAPPING, RENDER_FAST_TEXTURE_MAPPING | RENDER_MULTITHREADED, "multithreaded fast texture mapping");
+	return result;
+}
+
+/** Writing through lock() has to show up, also when shaders sample a tiled copy of the texels (BURNINGVIDEO_TEXTURE_TILED) */
+static bool textureLockUpdate()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2du(160, 120), 32);
+	if (!device)
+		return false;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	ITexture* texture = driver->addTexture(core::dimension2du(16, 16), "lockupdate", video::ECF_A8R8G8B8);
+	ISceneNode* node = smgr->addCubeSceneNode(10.f, 0, -1, core::vector3df(0.f, 0.f, 12.f));
+	node->setMaterialTexture(0, texture);
+	node->setMaterialFlag(video::EMF_LIGHTING, false);
+	smgr->addCameraSceneNode();
+
+	const u32 fill[2] = { 0xFF00FF00, 0xFF0000FF };
+	bool result = texture != 0;
+	for (u32 pass = 0; pass < 2 && result; ++pass)
+	{
+		u32* texel = (u32*)texture->lock(video::ETLM_WRITE_ONLY);
+		for (u32 i = 0; i < 16 * 16; ++i)
+			texel[i] = fill[pass];
+		texture->unlock();
+
+		result = false;
+		device->run();
+		if (driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80)))
+		{
+			smgr->drawAll();
+			driver->endScene();
+
+			IImage* screenshot = driver->createScreenShot();
+			if (screenshot)
+			{
+				const SColor c = screenshot->getPixel(80, 60);
+				result = pass == 0 ?
+					c.getGreen() > 200 && c.getRed() < 50 && c.getBlue() < 50 :
+					c.getBlue() > 200 && c.getRed() < 50 && c.getGreen() < 50;
+				screenshot->drop();
+			}
+		}
+	}
+
+	if (!result)
+		logTestString("Burning's Video texture lock update failed\n");
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Renders a near cube, a cube hidden behind it and a partly hidden one, either the near cube first or last
+static IImage* renderOccludedCubes(bool nearFirst)
+{
+	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2du(160, 120), 32);
+	if (!device)
+		return 0;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	ITexture* texture = driver->getTexture("../media/wall.bmp");
+	ISceneNode* nodes[3];
+	nodes[0] = smgr->addCubeSceneNode(10.f, 0, -1, core::vector3df(0.f, 0.f, 20.f));
+	nodes[1] = smgr->addCubeSceneNode(4.f, 0, -1, core::vector3df(0.7f, 0.3f, 30.f), core::vector3df(0.f, 20.f, 0.f));
+	nodes[2] = smgr->addCubeSceneNode(6.f, 0, -1, core::vector3df(9.3f, 2.7f, 30.f), core::vector3df(0.f, 20.f, 0.f));
+	for (u32 i = 0; i < 3; ++i)
+	{
+		nodes[i]->setMaterialTexture(0, texture);
+		nodes[i]->setMaterialFlag(video::EMF_LIGHTING, false);
+		nodes[i]->setVisible(false);
+	}
+	smgr->addCameraSceneNode();
+
+	IImage* screenshot = 0;
+	device->run();
+	if (driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80)))
+	{
+		// sets up the camera, the cubes are drawn by hand in the wanted order
+		smgr->drawAll();
+		for (u32 i = 0; i < 3; ++i)
+			nodes[nearFirst ? i : 2 - i]->render();
+		driver->endScene();
+		screenshot = driver->createScreenShot();
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return screenshot;
+}
+
+/** Triangles behind the depth tiles are skipped by the hierarchical depth buffer.
+Drawing the near cube first has to give the same pixels as drawing it last, where nothing can be skipped */
+static bool hierarchicalDepth()
+{
+	IImage* a = renderOccludedCubes(true);
+	IImage* b = renderOccludedCubes(false);
+
+	bool result = a && b && a->getImageDataSizeInBytes() == b->getImageDataSizeInBytes();
+	if (result)
+		result = memcmp(a->getData(), b->getData(), a->getImageDataSizeInBytes()) == 0;
+
+	if (!result)
+		logTestString("Burning's Video hierarchical depth failed\n");
+
+	if (a)
+		a->drop();
+	if (b)
+		b->drop();
+
+	return result;
+}
+
+//! Renders a sphere with the given vertex hint: twice at the same place, moved, and moved with changed vertices
+static bool renderStaticMesh(scene::E_HARDWARE_MAPPING hint, IImage* frames[4])
+{
+	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2du(160, 120), 32);
+	if (!device)
+		return false;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	// enough vertices for a hardware buffer link
+	IMesh* mesh = smgr->getGeometryCreator()->createSphereMesh(4.f, 32, 32);
+	mesh->setHardwareMappingHint(hint);
+	ISceneNode* node = smgr->addMeshSceneNode(mesh, 0, -1, core::vector3df(0.f, 0.f, 20.f), core::vector3df(30.f, 40.f, 0.f));
+	node->setMaterialTexture(0, driver->getTexture("../media/wall.bmp"));
+	node->setMaterialFlag(video::EMF_LIGHTING, false);
+	smgr->addCameraSceneNode();
+
+	for (u32 frame = 0; frame < 4; ++frame)
+	{
+		if (frame == 2)
+			node->setPosition(core::vector3df(4.f, 2.f, 20.f));
+
+		// same place as the frame before, only setDirty tells about the new vertices
+		if (frame == 3)
+		{
+			IMeshBuffer* mb = mesh->getMeshBuffer(0);
+			S3DVertex* vertices = (S3DVertex*)mb->getVertices();
+			for (u32 i = 0; i < mb->getVertexCount(); ++i)
+				vertices[i].Pos *= 1.5f;
+			mb->setDirty(scene::EBT_VERTEX);
+		}
+
+		frames[frame] = 0;
+		device->run();
+		if (driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80)))
+		{
+			smgr->drawAll();
+			driver->endScene();
+			frames[frame] = driver->createScreenShot();
+		}
+	}
+	mesh->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return true;
+}
+
+/** Static meshbuffers are drawn from the post transform cache. The frames have to
+give the same pixels as without the cache, after a move and after setDirty */
+static bool postTransformCache()
+{
+	IImage* cached[4] = { 0, 0, 0, 0 };
+	IImage* uncached[4] = { 0, 0, 0, 0 };
+	bool result = renderStaticMesh(scene::EHM_STATIC, cached);
+	result &= renderStaticMesh(scene::EHM_NEVER, uncached);
+
+	for (u32 i = 0; i < 4; ++i)
+	{
+		bool equal = cached[i] && uncached[i] && cached[i]->getImageDataSizeInBytes() == uncached[i]->getImageDataSizeInBytes();
+		if (equal)
+			equal = memcmp(cached[i]->getData(), uncached[i]->getData(), cached[i]->getImageDataSizeInBytes()) == 0;
+		if (!equal)
+			logTestString("Burning's Video post transform cache failed in frame %u\n", i);
+		result &= equal;
+
+		if (cached[i])
+			cached[i]->drop();
+		if (uncached[i])
+			uncached[i]->drop();
+	}
+
+	return result;
+}
+
+//! setMaterial with the material of the last call is skipped, but not after a line changed the shader
+static bool redundantMaterialChanges()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2du(160, 120), 32);
+	if (!device)
+		return false;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	ISceneNode* left = smgr->addCubeSceneNode(6.f, 0, -1, core::vector3df(-8.f, 0.f, 20.f));
+	ISceneNode* right = smgr->addCubeSceneNode(6.f, 0, -1, core::vector3df(8.f, 0.f, 20.f));
+	left->setMaterialFlag(video::EMF_LIGHTING, false);
+	right->setMaterialFlag(video::EMF_LIGHTING, false);
+	smgr->addCameraSceneNode();
+
+	bool result = false;
+	device->run();
+	if (driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80)))
+	{
+		smgr->drawAll();
+
+		// a line switches to the wireframe shader. the right cube has to be filled again
+		driver->clearBuffers(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80));
+		left->render();
+		driver->setTransform(video::ETS_WORLD, core::IdentityMatrix);
+		driver->draw3DLine(core::vector3df(-8.f, -5.f, 20.f), core::vector3df(-8.f, 5.f, 20.f), video::SColor(255, 255, 0, 0));
+		right->render();
+		driver->endScene();
+
+		result = driver->getMaterialChangeCount(true) > 0 && driver->getMaterialChangeCount() > 0;
+
+		const core::position2di center = smgr->getSceneCollisionManager()->getScreenCoordinatesFrom3DPosition(right->getAbsolutePosition());
+		IImage* screenshot = driver->createScreenShot();
+		if (screenshot)
+		{
+			const SColor c = screenshot->getPixel(center.X, center.Y);
+			result &= c.getRed() > 200 && c.getGreen() > 200 && c.getBlue() > 200;
+			screenshot->drop();
+		}
+		else
+			result = false;
+	}
+
+	if (!result)
+		logTestString("Burning's Video redundant material changes failed, %u applied %u skipped\n",
+			driver->getMaterialChangeCount(), driver->getMaterialChangeCount(true));
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Instances have to look like mesh scene nodes at the same place, colored ones are tinted
+static bool instancedMesh()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2du(160, 120), 32);
+	if (!device)
+		return false;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	IMesh* mesh = smgr->getGeometryCreator()->createCubeMesh(core::vector3df(6.f, 6.f, 6.f));
+	IInstancedMeshSceneNode* instances = smgr->addInstancedMeshSceneNode(mesh, 0, -1, core::vector3df(0.f, 0.f, 20.f));
+	instances->setMaterialFlag(video::EMF_LIGHTING, false);
+	smgr->addCameraSceneNode();
+
+	const core::vector3df positions[3] = { core::vector3df(-8.f, 0.f, 0.f), core::vector3df(8.f, 0.f, 0.f), core::vector3df(0.f, 0.f, -40.f) };
+	ISceneNode* nodes[3];
+	for (u32 i = 0; i < 3; ++i)
+	{
+		core::matrix4 m;
+		m.setTranslation(positions[i]);
+		m.setRotationDegrees(core::vector3df(0.f, 30.f * i, 0.f));
+		instances->addInstance(m);
+
+		nodes[i] = smgr->addMeshSceneNode(mesh, 0, -1, positions[i] + instances->getPosition(), m.getRotationDegrees());
+		nodes[i]->setMaterialFlag(video::EMF_LIGHTING, false);
+		nodes[i]->setVisible(false);
+	}
+	mesh->drop();
+
+	IImage* screenshots[3] = { 0, 0, 0 };
+	for (u32 frame = 0; frame < 3; ++frame)
+	{
+		// instances, mesh scene nodes, instances with a red right cube
+		instances->setVisible(frame != 1);
+		for (u32 i = 0; i < 3; ++i)
+			nodes[i]->setVisible(frame == 1);
+		instances->setInstanceColor(1, frame == 2 ? SColor(255, 255, 0, 0) : SColor(0xffffffff));
+
+		device->run();
+		if (driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80)))
+		{
+			smgr->drawAll();
+			driver->endScene();
+			screenshots[frame] = driver->createScreenShot();
+		}
+	}
+
+	// the instance behind the camera is culled
+	bool result = instances->getVisibleInstanceCount() == 2 && screenshots[0] && screenshots[1] && screenshots[2];
+
+	if (result)
+	{
+		const core::dimension2du& size = screenshots[0]->getDimension();
+		for (u32 y = 0; result && y < size.Height; ++y)
+			for (u32 x = 0; result && x < size.Width; ++x)
+				result = screenshots[0]->getPixel(x, y) == screenshots[1]->getPixel(x, y);
+
+		const core::position2di left = smgr->getSceneCollisionManager()->getScreenCoordinatesFrom3DPosition(nodes[0]->getAbsolutePosition());
+		const core::position2di right = smgr->getSceneCollisionManager()->getScreenCoordinatesFrom3DPosition(nodes[1]->getAbsolutePosition());
+		const SColor white = screenshots[2]->getPixel(left.X, left.Y);
+		const SColor red = screenshots[2]->getPixel(right.X, right.Y);
+		result &= white.getRed() > 200 && white.getGreen() > 200 && white.getBlue() > 200;
+		result &= red.getRed() > 200 && red.getGreen() < 20 && red.getBlue() < 20;
+	}
+
+	for (u32 i = 0; i < 3; ++i)
+		if (screenshots[i])
+			screenshots[i]->drop();
+
+	if (!result)
+		logTestString("Burning's Video instanced mesh failed, %u of %u instances visible\n",
+			instances->getVisibleInstanceCount(), instances->getInstanceCount());
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+/** The SIMD vertex transform has to produce exactly the same pixels as the scalar one, with fog and texture matrices */
+static bool simdVertexTransform()
+{
+	return compareRenders(RENDER_FOG_TEXTURE_MATRIX, RENDER_FOG_TEXTURE_MATRIX | RENDER_SCALAR_VERTICES, "SIMD vertex transform");
+}
+
 /** Tests the Burning Video driver */
 bool burningsVideo(void)
 {
@@ -36,5 +518,16 @@ bool burningsVideo(void)
 	device->run();
     device->drop();
 
+	result &= multithreadedRasterizer();
+	result &= tiledRasterizer();
+	result &= depthPrepass();
+	result &= simdVertexTransform();
+	result &= hierarchicalDepth();
+	result &= postTransformCache();
+	result &= fastTextureMapping();
+	result &= textureLockUpdate();
+	result &= redundantMaterialChanges();
+	result &= instancedMesh();
+
     return result;
 }
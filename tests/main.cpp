@@ -84,6 +84,8 @@ int main(int argumentCount, char * arguments[])
 	TEST(removeCustomAnimator);
 	TEST(sceneCollisionManager);
 	TEST(sceneNodeAnimator);
+	TEST(sceneManager);
+	TEST(q3LevelVisibility);
 	TEST(meshLoaders);
 	TEST(testTimer);
 	TEST(testCoreutil);
@@ -0,0 +1,183 @@
+// Copyright (C) 2008-2012 Colin MacDonald
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+using namespace video;
+
+namespace
+{
+
+//! amount of primitives drawn in one frame with the camera at pos
+u32 drawFrom(IVideoDriver* driver, ISceneManager* smgr, ICameraSceneNode* camera,
+	const vector3df& pos, const vector3df& target)
+{
+	camera->setPosition(pos);
+	camera->setTarget(target);
+	camera->updateAbsolutePosition();
+	driver->beginScene(true, true, SColor(255,0,0,0));
+	smgr->drawAll();
+	driver->endScene();
+	return driver->getPrimitiveCountDrawn();
+}
+
+//! loads the level with 65536 clusters of 65536 bytes in the vis data, the size wraps to 0 in 32 bit
+bool brokenVisData(IrrlichtDevice* device)
+{
+	io::IReadFile* file = device->getFileSystem()->createAndOpenFile("20kdm2.bsp");
+	if (!file)
+		return false;
+
+	array<u8> data;
+	data.set_used(file->getSize());
+	const bool read = file->read(data.pointer(), data.size()) == data.size();
+	file->drop();
+
+	// offset of the vis data lump (16) is stored little endian after id and version
+	const u32 lump = 8 + 16 * 8;
+	const u32 offset = data[lump] | (data[lump + 1] << 8) | (data[lump + 2] << 16) | (data[lump + 3] << 24);
+	if (!read || offset + 8 > data.size())
+		return false;
+
+	const u8 count[4] = { 0, 0, 1, 0 };
+	memcpy(&data[offset], count, 4);
+	memcpy(&data[offset + 4], count, 4);
+
+	file = device->getFileSystem()->createMemoryReadFile(data.pointer(), (s32)data.size(), "brokenvis.bsp");
+	IAnimatedMesh* mesh = device->getSceneManager()->getMesh(file);
+	file->drop();
+
+	// the vis data is ignored, every cluster sees every other
+	IQ3LevelMesh* level = static_cast<IQ3LevelMesh*>(mesh);
+	const bool result = mesh && mesh->getMeshType() == EAMT_BSP &&
+		level->getClusterCount() == 0 && level->isClusterVisible(1, 0);
+
+	if (mesh)
+		device->getSceneManager()->getMeshCache()->removeMesh(mesh);
+
+	return result;
+}
+
+} // end anonymous namespace
+
+//! Tests the vis data of quake3 levels and the level scene node culling with it
+bool q3LevelVisibility()
+{
+	IrrlichtDevice *device = createDevice(EDT_NULL, dimension2d<u32>(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+
+	bool result = device->getFileSystem()->addFileArchive("../media/map-20kdm2.pk3");
+	assert_log(result);
+
+	IAnimatedMesh* mesh = result ? smgr->getMesh("20kdm2.bsp") : 0;
+	result &= (mesh && mesh->getMeshType() == EAMT_BSP);
+	assert_log(result);
+	if (!result)
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	IQ3LevelMesh* level = static_cast<IQ3LevelMesh*>(mesh);
+	IMesh* geometry = level->getMesh(quake3::E_Q3_MESH_GEOMETRY);
+	const u32 bufferCount = geometry->getMeshBufferCount();
+
+	result &= level->getClusterCount() > 0;
+	assert_log(result);
+
+	array< array<u16> > indices;
+	for (u32 i=0; i<bufferCount; ++i)
+		indices.push_back(array<u16>());
+
+	// without a cluster all faces are collected, exactly as in the mesh buffers
+	const u32 allFaces = level->getPotentiallyVisibleIndices(-1, indices.pointer(), bufferCount);
+	result &= allFaces > 0;
+	u32 allTriangles = 0;
+	for (u32 i=0; i<bufferCount; ++i)
+	{
+		const IMeshBuffer* mb = geometry->getMeshBuffer(i);
+		bool same = indices[i].size() == mb->getIndexCount();
+		for (u32 k=0; same && k<indices[i].size(); ++k)
+			same = indices[i][k] == mb->getIndices()[k];
+		result &= same;
+		allTriangles += mb->getIndexCount() / 3;
+	}
+	assert_log(result);
+
+	result &= level->getClusterFromPosition(geometry->getBoundingBox().MaxEdge + vector3df(1000.f)) == -1;
+	assert_log(result);
+
+	ISceneNode* node = smgr->addQuake3LevelSceneNode(level);
+	result &= node && node->getType() == ESNT_Q3LEVEL_SCENE_NODE;
+	assert_log(result);
+	if (!node)
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	// the camera position is looked up in the coordinate system of the level
+	const vector3df offset(-1350.f, -130.f, -1400.f);
+	node->setPosition(offset);
+	ICameraSceneNode* camera = smgr->addCameraSceneNode();
+	camera->setFarValue(100000.f);
+
+	// sample the level for positions in clusters which see only a part of it
+	const aabbox3df& box = geometry->getBoundingBox();
+	const vector3df step = box.getExtent() / 8.f;
+	u32 clusters = 0;
+	u32 culled = 0;
+	for (u32 x=1; x<8; ++x)
+	for (u32 y=1; y<8; ++y)
+	for (u32 z=1; z<8; ++z)
+	{
+		const vector3df pos = box.MinEdge + step * vector3df((f32)x, (f32)y, (f32)z);
+		const s32 cluster = level->getClusterFromPosition(pos);
+		if (cluster < 0)
+			continue;
+
+		++clusters;
+		result &= cluster < level->getClusterCount() && level->isClusterVisible(cluster, cluster);
+		result &= !level->isClusterVisible(cluster, -1);
+
+		const u32 faces = level->getPotentiallyVisibleIndices(cluster, indices.pointer(), bufferCount);
+		u32 triangles = 0;
+		for (u32 i=0; i<bufferCount; ++i)
+			triangles += indices[i].size() / 3;
+		result &= faces <= allFaces && triangles <= allTriangles;
+		if (faces < allFaces)
+			++culled;
+
+		// the node draws the same set with the camera in the cluster
+		result &= drawFrom(driver, smgr, camera, pos + offset, pos + offset + vector3df(0.f, 0.f, 1.f)) == triangles;
+	}
+	assert_log(result);
+
+	result &= clusters > 0 && culled > 0;
+	assert_log(result);
+
+	// outside of the level everything is drawn
+	result &= drawFrom(driver, smgr, camera, box.MaxEdge + vector3df(1000.f) + offset, box.getCenter() + offset) == allTriangles;
+	assert_log(result);
+
+	result &= brokenVisData(device);
+	assert_log(result);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
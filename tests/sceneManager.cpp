@@ -0,0 +1,813 @@
+// Copyright (C) 2008-2012 Colin MacDonald
+// No rights reserved: this software is in the public domain.
+
+#include "testUtils.h"
+
+using namespace irr;
+using namespace core;
+using namespace scene;
+
+namespace
+{
+
+//! node which writes its id into a list when it is rendered
+class CRecordingSceneNode : public ISceneNode
+{
+public:
+	CRecordingSceneNode(ISceneNode* parent, ISceneManager* mgr, s32 id, E_SCENE_NODE_RENDER_PASS pass, array<s32>& rendered)
+		: ISceneNode(parent, mgr, id), Pass(pass), Rendered(rendered)
+	{
+		Box.reset(vector3df(-1.f, -1.f, -1.f));
+		Box.addInternalPoint(vector3df(1.f, 1.f, 1.f));
+		setAutomaticCulling(EAC_FRUSTUM_BOX);
+	}
+
+	virtual void OnRegisterSceneNode()
+	{
+		if (IsVisible)
+			SceneManager->registerNodeForRendering(this, Pass);
+
+		ISceneNode::OnRegisterSceneNode();
+	}
+
+	virtual void render()
+	{
+		Rendered.push_back(getID());
+	}
+
+	virtual const aabbox3d<f32>& getBoundingBox() const
+	{
+		return Box;
+	}
+
+	virtual video::SMaterial& getMaterial(u32 num)
+	{
+		return Material;
+	}
+
+	virtual u32 getMaterialCount() const
+	{
+		return 1;
+	}
+
+	void setBox(const aabbox3df& box)
+	{
+		Box = box;
+	}
+
+private:
+	aabbox3df Box;
+	video::SMaterial Material;
+	E_SCENE_NODE_RENDER_PASS Pass;
+	array<s32>& Rendered;
+};
+
+//! counts how often its relative transformation is built
+class CTransformCountingSceneNode : public ISceneNode
+{
+public:
+	CTransformCountingSceneNode(ISceneNode* parent, ISceneManager* mgr)
+		: ISceneNode(parent, mgr), Builds(0)
+	{
+	}
+
+	virtual void render()
+	{
+	}
+
+	virtual const aabbox3d<f32>& getBoundingBox() const
+	{
+		return Box;
+	}
+
+	virtual matrix4 getRelativeTransformation() const
+	{
+		++Builds;
+		return ISceneNode::getRelativeTransformation();
+	}
+
+	mutable u32 Builds;
+
+private:
+	aabbox3df Box;
+};
+
+//! draws the scene and returns the ids of the rendered nodes in render order
+static void drawScene(ISceneManager* smgr, bool parallel, array<s32>& rendered, s32& calls, s32& culled)
+{
+	smgr->getParameters()->setAttribute(PARALLEL_SCENE_TRAVERSAL, parallel);
+
+	rendered.set_used(0);
+	smgr->drawAll();
+
+	calls = smgr->getParameters()->getAttributeAsInt("calls");
+	culled = smgr->getParameters()->getAttributeAsInt("culled");
+}
+
+//! draws the scene and picks along a fan of rays from the camera
+static void drawAndPick(ISceneManager* smgr, bool indexed, array<s32>& rendered, array<s32>& picked, s32& culled)
+{
+	smgr->getParameters()->setAttribute(SPATIAL_SCENE_INDEX, indexed);
+
+	rendered.set_used(0);
+	smgr->drawAll();
+	culled = smgr->getParameters()->getAttributeAsInt("culled");
+
+	picked.set_used(0);
+	for (s32 i = 0; i < 35; ++i)
+	{
+		const line3df ray(vector3df(0.f, 0.f, -50.f),
+			vector3df((f32)(i % 7) * 12.f - 36.f, (f32)(i / 7) * 5.f - 10.f, 150.f));
+		ISceneNode* node = smgr->getSceneCollisionManager()->getSceneNodeFromRayBB(ray);
+		picked.push_back(node ? node->getID() : -1);
+	}
+}
+
+static bool equalLists(const array<s32>& a, const array<s32>& b)
+{
+	bool result = a.size() == b.size();
+	for (u32 i = 0; result && i < a.size(); ++i)
+		result = a[i] == b[i];
+	return result;
+}
+
+} // end anonymous namespace
+
+//! Parallel registration has to give the same render lists as the serial one
+static bool parallelSceneTraversal()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -50.f), vector3df(0.f, 0.f, 0.f));
+
+	array<s32> rendered;
+	s32 id = 0;
+	for (s32 top = 0; top < 37; ++top)
+	{
+		// every third subtree is behind the camera. children of some nodes are moved back into view
+		const f32 z = (top % 3) ? (f32)(top % 7) * 4.f : -100.f;
+		const E_SCENE_NODE_RENDER_PASS pass = (top % 4) ? ESNRP_SOLID : ESNRP_TRANSPARENT;
+		ISceneNode* parent = new CRecordingSceneNode(smgr->getRootSceneNode(), smgr, id++, pass, rendered);
+		parent->setPosition(vector3df((f32)(top % 5) * 8.f - 16.f, 0.f, z));
+		parent->drop();
+
+		for (s32 child = 0; child < top % 6; ++child)
+		{
+			ISceneNode* node = new CRecordingSceneNode(parent, smgr, id++, child & 1 ? ESNRP_TRANSPARENT : ESNRP_SOLID, rendered);
+			node->setPosition(vector3df((f32)child * 3.f, (f32)child, (top % 3) ? 0.f : (f32)(child * 50)));
+			node->setVisible(child != 4);
+			node->drop();
+		}
+	}
+
+	// updates the absolute positions
+	smgr->drawAll();
+
+	s32 serialCalls, serialCulled;
+	drawScene(smgr, false, rendered, serialCalls, serialCulled);
+	const array<s32> serial(rendered);
+
+	s32 calls, culled;
+	drawScene(smgr, true, rendered, calls, culled);
+
+	bool result = serial.size() > 0 && serial.size() < (u32)id && rendered.size() == serial.size();
+	for (u32 i = 0; result && i < serial.size(); ++i)
+		result = rendered[i] == serial[i];
+
+	if (!result)
+		logTestString("Parallel scene traversal rendered %u nodes, serial %u nodes\n", rendered.size(), serial.size());
+
+	if (calls != serialCalls || culled != serialCulled)
+	{
+		logTestString("Parallel scene traversal counted %d calls %d culled, serial %d calls %d culled\n", calls, culled, serialCalls, serialCulled);
+		result = false;
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Culling and picking with the spatial index have to give the same results as without
+static bool spatialSceneIndex()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -50.f), vector3df(0.f, 0.f, 0.f));
+
+	// children of empty nodes are not picked
+	ISceneNode* group = smgr->addEmptySceneNode(0, 1000);
+
+	array<s32> rendered;
+	array<ISceneNode*> nodes;
+	s32 id = 0;
+	for (; id < 240; ++id)
+	{
+		ISceneNode* parent = (id % 10 == 9) ? group : smgr->getRootSceneNode();
+		if (id % 7 == 3)
+			parent = nodes[id - 3];
+
+		ISceneNode* node = new CRecordingSceneNode(parent, smgr, id, ESNRP_SOLID, rendered);
+		node->setPosition(vector3df((f32)(id % 20) * 7.f - 70.f, (f32)((id / 20) % 5) * 5.f - 10.f, (f32)(id / 20) * 12.f - 70.f));
+		const E_CULLING_TYPE culling[4] = { EAC_FRUSTUM_BOX, EAC_BOX, EAC_FRUSTUM_SPHERE, EAC_OFF };
+		node->setAutomaticCulling(culling[id % 4]);
+		nodes.push_back(node);
+		node->drop();
+	}
+
+	// updates the absolute positions
+	smgr->drawAll();
+
+	array<s32> serialPicked, picked;
+	s32 serialCulled, culled;
+	drawAndPick(smgr, false, rendered, serialPicked, serialCulled);
+	const array<s32> serialRendered(rendered);
+	drawAndPick(smgr, true, rendered, picked, culled);
+
+	bool result = serialRendered.size() > 0 && serialRendered.size() < nodes.size() &&
+		equalLists(serialRendered, rendered) && equalLists(serialPicked, picked) && culled == serialCulled;
+	if (!result)
+		logTestString("Spatial scene index rendered %u nodes, culled %d, without index %u nodes, culled %d\n",
+			rendered.size(), culled, serialRendered.size(), serialCulled);
+
+	// move, reparent, hide and remove nodes while the index is in use
+	for (u32 i = 0; i < nodes.size(); ++i)
+	{
+		if (i % 3 == 0)
+			nodes[i]->setPosition(nodes[i]->getPosition() + vector3df(30.f, 0.f, 25.f));
+		else if (i % 3 == 1)
+			nodes[i]->setPosition(nodes[i]->getPosition() + vector3df(0.1f, 0.f, 0.f));
+	}
+	// boxes changing without a move, like animated meshes
+	for (u32 i = 2; i < nodes.size(); i += 3)
+		static_cast<CRecordingSceneNode*>(nodes[i])->setBox(aabbox3df(-6.f, -4.f, -6.f, 6.f, 4.f, 6.f));
+	nodes[20]->addChild(nodes[41]);
+	nodes[123]->addChild(group);
+	nodes[60]->setVisible(false);
+	nodes[81]->remove();
+	nodes[150]->remove();
+	for (; id < 260; ++id)
+	{
+		ISceneNode* node = new CRecordingSceneNode(nodes[id - 200], smgr, id, ESNRP_SOLID, rendered);
+		node->setPosition(vector3df(0.f, 1.f, 5.f));
+		node->drop();
+	}
+
+	smgr->drawAll();
+	drawAndPick(smgr, true, rendered, picked, culled);
+	const array<s32> indexedRendered(rendered);
+	drawAndPick(smgr, false, rendered, serialPicked, serialCulled);
+
+	if (!equalLists(indexedRendered, rendered) || !equalLists(serialPicked, picked) || culled != serialCulled)
+	{
+		logTestString("Spatial scene index rendered %u nodes, culled %d after changes, without index %u nodes, culled %d\n",
+			indexedRendered.size(), culled, rendered.size(), serialCulled);
+		result = false;
+	}
+
+	// a box growing without a move is picked outside of its old box
+	CRecordingSceneNode* growing = static_cast<CRecordingSceneNode*>(nodes[50]);
+	growing->setBox(aabbox3df(-1.f, -1.f, -1.f, 1.f, 1.f, 1.f));
+	drawAndPick(smgr, true, rendered, picked, culled);
+	growing->setBox(aabbox3df(-6.f, -4.f, -6.f, 6.f, 4.f, 6.f));
+	const line3df side(vector3df(4.f, 0.f, -60.f), vector3df(4.f, 0.f, -30.f));
+	if (smgr->getSceneCollisionManager()->getSceneNodeFromRayBB(side) != growing)
+	{
+		logTestString("Spatial scene index missed a node with a grown bounding box\n");
+		result = false;
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Batched culling has to cull the same nodes as the tests of isCulled
+static bool batchedSceneCulling()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -50.f), vector3df(0.f, 0.f, 0.f));
+
+	// rotated and scaled nodes around the borders of the frustum
+	array<s32> rendered;
+	s32 id = 0;
+	for (; id < 300; ++id)
+	{
+		ISceneNode* parent = smgr->getRootSceneNode();
+		if (id % 5 == 4)
+			parent = smgr->getSceneNodeFromId(id - 4);
+
+		ISceneNode* node = new CRecordingSceneNode(parent, smgr, id, (id % 3) ? ESNRP_SOLID : ESNRP_TRANSPARENT, rendered);
+		const f32 angle = (f32)id * 0.37f;
+		const f32 radius = (f32)(id % 11) * 4.f;
+		node->setPosition(vector3df(cosf(angle) * radius, sinf(angle) * radius, (f32)(id % 13) * 6.f - 55.f));
+		node->setRotation(vector3df((f32)(id * 17 % 360), (f32)(id * 29 % 360), 0.f));
+		node->setScale(vector3df(0.5f + (f32)(id % 4), 1.f, 0.5f + (f32)(id % 3)));
+		const E_CULLING_TYPE culling[5] = { EAC_FRUSTUM_BOX, EAC_BOX, EAC_FRUSTUM_SPHERE, EAC_OFF, (E_CULLING_TYPE)(EAC_BOX | EAC_FRUSTUM_BOX) };
+		node->setAutomaticCulling(culling[id % 5]);
+		node->setVisible(id % 17 != 5);
+		node->drop();
+	}
+
+	// updates the absolute positions
+	smgr->drawAll();
+
+	s32 calls, culled;
+	smgr->getParameters()->setAttribute(BATCHED_SCENE_CULLING, false);
+	drawScene(smgr, false, rendered, calls, culled);
+	const array<s32> serial(rendered);
+	const s32 serialCulled = culled;
+
+	smgr->getParameters()->setAttribute(BATCHED_SCENE_CULLING, true);
+	drawScene(smgr, false, rendered, calls, culled);
+
+	bool result = serial.size() > 0 && serial.size() < (u32)id && equalLists(serial, rendered) && culled == serialCulled;
+
+	// together with parallel registration
+	drawScene(smgr, true, rendered, calls, culled);
+	result &= equalLists(serial, rendered) && culled == serialCulled;
+
+	// boxes from the flat copy of the scene
+	smgr->getParameters()->setAttribute(FLAT_SCENE_STORE, true);
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= equalLists(serial, rendered) && culled == serialCulled;
+
+	// which has to follow moved, hidden, removed and added nodes
+	smgr->getSceneNodeFromId(10)->setPosition(vector3df(0.f, 0.f, 0.f));
+	smgr->getSceneNodeFromId(20)->setPosition(vector3df(0.f, 500.f, 0.f));
+	smgr->getSceneNodeFromId(30)->setVisible(false);
+	smgr->getSceneNodeFromId(40)->remove();
+	smgr->getSceneNodeFromId(51)->setParent(smgr->getSceneNodeFromId(20));
+	new CRecordingSceneNode(smgr->getSceneNodeFromId(60), smgr, id, ESNRP_SOLID, rendered);
+	smgr->getSceneNodeFromId(id)->drop();
+
+	drawScene(smgr, false, rendered, calls, culled);
+	const array<s32> flat(rendered);
+	const s32 flatCulled = culled;
+	smgr->getParameters()->setAttribute(FLAT_SCENE_STORE, false);
+	smgr->getParameters()->setAttribute(BATCHED_SCENE_CULLING, false);
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= equalLists(flat, rendered) && culled == flatCulled && !equalLists(flat, serial);
+
+	if (!result)
+		logTestString("Batched culling rendered %u nodes, culled %d, without %u nodes, culled %d\n",
+			rendered.size(), culled, serial.size(), serialCulled);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Solid nodes are sorted by material and textures, then front to back. Transparent nodes back to front
+static bool renderQueueOrder()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -50.f), vector3df(0.f, 0.f, 0.f));
+
+	video::ITexture* textures[2] =
+	{
+		driver->addTexture(dimension2du(2, 2), "texture0"),
+		driver->addTexture(dimension2du(2, 2), "texture1")
+	};
+	const video::E_MATERIAL_TYPE types[3] = { video::EMT_SOLID, video::EMT_LIGHTMAP, video::EMT_DETAIL_MAP };
+
+	array<s32> rendered;
+	s32 id;
+	for (id = 0; id < 36; ++id)
+	{
+		const E_SCENE_NODE_RENDER_PASS pass = id < 24 ? ESNRP_SOLID : ESNRP_TRANSPARENT;
+		ISceneNode* node = new CRecordingSceneNode(smgr->getRootSceneNode(), smgr, id, pass, rendered);
+		node->setPosition(vector3df(0.f, 0.f, (f32)((id * 7) % 13) * 3.f));
+		node->getMaterial(0).MaterialType = types[id % 3];
+		node->getMaterial(0).setTexture(0, textures[(id / 3) % 2]);
+		node->drop();
+	}
+
+	// updates the absolute positions
+	smgr->drawAll();
+	rendered.set_used(0);
+	smgr->drawAll();
+
+	bool result = rendered.size() == (u32)id;
+	u32 materialChanges = 0;
+	for (u32 i = 1; result && i < rendered.size(); ++i)
+	{
+		ISceneNode* prev = smgr->getSceneNodeFromId(rendered[i - 1]);
+		ISceneNode* node = smgr->getSceneNodeFromId(rendered[i]);
+		const bool solid = rendered[i] < 24;
+		if (solid != (rendered[i - 1] < 24))
+			continue;
+
+		const f32 dz = node->getPosition().Z - prev->getPosition().Z;
+		if (solid && (prev->getMaterial(0).MaterialType != node->getMaterial(0).MaterialType ||
+			prev->getMaterial(0).getTexture(0) != node->getMaterial(0).getTexture(0)))
+			++materialChanges;
+		else if (solid ? dz < 0.f : dz > 0.f)
+			result = false;
+	}
+	result &= materialChanges == 5;
+
+	if (!result)
+		logTestString("Render queue order wrong, %u nodes, %u material changes\n", rendered.size(), materialChanges);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Instances outside of the view frustum are culled, the visible ones drawn in one go
+static bool instancedMeshCulling()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -50.f), vector3df(0.f, 0.f, 0.f));
+
+	IMesh* mesh = smgr->getGeometryCreator()->createCubeMesh(vector3df(1.f, 1.f, 1.f));
+	IInstancedMeshSceneNode* node = smgr->addInstancedMeshSceneNode(mesh);
+	mesh->drop();
+
+	// a row along x, every other one behind the camera
+	u32 visible = 0;
+	for (s32 i = 0; i < 40; ++i)
+	{
+		matrix4 m;
+		m.setTranslation(vector3df((f32)(i - 20), 0.f, (i & 1) ? -100.f : 0.f));
+		node->addInstance(m, video::SColor(255, 255, (u32)i * 6, 0));
+		visible += (i & 1) ? 0 : 1;
+	}
+
+	bool result = node->getInstanceCount() == 40 &&
+		equals(node->getBoundingBox().MinEdge.X, -20.5f) && equals(node->getBoundingBox().MaxEdge.X, 19.5f);
+
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80));
+	smgr->drawAll();
+	driver->endScene();
+
+	const u32 drawn = driver->getPrimitiveCountDrawn();
+	result &= node->getVisibleInstanceCount() == visible && drawn == visible * 12;
+
+	if (!result)
+		logTestString("Instanced mesh drew %u of %u instances, %u primitives\n",
+			node->getVisibleInstanceCount(), node->getInstanceCount(), drawn);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! draws the scene and returns the amount of drawn primitives
+static u32 drawPrimitives(IrrlichtDevice* device)
+{
+	video::IVideoDriver* driver = device->getVideoDriver();
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(0, 80, 80, 80));
+	device->getSceneManager()->drawAll();
+	driver->endScene();
+	return driver->getPrimitiveCountDrawn();
+}
+
+//! Static mesh nodes are merged per material and follow the changes of their nodes
+static bool staticBatch()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, -50.f), vector3df(0.f, 0.f, 0.f));
+
+	// a wall of cubes in front of the camera and one behind it, the top row in a group
+	IMesh* mesh = smgr->getGeometryCreator()->createCubeMesh(vector3df(1.f, 1.f, 1.f));
+	ISceneNode* group = smgr->addEmptySceneNode();
+	array<IMeshSceneNode*> nodes;
+	for (s32 i = 0; i < 100; ++i)
+	{
+		const vector3df pos((f32)(i % 10) * 10.f - 45.f, (f32)(i / 10 % 5) * 10.f - 20.f, i < 50 ? 0.f : -200.f);
+		IMeshSceneNode* node = smgr->addMeshSceneNode(mesh, i < 10 ? group : 0, i, pos);
+		node->setMaterialFlag(video::EMF_LIGHTING, (i & 1) != 0);
+		nodes.push_back(node);
+	}
+
+	// not merged: an animated node and a node with a child
+	IMeshSceneNode* animated = smgr->addMeshSceneNode(mesh, 0, -1, vector3df(0.f, 0.f, 10.f));
+	ISceneNodeAnimator* animator = smgr->createRotationAnimator(vector3df(0.f, 1.f, 0.f));
+	animated->addAnimator(animator);
+	animator->drop();
+	IMeshSceneNode* withChild = smgr->addMeshSceneNode(mesh, 0, -1, vector3df(0.f, 0.f, 20.f));
+	smgr->addEmptySceneNode(withChild);
+	mesh->drop();
+
+	IStaticBatchSceneNode* batch = smgr->addStaticBatchSceneNode(0, 20.f);
+	bool result = batch->getNodeCount() == 100 && !nodes[0]->isVisible() && animated->isVisible();
+	result &= batch->getChunkCount() > 1 && batch->getMeshBufferCount() <= batch->getChunkCount() * 2;
+
+	u32 drawn = drawPrimitives(device);
+	result &= drawn == 52 * 12 && batch->getVisibleChunkCount() < batch->getChunkCount();
+	assert_log(result);
+
+	// moved behind the camera
+	nodes[20]->setPosition(vector3df(0.f, 0.f, -100.f));
+	drawn = drawPrimitives(device);
+	result &= drawn == 51 * 12;
+
+	// hidden parent
+	group->setVisible(false);
+	drawn = drawPrimitives(device);
+	result &= drawn == 41 * 12;
+	group->setVisible(true);
+	drawn = drawPrimitives(device);
+	result &= drawn == 51 * 12;
+	assert_log(result);
+
+	// taken out of the batch, drawn on its own
+	result &= batch->removeNode(nodes[21]) && nodes[21]->isVisible() && batch->getNodeCount() == 99;
+	nodes[22]->setVisible(true);
+	drawn = drawPrimitives(device);
+	result &= drawn == 51 * 12 && batch->getNodeCount() == 98;
+
+	// removed from the scene
+	nodes[23]->remove();
+	drawn = drawPrimitives(device);
+	result &= drawn == 50 * 12 && batch->getNodeCount() == 97;
+
+	if (!result)
+		logTestString("Static batch drew %u primitives with %u nodes in %u chunks\n",
+			drawn, batch->getNodeCount(), batch->getChunkCount());
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+static bool softwareOcclusionCulling()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	smgr->addCameraSceneNode(0, vector3df(0.f, 0.f, 0.f), vector3df(0.f, 0.f, 100.f));
+
+	// a wall from z 20 to 40 covering x and y from -10 to 10
+	IMesh* mesh = smgr->getGeometryCreator()->createCubeMesh(vector3df(20.f, 20.f, 20.f));
+	IMeshSceneNode* wall = smgr->addMeshSceneNode(mesh, 0, -1, vector3df(0.f, 0.f, 30.f));
+	mesh->drop();
+	smgr->addOccluder(wall);
+
+	array<s32> rendered;
+	const u32 culling = EAC_FRUSTUM_BOX | EAC_OCC_SOFTWARE;
+	const vector3df positions[] =
+	{
+		vector3df(0.f, 0.f, 60.f),	// behind the wall
+		vector3df(5.f, 5.f, 100.f),	// behind the wall
+		vector3df(30.f, 0.f, 60.f),	// partly behind the edge of the wall
+		vector3df(0.f, 0.f, 10.f),	// in front of the wall
+		vector3df(0.f, 0.f, 25.f),	// inside the wall, behind its front side
+		vector3df(0.f, 0.f, 60.f)	// behind the wall without EAC_OCC_SOFTWARE
+	};
+	for (s32 i = 0; i < 6; ++i)
+	{
+		ISceneNode* node = new CRecordingSceneNode(smgr->getRootSceneNode(), smgr, i, ESNRP_SOLID, rendered);
+		node->setPosition(positions[i]);
+		node->setAutomaticCulling(i < 5 ? culling : EAC_FRUSTUM_BOX);
+		node->drop();
+	}
+
+	array<s32> expected;
+	expected.push_back(2);
+	expected.push_back(3);
+	expected.push_back(5);
+
+	s32 calls, culled;
+	bool result = true;
+	for (u32 parallel = 0; parallel < 2; ++parallel)
+	{
+		drawScene(smgr, parallel != 0, rendered, calls, culled);
+		rendered.sort();
+		result &= equalLists(rendered, expected);
+	}
+	assert_log(result);
+
+	// an invisible occluder hides nothing
+	wall->setVisible(false);
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= rendered.size() == 6;
+	wall->setVisible(true);
+
+	// the wall turned away from the hidden nodes
+	wall->setPosition(vector3df(0.f, 0.f, -30.f));
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= rendered.size() == 6;
+	wall->setPosition(vector3df(0.f, 0.f, 30.f));
+
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= rendered.size() == 3;
+
+	smgr->removeOccluder(wall);
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= rendered.size() == 6;
+	assert_log(result);
+
+	// a wall removed from the scene hides nothing
+	smgr->addOccluder(wall);
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= rendered.size() == 3;
+	wall->remove();
+	drawScene(smgr, false, rendered, calls, culled);
+	result &= rendered.size() == 6;
+	assert_log(result);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+static bool cachedTransformations()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	ISceneNode* root = smgr->getRootSceneNode();
+	ISceneNode* parent = smgr->addEmptySceneNode(0);
+	ISceneNode* child = smgr->addEmptySceneNode(parent);
+	ISceneNode* leaf = smgr->addEmptySceneNode(child);
+	IDummyTransformationSceneNode* dummy = smgr->addDummyTransformationSceneNode(0);
+	ISceneNode* dummyChild = smgr->addEmptySceneNode(dummy);
+	child->setPosition(vector3df(0.f, 1.f, 0.f));
+	leaf->setPosition(vector3df(0.f, 0.f, 1.f));
+	root->OnAnimate(0);
+
+	bool result = leaf->getAbsolutePosition().equals(vector3df(0.f, 1.f, 1.f));
+
+	// nothing moved
+	const u32 parentVersion = parent->getTransformationVersion();
+	const u32 leafVersion = leaf->getTransformationVersion();
+	const u32 dummyChildVersion = dummyChild->getTransformationVersion();
+	root->OnAnimate(10);
+	parent->setPosition(parent->getPosition());
+	root->OnAnimate(20);
+	result &= parent->getTransformationVersion() == parentVersion;
+	result &= leaf->getTransformationVersion() == leafVersion;
+	result &= dummyChild->getTransformationVersion() == dummyChildVersion;
+	assert_log(result);
+
+	// moving the parent moves the subtree
+	parent->setPosition(vector3df(10.f, 0.f, 0.f));
+	parent->setRotation(vector3df(0.f, 90.f, 0.f));
+	root->OnAnimate(30);
+	result &= parent->getTransformationVersion() != parentVersion;
+	result &= leaf->getTransformationVersion() != leafVersion;
+	result &= leaf->getAbsolutePosition().equals(vector3df(11.f, 1.f, 0.f));
+	result &= dummyChild->getTransformationVersion() == dummyChildVersion;
+
+	// the matrix of a dummy node changes through a reference
+	dummy->getRelativeTransformationMatrix().setTranslation(vector3df(0.f, 0.f, 5.f));
+	root->OnAnimate(40);
+	result &= dummyChild->getAbsolutePosition().equals(vector3df(0.f, 0.f, 5.f));
+
+	// a new parent
+	leaf->setParent(dummy);
+	root->OnAnimate(50);
+	result &= leaf->getAbsolutePosition().equals(vector3df(0.f, 0.f, 6.f));
+	assert_log(result);
+
+	// the triangle selector follows its moved node
+	IMesh* mesh = smgr->getGeometryCreator()->createCubeMesh(vector3df(2.f, 2.f, 2.f));
+	IMeshSceneNode* cube = smgr->addMeshSceneNode(mesh);
+	ITriangleSelector* selector = smgr->createOctreeTriangleSelector(mesh, cube, 4);
+	mesh->drop();
+	root->OnAnimate(60);
+
+	triangle3df triangles[12];
+	s32 count = 0;
+	const aabbox3df origin(-0.5f, -0.5f, -0.5f, 0.5f, 0.5f, 1.5f);
+	const aabbox3df moved(19.5f, -0.5f, -0.5f, 20.5f, 0.5f, 1.5f);
+	selector->getTriangles(triangles, 12, count, origin);
+	result &= count > 0;
+	cube->setPosition(vector3df(20.f, 0.f, 0.f));
+	root->OnAnimate(70);
+	selector->getTriangles(triangles, 12, count, origin);
+	result &= count == 0;
+	selector->getTriangles(triangles, 12, count, moved);
+	result &= count > 0;
+	selector->drop();
+	assert_log(result);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! a static subtree does no transformation work while its moved sibling is updated
+static bool staticSubtreeTransformations()
+{
+	IrrlichtDevice* device = createDevice(video::EDT_NULL, dimension2du(160, 120));
+	assert_log(device);
+	if (!device)
+		return false;
+
+	ISceneManager* smgr = device->getSceneManager();
+	ISceneNode* root = smgr->getRootSceneNode();
+
+	// a static and a moving parent with 8 children each
+	CTransformCountingSceneNode* nodes[18];
+	nodes[0] = new CTransformCountingSceneNode(root, smgr);
+	nodes[9] = new CTransformCountingSceneNode(root, smgr);
+	for (u32 i = 1; i < 9; ++i)
+	{
+		nodes[i] = new CTransformCountingSceneNode(nodes[0], smgr);
+		nodes[i + 9] = new CTransformCountingSceneNode(nodes[9], smgr);
+		nodes[i]->setPosition(vector3df((f32)i, 0.f, 0.f));
+		nodes[i + 9]->setPosition(vector3df((f32)i, 0.f, 0.f));
+	}
+	for (u32 i = 0; i < 18; ++i)
+		nodes[i]->drop();
+	root->OnAnimate(0);
+
+	u32 versions[18];
+	for (u32 i = 0; i < 18; ++i)
+	{
+		versions[i] = nodes[i]->getTransformationVersion();
+		nodes[i]->Builds = 0;
+	}
+
+	bool result = true;
+	for (u32 frame = 1; frame <= 4; ++frame)
+	{
+		nodes[9]->setPosition(vector3df(0.f, (f32)frame, 0.f));
+		root->OnAnimate(frame * 10);
+
+		for (u32 i = 0; i < 9; ++i)
+			result &= nodes[i]->Builds == 0 && nodes[i]->getTransformationVersion() == versions[i];
+		for (u32 i = 9; i < 18; ++i)
+			result &= nodes[i]->Builds == frame && nodes[i]->getTransformationVersion() == versions[i] + frame;
+		result &= nodes[17]->getAbsolutePosition().equals(vector3df(8.f, (f32)frame, 0.f));
+	}
+	assert_log(result);
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+/** Tests for the scene manager which do not depend on a driver */
+bool sceneManager(void)
+{
+	bool result = parallelSceneTraversal();
+	result &= renderQueueOrder();
+	result &= instancedMeshCulling();
+	result &= spatialSceneIndex();
+	result &= batchedSceneCulling();
+	result &= softwareOcclusionCulling();
+	result &= cachedTransformations();
+	result &= staticSubtreeTransformations();
+	result &= staticBatch();
+
+	return result;
+}
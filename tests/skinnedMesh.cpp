@@ -5,8 +5,434 @@
 
 using namespace irr;
 
-// Tests skinned meshes.
-bool skinnedMesh(void)
+namespace
+{
+
+//! Nodes sharing a skinned mesh at different frames skin their own copy of it
+bool sharedSkinnedMesh()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	if (!device)
+		return false;
+
+	video::IVideoDriver* driver = device->getVideoDriver();
+	scene::ISceneManager * smgr = device->getSceneManager();
+
+	scene::ISkinnedMesh* mesh = (scene::ISkinnedMesh*)smgr->getMesh("../media/ninja.b3d");
+	if (!mesh)
+	{
+		logTestString("Could not load ninja.\n");
+		return false;
+	}
+
+	// the mesh as it was loaded
+	const core::aabbox3df meshBox = mesh->getBoundingBox();
+	core::array<core::vector3df> positions;
+	const scene::IMeshBuffer* buffer = mesh->getMeshBuffer(0);
+	for (u32 i=0; i<buffer->getVertexCount(); ++i)
+		positions.push_back(buffer->getPosition(i));
+
+	smgr->addCameraSceneNode(0, core::vector3df(0, 5, -20), core::vector3df(0, 5, 0));
+
+	// box of a single node at a frame
+	scene::IAnimatedMeshSceneNode* node = smgr->addAnimatedMeshSceneNode(mesh);
+	node->setAnimationSpeed(0.f);
+	node->setCurrentFrame(62.f);
+	smgr->drawAll();
+	const core::aabbox3df box62 = node->getBoundingBox();
+	node->setCurrentFrame(10.f);
+	smgr->drawAll();
+	const core::aabbox3df box10 = node->getBoundingBox();
+	node->remove();
+
+	bool result = box10 != box62;
+
+	scene::IAnimatedMeshSceneNode* nodes[4];
+	for (u32 i=0; i<4; ++i)
+	{
+		nodes[i] = smgr->addAnimatedMeshSceneNode(mesh, 0, -1, core::vector3df(i*4.f-6.f, 0, 0));
+		nodes[i]->setAnimationSpeed(0.f);
+		nodes[i]->setCurrentFrame(i&1 ? 62.f : 10.f);
+	}
+
+	driver->beginScene(video::ECBF_COLOR | video::ECBF_DEPTH, video::SColor(255, 60, 60, 60));
+	smgr->drawAll();
+	driver->endScene();
+
+	for (u32 i=0; i<4; ++i)
+		result &= nodes[i]->getBoundingBox() == (i&1 ? box62 : box10);
+	if (!result)
+		logTestString("Nodes sharing a skinned mesh have wrong boxes.\n");
+
+	// the shared mesh is not skinned
+	bool unchanged = mesh->getBoundingBox() == meshBox;
+	for (u32 i=0; i<buffer->getVertexCount(); ++i)
+		unchanged &= buffer->getPosition(i) == positions[i];
+	if (!unchanged)
+		logTestString("Shared skinned mesh was changed by its nodes.\n");
+	result &= unchanged;
+
+	// joints follow the frame of their own node
+	const core::vector3df joint10 = nodes[0]->getJointNode("Joint8")->getAbsolutePosition() - nodes[0]->getAbsolutePosition();
+	const core::vector3df joint62 = nodes[1]->getJointNode("Joint8")->getAbsolutePosition() - nodes[1]->getAbsolutePosition();
+	const core::vector3df joint10b = nodes[2]->getJointNode("Joint8")->getAbsolutePosition() - nodes[2]->getAbsolutePosition();
+	result &= joint10.equals(joint10b) && !joint10.equals(joint62);
+	if (!result)
+		logTestString("Joints of nodes sharing a skinned mesh are wrong.\n");
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! five joints in a chain, the first 6 vertices with up to 4 weights
+scene::ISkinnedMesh* createWeightedMesh(scene::ISceneManager* smgr, bool fiveWeights)
+{
+	scene::ISkinnedMesh* mesh = smgr->createSkinnedMesh();
+
+	scene::SSkinMeshBuffer* buffer = mesh->addMeshBuffer();
+	for (u32 i=0; i<7; ++i)
+		buffer->Vertices_Standard.push_back(video::S3DVertex((f32)i, 1.f+i*0.5f, 0.f, 0.f, 0.f, -1.f, video::SColor(255,255,255,255), 0.f, 0.f));
+	const u16 indices[] = {0,1,2, 3,4,5, 4,5,6};
+	for (u32 i=0; i<9; ++i)
+		buffer->Indices.push_back(indices[i]);
+
+	scene::ISkinnedMesh::SJoint* joints[5];
+	for (u32 i=0; i<5; ++i)
+	{
+		joints[i] = mesh->addJoint(i ? joints[i-1] : 0);
+		joints[i]->Name = core::stringc("joint") + core::stringc(i);
+		joints[i]->LocalMatrix.setTranslation(core::vector3df(0.f, i ? 1.f : 0.f, 0.f));
+	}
+
+	scene::ISkinnedMesh::SPositionKey* position = mesh->addPositionKey(joints[1]);
+	position->frame = 0.f;
+	position->position.set(0.f, 1.f, 0.f);
+	position = mesh->addPositionKey(joints[1]);
+	position->frame = 10.f;
+	position->position.set(2.f, 3.f, 0.f);
+
+	scene::ISkinnedMesh::SRotationKey* rotation = mesh->addRotationKey(joints[1]);
+	rotation->frame = 0.f;
+	rotation = mesh->addRotationKey(joints[1]);
+	rotation->frame = 10.f;
+	rotation->rotation.set(0.f, 0.f, core::HALF_PI);
+
+	scene::ISkinnedMesh::SScaleKey* scale = mesh->addScaleKey(joints[2]);
+	scale->frame = 0.f;
+	scale->scale.set(1.f, 1.f, 1.f);
+	scale = mesh->addScaleKey(joints[2]);
+	scale->frame = 10.f;
+	scale->scale.set(2.f, 1.f, 2.f);
+
+	// vertex, joint, strength
+	const f32 weights[][3] = {
+		{0, 0, 1.f},
+		{1, 1, 1.f},
+		{2, 0, 0.5f}, {2, 1, 0.5f},
+		{3, 0, 0.25f}, {3, 1, 0.25f}, {3, 2, 0.5f},
+		{4, 1, 0.3f}, {4, 2, 0.7f},
+		{5, 0, 0.2f}, {5, 1, 0.2f}, {5, 2, 0.2f}, {5, 4, 0.4f},
+		{6, 0, 0.2f}, {6, 1, 0.2f}, {6, 2, 0.2f}, {6, 3, 0.2f}, {6, 4, 0.2f}};
+	const u32 count = fiveWeights ? 18 : 13;
+	for (u32 i=0; i<count; ++i)
+	{
+		scene::ISkinnedMesh::SWeight* weight = mesh->addWeight(joints[(u32)weights[i][1]]);
+		weight->buffer_id = 0;
+		weight->vertex_id = (u32)weights[i][0];
+		weight->strength = weights[i][2];
+	}
+
+	mesh->finalize();
+	return mesh;
+}
+
+//! Keys are found in long tracks when jumping around and with resampled keys
+bool keyframeLookup()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	if (!device)
+		return false;
+
+	scene::ISkinnedMesh* mesh = device->getSceneManager()->createSkinnedMesh();
+	scene::ISkinnedMesh::SJoint* joint = mesh->addJoint();
+	for (u32 i=0; i<200; ++i)
+	{
+		scene::ISkinnedMesh::SPositionKey* key = mesh->addPositionKey(joint);
+		key->frame = (f32)i;
+		key->position.set(sinf(i*0.1f), i*i*0.01f, 0.f);
+	}
+	mesh->finalize();
+
+	bool result = true;
+	const f32 frames[] = {0.f, 150.25f, 3.5f, 3.75f, 4.5f, 199.f, 98.1f, 10.f};
+	for (u32 pass=0; pass<3; ++pass)
+	{
+		// keys on the samples, so resampling gives the same results
+		mesh->setKeyResampling(pass==0 ? 0.f : 1.f/pass);
+
+		for (u32 f=0; f<sizeof(frames)/sizeof(frames[0]); ++f)
+		{
+			const u32 k = core::min_((u32)frames[f], 198u);
+			const f32 t = frames[f] - k;
+			const core::vector3df expected(sinf(k*0.1f)*(1.f-t) + sinf((k+1)*0.1f)*t,
+				k*k*0.01f*(1.f-t) + (k+1)*(k+1)*0.01f*t, 0.f);
+
+			mesh->animateMesh(frames[f], 1.f);
+			const core::vector3df position = mesh->getAllJoints()[0]->LocalAnimatedMatrix.getTranslation();
+			if (!position.equals(expected, 0.01f))
+			{
+				logTestString("Wrong position at frame %f in pass %u\n", frames[f], pass);
+				result = false;
+			}
+		}
+	}
+
+	mesh->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Compressed keys animate close to the original ones
+bool compressedKeys()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	if (!device)
+		return false;
+
+	scene::ISceneManager * smgr = device->getSceneManager();
+	scene::ISkinnedMesh* original = (scene::ISkinnedMesh*)smgr->getMesh("../media/ninja.b3d");
+	smgr->getParameters()->setAttribute(scene::SKINNED_MESH_KEY_COMPRESSION, 0.0001f);
+	scene::ISkinnedMesh* compressed = (scene::ISkinnedMesh*)smgr->getMesh("../media/ninja.b3d", "compressed");
+	if (!original || !compressed || original == compressed)
+	{
+		device->closeDevice();
+		device->run();
+		device->drop();
+		return false;
+	}
+
+	bool result = compressed->getFrameCount() == original->getFrameCount();
+	u32 keys = 0;
+	for (u32 i=0; i<compressed->getJointCount(); ++i)
+	{
+		const scene::ISkinnedMesh::SJoint* joint = compressed->getAllJoints()[i];
+		keys += joint->PositionKeys.size() + joint->ScaleKeys.size() + joint->RotationKeys.size();
+	}
+	result &= keys == 0;
+
+	const f32 frames[] = {0.f, 1.5f, 30.f, 100.25f, 183.f, 12.f};
+	f32 maxError = 0.f;
+	for (u32 f=0; f<sizeof(frames)/sizeof(frames[0]); ++f)
+	{
+		original->animateMesh(frames[f], 1.f);
+		original->skinMesh();
+		compressed->animateMesh(frames[f], 1.f);
+		compressed->skinMesh();
+
+		for (u32 b=0; b<original->getMeshBufferCount(); ++b)
+		{
+			const scene::IMeshBuffer* a = original->getMeshBuffer(b);
+			const scene::IMeshBuffer* c = compressed->getMeshBuffer(b);
+			for (u32 i=0; i<a->getVertexCount(); ++i)
+				maxError = core::max_(maxError, a->getPosition(i).getDistanceFrom(c->getPosition(i)));
+		}
+	}
+	if (maxError > 0.01f)
+	{
+		logTestString("Compressed keys moved vertices by %f\n", maxError);
+		result = false;
+	}
+
+	// mesh writers get the keys decompressed
+	core::array<u8> memory;
+	memory.set_used(1024*1024);
+	io::IWriteFile* writeFile = device->getFileSystem()->createMemoryWriteFile(memory.pointer(), memory.size(), "compressed.b3d");
+	scene::IMeshWriter* writer = smgr->createMeshWriter(scene::EMWT_B3D);
+	result &= writer && writer->writeMesh(writeFile, compressed);
+	const s32 writtenSize = writeFile->getPos();
+	if (writer)
+		writer->drop();
+	writeFile->drop();
+
+	smgr->getParameters()->setAttribute(scene::SKINNED_MESH_KEY_COMPRESSION, 0.f);
+	io::IReadFile* readFile = device->getFileSystem()->createMemoryReadFile(memory.pointer(), writtenSize, "written.b3d");
+	scene::ISkinnedMesh* written = (scene::ISkinnedMesh*)smgr->getMesh(readFile);
+	readFile->drop();
+	u32 writtenKeys = 0;
+	for (u32 i=0; written && i<written->getJointCount(); ++i)
+	{
+		const scene::ISkinnedMesh::SJoint* joint = written->getAllJoints()[i];
+		writtenKeys += joint->PositionKeys.size() + joint->ScaleKeys.size() + joint->RotationKeys.size();
+	}
+	if (!written || written->isStatic() || writtenKeys == 0)
+	{
+		logTestString("Written mesh with compressed keys has %u keys\n", writtenKeys);
+		result = false;
+	}
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Layers blend clips over the frame of a node, weighted and masked
+bool animationLayers()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	if (!device)
+		return false;
+
+	scene::ISceneManager * smgr = device->getSceneManager();
+	scene::ISkinnedMesh* mesh = createWeightedMesh(smgr, false);
+
+	scene::IAnimatedMeshSceneNode* node = smgr->addAnimatedMeshSceneNode(mesh);
+	node->setFrameLoop(0, 0);
+	scene::IBoneSceneNode* joint1 = node->getJointNode("joint1");
+	scene::IBoneSceneNode* joint2 = node->getJointNode("joint2");
+
+	scene::SAnimationLayer layer;
+	layer.StartFrame = 10;
+	layer.EndFrame = 10;
+	node->addAnimationLayer(layer);
+
+	// the layer replaces the pose of the node
+	node->OnAnimate(1000);
+	bool result = joint1->getPosition().equals(core::vector3df(2.f, 3.f, 0.f));
+	result &= joint2->getScale().equals(core::vector3df(2.f, 1.f, 2.f));
+
+	// half way between two keys is the same as half the weight
+	node->getAnimationLayer(0).Weight = 0.5f;
+	node->OnAnimate(1000);
+	result &= joint1->getPosition().equals(core::vector3df(1.f, 2.f, 0.f));
+	result &= joint2->getScale().equals(core::vector3df(1.5f, 1.f, 1.5f));
+
+	mesh->animateMesh(5.f, 1.f);
+	mesh->skinMesh();
+	result &= node->getBoundingBox() == mesh->getBoundingBox();
+
+	// a layer is blended over the result of the layers before it, not summed up
+	node->getAnimationLayer(0).Weight = 1.f;
+	scene::SAnimationLayer half;
+	half.StartFrame = 5;
+	half.EndFrame = 5;
+	half.Weight = 0.5f;
+	result &= node->addAnimationLayer(half) == 1;
+	node->OnAnimate(1000);
+	result &= joint1->getPosition().equals(core::vector3df(1.5f, 2.5f, 0.f));
+	node->removeAnimationLayer(1);
+
+	// only joint2 and the joints below it follow the layer
+	node->getAnimationLayer(0).Weight = 1.f;
+	result &= node->setAnimationLayerMask(0, "joint2");
+	result &= !node->setAnimationLayerMask(0, "nojoint");
+	node->OnAnimate(1000);
+	result &= joint1->getPosition().equals(core::vector3df(0.f, 1.f, 0.f));
+	result &= joint2->getScale().equals(core::vector3df(2.f, 1.f, 2.f));
+
+	// layers advance with their own speed
+	node->removeAnimationLayer(0);
+	layer.StartFrame = 0;
+	layer.FramesPerSecond = 10.f;
+	result &= node->addAnimationLayer(layer) == 0;
+	node->OnAnimate(1500);
+	result &= core::equals(node->getAnimationLayer(0).CurrentFrame, 5.f);
+	node->OnAnimate(2600);
+	result &= core::equals(node->getAnimationLayer(0).CurrentFrame, 6.f, 0.001f);
+	result &= joint1->getPosition().equals(core::vector3df(1.2f, 2.2f, 0.f));
+
+	// the pose follows the frame of the node while the layers stand still
+	node->getAnimationLayer(0).FramesPerSecond = 0.f;
+	node->getAnimationLayer(0).Weight = 0.5f;
+	node->setFrameLoop(0, 10);
+	node->setAnimationSpeed(10.f);
+	node->setCurrentFrame(0.f);
+	node->OnAnimate(2600);
+	result &= joint1->getPosition().equals(core::vector3df(0.6f, 1.6f, 0.f));
+	node->OnAnimate(3100);
+	result &= joint1->getPosition().equals(core::vector3df(1.1f, 2.1f, 0.f));
+
+	if (!result)
+		logTestString("Animation layers blended wrong\n");
+
+	mesh->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+//! Skinning vertex by vertex gives the same results as skinning joint by joint
+bool skinningByVertex()
+{
+	IrrlichtDevice *device = createDevice(video::EDT_NULL, core::dimension2d<u32>(160, 120));
+	if (!device)
+		return false;
+
+	scene::ISceneManager * smgr = device->getSceneManager();
+
+	// a vertex with 5 weights makes the mesh skin by joints
+	scene::ISkinnedMesh* byVertex = createWeightedMesh(smgr, false);
+	scene::ISkinnedMesh* byJoint = createWeightedMesh(smgr, true);
+
+	bool result = true;
+	const f32 frames[] = {0.f, 3.5f, 7.f, 10.f};
+	for (u32 f=0; f<4; ++f)
+	{
+		byVertex->animateMesh(frames[f], 1.f);
+		byVertex->skinMesh();
+		byJoint->animateMesh(frames[f], 1.f);
+		byJoint->skinMesh();
+
+		const scene::IMeshBuffer* a = byVertex->getMeshBuffer(0);
+		const scene::IMeshBuffer* b = byJoint->getMeshBuffer(0);
+		for (u32 i=0; i<6; ++i)
+		{
+			if (!a->getPosition(i).equals(b->getPosition(i), 0.0001f) ||
+				!a->getNormal(i).equals(b->getNormal(i), 0.0001f))
+			{
+				logTestString("Vertex %u skinned differently at frame %f\n", i, frames[f]);
+				result = false;
+			}
+		}
+	}
+
+	// moved by the animation, vertex 0 only belongs to the root
+	const scene::IMeshBuffer* buffer = byVertex->getMeshBuffer(0);
+	result &= buffer->getPosition(0).equals(core::vector3df(0.f, 1.f, 0.f));
+	result &= !buffer->getPosition(1).equals(core::vector3df(1.f, 1.5f, 0.f));
+
+	// a node skins its own instance the same way
+	byVertex->animateMesh(7.f, 1.f);
+	byVertex->skinMesh();
+	scene::IAnimatedMeshSceneNode* node = smgr->addAnimatedMeshSceneNode(byVertex);
+	node->setAnimationSpeed(0.f);
+	node->setCurrentFrame(7.f);
+	smgr->drawAll();
+	result &= node->getBoundingBox() == byVertex->getBoundingBox();
+
+	byVertex->drop();
+	byJoint->drop();
+
+	device->closeDevice();
+	device->run();
+	device->drop();
+
+	return result;
+}
+
+// Tests joints after changing the mesh.
+bool setMeshJoints()
 {
 	// Use EDT_BURNINGSVIDEO since it is not dependent on (e.g.) OpenGL driver versions.
 	IrrlichtDevice *device = createDevice(video::EDT_BURNINGSVIDEO, core::dimension2d<u32>(160, 120), 32);
@@ -73,3 +499,17 @@ bool skinnedMesh(void)
 
 	return result;
 }
+
+} // end anonymous namespace
+
+// Tests skinned meshes.
+bool skinnedMesh(void)
+{
+	bool result = sharedSkinnedMesh();
+	result &= skinningByVertex();
+	result &= keyframeLookup();
+	result &= compressedKeys();
+	result &= animationLayers();
+	result &= setMeshJoints();
+	return result;
+}